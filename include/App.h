@@ -12,31 +12,41 @@
 #include <backend/VulkanInstance.h>
 #include <backend/Window.h>
 #include <backend/Pipeline.h>
-#include <backend/RenderPass.h>
 #include <backend/Swapchain.h>
 #include <backend/DescriptorSetBuilder.h>
+#include <backend/RenderGraph.h>
 
 #include <Image.h>
 #include <Vertex.h>
 #include <Model.h>
+#include <IndirectCuller.h>
+#include <Benchmark.h>
+#include <FramePacing.h>
+#include <FrameStatistics.h>
 
 class VertexBuffer;
 class IndexBuffer;
 class UniformBuffer;
+class DynamicUniformBuffer;
 class DescriptorSetLayout;
 class Texture2D;
 class DepthAttachment;
 
-const uint32_t MAX_FRAMES_IN_FLIGHT = 2;
+// The scene is a square grid of copies of the model, most of which are culled
+const uint32_t OBJECT_GRID_SIZE = 15;
 
 struct PerFrameState
 {
     Semaphore &ImageAvailable;
     Semaphore &RenderFinished;
     CommandBuffer &CommandBuffer;
+    // The camera of benchmarks, which bind it as a regular uniform buffer
     UniformBuffer &UniformBuffer;
+    // Reset once the frame's fence signaled, the scene's constants are uploaded to it every frame
+    DynamicUniformBuffer &Constants;
     DescriptorSet DescriptorSet;
-    TimerPool& TimerPool;
+    // Of this frame's scene constants in `Constants`
+    uint32_t ConstantsOffset = 0;
 };
 
 struct UniformConstants {
@@ -45,39 +55,83 @@ struct UniformConstants {
     glm::mat4 projection;
 };
 
+/// <summary>
+/// Renders offscreen without a window for a fixed number of frames, e.g. for benchmarks on machines without a display
+/// </summary>
+struct HeadlessCreateInfo
+{
+    uint32_t FrameCount = 1000;
+    OffscreenSwapchainCreateInfo Target{};
+};
+
 class App
 {
   public:
-    App();
+    /// <summary>
+    /// Creates the app, which runs the given benchmark instead of the regular scene if set
+    /// </summary>
+    App(std::optional<BenchmarkCreateInfo> benchmark = std::nullopt,
+        uint32_t framesInFlight = DEFAULT_FRAMES_IN_FLIGHT,
+        std::optional<HeadlessCreateInfo> headless = std::nullopt,
+        const FrameStatisticsCreateInfo &statistics = {});
     ~App();
 
     void RunRenderLoop();
 
   private:
+    VulkanInstance CreateVulkanInstance(const std::optional<HeadlessCreateInfo> &headless);
+    bool ShouldClose() const;
+    void RecordNextFrame();
     Texture2D& LoadImage();
     Model LoadModel();
     DepthAttachment& CreateSwapchainDepthAttachment();
     UniformConstants GetUniforms();
-    RasterPipeline LoadShaderPipeline(VulkanDevice &vulkanDevice, const RenderPass& renderPass) const;
+    PendingRasterPipeline LoadShaderPipeline(VulkanDevice &vulkanDevice, const RenderingLayout &rendering) const;
     void RecordFrame(PerFrameState& state);
+    /// <summary>
+    /// Builds and compiles the frame graph, returning its main pass
+    /// </summary>
+    RenderGraphPass &BuildFrameGraph();
+    void RecordMainPass(RenderPassScope &mainPass);
     std::vector<std::reference_wrapper<Semaphore>> CreateSemaphorePerInFlightFrame();
     std::vector<PerFrameState> CreatePerFrameState(VulkanDevice &vulkanDevice);
     std::vector<Vertex> GetVertices() const;
     std::vector<uint32_t> GetIndices() const;
-    const DescriptorSetLayout& BuildDescriptorSetLayout(VulkanDevice &vulkanDevice) const;
+    std::vector<IndirectObject> CreateObjectGrid() const;
+    BenchmarkFrame GetBenchmarkFrame(PerFrameState &state, uint32_t frameIndex);
+    // Whether a benchmark draws instead of the scene
+    bool IsBenchmarking() const;
+    bool IsBenchmarkFinished() const;
 
+    // Initialized first, as the per frame state and rings below are sized by it
+    uint32_t m_FramesInFlight;
+    // Only set when headless, the number of frames to render before closing
+    std::optional<uint32_t> m_HeadlessFrameCount;
     Model m_Model;
-    Window m_Window;
+    // Not created when headless
+    std::optional<Window> m_Window;
     VulkanInstance m_VulkanInstance;
     DepthAttachment &m_DepthAttachment;
-    RenderPass m_MainPass;
-    const SwapchainFramebuffer& m_SwapchainFramebuffers;
     const DescriptorSetLayout &m_DescriptorSetLayout;
     std::vector<PerFrameState> m_PerFrameState;
-    RasterPipeline m_RenderFullscreen;
+    // A ring with a range of queries per frame in flight
+    TimerPool &m_TimerPool;
     uint32_t m_CurrentFrameIndex = 0;
-    Swapchain &m_Swapchain;
     VertexBuffer &m_VertexBuffer;
     IndexBuffer &m_IndexBuffer;
     Texture2D& m_Texture;
+    IndirectCuller m_IndirectCuller;
+    // Null unless benchmarking, may run alongside the scene or draw instead of it
+    std::unique_ptr<Benchmark> m_Benchmark;
+    RenderGraph m_FrameGraph;
+    // Compiled along with the graph, before the pipelines that render in it are created
+    RenderGraphPass &m_MainPass;
+    PendingRasterPipeline m_RenderFullscreen;
+    FramePacingMonitor m_FramePacing;
+    FrameStatistics m_Statistics;
+    std::optional<std::chrono::steady_clock::time_point> m_LastFrameStart;
+    // Summed over the main command buffer of all frames, reported on exit
+    CommandStatistics m_CommandStatistics;
+    // Scope tree of the most recent frame whose timings were available, printed on exit
+    ResolvedTimerPool m_LastGpuTimings;
 };
@@ -0,0 +1,119 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+class VulkanDevice;
+class CommandBuffer;
+class RenderPassScope;
+class UniformBuffer;
+class Texture2D;
+class VertexBuffer;
+class IndexBuffer;
+struct RenderingLayout;
+
+/// <summary>
+/// Selects a benchmark by the name passed to `--benchmark` along with the options of all benchmarks, each of which
+/// only reads the options that apply to it
+/// </summary>
+struct BenchmarkCreateInfo
+{
+    // E.g. "push-constants" or "descriptor-template"
+    std::string Name;
+    // Number of measured frames, excluding the warm-up frames
+    uint32_t FrameCount = 500;
+    // Per draw data: number of draws per frame
+    uint32_t DrawCount = 1024;
+    // Shader variants: number of texture taps of the fragment shader, and whether it outputs grayscale
+    uint32_t TapCount = 64;
+    bool Grayscale = true;
+    // Descriptor updates: number of sets updated every frame
+    uint32_t SetCount = 1024;
+    // Compute blur: taps per texel are (2 * radius + 1)^2
+    uint32_t BlurRadius = 4;
+};
+
+/// <summary>
+/// The resources of the scene that benchmarks render or update with
+/// </summary>
+struct BenchmarkFrame
+{
+    uint32_t FrameIndex;
+    // Inside the "Draw" scope, ahead of the main pass
+    CommandBuffer &CommandBuffer;
+    const UniformBuffer &Camera;
+    Texture2D &Texture;
+    VertexBuffer &VertexBuffer;
+    IndexBuffer &IndexBuffer;
+};
+
+enum class EBenchmarkTimings
+{
+    Cpu,
+    Gpu,
+    CpuAndGpu
+};
+
+/// <summary>
+/// A benchmark that runs for a fixed number of measured frames after a few warm-up frames, and reports the average
+/// CPU and/or GPU time per frame once finished
+/// </summary>
+class Benchmark
+{
+  public:
+    virtual ~Benchmark() = default;
+
+    /// <summary>
+    /// Creates the benchmark named in `createInfo`, throws if there is none with that name
+    /// </summary>
+    static std::unique_ptr<Benchmark> Create(VulkanDevice &device, const RenderingLayout &rendering,
+                                             const BenchmarkCreateInfo &createInfo, uint32_t framesInFlight);
+    static bool IsKnown(std::string_view name);
+
+    /// <summary>
+    /// Whether `Record` draws instead of the scene. Otherwise the scene is drawn as usual alongside the benchmark
+    /// </summary>
+    virtual bool ReplacesScene() const = 0;
+    /// <summary>
+    /// Called once per frame before the main pass is recorded. Work recorded into the frame's command buffer here is
+    /// part of the "Draw" scope
+    /// </summary>
+    virtual void Update(const BenchmarkFrame &frame);
+    /// <summary>
+    /// Records the benchmark's draws into the main pass, only called if it replaces the scene
+    /// </summary>
+    virtual void Record(RenderPassScope &renderPass, const BenchmarkFrame &frame);
+    /// <summary>
+    /// Adds the resolved GPU time of the "Draw" scope of a frame recorded earlier
+    /// </summary>
+    void AddGpuTime(std::chrono::nanoseconds gpuTime);
+    bool IsFinished() const;
+    virtual void Report(std::ostream &output) const = 0;
+
+  protected:
+    Benchmark(uint32_t frameCount, EBenchmarkTimings timings);
+
+    /// <summary>
+    /// Counts a frame, and adds its CPU time unless it's a warm-up frame or all frames were measured already.
+    /// Returns whether the CPU time was added
+    /// </summary>
+    bool AddFrame(std::optional<std::chrono::nanoseconds> cpuTime = std::nullopt);
+    uint32_t GetCpuSampleCount() const;
+    uint32_t GetGpuSampleCount() const;
+    std::chrono::duration<double, std::milli> GetAverageCpuTime() const;
+    std::chrono::duration<double, std::milli> GetAverageGpuTime() const;
+    std::chrono::nanoseconds GetTotalCpuTime() const;
+
+  private:
+    uint32_t m_FrameCount;
+    EBenchmarkTimings m_Timings;
+    uint32_t m_Frames = 0;
+    uint32_t m_CpuSamples = 0;
+    uint32_t m_GpuSamples = 0;
+    std::chrono::nanoseconds m_CpuTime{0};
+    std::chrono::nanoseconds m_GpuTime{0};
+};
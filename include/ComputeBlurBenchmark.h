@@ -0,0 +1,54 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+#include <backend/ComputePipeline.h>
+#include <backend/DescriptorSetBuilder.h>
+
+#include <Benchmark.h>
+
+class DeviceBuffer;
+class Texture;
+
+/// <summary>
+/// Matches the `BlurSettings` push constant block in blur.comp
+/// </summary>
+struct BlurSettings
+{
+    int32_t Radius;
+};
+
+/// <summary>
+/// Blurs the scene's texture into a storage image every frame with an indirect compute dispatch, and measures the
+/// GPU time it takes. Nothing is drawn, so this replaces the scene
+/// </summary>
+class ComputeBlurBenchmark : public Benchmark
+{
+  public:
+    ComputeBlurBenchmark(VulkanDevice &device, const BenchmarkCreateInfo &createInfo, uint32_t framesInFlight);
+    ComputeBlurBenchmark(const ComputeBlurBenchmark &) = delete;
+
+    bool ReplacesScene() const override;
+    /// <summary>
+    /// Records the blur into the frame's command buffer, ahead of the main pass
+    /// </summary>
+    void Update(const BenchmarkFrame &frame) override;
+    void Report(std::ostream &output) const override;
+    static bool IsName(std::string_view name);
+
+  private:
+    DeviceBuffer &CreateArgumentBuffer(VulkanDevice &device) const;
+
+    BlurSettings m_Settings;
+    const DescriptorSetLayout &m_DescriptorSetLayout;
+    ComputePipeline m_Pipeline;
+    DeviceBuffer &m_ArgumentBuffer;
+    // One per frame in flight, so that a frame doesn't overwrite the image an earlier frame may still be writing
+    std::vector<std::reference_wrapper<Texture>> m_Outputs;
+    std::vector<DescriptorSet> m_DescriptorSets;
+};
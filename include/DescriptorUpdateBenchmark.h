@@ -0,0 +1,57 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include <backend/DescriptorAllocator.h>
+#include <backend/DescriptorSetBuilder.h>
+
+#include <Benchmark.h>
+
+struct DescriptorUpdateMode
+{
+    EDescriptorUpdatePath Path;
+    // Allocates the sets every frame from an allocator per frame in flight, reset once the frame retired, instead of
+    // rewriting the same sets
+    bool Transient = false;
+};
+
+/// <summary>
+/// Rewrites a uniform buffer and a texture to many descriptor sets every frame, either with a write per binding
+/// or through the layout's update template, and measures the CPU time spent updating. The sets are never bound,
+/// so the scene is drawn as usual
+/// </summary>
+class DescriptorUpdateBenchmark : public Benchmark
+{
+  public:
+    DescriptorUpdateBenchmark(VulkanDevice &device, DescriptorUpdateMode mode, const BenchmarkCreateInfo &createInfo,
+                              uint32_t framesInFlight);
+    DescriptorUpdateBenchmark(const DescriptorUpdateBenchmark &) = delete;
+
+    bool ReplacesScene() const override;
+    /// <summary>
+    /// Updates all sets once, measuring the CPU time it takes, including allocating the sets if they're transient
+    /// </summary>
+    void Update(const BenchmarkFrame &frame) override;
+    void Report(std::ostream &output) const override;
+    static std::optional<DescriptorUpdateMode> ParseMode(std::string_view name);
+
+  private:
+    uint32_t UpdateSets(std::span<DescriptorSet> descriptorSets, const BenchmarkFrame &frame);
+
+    DescriptorUpdateMode m_Mode;
+    uint32_t m_SetCount;
+    const DescriptorSetLayout &m_DescriptorSetLayout;
+    // Persistent mode only
+    std::vector<DescriptorSet> m_DescriptorSets;
+    // Transient mode only, one per frame in flight
+    std::vector<std::reference_wrapper<DescriptorAllocator>> m_FrameAllocators;
+    uint64_t m_Updates = 0;
+};
@@ -0,0 +1,62 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+#include <backend/TimerPool.h>
+
+// Bounds of how many frames the CPU may record ahead of the GPU
+const uint32_t MIN_FRAMES_IN_FLIGHT = 1;
+const uint32_t MAX_FRAMES_IN_FLIGHT = 4;
+const uint32_t DEFAULT_FRAMES_IN_FLIGHT = 2;
+
+enum class EFramePacingPreset
+{
+    // A single frame in flight, so input is at most one frame old when it reaches the GPU, at the cost of the GPU
+    // idling while the CPU records the next frame
+    LowLatency,
+    // Three frames in flight, which keeps the GPU fed through CPU hitches but delays input by up to three frames
+    MaxThroughput
+};
+
+uint32_t GetFramesInFlight(EFramePacingPreset preset);
+std::optional<EFramePacingPreset> ParseFramePacingPreset(std::string_view name);
+
+/// <summary>
+/// Measures the cost of the frames in flight setting: how long a frame slot is occupied from sampling its input until
+/// the CPU reuses it, and how long the GPU idles between consecutive frames. The slot is only reused after the other
+/// frames in flight were recorded, so the first grows with the frame count rather than tracking when the GPU finished.
+/// </summary>
+class FramePacingMonitor
+{
+  public:
+    explicit FramePacingMonitor(uint32_t framesInFlight);
+
+    /// <summary>
+    /// Marks the point input was sampled for the frame recorded into `frameSlot`
+    /// </summary>
+    void SampleInput(uint32_t frameSlot);
+    /// <summary>
+    /// Called when `frameSlot` is reused, once the fence of the frame last recorded into it was waited on, with the
+    /// time the wait returned and the GPU span of that frame. Frames need to complete in the order they were submitted
+    /// </summary>
+    void CompleteFrame(uint32_t frameSlot, std::chrono::steady_clock::time_point slotReused,
+                       std::optional<GpuTimeSpan> gpuFrame);
+    void Report(std::ostream &output) const;
+
+  private:
+    uint32_t m_FramesInFlight;
+    std::vector<std::optional<std::chrono::steady_clock::time_point>> m_InputTimes;
+    std::optional<std::chrono::nanoseconds> m_LastGpuFrameEnd;
+
+    uint32_t m_SlotReuseSamples = 0;
+    std::chrono::nanoseconds m_TotalInputToSlotReuse{0};
+    std::chrono::nanoseconds m_MaxInputToSlotReuse{0};
+    uint32_t m_BubbleSamples = 0;
+    std::chrono::nanoseconds m_TotalBubble{0};
+    std::chrono::nanoseconds m_MaxBubble{0};
+    std::chrono::nanoseconds m_TotalGpuBusy{0};
+};
@@ -0,0 +1,96 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <backend/TimerPool.h>
+
+struct FrameStatisticsCreateInfo
+{
+    // Number of most recent samples of each series the statistics are computed over
+    uint32_t WindowSize = 600;
+    // Frames between the summaries printed to stdout, 0 to only print on exit
+    uint32_t ReportInterval = 600;
+    // Written on exit if set, as JSON if the extension is `.json` and CSV otherwise
+    std::optional<std::filesystem::path> OutputPath;
+};
+
+/// <summary>
+/// Summary of the samples in the window of a series, in milliseconds
+/// </summary>
+struct FrameStatisticsSummary
+{
+    size_t Count = 0;
+    double Min = 0.0;
+    double Mean = 0.0;
+    double P50 = 0.0;
+    double P95 = 0.0;
+    double P99 = 0.0;
+    double Max = 0.0;
+};
+
+/// <summary>
+/// Collects named series of durations, e.g. CPU frame times, GPU scopes and CPU waits, over a rolling window of the
+/// most recent frames, and reports their distribution.
+/// </summary>
+class FrameStatistics
+{
+  public:
+    explicit FrameStatistics(const FrameStatisticsCreateInfo &createInfo);
+
+    void AddSample(std::string_view series, std::chrono::nanoseconds duration);
+    /// <summary>
+    /// Adds each scope of a resolved frame as a series prefixed with "GPU "
+    /// </summary>
+    void AddGpuTimings(const ResolvedTimerPool &timings);
+    /// <summary>
+    /// Marks the end of a frame, printing a summary to `output` every `ReportInterval` frames
+    /// </summary>
+    void EndFrame(std::ostream &output);
+    FrameStatisticsSummary Summarize(std::string_view series) const;
+    void Report(std::ostream &output) const;
+    void WriteCsv(std::ostream &output) const;
+    void WriteJson(std::ostream &output) const;
+    /// <summary>
+    /// Writes the statistics to the output path of the create info, if any
+    /// </summary>
+    void Save() const;
+
+  private:
+    struct Series
+    {
+        // Ring of the most recent samples, `Next` is overwritten once it's full
+        std::vector<std::chrono::nanoseconds> Samples;
+        size_t Next = 0;
+    };
+
+    FrameStatisticsCreateInfo m_CreateInfo;
+    // Ordered, so that reports list the series in the same order every time
+    std::map<std::string, Series, std::less<>> m_Series;
+    uint64_t m_FrameCount = 0;
+    // Reused for the prefixed names of GPU scopes, so that only new series allocate
+    std::string m_GpuSeriesName;
+};
+
+/// <summary>
+/// Adds the time from construction to destruction as a sample of a series, for timing CPU work such as waits
+/// </summary>
+class ScopedCpuTimer
+{
+  public:
+    ScopedCpuTimer(FrameStatistics &statistics, std::string_view series);
+    ScopedCpuTimer(const ScopedCpuTimer &) = delete;
+    ~ScopedCpuTimer();
+
+  private:
+    FrameStatistics &m_Statistics;
+    std::string_view m_Series;
+    std::chrono::steady_clock::time_point m_Start;
+};
@@ -0,0 +1,108 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <vector>
+
+#include <backend/ComputePipeline.h>
+#include <backend/DescriptorSetBuilder.h>
+#include <backend/CommandBufferPool.h>
+
+class VulkanDevice;
+class DeviceBuffer;
+class RenderPassScope;
+
+/// <summary>
+/// A single culled object. Matches `ObjectData` in the culling and indirect vertex shaders
+/// </summary>
+struct IndirectObject
+{
+    glm::mat4 Transform;
+    // xyz: center in object space, w: radius
+    glm::vec4 BoundingSphere;
+    uint32_t IndexCount;
+    uint32_t FirstIndex;
+    int32_t VertexOffset;
+    uint32_t Padding = 0;
+};
+
+/// <summary>
+/// The transforms to cull against, with the same layout as `UniformConstants`
+/// </summary>
+struct CullCamera
+{
+    glm::mat4 Model;
+    glm::mat4 View;
+    glm::mat4 Projection;
+};
+
+struct IndirectCullerCreateInfo
+{
+    uint32_t MaxObjectCount;
+    uint32_t FramesInFlight;
+};
+
+/// <summary>
+/// GPU driven drawing of many objects: a compute pass on the compute queue culls all objects against
+/// the camera frustum and writes a compacted list of indirect draws plus a count, which the graphics
+/// queue then draws with a single indirect call. The CPU cost per frame is independent of the object count.
+/// </summary>
+class IndirectCuller
+{
+  public:
+    IndirectCuller(VulkanDevice &device, const IndirectCullerCreateInfo &createInfo);
+    IndirectCuller(const IndirectCuller &) = delete;
+    IndirectCuller(IndirectCuller &&) = default;
+
+    /// <summary>
+    /// Uploads the objects to cull. This is not synchronized with frames in flight, so only call this
+    /// while none of the frames are using the objects (e.g. at load time)
+    /// </summary>
+    void SetObjects(std::span<const IndirectObject> objects);
+    /// <summary>
+    /// Records and submits the culling pass for the given frame. Call this only after the graphics
+    /// work of the previous use of this frame index has finished.
+    /// </summary>
+    /// <param name="frameIndex">The frame in flight to cull for</param>
+    /// <param name="camera">The transforms to cull with</param>
+    /// <returns>The semaphore the graphics submission has to wait on prior to drawing</returns>
+    SemaphoreWait Cull(uint32_t frameIndex, const CullCamera &camera);
+    void Draw(RenderPassScope &renderPass, uint32_t frameIndex) const;
+    /// <summary>
+    /// The buffer holding the objects, with the same layout as the `Objects` buffer in indirect.vert
+    /// </summary>
+    const DeviceBuffer &GetObjectBuffer() const;
+
+  private:
+    struct ObjectBufferHeader
+    {
+        uint32_t ObjectCount;
+        uint32_t Padding[3];
+    };
+
+    struct PerFrameCullState
+    {
+        std::reference_wrapper<CommandBuffer> CullCommandBuffer;
+        std::reference_wrapper<Semaphore> CullFinished;
+        DescriptorSet CullDescriptorSet;
+        std::reference_wrapper<DeviceBuffer> Camera;
+        std::reference_wrapper<DeviceBuffer> DrawCommands;
+        std::reference_wrapper<DeviceBuffer> DrawCount;
+    };
+
+    std::vector<PerFrameCullState> CreatePerFrameState(VulkanDevice &device, uint32_t framesInFlight);
+    DeviceBuffer &CreateSharedBuffer(VulkanDevice &device, VkDeviceSize size, VkBufferUsageFlags usage) const;
+
+    uint32_t m_MaxObjectCount;
+    uint32_t m_ObjectCount = 0;
+    bool m_UseDrawCount;
+    bool m_UseMultiDraw;
+    std::vector<uint32_t> m_QueueFamilies;
+    const DescriptorSetLayout &m_DescriptorSetLayout;
+    ComputePipeline m_CullPipeline;
+    DeviceBuffer &m_Objects;
+    std::vector<PerFrameCullState> m_PerFrameState;
+};
@@ -0,0 +1,49 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.h>
+
+#include <backend/Pipeline.h>
+
+/// <summary>
+/// Per-instance vertex stream, advanced once per instance instead of once per vertex
+/// </summary>
+struct InstanceData
+{
+    glm::mat4 Transform;
+    uint32_t MaterialIndex;
+
+    /// <param name="binding">The binding the instance buffer will be bound to</param>
+    /// <param name="firstLocation">The first free location after the per-vertex attributes. The transform
+    /// takes up four locations, one per column</param>
+    static VertexBindingDescription GetVertexBindingDescription(uint32_t binding = 1, uint32_t firstLocation = 3);
+};
+
+inline VertexBindingDescription InstanceData::GetVertexBindingDescription(uint32_t binding, uint32_t firstLocation)
+{
+    VkVertexInputBindingDescription bindingDescription;
+    bindingDescription.binding = binding;
+    bindingDescription.stride = sizeof(InstanceData);
+    bindingDescription.inputRate = VkVertexInputRate::VK_VERTEX_INPUT_RATE_INSTANCE;
+
+    VertexBindingDescription description{bindingDescription, {}};
+    for (uint32_t column = 0; column < 4; column++)
+    {
+        VkVertexInputAttributeDescription columnAttribute;
+        columnAttribute.binding = binding;
+        columnAttribute.location = firstLocation + column;
+        columnAttribute.format = VkFormat::VK_FORMAT_R32G32B32A32_SFLOAT;
+        columnAttribute.offset = static_cast<uint32_t>(offsetof(InstanceData, Transform) + sizeof(glm::vec4) * column);
+        description.AttributeDescriptions.emplace_back(columnAttribute);
+    }
+
+    VkVertexInputAttributeDescription materialAttribute;
+    materialAttribute.binding = binding;
+    materialAttribute.location = firstLocation + 4;
+    materialAttribute.format = VkFormat::VK_FORMAT_R32_UINT;
+    materialAttribute.offset = offsetof(InstanceData, MaterialIndex);
+    description.AttributeDescriptions.emplace_back(materialAttribute);
+    return description;
+}
@@ -2,6 +2,8 @@
 #include <string>
 #include <vector>
 
+#include <glm/glm.hpp>
+
 #include <Vertex.h>
 
 class Model
@@ -11,8 +13,15 @@ public:
 
     const std::vector<Vertex> &GetVertices() const;
     const std::vector<uint32_t> &GetIndices() const;
+    /// <summary>
+    /// Sphere enclosing all vertices, with the center in xyz and the radius in w
+    /// </summary>
+    glm::vec4 GetBoundingSphere() const;
 
 private:
+    glm::vec4 CalculateBoundingSphere() const;
+
     std::vector<Vertex> m_Vertices;
     std::vector<uint32_t> m_Indices;
+    glm::vec4 m_BoundingSphere;
 };
\ No newline at end of file
@@ -0,0 +1,116 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+#include <backend/Pipeline.h>
+#include <backend/DescriptorSetBuilder.h>
+
+#include <Benchmark.h>
+
+class DynamicUniformBuffer;
+class VertexBuffer;
+class BindlessTextureTable;
+
+enum class EPerDrawDataMode
+{
+    // One vkCmdPushConstants per draw
+    PushConstants,
+    // A buffer upload, descriptor write and descriptor set bind per draw
+    UniformBuffer,
+    // A copy into a per-frame ring and a set bind with a new dynamic offset per draw, without descriptor writes
+    DynamicUniformBuffer,
+    // A single instanced draw, with the transforms in a per-instance vertex stream, see `InstanceData`
+    Instanced,
+    // Push constants as above, which also carry an index into the bindless texture table that is bound once
+    Bindless
+};
+
+/// <summary>
+/// The data that changes for every draw. Matches the `PushConstants` block in pushconstant.vert
+/// and the `PerDrawObject` block in perdraw.vert
+/// </summary>
+struct PerDrawConstants
+{
+    glm::mat4 Transform;
+};
+
+/// <summary>
+/// The per draw data of the bindless mode. Matches the `PushConstants` block in bindless.vert
+/// </summary>
+struct BindlessDrawConstants
+{
+    glm::mat4 Transform;
+    uint32_t TextureIndex;
+};
+
+/// <summary>
+/// Draws the same mesh many times with a different transform per draw, passing the transform either
+/// through push constants, a uniform buffer per draw or a per-instance vertex stream, and measures the CPU time
+/// spent recording the draws as well as the GPU time spent executing them.
+/// </summary>
+class PerDrawDataBenchmark : public Benchmark
+{
+  public:
+    PerDrawDataBenchmark(VulkanDevice &device, const RenderingLayout &rendering, EPerDrawDataMode mode,
+                         const BenchmarkCreateInfo &createInfo, uint32_t framesInFlight);
+    PerDrawDataBenchmark(const PerDrawDataBenchmark &) = delete;
+
+    bool ReplacesScene() const override;
+    /// <summary>
+    /// Binds the benchmark pipeline and records all draws, measuring the CPU time it takes
+    /// </summary>
+    void Record(RenderPassScope &renderPass, const BenchmarkFrame &frame) override;
+    void Report(std::ostream &output) const override;
+    static std::optional<EPerDrawDataMode> ParseMode(std::string_view name);
+
+  private:
+    struct PerFrameDrawState
+    {
+        // Push constant, instanced and bindless mode: one set shared by all draws
+        std::optional<DescriptorSet> SharedDescriptorSet;
+        // Uniform buffer mode: one set and buffer per draw, since a set cannot be updated
+        // after it was bound in a command buffer that is still recording
+        std::vector<DescriptorSet> DrawDescriptorSets;
+        std::vector<std::reference_wrapper<UniformBuffer>> DrawUniformBuffers;
+        // Dynamic uniform buffer mode: the shared set points into this ring
+        DynamicUniformBuffer *DrawRing = nullptr;
+    };
+
+    const DescriptorSetLayout &BuildDescriptorSetLayout(VulkanDevice &device) const;
+    const RasterPipeline &CreatePipeline(VulkanDevice &device, const RenderingLayout &rendering) const;
+    std::filesystem::path GetVertexShaderPath() const;
+    std::filesystem::path GetFragmentShaderPath() const;
+    std::vector<PerFrameDrawState> CreatePerFrameState(VulkanDevice &device, uint32_t framesInFlight) const;
+    std::vector<glm::mat4> CreateTransforms() const;
+    void RecordPushConstants(RenderPassScope &renderPass, PerFrameDrawState &state, const UniformBuffer &camera,
+                             Texture2D &texture, uint32_t indexCount);
+    void RecordUniformBuffers(RenderPassScope &renderPass, PerFrameDrawState &state, const UniformBuffer &camera,
+                              Texture2D &texture, uint32_t indexCount);
+    void RecordDynamicUniformBuffer(RenderPassScope &renderPass, PerFrameDrawState &state, const UniformBuffer &camera,
+                                    Texture2D &texture, uint32_t indexCount);
+    void RecordInstanced(RenderPassScope &renderPass, PerFrameDrawState &state, const UniformBuffer &camera,
+                         Texture2D &texture, uint32_t indexCount);
+    void RecordBindless(RenderPassScope &renderPass, PerFrameDrawState &state, const UniformBuffer &camera,
+                        Texture2D &texture, uint32_t indexCount);
+    const char *GetModeName() const;
+
+    EPerDrawDataMode m_Mode;
+    uint32_t m_DrawCount;
+    const DescriptorSetLayout &m_DescriptorSetLayout;
+    const RasterPipeline &m_Pipeline;
+    std::vector<PerFrameDrawState> m_PerFrameState;
+    std::vector<glm::mat4> m_Transforms;
+    // Instanced mode only, an `InstanceData` per draw. The transforms don't change, so it's shared by all frames
+    VertexBuffer *m_InstanceBuffer = nullptr;
+    // Bindless mode only
+    const BindlessTextureTable *m_BindlessTextures = nullptr;
+};
@@ -0,0 +1,67 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+#include <backend/Pipeline.h>
+#include <backend/DescriptorSetBuilder.h>
+
+#include <Benchmark.h>
+
+enum class EShaderVariantMode
+{
+    // The tap count and grayscale toggle are read from push constants in the shader
+    RuntimeBranching,
+    // The same settings are specialization constants, so the driver can unroll the loop and drop the branch
+    Specialized
+};
+
+/// <summary>
+/// Matches the `ShadingSettings` push constant block in variant.frag
+/// </summary>
+struct ShadingSettings
+{
+    uint32_t TapCount;
+    VkBool32 Grayscale;
+};
+
+/// <summary>
+/// Matches the specialization constants in variant.frag
+/// </summary>
+struct ShadingSpecialization
+{
+    VkBool32 UseSpecialization;
+    uint32_t TapCount;
+    VkBool32 Grayscale;
+};
+
+/// <summary>
+/// Draws the mesh with a fragment shader that is expensive enough to bound the frame, with its settings either
+/// passed at runtime or specialized into the pipeline, and measures the GPU time spent drawing.
+/// </summary>
+class ShaderVariantBenchmark : public Benchmark
+{
+  public:
+    ShaderVariantBenchmark(VulkanDevice &device, const RenderingLayout &rendering, EShaderVariantMode mode,
+                           const BenchmarkCreateInfo &createInfo, uint32_t framesInFlight);
+    ShaderVariantBenchmark(const ShaderVariantBenchmark &) = delete;
+
+    bool ReplacesScene() const override;
+    void Record(RenderPassScope &renderPass, const BenchmarkFrame &frame) override;
+    void Report(std::ostream &output) const override;
+    static std::optional<EShaderVariantMode> ParseMode(std::string_view name);
+
+  private:
+    const RasterPipeline &CreatePipeline(VulkanDevice &device, const RenderingLayout &rendering) const;
+
+    EShaderVariantMode m_Mode;
+    ShadingSettings m_Settings;
+    const DescriptorSetLayout &m_DescriptorSetLayout;
+    const RasterPipeline &m_Pipeline;
+    std::vector<DescriptorSet> m_DescriptorSets;
+};
@@ -14,7 +14,7 @@ struct Vertex
 
     constexpr static VkVertexInputBindingDescription GetBindingDescription();
     constexpr static std::array<VkVertexInputAttributeDescription, 3> GetAttributeDescriptions(); 
-    constexpr static VertexBindingDescription GetVertexBindingDescription();
+    static VertexBindingDescription GetVertexBindingDescription();
 };
 
 constexpr VkVertexInputBindingDescription Vertex::GetBindingDescription()
@@ -43,15 +43,16 @@ constexpr std::array<VkVertexInputAttributeDescription, 3> Vertex::GetAttributeD
     VkVertexInputAttributeDescription uvAttribute;
     uvAttribute.binding = 0;
     uvAttribute.location = 2;
-    uvAttribute.format = VkFormat::VK_FORMAT_R32G32B32_SFLOAT;
+    uvAttribute.format = VkFormat::VK_FORMAT_R32G32_SFLOAT;
     uvAttribute.offset = offsetof(Vertex, UV);
     return {positionAttribute, colorAttribute, uvAttribute};
 }
 
-constexpr VertexBindingDescription Vertex::GetVertexBindingDescription()
+inline VertexBindingDescription Vertex::GetVertexBindingDescription()
 {
+    auto attributeDescriptions = GetAttributeDescriptions();
     return VertexBindingDescription{
         GetBindingDescription(),
-        GetAttributeDescriptions()
+        {attributeDescriptions.begin(), attributeDescriptions.end()}
     };
 }
@@ -0,0 +1,73 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "DescriptorPool.h"
+#include "DescriptorSetBuilder.h"
+
+// The descriptor set index shaders declare the bindless arrays at, e.g.
+// `layout(set = 1, binding = 0) uniform texture2D Textures[];` and
+// `layout(set = 1, binding = 1) uniform sampler Samplers[];`
+constexpr uint32_t BindlessSetIndex = 1;
+// The sampler that is always registered at index 0, which matches the sampler of `Texture2D`
+constexpr uint32_t BindlessDefaultSampler = 0;
+
+struct BindlessTextureTableCreateInfo
+{
+    uint32_t MaxTextures = 4096;
+    uint32_t MaxSamplers = 64;
+    // Of the default sampler
+    float MaxAnisotropy = 1.0f;
+};
+
+/// <summary>
+/// A single descriptor set holding an array of sampled images and an array of samplers, which shaders index with
+/// indices passed through push constants or instance data. The set is bound once instead of binding a set per draw.
+/// Entries are written with update-after-bind, so textures can be registered while the set is in use, and unused
+/// entries may be left unwritten
+/// </summary>
+class BindlessTextureTable
+{
+  public:
+    BindlessTextureTable(VkDevice device, const BindlessTextureTableCreateInfo &createInfo);
+    BindlessTextureTable(const BindlessTextureTable &) = delete;
+    BindlessTextureTable(BindlessTextureTable &&other);
+    ~BindlessTextureTable();
+
+    /// <summary>
+    /// Writes `view` to a free slot, returning its index in the texture array. Commands don't know which
+    /// entries a shader reads, so the image has to be in `VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL` by the time
+    /// it's used, e.g. through `CommandBuffer::RequireAccess`
+    /// </summary>
+    uint32_t RegisterTexture(VkImageView view);
+    /// <summary>
+    /// Frees the slot for later textures. Only valid once no pending command buffer reads the entry anymore
+    /// </summary>
+    void UnregisterTexture(uint32_t textureIndex);
+    /// <summary>
+    /// Returns the index of `sampler` in the sampler array, registering it if it's new. The sampler is not owned
+    /// by the table and has to outlive it
+    /// </summary>
+    uint32_t RegisterSampler(VkSampler sampler);
+    const DescriptorSetLayout &GetLayout() const;
+    VkDescriptorSet Get() const;
+
+  private:
+    void Write(uint32_t binding, uint32_t arrayElement, VkDescriptorType descriptorType,
+               const VkDescriptorImageInfo &imageInfo);
+    VkSampler CreateDefaultSampler(float maxAnisotropy) const;
+
+    VkDevice m_Device;
+    uint32_t m_MaxTextures;
+    uint32_t m_MaxSamplers;
+    DescriptorSetLayout m_Layout;
+    DescriptorPool m_Pool;
+    VkDescriptorSet m_DescriptorSet = VK_NULL_HANDLE;
+    // Owned, at `BindlessDefaultSampler`
+    VkSampler m_DefaultSampler = VK_NULL_HANDLE;
+    std::vector<VkSampler> m_Samplers;
+    std::vector<uint32_t> m_FreeTextureSlots;
+    uint32_t m_NextTextureSlot = 0;
+};
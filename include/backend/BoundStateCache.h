@@ -0,0 +1,104 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <vector>
+
+enum class EBoundState
+{
+    Pipeline,
+    Viewport,
+    Scissor,
+    VertexBuffer,
+    IndexBuffer,
+    DescriptorSet,
+    // A single binding written by `vkUpdateDescriptorSets`, skipped if it still holds the same resource
+    DescriptorWrite,
+    Count
+};
+
+struct CommandStatistics
+{
+    uint32_t GetEmitted(EBoundState state) const;
+    uint32_t GetSkipped(EBoundState state) const;
+    uint32_t GetTotalEmitted() const;
+    uint32_t GetTotalSkipped() const;
+    /// <summary>
+    /// Sums up the statistics of several recordings, e.g. of all frames
+    /// </summary>
+    CommandStatistics &operator+=(const CommandStatistics &other);
+    void Report(std::ostream &stream) const;
+
+    std::array<uint32_t, static_cast<size_t>(EBoundState::Count)> Emitted{};
+    std::array<uint32_t, static_cast<size_t>(EBoundState::Count)> Skipped{};
+    // Number of `vkUpdateDescriptorSets` calls, each covering all changed bindings of a set
+    uint32_t DescriptorUpdates = 0;
+};
+
+/// <summary>
+/// Mirrors the state bound on a single command buffer, so that binds of a value that is
+/// already bound can be skipped. Every `Set*` returns whether the command should be emitted.
+/// </summary>
+class BoundStateCache
+{
+  public:
+    // Forgets all bound state, e.g. because the command buffer was (re)begun, in which case
+    // all state is undefined
+    void Invalidate();
+    void ResetStatistics();
+    const CommandStatistics &GetStatistics() const;
+
+    bool SetPipeline(VkPipelineBindPoint bindPoint, VkPipeline pipeline);
+    bool SetViewport(const VkViewport &viewport);
+    bool SetScissor(const VkRect2D &scissor);
+    bool SetVertexBuffer(uint32_t binding, VkBuffer buffer, VkDeviceSize offset);
+    bool SetIndexBuffer(VkBuffer buffer, VkDeviceSize offset, VkIndexType indexType);
+    bool SetDescriptorSet(VkPipelineBindPoint bindPoint, VkPipelineLayout layout, uint32_t setIndex,
+                          VkDescriptorSet descriptorSet, std::span<const uint32_t> dynamicOffsets = {});
+    /// <summary>
+    /// Only counts the writes of a set flushed before binding it, as descriptor contents aren't command buffer state
+    /// </summary>
+    void RecordDescriptorWrites(uint32_t written, uint32_t skipped);
+
+  private:
+    struct BoundVertexBuffer
+    {
+        VkBuffer Buffer = VK_NULL_HANDLE;
+        VkDeviceSize Offset = 0;
+    };
+
+    struct BoundIndexBuffer
+    {
+        VkBuffer Buffer = VK_NULL_HANDLE;
+        VkDeviceSize Offset = 0;
+        VkIndexType IndexType = VkIndexType::VK_INDEX_TYPE_UINT32;
+    };
+
+    struct BoundDescriptorSet
+    {
+        VkPipelineLayout Layout = VK_NULL_HANDLE;
+        VkDescriptorSet DescriptorSet = VK_NULL_HANDLE;
+        std::vector<uint32_t> DynamicOffsets;
+    };
+
+    // Graphics and compute have separate bind points, which don't disturb each other
+    struct BindPointState
+    {
+        VkPipeline Pipeline = VK_NULL_HANDLE;
+        std::vector<BoundDescriptorSet> DescriptorSets;
+    };
+
+    static size_t BindPointIndex(VkPipelineBindPoint bindPoint);
+    bool Record(EBoundState state, bool changed);
+
+    std::array<BindPointState, 2> m_BindPoints;
+    std::optional<VkViewport> m_Viewport;
+    std::optional<VkRect2D> m_Scissor;
+    std::vector<BoundVertexBuffer> m_VertexBuffers;
+    std::optional<BoundIndexBuffer> m_IndexBuffer;
+    CommandStatistics m_Statistics;
+};
@@ -4,8 +4,9 @@
 #include <optional>
 #include <cassert>
 #include <span>
+#include <cstddef>
 
-#include "Barrier.h"
+#include "ResourceState.h"
 
 class PhysicalDevice;
 class Fence;
@@ -18,13 +19,8 @@ struct CreateBufferInfo
     VkMemoryPropertyFlags MemoryProperties;
     bool PersistentlyMapped = true;
     VkSharingMode SharingMode = VkSharingMode::VK_SHARING_MODE_EXCLUSIVE;
-};
-
-struct TransferOp
-{
-    Queue Destination;
-    VkAccessFlags DestinationAccessMask;
-    VkPipelineStageFlags DestinationPipelineStage;
+    // Only used for `VK_SHARING_MODE_CONCURRENT`, the queue families that may access the buffer
+    std::vector<uint32_t> QueueFamilies;
 };
 
 class DeviceBuffer
@@ -40,32 +36,23 @@ public:
     VkBuffer Get() const;
     VkDeviceSize GetSize() const;
     /// <summary>
-    /// Transfer the buffer ownership to another queue (family)
-    ///
-    /// This assuems the most recent operation was an upload (i.e. `VkPipelineStageFlagBits::VK_PIPELINE_STAGE_TRANSFER_BIT`)
-    /// </summary>
-    /// <param name="transferOperation">The transfer operation parameters, specifying the context in which the buffer will be used on the target</param>
-    /// <param name="commandBuffer">The (transfer) command buffer from which` queue (family) the buffer will be released</param>
-    void Transfer(TransferOp transferOperation, const CommandBuffer& commandBuffer);
-
-    /// <summary>
-    /// Takes the transfer acquire barrier, if there is any, for a previously enqueued release barrier used for uploading data
+    /// The access state as of the last command recorded on this buffer, used by `CommandBuffer` to derive barriers
     /// </summary>
-    std::optional<BufferMemoryBarrier> TakePendingAcquire();
+    ResourceState& GetState() const;
 
     template<typename T>
-    void UploadData(std::span<T> data)
+    void UploadData(std::span<T> data, VkDeviceSize offset = 0)
     {
         auto bufferSize = data.size() * sizeof(T);
-        assert(bufferSize <= m_CreateInfo.Size && "Buffer too small for provided data");
+        assert(offset + bufferSize <= m_CreateInfo.Size && "Buffer too small for provided data");
         if (m_MappedBuffer.has_value())
         {
-			memcpy(*m_MappedBuffer, data.data(), bufferSize);
+			memcpy(static_cast<std::byte *>(*m_MappedBuffer) + offset, data.data(), bufferSize);
         }
         else
         {
             void *mappedBuffer;
-            vkMapMemory(m_Device, m_Memory, 0, bufferSize, 0, &mappedBuffer);
+            vkMapMemory(m_Device, m_Memory, offset, bufferSize, 0, &mappedBuffer);
 			memcpy(mappedBuffer, data.data(), bufferSize);
 			vkUnmapMemory(m_Device, m_Memory);
         }
@@ -77,6 +64,6 @@ private:
 	VkDeviceMemory m_Memory;
     CreateBufferInfo m_CreateInfo;
     std::optional<void *> m_MappedBuffer;
-    std::optional<BufferMemoryBarrier> m_PendingAcquireBarrier;
-    Fence *m_PendingReleaseFence = nullptr;
+    // Tracking state rather than buffer contents, so it can change for buffers that are only read
+    mutable ResourceState m_State;
 };
@@ -10,10 +10,16 @@
 #include <backend/Fence.h>
 #include <backend/Queue.h>
 #include <backend/Barrier.h>
+#include <backend/ResourceState.h>
+#include <backend/RenderPassScope.h>
+#include <backend/BoundStateCache.h>
+#include <backend/PushConstants.h>
+#include <backend/RenderingInfo.h>
 
 class Framebuffer;
 class RenderPass;
 class RasterPipeline;
+class ComputePipeline;
 class VertexBuffer;
 class UniformBuffer;
 class DeviceBuffer;
@@ -22,13 +28,32 @@ class DescriptorSet;
 class ExtensionFunctionMapping;
 class VulkanInstance;
 class BindSet;
+class Texture;
 class Texture2D;
 class TimerPool;
+struct Viewport;
+
+struct SemaphoreWait
+{
+    std::reference_wrapper<Semaphore> WaitSemaphore;
+    // The stages that wait on the semaphore being signaled
+    VkPipelineStageFlags WaitStage;
+};
+
+// Only set when dynamic rendering is enabled
+struct DynamicRenderingFunctions
+{
+    PFN_vkCmdBeginRenderingKHR BeginRendering = nullptr;
+    PFN_vkCmdEndRenderingKHR EndRendering = nullptr;
+};
 
 struct CommandBufferPoolCreateInfo
 {
     VkCommandPoolCreateFlagBits CreationFlags;
     uint32_t QueueIndex;
+    // Only set when synchronization2 is enabled, barriers fall back to `vkCmdPipelineBarrier` otherwise
+    PFN_vkCmdPipelineBarrier2KHR PipelineBarrier2 = nullptr;
+    DynamicRenderingFunctions DynamicRendering;
 };
 
 class CommandBuffer
@@ -41,36 +66,132 @@ class CommandBuffer
 	};
 
   public:
-    CommandBuffer(VkCommandBuffer &&commandBuffer, VkDevice device, Queue queue);
+    CommandBuffer(VkCommandBuffer &&commandBuffer, VkDevice device, Queue queue,
+                  PFN_vkCmdPipelineBarrier2KHR pipelineBarrier2, DynamicRenderingFunctions dynamicRendering);
     CommandBuffer(CommandBuffer && other);
     CommandBuffer(const CommandBuffer & other) = delete;
     ~CommandBuffer();
 
     void SetName(const std::string& name, const ExtensionFunctionMapping& functionMapping);
     void WaitFence();
+    /// <summary>
+    /// The fence of the last submission, or null if that submission has already finished
+    /// </summary>
+    Fence *GetPendingFence();
     void Begin();
     void BeginSingleTake();
+    /// <summary>
+    /// Begins the render pass, which stays active until the returned scope is destroyed
+    /// </summary>
+    [[nodiscard]] RenderPassScope BeginRenderPass(const Framebuffer &frameBuffer, const RenderPass &renderPass);
+    /// <summary>
+    /// Begins rendering directly to the image views of `renderingInfo`, without a render pass or framebuffer object.
+    /// Rendering stays active until the returned scope is destroyed, after which the attachments are transitioned
+    /// to their final layouts. Requires dynamic rendering to be enabled
+    /// </summary>
+    [[nodiscard]] RenderPassScope BeginRendering(const RenderingInfo &renderingInfo);
     void Draw(const Framebuffer& frameBuffer, const RenderPass& renderPass, const RasterPipeline& pipeline, VertexBuffer& vertexBuffer, BindSet&& bindSet);
     void DrawIndexed(const Framebuffer& frameBuffer, const RenderPass& renderPass, const RasterPipeline& pipeline, VertexBuffer& vertexBuffer, IndexBuffer& indexBuffer, BindSet&& bindSet);
+    /// <summary>
+    /// Ends and submits the command buffer, where all wait semaphores are waited on before color attachment output
+    /// </summary>
     Fence& End(std::span<Semaphore> waitSemaphores, std::span<Semaphore> signalSemaphores);
+    Fence& End(std::span<const SemaphoreWait> waitSemaphores, std::span<Semaphore> signalSemaphores);
     Fence& End();
+    /// <summary>
+    /// Updates the push constants of `stages` at byte `Offset` with `data`, using the layout of `pipeline`.
+    /// Unlike a uniform buffer, this needs no descriptor write and the value is versioned per draw
+    /// </summary>
+    template <typename T, uint32_t Offset = 0>
+    void PushConstants(const RasterPipeline &pipeline, VkShaderStageFlags stages, const T &data)
+    {
+        ValidatePushConstantType<T, Offset>();
+        PushConstantsInternal(pipeline, stages, Offset, static_cast<uint32_t>(sizeof(T)), &data);
+    }
+    template <typename T, uint32_t Offset = 0> void PushConstants(const ComputePipeline &pipeline, const T &data)
+    {
+        ValidatePushConstantType<T, Offset>();
+        PushConstantsInternal(pipeline, Offset, static_cast<uint32_t>(sizeof(T)), &data);
+    }
+    void BindComputePipeline(const ComputePipeline &pipeline);
+    /// <summary>
+    /// Binds the set with one offset per dynamic binding, in binding order
+    /// </summary>
+    void BindComputeDescriptorSet(BindSet &&bindSet, const ComputePipeline &pipeline,
+                                  std::span<const uint32_t> dynamicOffsets = {});
+    void Dispatch(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ);
+    /// <summary>
+    /// Dispatches with the group counts read from the `VkDispatchIndirectCommand` at `offset` in `argumentBuffer`,
+    /// e.g. written by an earlier dispatch
+    /// </summary>
+    void DispatchIndirect(const DeviceBuffer &argumentBuffer, VkDeviceSize offset = 0);
+    void FillBuffer(DeviceBuffer &buffer, uint32_t value);
     void Copy(const DeviceBuffer &source, const DeviceBuffer &destination);
-    void CopyBufferToImage(const DeviceBuffer& source, Texture2D& texture);
+    void CopyBufferToImage(const DeviceBuffer& source, const Texture& texture);
+    /// <summary>
+    /// Declares that the next commands access `buffer` as `access`. The barrier this needs, if any, is batched
+    /// with all others and recorded right before the next command that does work. Barriers can't be recorded
+    /// inside a render pass, so accesses of resources used in a render pass have to be declared before beginning it
+    /// </summary>
+    void RequireAccess(const DeviceBuffer &buffer, EResourceAccess access);
+    void RequireAccess(const Texture &texture, EResourceAccess access);
+    void RequireAccess(const Texture &texture, EResourceAccess access, const VkImageSubresourceRange &range);
+    /// <summary>
+    /// Declares the accesses of all resources in `bindSet` by the shaders of `bindPoint`
+    /// </summary>
+    void RequireAccess(const BindSet &bindSet, VkPipelineBindPoint bindPoint);
+    /// <summary>
+    /// Discards the contents of `texture`, which was last accessed with `previousAccess` outside of this command
+    /// buffer's tracking, e.g. by the presentation engine. The next access waits for it, see `DiscardState`
+    /// </summary>
+    void DiscardContents(const Texture &texture, EResourceAccess previousAccess);
+    /// <summary>
+    /// Discards the contents of `texture`, whose memory was last used by the resources in `previousOccupants` on this
+    /// queue, possibly in an earlier frame that is still in flight. The next access waits for all of them
+    /// </summary>
+    void DiscardContents(const Texture &texture, std::span<const ResourceState *const> previousOccupants);
+    /// <summary>
+    /// Releases ownership to the queue family of `destination`. The first access recorded on that family acquires it
+    /// </summary>
+    void ReleaseOwnership(const DeviceBuffer &buffer, Queue destination);
+    /// <summary>
+    /// Releases ownership to the queue family of `destination`, transitioning the image to the layout of `nextAccess`.
+    /// The first access recorded on that family acquires it
+    /// </summary>
+    void ReleaseOwnership(const Texture &texture, EResourceAccess nextAccess, Queue destination);
+    /// <summary>
+    /// Records an explicit barrier right away, bypassing the tracked resource state. Prefer `RequireAccess`
+    /// </summary>
     void InsertBarrier(const BufferMemoryBarrier &barrier) const;
     void InsertBarrier(const ImageMemoryBarrier &barrier) const;
     void InsertBarriers(const BarrierArray &barriers) const;
     Queue GetQueue() const;
     void ResetTimerPool(TimerPool &timerPool) const;
+    /// <summary>
+    /// Counts of state binds and descriptor writes emitted and skipped as redundant since the last `Begin`
+    /// </summary>
+    const CommandStatistics &GetStatistics() const;
     // TODO: Remove, temporarily pub only for Timers
     VkCommandBuffer Get() const;
   private:
-    void BindVertexBuffer(VertexBuffer &vertexBuffer);
+    friend class RenderPassScope;
+
+    void BeginRenderPassInternal(const Framebuffer &frameBuffer, const RenderPass &renderPass);
+    void BeginRenderingInternal(const RenderingInfo &renderingInfo);
+    void EndRenderPassInternal();
+    void BindPipeline(const RasterPipeline &pipeline, const Viewport &viewport);
+    void BindVertexBuffer(VertexBuffer &vertexBuffer, uint32_t binding);
     void BindIndexBuffer(IndexBuffer &indexBuffer);
-    void BindDescriptorSet(BindSet &bindset, const RasterPipeline &pipeline);
-    void HandleAcquire(std::optional<BufferMemoryBarrier> pendingAcquire);
-    void HandleAcquire(std::optional<ImageMemoryBarrier> pendingAcquire);
+    void BindDescriptorSet(BindSet &bindset, const RasterPipeline &pipeline, std::span<const uint32_t> dynamicOffsets);
+    void BindDescriptorSet(BindSet &bindSet, VkPipelineBindPoint bindPoint, VkPipelineLayout pipelineLayout,
+                           std::span<const uint32_t> dynamicOffsets);
+    void BindDescriptorSet(VkDescriptorSet descriptorSet, uint32_t setIndex, VkPipelineBindPoint bindPoint,
+                           VkPipelineLayout pipelineLayout, std::span<const uint32_t> dynamicOffsets = {});
+    void PushConstantsInternal(const RasterPipeline &pipeline, VkShaderStageFlags stages, uint32_t offset,
+                               uint32_t size, const void *data);
+    void PushConstantsInternal(const ComputePipeline &pipeline, uint32_t offset, uint32_t size, const void *data);
     void Reset();
-    void FlushPendingBarriers();
+    void FlushBarriers();
 
     // Only used in case we Reset, which can clear a debug name previously
     // set.
@@ -89,8 +210,17 @@ class CommandBuffer
     // In unique_ptr to outlive the CommandBuffer in case it's moved
     std::unique_ptr<Fence> m_InFlight;
     CommandBufferStatus m_Status = CommandBufferStatus::Reset;
+    bool m_InsideRenderPass = false;
+    // Whether the active render pass is dynamic rendering, which ends with `m_EndRenderingBarriers`
+    bool m_InsideDynamicRendering = false;
+    std::vector<VkImageMemoryBarrier> m_EndRenderingBarriers;
+    DynamicRenderingFunctions m_DynamicRendering;
+    BoundStateCache m_BoundState;
     Queue m_Queue;
-    std::vector<BarrierArray> m_PendingBarriers;
+    PFN_vkCmdPipelineBarrier2KHR m_PipelineBarrier2;
+    // Identifies the current recording, see `ResourceState::RecordingId`
+    uint64_t m_RecordingId = 0;
+    BarrierBatch m_PendingBarriers;
 };
 
 // TODO: Template with per-type command buffer, so that they only have the matching
@@ -105,11 +235,15 @@ class CommandBufferPool
     
     std::vector<std::reference_wrapper<CommandBuffer>> CreateCommandBuffers(uint32_t count, Queue queue);
     CommandBuffer& CreateCommandBuffer(Queue queue);
+    // The fences of all submissions from this pool that may not have finished yet
+    std::vector<Fence *> GetPendingFences();
     void SetName(const std::string& name, ExtensionFunctionMapping mapping);
   private:
     const VulkanInstance &m_Instance;
     VkDevice m_Device;
     VkCommandPool m_CommandBufferPool;
+    PFN_vkCmdPipelineBarrier2KHR m_PipelineBarrier2;
+    DynamicRenderingFunctions m_DynamicRendering;
     // TODO: Cleanup command buffers
     std::vector<std::unique_ptr<CommandBuffer>> m_CommandBuffers;
 };
@@ -0,0 +1,78 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <vector>
+
+#include "PipelineLayout.h"
+#include "PushConstants.h"
+#include "SpecializationConstants.h"
+
+class DescriptorSetLayout;
+
+struct ComputePipelineCreateInfo
+{
+    VkPipelineShaderStageCreateInfo ShaderStage{};
+    const PipelineLayout &Layout;
+    VkPipelineCache PipelineCache = VK_NULL_HANDLE;
+};
+
+class ComputePipeline
+{
+  public:
+    ComputePipeline(VkDevice vulkanDevice, ComputePipelineCreateInfo createInfo);
+
+    ComputePipeline(const ComputePipeline &) = delete;
+    ComputePipeline(ComputePipeline &&other);
+    ~ComputePipeline();
+
+    ComputePipeline &operator=(const ComputePipeline &) = delete;
+    ComputePipeline &operator=(ComputePipeline &&) = delete;
+
+    VkPipelineLayout GetPipelineLayout() const;
+    VkPipeline Get() const;
+    const std::vector<VkPushConstantRange> &GetPushConstantRanges() const;
+  private:
+    VkDevice m_VulkanDevice;
+    // Owned by the device, as it's shared between pipelines
+    const PipelineLayout &m_Layout;
+    VkPipeline m_Pipeline;
+};
+
+class ComputePipelineBuilder
+{
+  public:
+    explicit ComputePipelineBuilder(std::filesystem::path &&computeShaderPath);
+
+    /// <summary>
+    /// Uses `descriptorSetLayout` for set 0. Without it, the layout and push constant ranges are derived from the shader
+    /// </summary>
+    ComputePipelineBuilder &SetDescriptorSetLayout(const DescriptorSetLayout &descriptorSetLayout);
+    /// <summary>
+    /// Adds a push constant range of `T` at byte `Offset`. The layout of `T` has to match the push_constant block
+    /// of the shader, starting at `Offset`
+    /// </summary>
+    template <typename T, uint32_t Offset = 0> ComputePipelineBuilder &AddPushConstantRange()
+    {
+        ValidatePushConstantType<T, Offset>();
+        return AddPushConstantRange(VkPushConstantRange{VkShaderStageFlagBits::VK_SHADER_STAGE_COMPUTE_BIT, Offset,
+                                                        static_cast<uint32_t>(sizeof(T))});
+    }
+    /// <summary>
+    /// Compiles the shader with `constants`, e.g. to specialize the work group size
+    /// </summary>
+    ComputePipelineBuilder &SetSpecializationConstants(SpecializationConstants constants);
+    const std::filesystem::path &GetComputeShaderPath() const;
+    std::optional<std::reference_wrapper<const DescriptorSetLayout>> GetDescriptorSetLayout() const;
+    const std::vector<VkPushConstantRange> &GetPushConstantRanges() const;
+    const std::optional<SpecializationConstants> &GetSpecializationConstants() const;
+  private:
+    ComputePipelineBuilder &AddPushConstantRange(VkPushConstantRange range);
+
+    std::filesystem::path m_ComputeShaderPath;
+    std::optional<std::reference_wrapper<const DescriptorSetLayout>> m_DescriptorSetLayout;
+    std::vector<VkPushConstantRange> m_PushConstantRanges;
+    std::optional<SpecializationConstants> m_Specialization;
+};
@@ -0,0 +1,52 @@
+#pragma once
+#include <deque>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+class Fence;
+
+/// <summary>
+/// Keeps objects alive until the submissions that may still use them have finished, so that they can be replaced
+/// without waiting for the device to idle. Objects are destroyed by their destructor, in the order they were pushed
+/// </summary>
+class DeferredDeletionQueue
+{
+  public:
+    DeferredDeletionQueue() = default;
+    DeferredDeletionQueue(const DeferredDeletionQueue &) = delete;
+    DeferredDeletionQueue(DeferredDeletionQueue &&) = default;
+    ~DeferredDeletionQueue();
+
+    /// <summary>
+    /// Takes ownership of `object` and destroys it once all fences in `pendingWork` signaled, or were waited on
+    /// by their owner
+    /// </summary>
+    template <typename T> void Push(std::vector<Fence *> pendingWork, T &&object)
+    {
+        m_Deletions.emplace_back(PendingDeletion{
+            std::move(pendingWork), std::make_shared<std::decay_t<T>>(std::forward<T>(object))});
+    }
+    /// <summary>
+    /// Destroys the objects whose work finished, without blocking. Called once per frame
+    /// </summary>
+    void Collect();
+    /// <summary>
+    /// Waits for all pending work and destroys every object, e.g. before the device is destroyed
+    /// </summary>
+    void Flush();
+    size_t GetPendingCount() const;
+
+  private:
+    struct PendingDeletion
+    {
+        std::vector<Fence *> PendingWork;
+        // Type erased, the deleter of the shared pointer destroys the object
+        std::shared_ptr<void> Object;
+    };
+
+    static bool HasFinished(PendingDeletion &deletion);
+
+    std::deque<PendingDeletion> m_Deletions;
+};
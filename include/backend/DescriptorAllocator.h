@@ -0,0 +1,65 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "DescriptorPool.h"
+#include "DescriptorSetBuilder.h"
+
+struct DescriptorAllocatorCreateInfo
+{
+    // Sets in the first pool. Each next pool holds twice as many as the one before, up to `MaxSetsPerPool`
+    uint32_t InitialSetsPerPool = 64;
+    uint32_t MaxSetsPerPool = 4096;
+};
+
+struct DescriptorAllocatorStatistics
+{
+    uint32_t PoolCount = 0;
+    // Sets allocated since the last reset
+    uint32_t AllocatedSets = 0;
+    // `vkAllocateDescriptorSets` calls since the last reset
+    uint32_t AllocateCalls = 0;
+};
+
+/// <summary>
+/// Allocates descriptor sets from a chain of pools, creating another pool whenever the existing ones are exhausted.
+/// New pools are sized by the number of descriptors of each type per set observed so far, so no pool sizes have to
+/// be tuned by hand. Allocators can be reset as a whole, e.g. to free per-frame sets once the frame retired
+/// </summary>
+class DescriptorAllocator
+{
+  public:
+    DescriptorAllocator(VkDevice device, const DescriptorAllocatorCreateInfo &createInfo);
+    DescriptorAllocator(const DescriptorAllocator &) = delete;
+    DescriptorAllocator(DescriptorAllocator &&other) = default;
+
+    DescriptorSet Allocate(const DescriptorSetLayout &layout);
+    /// <summary>
+    /// Allocates `count` sets of `layout` in as few `vkAllocateDescriptorSets` calls as the pools allow
+    /// </summary>
+    std::vector<DescriptorSet> Allocate(const DescriptorSetLayout &layout, uint32_t count);
+    /// <summary>
+    /// Frees all sets allocated so far with `vkResetDescriptorPool`, keeping the pools for the next allocations.
+    /// Only valid once no command buffer using any of the sets is pending anymore
+    /// </summary>
+    void Reset();
+    DescriptorAllocatorStatistics GetStatistics() const;
+
+  private:
+    void RecordUsage(const DescriptorSetLayout &layout, uint32_t count);
+    DescriptorPool CreatePool(const DescriptorSetLayout &layout);
+
+    VkDevice m_Device;
+    DescriptorAllocatorCreateInfo m_CreateInfo;
+    std::vector<DescriptorPool> m_Pools;
+    // Pools before this one are full until the next reset
+    size_t m_CurrentPool = 0;
+    uint32_t m_NextPoolSets;
+    // Descriptors of each type in all sets allocated over the lifetime of the allocator, to size new pools with
+    std::map<VkDescriptorType, uint64_t> m_ObservedDescriptors;
+    uint64_t m_ObservedSets = 0;
+    DescriptorAllocatorStatistics m_Statistics;
+};
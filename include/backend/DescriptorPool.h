@@ -1,5 +1,6 @@
 #pragma once
 #include <cstdint>
+#include <span>
 #include <unordered_map>
 #include <vector>
 
@@ -21,11 +22,22 @@ class DescriptorPool
 {
   public:
     DescriptorPool(VkDevice device, const DescriptorPoolCreateInfo& descriptorPoolCreateInfo);
+    DescriptorPool(VkDevice device, std::span<const VkDescriptorPoolSize> poolSizes, uint32_t maxSets,
+                   VkDescriptorPoolCreateFlags flags = 0);
     ~DescriptorPool();
     DescriptorPool(const DescriptorPool&) = delete;
     DescriptorPool(DescriptorPool&& other);
 
     DescriptorSet CreateDescriptorSet(const DescriptorSetLayout& layout);
+    /// <summary>
+    /// Allocates a set for each of `layouts` into `sets` in a single call. Returns the error instead of throwing,
+    /// so that callers can move on to another pool when this one is exhausted
+    /// </summary>
+    VkResult TryAllocate(std::span<const VkDescriptorSetLayout> layouts, std::span<VkDescriptorSet> sets);
+    /// <summary>
+    /// Frees all sets allocated from the pool
+    /// </summary>
+    void Reset();
 private:
     VkDescriptorPool m_DescriptorPool;
     VkDevice m_Device;
@@ -1,100 +1,231 @@
 #pragma once
 #include <cstdint>
+#include <optional>
+#include <span>
 #include <vector>
 
 #include <vulkan/vulkan.hpp>
 
-#include <backend/Barrier.h>
+#include "ObjectCache.h"
 
 class UniformBuffer;
+class DynamicUniformBuffer;
+class DeviceBuffer;
+class Texture;
 class Texture2D;
 class DescriptorPool;
 class DescriptorSet;
 class ExtensionFunctionMapping;
 
+/// <summary>
+/// The resource of a single descriptor. An array of these indexed by binding is the data the update template
+/// of a layout reads
+/// </summary>
+union DescriptorInfo
+{
+    VkDescriptorBufferInfo BufferInfo;
+    VkDescriptorImageInfo ImageInfo;
+};
+
+enum class EDescriptorUpdatePath
+{
+    // A `VkWriteDescriptorSet` per changed binding
+    Writes,
+    // The update template of the layout, which writes all bindings at once. Falls back to writes for layouts
+    // without a template, or when not all bindings are bound
+    Template
+};
+
 class BindSet
 {
-  private:
-    struct BindEntry
+  public:
+    struct BoundResource
     {
-        VkWriteDescriptorSet StagingDescriptorWrite;
-        union {
-            VkDescriptorBufferInfo BufferInfo;
-            VkDescriptorImageInfo ImageInfo;
-        } DataInfo;
+        // Exactly one of these is set
+        const DeviceBuffer *Buffer = nullptr;
+        const Texture *Image = nullptr;
+        VkDescriptorType DescriptorType;
+        // A storage buffer that no shader using the layout writes
+        bool ReadOnly = false;
     };
 
-  public:
-    BindSet(const DescriptorSet& descriptorSet, VkDevice device);
+    BindSet(DescriptorSet& descriptorSet, VkDevice device);
 
     BindSet& BindTexture(Texture2D& texture) &;
     BindSet& BindUniformBuffer(const UniformBuffer& buffer) &;
+    /// <summary>
+    /// Binds the ring to a `VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC` binding, whose slice is selected with the
+    /// dynamic offsets given when binding the set
+    /// </summary>
+    BindSet& BindDynamicUniformBuffer(const DynamicUniformBuffer& buffer) &;
+    BindSet& BindStorageBuffer(const DeviceBuffer& buffer) &;
+    /// <summary>
+    /// Binds the image for unfiltered loads and stores, which requires `VK_IMAGE_USAGE_STORAGE_BIT`
+    /// </summary>
+    BindSet& BindStorageImage(const Texture& texture) &;
     [[nodiscard]] BindSet&& BindTexture(Texture2D& texture) &&;
     [[nodiscard]] BindSet&& BindUniformBuffer(const UniformBuffer& buffer) &&;
-    void FlushWrites();
-    std::vector<ImageMemoryBarrier> TakePendingAcquires();
+    [[nodiscard]] BindSet&& BindDynamicUniformBuffer(const DynamicUniformBuffer& buffer) &&;
+    [[nodiscard]] BindSet&& BindStorageBuffer(const DeviceBuffer& buffer) &&;
+    [[nodiscard]] BindSet&& BindStorageImage(const Texture& texture) &&;
+    /// <summary>
+    /// Writes the set if any binding's resource differs from the one last written to it. Through the template,
+    /// all bindings are written in a single `vkUpdateDescriptorSetWithTemplate`, otherwise only the changed ones
+    /// in a single `vkUpdateDescriptorSets`. Returns the number of bindings written
+    /// </summary>
+    uint32_t FlushWrites(EDescriptorUpdatePath path = EDescriptorUpdatePath::Template);
+    /// <summary>
+    /// The resources bound so far, from which the command buffer derives the barriers needed to bind the set
+    /// </summary>
+    std::span<const BoundResource> GetBoundResources() const;
     const DescriptorSet &GetDescriptorSet() const;
   private:
     void BindTextureInternal(Texture2D &texture);
     void BindUniformBufferInternal(const UniformBuffer &buffer);
+    void BindDynamicUniformBufferInternal(const DynamicUniformBuffer &buffer);
+    void BindBufferInternal(const DeviceBuffer &buffer, VkDescriptorType descriptorType);
+    void BindBufferInternal(const DeviceBuffer &buffer, VkDescriptorType descriptorType,
+                            const VkDescriptorBufferInfo &bufferInfo);
+    void BindStorageImageInternal(const Texture &texture);
 
-    const DescriptorSet& m_DescriptorSet;
-    std::vector<BindEntry> m_Entries;
+    uint32_t FlushTemplate();
+    uint32_t FlushDescriptorWrites();
 
-	// Unfortunately, as we're taking pending acquires here,
-	// this assumes that the first call to Bind for a specifc resource
-	// assumes that that person won't bind _and_ submit the same resource
-	// in a different BindSet prior to submitting this `BindSet`.
-	// TODO: Use references to the resources instead, so that we can
-	// fetch the pending acqquires at the time of invoking the call to bind.
-    std::vector<ImageMemoryBarrier> m_PendingAcquires;
+    DescriptorSet& m_DescriptorSet;
+    // Indexed by binding, so that the infos are packed the way the update template expects them
+    std::vector<VkWriteDescriptorSet> m_Writes;
+    std::vector<DescriptorInfo> m_Infos;
+    std::vector<BoundResource> m_BoundResources;
     VkDevice m_Device;
 };
 
 class DescriptorSetLayout
 {
   public:
-    DescriptorSetLayout(VkDevice device, std::vector<VkDescriptorSetLayoutBinding> bindings);
+    /// <summary>
+    /// `readOnlyBindings` are the storage buffer bindings that shaders only read, so binding them needs no barrier
+    /// against other reads
+    /// </summary>
+    DescriptorSetLayout(VkDevice device, std::vector<VkDescriptorSetLayoutBinding> bindings,
+                        std::vector<uint32_t> readOnlyBindings = {});
+    /// <summary>
+    /// With `bindingFlags` per binding, e.g. for partially bound or update-after-bind arrays
+    /// </summary>
+    DescriptorSetLayout(VkDevice device, std::vector<VkDescriptorSetLayoutBinding> bindings,
+                        VkDescriptorSetLayoutCreateFlags flags, std::span<const VkDescriptorBindingFlags> bindingFlags);
     ~DescriptorSetLayout();
     DescriptorSetLayout(const DescriptorSetLayout&) = delete;
     DescriptorSetLayout(DescriptorSetLayout&& other);
 
     VkDescriptorSetLayout Get() const;
+    std::span<const VkDescriptorSetLayoutBinding> GetBindings() const;
+    /// <summary>
+    /// Writes a `DescriptorInfo` per binding, indexed by binding. Null for layouts with arrays or gaps
+    /// between their bindings
+    /// </summary>
+    VkDescriptorUpdateTemplate GetUpdateTemplate() const;
+    /// <summary>
+    /// The number of dynamic offsets binding a set of this layout takes
+    /// </summary>
+    uint32_t GetDynamicOffsetCount() const;
+    bool IsReadOnly(uint32_t binding) const;
+    /// <summary>
+    /// Describes the bindings of a layout, for sharing identical layouts
+    /// </summary>
+    static StateKey GetStateKey(std::span<const VkDescriptorSetLayoutBinding> bindings,
+                                std::span<const uint32_t> readOnlyBindings);
   private:
+    VkDescriptorUpdateTemplate CreateUpdateTemplate() const;
+
     VkDescriptorSetLayout m_Layout = VK_NULL_HANDLE;
+    VkDescriptorUpdateTemplate m_UpdateTemplate = VK_NULL_HANDLE;
     VkDevice m_Device;
 
-    // For validation only
+    // For validation and sizing descriptor pools only
     std::vector<VkDescriptorSetLayoutBinding> m_Bindings; 
+    std::vector<uint32_t> m_ReadOnlyBindings;
 };
 
 class DescriptorSet
 {
   public:
     DescriptorSet(const DescriptorSetLayout& layout, VkDevice device, VkDescriptorSet set);
+    // Move only, as two copies of the same set would each skip writes based on their own cache of written bindings
+    DescriptorSet(const DescriptorSet&) = delete;
+    DescriptorSet(DescriptorSet&& other) = default;
+    DescriptorSet& operator=(const DescriptorSet&) = delete;
 
     [[nodiscard]] BindSet BindTexture(Texture2D& texture);
     [[nodiscard]] BindSet BindUniformBuffer(const UniformBuffer& buffer);
+    [[nodiscard]] BindSet BindDynamicUniformBuffer(const DynamicUniformBuffer& buffer);
+    [[nodiscard]] BindSet BindStorageBuffer(const DeviceBuffer& buffer);
+    [[nodiscard]] BindSet BindStorageImage(const Texture& texture);
     VkDescriptorSet Get() const;
     const DescriptorSetLayout& GetLayout() const;
     void SetName(const std::string &name, const ExtensionFunctionMapping& mapping);
+    /// <summary>
+    /// Forgets the resources written so far, so that the next bind writes all bindings again. Needed when a bound
+    /// resource is destroyed and another one may be created with the same handle
+    /// </summary>
+    void InvalidateWrites();
   private:
+    friend class BindSet;
+
+    // The resource last written to a binding, to skip writing it again
+    struct WrittenDescriptor
+    {
+        VkDescriptorType DescriptorType;
+        DescriptorInfo Info;
+    };
+
+    /// <summary>
+    /// Remembers the resource `info` of `write` for its binding, returning whether it differs from the one written before
+    /// </summary>
+    bool UpdateWritten(const VkWriteDescriptorSet &write, const DescriptorInfo &info);
+
     const DescriptorSetLayout& m_Layout;
     VkDevice m_Device;
     VkDescriptorSet m_DescriptorSet;
+    // Indexed by binding
+    std::vector<std::optional<WrittenDescriptor>> m_Written;
+    // Reused between flushes, so that flushing doesn't allocate
+    std::vector<VkWriteDescriptorSet> m_PendingWrites;
 };
 
 class DescriptorSetBuilder
 {
   public:
-    DescriptorSetBuilder& AddUniformBuffer();
-    DescriptorSetBuilder& AddTexture();
+    /// <summary>
+    /// Adds a binding after the last one, visible to `stages` only
+    /// </summary>
+    DescriptorSetBuilder& AddUniformBuffer(VkShaderStageFlags stages);
+    /// <summary>
+    /// A uniform buffer whose offset is given when binding the set, see `DynamicUniformBuffer`. Reflection can't
+    /// tell these apart from regular uniform buffers, see `VulkanDevice::CreateReflectedDescriptorSetLayout`
+    /// </summary>
+    DescriptorSetBuilder& AddDynamicUniformBuffer(VkShaderStageFlags stages);
+    DescriptorSetBuilder& AddTexture(VkShaderStageFlags stages);
+    /// <summary>
+    /// A storage buffer, which binding for compute counts as a read and write unless `readOnly`
+    /// </summary>
+    DescriptorSetBuilder& AddStorageBuffer(VkShaderStageFlags stages, bool readOnly = false);
+    DescriptorSetBuilder& AddStorageImage(VkShaderStageFlags stages);
+    /// <summary>
+    /// Adds a binding as is, e.g. one derived from the shaders
+    /// </summary>
+    DescriptorSetBuilder& AddBinding(const VkDescriptorSetLayoutBinding& binding, bool readOnly = false);
     /// <summary>
     /// Builds a descriptor set layout and clears the current builder
     /// </summary>
     /// <param name="device">The device to use for building</param>
     /// <returns>The layout based on the bindings</returns>
     DescriptorSetLayout Build(VkDevice device);
+    std::span<const VkDescriptorSetLayoutBinding> GetBindings() const;
+    std::span<const uint32_t> GetReadOnlyBindings() const;
   private:
+    DescriptorSetBuilder& AddNextBinding(VkDescriptorType descriptorType, VkShaderStageFlags stages,
+                                         bool readOnly = false);
+
     std::vector<VkDescriptorSetLayoutBinding> m_Bindings;
+    std::vector<uint32_t> m_ReadOnlyBindings;
 };
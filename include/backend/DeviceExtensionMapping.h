@@ -6,6 +6,8 @@
 enum class EDeviceExtension
 {
     Swapchain,
+    Synchronization2,
+    DynamicRendering,
     Unknown
 };
 
@@ -0,0 +1,64 @@
+#pragma once
+#include "Buffer.h"
+
+#include <cassert>
+#include <cstdint>
+#include <type_traits>
+
+class VulkanDevice;
+
+struct DynamicUniformBufferCreateInfo
+{
+    // The budget per frame: uploads between two resets. The buffer holds exactly this many slices and doesn't grow,
+    // as another buffer would need another descriptor write
+    uint32_t MaxUploads = 256;
+    // The largest upload, which is the range of the descriptor
+    VkDeviceSize MaxUploadSize = 256;
+};
+
+/// <summary>
+/// A persistently mapped buffer that uploads are bump-allocated from, each at an offset aligned to
+/// `minUniformBufferOffsetAlignment`. It's bound once as a `VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC` descriptor,
+/// after which every upload only costs a memcpy and a different dynamic offset when binding the set.
+/// Meant to be used one per frame in flight, reset once the frame's fence signaled
+/// </summary>
+class DynamicUniformBuffer
+{
+  public:
+    DynamicUniformBuffer(VulkanDevice &vulkanDevice, const DynamicUniformBufferCreateInfo &createInfo,
+                         VkDeviceSize offsetAlignment);
+    DynamicUniformBuffer(DynamicUniformBuffer &&other) = default;
+    DynamicUniformBuffer(const DynamicUniformBuffer &other) = delete;
+
+    /// <summary>
+    /// Copies `data` to the next free slice, returning its offset to pass as the dynamic offset of the binding
+    /// </summary>
+    template <typename T> uint32_t Upload(const T &data)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "Uniform data is copied byte-wise");
+        assert(sizeof(T) <= m_MaxUploadSize && "Upload is larger than the range of the descriptor");
+        auto offset = Allocate();
+        m_Buffer.UploadData(std::span<const T>(&data, 1), offset);
+        return offset;
+    }
+    /// <summary>
+    /// Frees all slices. Only valid once no pending command buffer reads any of them anymore
+    /// </summary>
+    void Reset();
+
+    VkDescriptorBufferInfo GetDescriptorInfo() const;
+    const DeviceBuffer &GetBuffer() const;
+    /// <summary>
+    /// Bytes of the slices allocated since the last reset
+    /// </summary>
+    VkDeviceSize GetUsedSize() const;
+
+  private:
+    uint32_t Allocate();
+    DeviceBuffer &CreateBuffer(VulkanDevice &vulkanDevice, VkDeviceSize size);
+
+    DeviceBuffer &m_Buffer;
+    VkDeviceSize m_MaxUploadSize;
+    VkDeviceSize m_SliceStride;
+    VkDeviceSize m_Head = 0;
+};
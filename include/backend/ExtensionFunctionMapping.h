@@ -6,7 +6,9 @@ enum class EExtensionFunction
 {
     CreateDebugUtilsMessenger,
     DestroyDebugUtilsMessenger,
-    DebugUtilsSetObjectName
+    DebugUtilsSetObjectName,
+    CmdBeginDebugUtilsLabel,
+    CmdEndDebugUtilsLabel
 };
 
 // TODO: Automatically bind requested extensions through DeviceExtensionMapping to the matching functions
@@ -27,6 +27,10 @@ class Fence
     /// </summary>
     void WaitAndReset();
     /// <summary>
+    /// Waits for the fence without resetting it, so that its owner can still wait on and reset it
+    /// </summary>
+    void Wait();
+    /// <summary>
     /// Gets the underlying fence for usage in calls to the Vulkan API
     /// </summary>
     /// <returns>The underlying fence handle</returns>
@@ -1,6 +1,8 @@
 #pragma once
 #include <vulkan/vulkan.h>
 
+#include <vector>
+
 #include "Viewport.h"
 
 class RenderPass;
@@ -8,8 +10,8 @@ class RenderPass;
 struct FramebufferCreateInfo
 {
     const RenderPass &RenderPass;
-    VkImageView ColorOutputView;
-    VkImageView DepthAttachmentView;
+    // In the order of the attachments of `RenderPass`
+    std::vector<VkImageView> Attachments;
     Viewport Viewport;
 };
 
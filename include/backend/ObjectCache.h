@@ -0,0 +1,113 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+
+/// <summary>
+/// Serializes the state an object is created from, so that objects created from identical state can be shared.
+/// Only add members one by one, as the padding of whole structs is unspecified
+/// </summary>
+class StateKey
+{
+  public:
+    template <typename T> StateKey &Add(const T &value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "Only plain values can be added to a key");
+        m_Data.append(reinterpret_cast<const char *>(&value), sizeof(T));
+        return *this;
+    }
+    StateKey &Add(std::string_view value)
+    {
+        // Prefixed with the size so that consecutive strings can't be ambiguous
+        Add(value.size());
+        m_Data.append(value);
+        return *this;
+    }
+    const std::string &Get() const
+    {
+        return m_Data;
+    }
+
+  private:
+    std::string m_Data;
+};
+
+struct ObjectCacheStatistics
+{
+    uint64_t Hits = 0;
+    uint64_t Misses = 0;
+
+    double HitRate() const
+    {
+        auto total = Hits + Misses;
+        return total == 0 ? 0.0 : static_cast<double>(Hits) / static_cast<double>(total);
+    }
+};
+
+/// <summary>
+/// Owns device objects keyed by the complete state they were created from, so that requesting an object with
+/// the same state again returns the existing one. Safe to use from multiple threads
+/// </summary>
+template <typename T> class ObjectCache
+{
+  public:
+    ObjectCache() = default;
+    ObjectCache(const ObjectCache &) = delete;
+    ObjectCache(ObjectCache &&other)
+    {
+        std::unique_lock lock(other.m_Mutex);
+        m_Objects = std::move(other.m_Objects);
+        m_Statistics = other.m_Statistics;
+    }
+
+    /// <summary>
+    /// Returns the object for `key`, creating it with `create` if there is none yet. The lock isn't held while
+    /// creating, so that different objects can be created concurrently
+    /// </summary>
+    template <typename Create> T &GetOrCreate(const StateKey &key, Create &&create)
+    {
+        {
+            std::unique_lock lock(m_Mutex);
+            auto existing = m_Objects.find(key.Get());
+            if (existing != m_Objects.end())
+            {
+                m_Statistics.Hits++;
+                return *existing->second;
+            }
+            m_Statistics.Misses++;
+        }
+        auto created = std::make_unique<T>(create());
+        std::unique_lock lock(m_Mutex);
+        // Another thread may have created the same object in the meantime, in which case ours is dropped
+        auto [entry, inserted] = m_Objects.try_emplace(key.Get(), std::move(created));
+        return *entry->second;
+    }
+
+    ObjectCacheStatistics GetStatistics() const
+    {
+        std::unique_lock lock(m_Mutex);
+        return m_Statistics;
+    }
+
+    void Clear()
+    {
+        std::unique_lock lock(m_Mutex);
+        m_Objects.clear();
+    }
+
+  private:
+    mutable std::mutex m_Mutex;
+    std::unordered_map<std::string, std::unique_ptr<T>> m_Objects;
+    ObjectCacheStatistics m_Statistics;
+};
+
+inline void ReportCacheStatistics(std::ostream &stream, std::string_view name, const ObjectCacheStatistics &statistics)
+{
+    stream << name << ": " << statistics.Hits << " hits, " << statistics.Misses << " misses ("
+           << statistics.HitRate() * 100.0 << "% hit rate)\n";
+}
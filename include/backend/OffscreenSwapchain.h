@@ -0,0 +1,61 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "Queue.h"
+#include "RenderingInfo.h"
+#include "Texture.h"
+#include "Viewport.h"
+
+class PhysicalDevice;
+class Semaphore;
+
+struct OffscreenSwapchainCreateInfo
+{
+    uint32_t Width = 800;
+    uint32_t Height = 600;
+    // Images are used round robin like the images of a swapchain
+    uint32_t ImageCount = 3;
+    VkFormat Format = VK_FORMAT_B8G8R8A8_SRGB;
+};
+
+/// <summary>
+/// Stands in for the swapchain when rendering headless, e.g. on machines without a display. Frames render into a
+/// ring of color textures, and acquiring and presenting signal and wait on the same semaphores a swapchain would,
+/// so that the frame loop doesn't need to know whether it renders to a window
+/// </summary>
+class OffscreenSwapchain
+{
+  public:
+    OffscreenSwapchain(VkDevice device, const PhysicalDevice &physicalDevice,
+                       const OffscreenSwapchainCreateInfo &createInfo, Queue queue);
+    OffscreenSwapchain(const OffscreenSwapchain &) = delete;
+    OffscreenSwapchain(OffscreenSwapchain &&) = default;
+
+    Viewport GetViewportDescription() const;
+    VkFormat GetFormat() const;
+    const Texture &GetCurrentTexture() const;
+    uint32_t CurrentIndex() const;
+
+    /// <summary>
+    /// Advances to the next image and signals `toSignal` through an empty submission, as the image is available
+    /// right away
+    /// </summary>
+    void AcquireNext(const Semaphore &toSignal);
+    /// <summary>
+    /// Waits on `waitSemaphores` through an empty submission, so they can be signaled again by the next frame
+    /// </summary>
+    void Present(std::span<Semaphore> waitSemaphores);
+
+  private:
+    void Submit(const VkSubmitInfo &submitInfo) const;
+
+    OffscreenSwapchainCreateInfo m_CreateInfo;
+    Queue m_Queue;
+    std::vector<Texture> m_Images;
+    uint32_t m_CurrentImageIndex = 0;
+    bool m_Acquired = false;
+};
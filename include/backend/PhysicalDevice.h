@@ -29,11 +29,33 @@ class PhysicalDevice
 
     const QueueFamilyIndices& GetQueueFamilies() const;
     bool IsValid() const;
+    // Software implementations such as lavapipe, which are only considered when rendering headless
+    bool IsCpu() const;
     const VkPhysicalDeviceProperties& GetProperties() const;
     const VkPhysicalDeviceFeatures& GetFeatures() const;
+    /// <summary>
+    /// The Vulkan 1.2 features, which are all reported as unsupported if the device doesn't support 1.2
+    /// </summary>
+    const VkPhysicalDeviceVulkan12Features& GetVulkan12Features() const;
+    /// <summary>
+    /// The Vulkan 1.2 limits, which are all zero if the device doesn't support 1.2
+    /// </summary>
+    const VkPhysicalDeviceVulkan12Properties& GetVulkan12Properties() const;
+    /// <summary>
+    /// Whether `VK_KHR_synchronization2` is available and its feature supported
+    /// </summary>
+    bool SupportsSynchronization2() const;
+    /// <summary>
+    /// Whether `VK_KHR_dynamic_rendering` is available and its feature supported
+    /// </summary>
+    bool SupportsDynamicRendering() const;
+    /// <summary>
+    /// Whether the descriptor indexing features of a bindless texture table are supported
+    /// </summary>
+    bool SupportsBindless() const;
     std::vector<EDeviceExtension> FilterAvailableExtensions(std::span<const EDeviceExtension> desiredExtensions) const;
     VulkanDevice CreateLogicalDevice(const std::vector<const char*> &validationLayers,
-                                                 std::vector<EDeviceExtension> extensions, GLFWwindow &window,
+                                                 std::vector<EDeviceExtension> extensions, GLFWwindow *window,
                                                  const VulkanInstance &instance);
 
     // TODO: These are the cached values, but not neccessarily the latest. Need to requery this possibly
@@ -52,6 +74,10 @@ class PhysicalDevice
     QueueFamilyIndices FindQueueFamilies(std::optional<std::reference_wrapper<const VulkanSurface>> surface) const;
     VkPhysicalDeviceProperties QueryDeviceProperties() const;
     VkPhysicalDeviceFeatures QueryDeviceFeatures() const;
+    VkPhysicalDeviceVulkan12Features QueryVulkan12Features() const;
+    VkPhysicalDeviceVulkan12Properties QueryVulkan12Properties() const;
+    bool QuerySynchronization2Support() const;
+    bool QueryDynamicRenderingSupport() const;
     SurfaceProperties QuerySurfaceProperties(std::optional<std::reference_wrapper<const VulkanSurface>> surface) const;
 
     VkPhysicalDevice m_PhysicalDevice;
@@ -59,9 +85,13 @@ class PhysicalDevice
     QueueFamilyIndices m_QueueFamilies;
     VkPhysicalDeviceProperties m_Properties;
     VkPhysicalDeviceFeatures m_Features;
+    VkPhysicalDeviceVulkan12Features m_Vulkan12Features;
+    VkPhysicalDeviceVulkan12Properties m_Vulkan12Properties;
     VkPhysicalDeviceMemoryProperties m_MemoryProperties;
     SurfaceProperties m_SurfaceProperties;
     std::set<EDeviceExtension> m_AvailableExtensions;
+    bool m_SupportsSynchronization2;
+    bool m_SupportsDynamicRendering;
     std::optional<std::reference_wrapper<const VulkanSurface>> m_TargetSurface;
     bool m_Valid;
 };
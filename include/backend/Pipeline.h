@@ -2,12 +2,19 @@
 #include <vulkan/vulkan.h>
 
 #include <array>
+#include <future>
+#include <memory>
 #include <optional>
+#include <vector>
 
 #include "ShaderModule.h"
 #include "RenderPass.h"
 #include "UniformBuffer.h"
 #include "DescriptorSetBuilder.h"
+#include "PushConstants.h"
+#include "PipelineLayout.h"
+#include "ObjectCache.h"
+#include "SpecializationConstants.h"
 
 struct Viewport;
 class VulkanDevice;
@@ -16,8 +23,10 @@ class UniformBuffer;
 struct PipelineCreateInfo
 {
     VkGraphicsPipelineCreateInfo CreateInfo{};
-    std::vector<VkDescriptorSetLayout> Descriptors;
-    const RenderPass &RenderPass;
+    const PipelineLayout &Layout;
+    // Created for dynamic rendering when it has no render pass
+    const RenderingLayout &Rendering;
+    VkPipelineCache PipelineCache = VK_NULL_HANDLE;
 };
 
 class RasterPipeline
@@ -33,20 +42,58 @@ class RasterPipeline
     RasterPipeline &operator=(ShaderModule &&) = delete;
     
     VkPipelineLayout GetPipelineLayout() const;
-    void Bind(const VkCommandBuffer &commandBuffer, const Viewport& viewport) const;
+    VkPipeline Get() const;
+    const std::vector<VkPushConstantRange> &GetPushConstantRanges() const;
   private:
     VkDevice m_VulkanDevice;
-    VkPipelineLayout m_PipelineLayout;
+    // Owned by the device, as it's shared between pipelines
+    const PipelineLayout &m_Layout;
     VkPipeline m_Pipeline;
 };
 
+/// <summary>
+/// A pipeline that is compiled in the background. Copies refer to the same pipeline, which is owned by the device
+/// </summary>
+class PendingRasterPipeline
+{
+  public:
+    explicit PendingRasterPipeline(std::shared_future<const RasterPipeline *> pipeline);
+
+    bool IsReady() const;
+    /// <summary>
+    /// The pipeline if it finished compiling, or null so that draws using it can be skipped or use a
+    /// fallback. Rethrows the error if compilation failed
+    /// </summary>
+    const RasterPipeline *TryGet() const;
+    /// <summary>
+    /// Blocks until the pipeline finished compiling
+    /// </summary>
+    const RasterPipeline &Wait() const;
+    /// <summary>
+    /// Blocks until the compilation finished or failed, without rethrowing, e.g. before destroying what it uses
+    /// </summary>
+    void WaitForCompletion() const;
+  private:
+    std::shared_future<const RasterPipeline *> m_Pipeline;
+};
+
 struct VertexBindingDescription 
 {
     VkVertexInputBindingDescription Description;
-    std::array<VkVertexInputAttributeDescription, 3> AttributeDescriptions; 
+    std::vector<VkVertexInputAttributeDescription> AttributeDescriptions; 
+};
 
+/// <summary>
+/// The bindings and attributes of all vertex streams of a pipeline, flattened so that they
+/// can be referred to by a `VkPipelineVertexInputStateCreateInfo`
+/// </summary>
+struct VertexInputState
+{
+    std::vector<VkVertexInputBindingDescription> Bindings;
+    std::vector<VkVertexInputAttributeDescription> Attributes;
+
+    // Only valid for as long as this `VertexInputState` is alive and unmodified
     VkPipelineVertexInputStateCreateInfo GetVkPipelineInputStateCreateInfo() const;
-    static VkPipelineVertexInputStateCreateInfo DefaultPipelineInputStateCreateInfo();
 };
 
 class RasterPipelineBuilder
@@ -54,15 +101,51 @@ class RasterPipelineBuilder
   public:
     RasterPipelineBuilder(std::filesystem::path &&vertexShaderPath, std::filesystem::path &&fragmentShaderPath);
 
+    /// <summary>
+    /// Replaces all vertex bindings with this single binding
+    /// </summary>
     RasterPipelineBuilder& SetVertexBindingDescription(const VertexBindingDescription& vertexBinding);
+    /// <summary>
+    /// Adds another vertex stream, e.g. a per-instance stream with `VK_VERTEX_INPUT_RATE_INSTANCE`
+    /// </summary>
+    RasterPipelineBuilder& AddVertexBindingDescription(const VertexBindingDescription& vertexBinding);
     RasterPipelineBuilder& SetDescriptorSetLayout(const DescriptorSetLayout& descriptorSet);
-    const std::optional<VertexBindingDescription>& GetVertexBindingDescription() const;
+    /// <summary>
+    /// Adds a push constant range of `T` at byte `Offset`, visible to `stages`. The layout of `T` has to
+    /// match the push_constant block of the shaders, starting at `Offset`
+    /// </summary>
+    template <typename T, uint32_t Offset = 0> RasterPipelineBuilder &AddPushConstantRange(VkShaderStageFlags stages)
+    {
+        ValidatePushConstantType<T, Offset>();
+        return AddPushConstantRange(VkPushConstantRange{stages, Offset, static_cast<uint32_t>(sizeof(T))});
+    }
+    /// <summary>
+    /// Compiles `stage` (vertex or fragment) with `constants`, replacing any set before. Pipelines with different
+    /// values are different pipelines
+    /// </summary>
+    RasterPipelineBuilder& SetSpecializationConstants(VkShaderStageFlagBits stage, SpecializationConstants constants);
+    const std::vector<VertexBindingDescription>& GetVertexBindingDescriptions() const;
+    VertexInputState GetVertexInputState() const;
     const std::filesystem::path& GetVertexShaderPath() const;
     const std::filesystem::path& GetFragmentShaderPath() const;
     std::optional<std::reference_wrapper<const DescriptorSetLayout>> GetDescriptorSetLayout() const;
+    const std::vector<VkPushConstantRange>& GetPushConstantRanges() const;
+    const std::optional<SpecializationConstants>& GetSpecializationConstants(VkShaderStageFlagBits stage) const;
+    /// <summary>
+    /// Describes the complete state of a pipeline created from this builder with `createInfo` for `rendering`,
+    /// for sharing identical pipelines. Pipelines for compatible render passes share the same key, as do
+    /// dynamic rendering pipelines for the same attachment formats
+    /// </summary>
+    StateKey GetStateKey(const VkGraphicsPipelineCreateInfo &createInfo, const PipelineLayout &layout,
+                         const RenderingLayout &rendering) const;
   private:
+    RasterPipelineBuilder& AddPushConstantRange(VkPushConstantRange range);
+
     std::filesystem::path m_VertexShaderPath;
     std::filesystem::path m_FragmentShaderPath;
-    std::optional<VertexBindingDescription> m_VertexBindingDescription;
+    std::vector<VertexBindingDescription> m_VertexBindingDescriptions;
     std::optional<std::reference_wrapper<const DescriptorSetLayout>> m_DescriptorSetLayout;
+    std::vector<VkPushConstantRange> m_PushConstantRanges;
+    std::optional<SpecializationConstants> m_VertexSpecialization;
+    std::optional<SpecializationConstants> m_FragmentSpecialization;
 };
@@ -0,0 +1,58 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+class PhysicalDevice;
+
+struct PipelineCacheStatistics
+{
+    // Whether the cache was populated from disk, i.e. whether pipelines were created warm
+    bool LoadedFromDisk = false;
+    uint32_t PipelineCount = 0;
+    std::chrono::duration<double, std::milli> CreationTime{0};
+};
+
+/// <summary>
+/// A `VkPipelineCache` that is persisted to disk, so that pipelines don't have to be compiled from SPIR-V
+/// again on every launch. The file is only used if it was written for the same driver and device
+/// </summary>
+class PipelineCache
+{
+  public:
+    PipelineCache(VkDevice device, const PhysicalDevice &physicalDevice, std::filesystem::path path);
+    PipelineCache(const PipelineCache &) = delete;
+    PipelineCache(PipelineCache &&other);
+    ~PipelineCache();
+
+    PipelineCache &operator=(const PipelineCache &) = delete;
+    PipelineCache &operator=(PipelineCache &&) = delete;
+
+    VkPipelineCache Get() const;
+    /// <summary>
+    /// Writes the cache to a temporary file first and then replaces the previous file, so that an interrupted
+    /// save never leaves a truncated cache behind
+    /// </summary>
+    void Save() const;
+    /// <summary>
+    /// Adds the time it took to create a pipeline using this cache. Safe to call from multiple threads
+    /// </summary>
+    void RecordCreation(std::chrono::duration<double, std::milli> creationTime);
+    PipelineCacheStatistics GetStatistics() const;
+    void Report(std::ostream &stream) const;
+
+  private:
+    std::vector<char> LoadValidatedData(const PhysicalDevice &physicalDevice) const;
+
+    VkDevice m_Device;
+    VkPipelineCache m_PipelineCache = VK_NULL_HANDLE;
+    std::filesystem::path m_Path;
+    // Pipelines may be created on multiple threads. The cache itself is internally synchronized
+    mutable std::mutex m_StatisticsMutex;
+    PipelineCacheStatistics m_Statistics;
+};
@@ -0,0 +1,41 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// <summary>
+/// A pool of worker threads that pipelines are compiled on, so that compiling many pipelines is
+/// spread over all cores and doesn't stall the thread recording frames
+/// </summary>
+class PipelineCompiler
+{
+  public:
+    /// <summary>
+    /// Starts `workerCount` threads, or one less than the number of cores if 0
+    /// </summary>
+    explicit PipelineCompiler(uint32_t workerCount = 0);
+    PipelineCompiler(const PipelineCompiler &) = delete;
+    PipelineCompiler(PipelineCompiler &&) = delete;
+    /// <summary>
+    /// Waits for the compilations in progress. Compilations that haven't started yet are dropped
+    /// </summary>
+    ~PipelineCompiler();
+
+    PipelineCompiler &operator=(const PipelineCompiler &) = delete;
+    PipelineCompiler &operator=(PipelineCompiler &&) = delete;
+
+    void Enqueue(std::function<void()> task);
+
+  private:
+    void RunWorker();
+
+    std::mutex m_Mutex;
+    std::condition_variable m_TaskAvailable;
+    std::deque<std::function<void()>> m_Tasks;
+    bool m_Stopping = false;
+    std::vector<std::thread> m_Workers;
+};
@@ -0,0 +1,31 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include <span>
+#include <vector>
+
+/// <summary>
+/// The descriptor set layouts and push constant ranges of a pipeline. Shared by all pipelines with the same
+/// interface, see `VulkanDevice::CreatePipelineLayout`
+/// </summary>
+class PipelineLayout
+{
+  public:
+    PipelineLayout(VkDevice device, std::span<const VkDescriptorSetLayout> descriptorSetLayouts,
+                   std::span<const VkPushConstantRange> pushConstantRanges);
+    PipelineLayout(const PipelineLayout &) = delete;
+    PipelineLayout(PipelineLayout &&other);
+    ~PipelineLayout();
+
+    PipelineLayout &operator=(const PipelineLayout &) = delete;
+    PipelineLayout &operator=(PipelineLayout &&) = delete;
+
+    VkPipelineLayout Get() const;
+    const std::vector<VkPushConstantRange> &GetPushConstantRanges() const;
+
+  private:
+    VkDevice m_Device;
+    VkPipelineLayout m_PipelineLayout = VK_NULL_HANDLE;
+    // For validation of push constant updates only
+    std::vector<VkPushConstantRange> m_PushConstantRanges;
+};
@@ -0,0 +1,30 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <span>
+#include <type_traits>
+
+// The minimum maxPushConstantsSize that every implementation supports
+constexpr uint32_t GuaranteedPushConstantsSize = 128;
+
+/// <summary>
+/// Compile time validation of a struct used as (part of) a push constant range at `Offset`
+/// </summary>
+template <typename T, uint32_t Offset> constexpr void ValidatePushConstantType()
+{
+    static_assert(std::is_trivially_copyable_v<T>, "Push constants are copied byte-wise, so must be trivially copyable");
+    static_assert(std::is_standard_layout_v<T>, "Push constants need a predictable layout to match the shader block");
+    static_assert(Offset % 4 == 0, "Push constant offset must be a multiple of 4");
+    static_assert(sizeof(T) % 4 == 0, "Push constant size must be a multiple of 4");
+    static_assert(Offset + sizeof(T) <= GuaranteedPushConstantsSize,
+                  "Push constant range exceeds the size that is guaranteed to be supported");
+}
+
+/// <summary>
+/// Whether an update of `size` bytes at `offset` for `stages` is allowed by the ranges of a layout:
+/// every stage needs a range covering the full update, and every range overlapping the update needs
+/// all of its stages included
+/// </summary>
+bool IsValidPushConstantUpdate(std::span<const VkPushConstantRange> ranges, VkShaderStageFlags stages,
+                               uint32_t offset, uint32_t size);
@@ -0,0 +1,270 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "ResourceState.h"
+#include "RenderPass.h"
+#include "RenderingInfo.h"
+#include "Framebuffer.h"
+#include "Texture.h"
+#include "DeferredDeletionQueue.h"
+
+class CommandBuffer;
+class CommandBufferPool;
+class RenderPassScope;
+class DeviceBuffer;
+class PhysicalDevice;
+
+struct RenderGraphTexture
+{
+    uint32_t Index;
+};
+
+struct RenderGraphBuffer
+{
+    uint32_t Index;
+};
+
+/// <summary>
+/// A texture that only lives within the graph. Its usage is derived from the accesses of the passes
+/// </summary>
+struct RenderGraphTextureCreateInfo
+{
+    uint32_t Width;
+    uint32_t Height;
+    VkFormat Format;
+};
+
+/// <summary>
+/// A texture that outlives the graph, but whose contents only last for one execution and that may be a different
+/// texture every time the graph executes, e.g. the acquired swapchain image
+/// </summary>
+struct RenderGraphFrameTexture
+{
+    VkFormat Format;
+    // Resolved every time the graph executes
+    std::function<const Texture &()> GetCurrent;
+    // Changes whenever the textures `GetCurrent` returns were recreated, so that framebuffers of the old ones are
+    // released
+    std::function<uint64_t()> GetGeneration;
+    // The last access before the graph executes, which the first pass using the texture waits for, e.g.
+    // `ColorAttachmentWrite` for a swapchain image whose acquire semaphore is waited on at that stage
+    EResourceAccess PreviousAccess;
+};
+
+enum class EAttachmentLoad
+{
+    Clear,
+    // Keeps the contents written by an earlier pass, which makes this pass depend on it
+    Load,
+    DontCare
+};
+
+struct RenderGraphStatistics
+{
+    uint32_t PassCount = 0;
+    uint32_t CulledPassCount = 0;
+    // Memory of all transient textures, with and without aliasing
+    VkDeviceSize TransientMemorySize = 0;
+    VkDeviceSize UnaliasedMemorySize = 0;
+};
+
+/// <summary>
+/// A pass of a `RenderGraph`, which declares every resource it accesses so that the graph can derive
+/// the dependencies between passes and the barriers in between them
+/// </summary>
+class RenderGraphPass
+{
+  public:
+    RenderGraphPass(std::string name, std::function<void(CommandBuffer &)> execute);
+    RenderGraphPass(std::string name, std::function<void(RenderPassScope &)> execute);
+
+    RenderGraphPass &Read(RenderGraphTexture texture, EResourceAccess access);
+    RenderGraphPass &Read(RenderGraphBuffer buffer, EResourceAccess access);
+    RenderGraphPass &Write(RenderGraphTexture texture, EResourceAccess access);
+    RenderGraphPass &Write(RenderGraphBuffer buffer, EResourceAccess access);
+    /// <summary>
+    /// Renders to `texture` as the next color attachment. Only valid for raster passes
+    /// </summary>
+    RenderGraphPass &WriteColor(RenderGraphTexture texture, EAttachmentLoad load = EAttachmentLoad::Clear);
+    RenderGraphPass &WriteDepth(RenderGraphTexture texture, EAttachmentLoad load = EAttachmentLoad::Clear);
+    /// <summary>
+    /// Keeps the pass even if nothing in the graph uses its results, e.g. because it renders to the swapchain
+    /// </summary>
+    RenderGraphPass &SetSideEffects();
+
+    const std::string &GetName() const;
+    bool IsRaster() const;
+    /// <summary>
+    /// The render pass of the pass. Only valid for raster passes of a compiled graph that doesn't use dynamic rendering
+    /// </summary>
+    const RenderPass &GetRenderPass() const;
+    /// <summary>
+    /// The layout to create pipelines for, which refers to the render pass unless the graph uses dynamic rendering.
+    /// Only valid for raster passes of a compiled graph
+    /// </summary>
+    const RenderingLayout &GetRenderingLayout() const;
+
+  private:
+    friend class RenderGraph;
+
+    struct ResourceAccess
+    {
+        uint32_t Resource;
+        bool IsTexture;
+        EResourceAccess Access;
+        bool Write;
+    };
+
+    struct Attachment
+    {
+        RenderGraphTexture Texture;
+        EAttachmentLoad Load;
+    };
+
+    struct FrameFramebuffer
+    {
+        // Of the frame textures among the attachments
+        std::vector<uint64_t> Generations;
+        std::vector<VkImageView> Views;
+        std::unique_ptr<Framebuffer> Framebuffer;
+    };
+
+    std::string m_Name;
+    std::function<void(CommandBuffer &)> m_Execute;
+    std::function<void(RenderPassScope &)> m_ExecuteRaster;
+    std::vector<ResourceAccess> m_Accesses;
+    std::vector<Attachment> m_ColorAttachments;
+    std::optional<Attachment> m_DepthAttachment;
+    bool m_SideEffects = false;
+
+    // Set by `RenderGraph::Compile`
+    std::unique_ptr<RenderPass> m_RenderPass;
+    std::unique_ptr<Framebuffer> m_Framebuffer;
+    RenderingLayout m_RenderingLayout;
+    // Instead of `m_Framebuffer` when rendering to frame textures, one per combination of their images
+    std::vector<FrameFramebuffer> m_FrameFramebuffers;
+};
+
+/// <summary>
+/// Describes a frame as passes and the resources they access. Compiling the graph culls passes whose
+/// results are never used, creates the render passes and transient textures, and places transient textures
+/// whose lifetimes don't overlap in the same memory. Executing it records all passes with the barriers and
+/// layout transitions between them.
+/// Passes run in the order they were added, which always satisfies the dependencies since a pass can only
+/// depend on the passes added before it. Raster passes render with dynamic rendering if `dynamicRendering` is set,
+/// and through render passes and framebuffers otherwise.
+/// </summary>
+class RenderGraph
+{
+  public:
+    /// <summary>
+    /// Framebuffers of frame textures that were recreated, e.g. with the swapchain, are destroyed once the work
+    /// submitted to `commandBufferPool` up to then finished
+    /// </summary>
+    RenderGraph(VkDevice device, const PhysicalDevice &physicalDevice, CommandBufferPool &commandBufferPool,
+                bool dynamicRendering);
+    RenderGraph(const RenderGraph &) = delete;
+    RenderGraph(RenderGraph &&other);
+    ~RenderGraph();
+
+    RenderGraphTexture CreateTexture(const std::string &name, const RenderGraphTextureCreateInfo &createInfo);
+    /// <summary>
+    /// Uses a texture that outlives the graph. Passes writing it are never culled
+    /// </summary>
+    RenderGraphTexture ImportTexture(const Texture &texture);
+    /// <summary>
+    /// Uses a texture that changes between executions, see `RenderGraphFrameTexture`. Passes writing it are never
+    /// culled
+    /// </summary>
+    RenderGraphTexture ImportFrameTexture(RenderGraphFrameTexture texture);
+    RenderGraphBuffer ImportBuffer(const DeviceBuffer &buffer);
+    RenderGraphPass &AddPass(std::string name, std::function<void(CommandBuffer &)> execute);
+    RenderGraphPass &AddRasterPass(std::string name, std::function<void(RenderPassScope &)> execute);
+
+    /// <summary>
+    /// (Re)creates all render passes and transient textures. Only call this while none of the command
+    /// buffers the graph was executed in are in flight
+    /// </summary>
+    void Compile();
+    /// <summary>
+    /// Records all passes that weren't culled into `commandBuffer`, which has to be recording
+    /// </summary>
+    void Execute(CommandBuffer &commandBuffer);
+    /// <summary>
+    /// The texture behind a handle. Transient textures only exist once the graph is compiled
+    /// </summary>
+    const Texture &GetTexture(RenderGraphTexture texture) const;
+    const RenderGraphStatistics &GetStatistics() const;
+
+  private:
+    struct TextureResource
+    {
+        std::string Name;
+        const Texture *Imported = nullptr;
+        // Only used for the format of frame textures
+        RenderGraphTextureCreateInfo CreateInfo{};
+        // Frame textures only
+        std::function<const Texture &()> GetCurrent;
+        std::function<uint64_t()> GetGeneration;
+        std::optional<EResourceAccess> PreviousAccess;
+        std::unique_ptr<Texture> Transient;
+        // Execution order indices of the first and last pass using the texture
+        std::optional<uint32_t> FirstUse;
+        uint32_t LastUse = 0;
+        VkImageUsageFlags Usage = 0;
+        // Transient textures whose memory overlaps, including the texture itself. Any of them may have used the
+        // memory last, earlier in the frame or in an earlier frame
+        std::vector<uint32_t> PreviousOccupants;
+
+        bool IsImported() const
+        {
+            return Imported != nullptr || GetCurrent != nullptr;
+        }
+    };
+
+    struct ResourceUse
+    {
+        uint32_t Resource;
+        bool IsTexture;
+        // Whether the pass depends on the previous contents
+        bool Reads;
+        bool Writes;
+    };
+
+    /// <summary>
+    /// All resources `pass` accesses, with attachments and multiple accesses of the same resource merged
+    /// </summary>
+    static std::vector<ResourceUse> GetUses(const RenderGraphPass &pass);
+    std::vector<bool> CullPasses() const;
+    void CreateTransientTextures();
+    void CreateRenderPass(RenderGraphPass &pass, uint32_t executionIndex);
+    const Framebuffer &GetFramebuffer(RenderGraphPass &pass);
+    RenderingInfo GetRenderingInfo(const RenderGraphPass &pass, uint32_t executionIndex) const;
+    std::vector<VkImageView> GetViews(const RenderGraphPass &pass) const;
+    Viewport GetViewport(const RenderGraphPass &pass) const;
+    VkFormat GetFormat(RenderGraphTexture texture) const;
+    bool IsReadAfter(RenderGraphTexture texture, uint32_t executionIndex) const;
+    // Whether the pass at `executionIndex` has to store its writes to `texture`
+    bool KeepsContents(RenderGraphTexture texture, uint32_t executionIndex) const;
+    void Reset();
+
+    VkDevice m_Device;
+    const PhysicalDevice &m_PhysicalDevice;
+    CommandBufferPool &m_CommandBufferPool;
+    bool m_DynamicRendering;
+    std::vector<std::unique_ptr<RenderGraphPass>> m_Passes;
+    std::vector<TextureResource> m_Textures;
+    std::vector<const DeviceBuffer *> m_Buffers;
+    // Indices into `m_Passes` of the passes that weren't culled, in execution order
+    std::vector<uint32_t> m_ExecutionOrder;
+    VkDeviceMemory m_TransientMemory = VK_NULL_HANDLE;
+    RenderGraphStatistics m_Statistics;
+    DeferredDeletionQueue m_RetiredFramebuffers;
+};
@@ -2,14 +2,20 @@
 #include <vulkan/vulkan.h>
 
 #include <functional>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "RenderingInfo.h"
 
 class DepthAttachment;
 
 struct RenderPassCreateInfo
 {
     // TODO: Abstract to attachment, encode with width/height
-    VkAttachmentDescription SwapchainAttachmentDescription;
-    VkAttachmentDescription DepthAttachment;
+    // Attachment indices in the framebuffer are the color attachments in order, followed by the depth attachment
+    std::vector<VkAttachmentDescription> ColorAttachments;
+    std::optional<VkAttachmentDescription> DepthAttachment;
 };
 
 class RenderPass
@@ -21,7 +27,23 @@ class RenderPass
     RenderPass(RenderPass && other);
 
     VkRenderPass Get() const;
+    /// <summary>
+    /// The values attachments are cleared to when beginning the pass, one per attachment
+    /// </summary>
+    std::span<const VkClearValue> GetClearValues() const;
+    /// <summary>
+    /// The color attachments followed by the depth attachment, if any
+    /// </summary>
+    std::span<const VkAttachmentDescription> GetAttachments() const;
+    uint32_t GetColorAttachmentCount() const;
+    /// <summary>
+    /// The attachment formats, for creating pipelines used in this render pass
+    /// </summary>
+    RenderingLayout GetRenderingLayout() const;
   private:
     VkDevice m_Device;
     VkRenderPass m_RenderPass;
+    std::vector<VkAttachmentDescription> m_Attachments;
+    uint32_t m_ColorAttachmentCount;
+    std::vector<VkClearValue> m_ClearValues;
 };
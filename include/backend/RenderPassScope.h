@@ -0,0 +1,108 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <span>
+
+#include "Viewport.h"
+#include "PushConstants.h"
+#include "RenderingInfo.h"
+
+class CommandBuffer;
+class Framebuffer;
+class RenderPass;
+class RasterPipeline;
+class VertexBuffer;
+class IndexBuffer;
+class DeviceBuffer;
+class BindSet;
+class DescriptorSet;
+class BindlessTextureTable;
+
+struct DrawParameters
+{
+    uint32_t VertexCount;
+    uint32_t InstanceCount = 1;
+    uint32_t FirstVertex = 0;
+    uint32_t FirstInstance = 0;
+};
+
+struct DrawIndexedParameters
+{
+    uint32_t IndexCount;
+    uint32_t InstanceCount = 1;
+    uint32_t FirstIndex = 0;
+    int32_t VertexOffset = 0;
+    uint32_t FirstInstance = 0;
+};
+
+/// <summary>
+/// Keeps a render pass instance open for as long as the scope is alive, so that any
+/// number of binds and draws can share a single vkCmdBeginRenderPass/vkCmdEndRenderPass,
+/// or vkCmdBeginRenderingKHR/vkCmdEndRenderingKHR with dynamic rendering.
+/// </summary>
+class RenderPassScope
+{
+  public:
+    RenderPassScope(CommandBuffer &commandBuffer, const Framebuffer &framebuffer, const RenderPass &renderPass);
+    RenderPassScope(CommandBuffer &commandBuffer, const RenderingInfo &renderingInfo);
+    RenderPassScope(const RenderPassScope &) = delete;
+    RenderPassScope(RenderPassScope &&other);
+    ~RenderPassScope();
+
+    RenderPassScope &operator=(const RenderPassScope &) = delete;
+    RenderPassScope &operator=(RenderPassScope &&other) = delete;
+
+    RenderPassScope &BindPipeline(const RasterPipeline &pipeline);
+    RenderPassScope &BindVertexBuffer(VertexBuffer &vertexBuffer, uint32_t binding = 0);
+    RenderPassScope &BindIndexBuffer(IndexBuffer &indexBuffer);
+    /// <summary>
+    /// Binds the descriptor set against the layout of the most recently bound pipeline, with one offset per
+    /// dynamic binding in binding order
+    /// </summary>
+    RenderPassScope &BindDescriptorSet(BindSet &&bindSet, std::span<const uint32_t> dynamicOffsets = {});
+    /// <summary>
+    /// Binds a set that was already bound through a `BindSet` in this pass again with other dynamic offsets, e.g.
+    /// for the next draw's slice of a `DynamicUniformBuffer`. Needs no descriptor writes nor barriers
+    /// </summary>
+    RenderPassScope &BindDescriptorSet(const DescriptorSet &descriptorSet, std::span<const uint32_t> dynamicOffsets);
+    /// <summary>
+    /// Binds the texture table at `BindlessSetIndex` against the layout of the most recently bound pipeline.
+    /// The table's textures are not tracked, so their accesses have to be declared before the pass begins
+    /// </summary>
+    RenderPassScope &BindBindlessTextures(const BindlessTextureTable &table);
+    /// <summary>
+    /// Pushes constants against the layout of the most recently bound pipeline
+    /// </summary>
+    template <typename T, uint32_t Offset = 0> RenderPassScope &PushConstants(VkShaderStageFlags stages, const T &data)
+    {
+        ValidatePushConstantType<T, Offset>();
+        return PushConstantsInternal(stages, Offset, static_cast<uint32_t>(sizeof(T)), &data);
+    }
+    void Draw(const DrawParameters &parameters);
+    void DrawIndexed(const DrawIndexedParameters &parameters);
+    /// <summary>
+    /// Draws `instanceCount` instances of the bound index buffer in a single call, where per-instance
+    /// data comes from vertex bindings with `VK_VERTEX_INPUT_RATE_INSTANCE`
+    /// </summary>
+    void DrawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount, uint32_t firstInstance = 0);
+    /// <summary>
+    /// Draws `drawCount` tightly packed `VkDrawIndexedIndirectCommand`s from the argument buffer, starting
+    /// at command `firstDraw`. Requires the multiDrawIndirect feature for a `drawCount` larger than 1
+    /// </summary>
+    void DrawIndexedIndirect(const DeviceBuffer &arguments, uint32_t drawCount, uint32_t firstDraw = 0);
+    /// <summary>
+    /// Like `DrawIndexedIndirect`, but the number of draws is read from the first uint32 in `count`,
+    /// clamped to `maxDrawCount`. Requires the drawIndirectCount feature
+    /// </summary>
+    void DrawIndexedIndirectCount(const DeviceBuffer &arguments, const DeviceBuffer &count, uint32_t maxDrawCount);
+    const Viewport &GetViewport() const;
+
+  private:
+    RenderPassScope &PushConstantsInternal(VkShaderStageFlags stages, uint32_t offset, uint32_t size, const void *data);
+
+    // Null once moved from, in which case the destructor won't end the pass
+    CommandBuffer *m_CommandBuffer;
+    Viewport m_Viewport;
+    const RasterPipeline *m_BoundPipeline = nullptr;
+};
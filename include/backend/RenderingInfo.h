@@ -0,0 +1,49 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include <optional>
+#include <vector>
+
+#include "Viewport.h"
+
+class RenderPass;
+
+/// <summary>
+/// The formats of the attachments a pipeline renders to. With dynamic rendering this is all a pipeline needs
+/// to know about them, so pipelines are compatible with any attachments of these formats
+/// </summary>
+struct RenderingLayout
+{
+    std::vector<VkFormat> ColorFormats;
+    VkFormat DepthFormat = VK_FORMAT_UNDEFINED;
+    VkSampleCountFlagBits Samples = VK_SAMPLE_COUNT_1_BIT;
+    // Set when rendering through this render pass, null when using dynamic rendering
+    const RenderPass *CompatibleRenderPass = nullptr;
+};
+
+/// <summary>
+/// An image view rendered to with dynamic rendering. Untracked attachments are always cleared, so their previous
+/// contents and layout are discarded
+/// </summary>
+struct RenderingAttachment
+{
+    VkImage Image;
+    VkImageView View;
+    VkImageAspectFlags AspectMask;
+    VkClearValue ClearValue{};
+    VkAttachmentStoreOp StoreOp = VK_ATTACHMENT_STORE_OP_STORE;
+    // The layout the image is left in when rendering ends, e.g. `VK_IMAGE_LAYOUT_PRESENT_SRC_KHR`
+    VkImageLayout FinalLayout;
+    // Set when the image was already transitioned to the attachment layout through `RequireAccess`, e.g. by a
+    // `RenderGraph`. No barriers are recorded around rendering then, the image stays in the attachment layout,
+    // and `LoadOp` may keep the previous contents
+    bool Tracked = false;
+    VkAttachmentLoadOp LoadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+};
+
+struct RenderingInfo
+{
+    std::vector<RenderingAttachment> ColorAttachments;
+    std::optional<RenderingAttachment> DepthAttachment;
+    Viewport Viewport;
+};
@@ -0,0 +1,141 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+/// <summary>
+/// The ways in which commands access a buffer or image. Each maps to the narrowest stages, access
+/// flags and (for images) layout that cover it, so that barriers only wait for what is actually used
+/// </summary>
+enum class EResourceAccess
+{
+    TransferRead,
+    TransferWrite,
+    VertexBufferRead,
+    IndexBufferRead,
+    IndirectBufferRead,
+    GraphicsUniformRead,
+    // Sampled or storage reads from the vertex and fragment shaders
+    GraphicsShaderRead,
+    // Storage image reads from the vertex and fragment shaders, which need the general layout
+    GraphicsStorageImageRead,
+    ComputeUniformRead,
+    ComputeShaderRead,
+    ComputeShaderReadWrite,
+    ColorAttachmentWrite,
+    DepthStencilAttachment,
+    Present
+};
+
+struct AccessInfo
+{
+    VkPipelineStageFlags2 Stages;
+    VkAccessFlags2 Access;
+    // Ignored for buffers
+    VkImageLayout Layout;
+    bool Write;
+};
+
+AccessInfo GetAccessInfo(EResourceAccess access);
+
+struct QueueOwnershipTransfer
+{
+    uint32_t SourceFamily;
+    uint32_t DestinationFamily;
+    // The acquire has to repeat the layout transition parameters of the release
+    VkImageLayout OldLayout;
+    VkImageLayout NewLayout;
+
+    bool operator==(const QueueOwnershipTransfer &other) const = default;
+};
+
+/// <summary>
+/// Synchronization state of a buffer or a single image subresource, as of the last access recorded
+/// </summary>
+struct ResourceState
+{
+    VkPipelineStageFlags2 WriteStages = 0;
+    VkAccessFlags2 WriteAccess = 0;
+    VkPipelineStageFlags2 ReadStages = 0;
+    // The stages and accesses that the last write has already been made visible to
+    VkPipelineStageFlags2 VisibleStages = 0;
+    VkAccessFlags2 VisibleAccess = 0;
+    VkImageLayout Layout = VkImageLayout::VK_IMAGE_LAYOUT_UNDEFINED;
+    // The command buffer recording that last accessed the resource. Accesses of an earlier recording are
+    // assumed to be synchronized through the semaphore or fence that orders the submissions
+    uint64_t RecordingId = 0;
+    // Set after a release to another queue family, until that family acquires the resource
+    std::optional<QueueOwnershipTransfer> PendingAcquire;
+};
+
+/// <summary>
+/// A barrier needed between the previously recorded accesses of a resource and a new one
+/// </summary>
+struct StateTransition
+{
+    VkPipelineStageFlags2 SourceStages;
+    VkAccessFlags2 SourceAccess;
+    VkPipelineStageFlags2 DestinationStages;
+    VkAccessFlags2 DestinationAccess;
+    VkImageLayout OldLayout;
+    VkImageLayout NewLayout;
+    std::optional<QueueOwnershipTransfer> OwnershipTransfer;
+
+    bool operator==(const StateTransition &other) const = default;
+};
+
+/// <summary>
+/// Updates `state` for `access` on `queueFamily` during recording `recordingId`, returning the barrier
+/// that has to precede the access. No barrier is needed for reads of data that is already visible, for
+/// the first access of a resource without a layout change, or for the first access in a new recording
+/// </summary>
+std::optional<StateTransition> TransitionState(ResourceState &state, EResourceAccess access, uint64_t recordingId,
+                                               uint32_t queueFamily, bool isImage);
+/// <summary>
+/// Releases the resource from `sourceFamily` to `destinationFamily`, transitioning images to `newLayout`
+/// (`VK_IMAGE_LAYOUT_UNDEFINED` for buffers). The matching acquire is emitted by the first access on the
+/// destination family
+/// </summary>
+StateTransition ReleaseState(ResourceState &state, VkImageLayout newLayout, uint64_t recordingId,
+                             uint32_t sourceFamily, uint32_t destinationFamily);
+/// <summary>
+/// Discards the contents of a resource whose memory was last used by the resources in `previousOccupants`,
+/// i.e. when aliasing memory. The next access in recording `recordingId` transitions from
+/// `VK_IMAGE_LAYOUT_UNDEFINED` and waits for the last accesses of all previous occupants, whichever recording
+/// they were in. These have to be on the same queue
+/// </summary>
+void DiscardState(ResourceState &state, std::span<const ResourceState *const> previousOccupants,
+                  uint64_t recordingId);
+/// <summary>
+/// Discards the contents of a resource that was last accessed with `previousAccess` outside of what is tracked, e.g.
+/// a swapchain image whose acquire semaphore is waited on at the color attachment stage. The next access in recording
+/// `recordingId` transitions from `VK_IMAGE_LAYOUT_UNDEFINED` and waits for that access
+/// </summary>
+void DiscardState(ResourceState &state, EResourceAccess previousAccess, uint64_t recordingId);
+
+/// <summary>
+/// Collects barriers so that all transitions before a command are recorded in a single call
+/// </summary>
+class BarrierBatch
+{
+  public:
+    void Add(VkBuffer buffer, const StateTransition &transition);
+    void Add(VkImage image, const VkImageSubresourceRange &range, const StateTransition &transition);
+    bool ContainsBuffer(VkBuffer buffer) const;
+    bool ContainsImage(VkImage image) const;
+    bool IsEmpty() const;
+    /// <summary>
+    /// Records all barriers and clears the batch. Uses `vkCmdPipelineBarrier2KHR` if `pipelineBarrier2` is set,
+    /// and otherwise a single legacy barrier with the union of all stages
+    /// </summary>
+    void Flush(VkCommandBuffer commandBuffer, PFN_vkCmdPipelineBarrier2KHR pipelineBarrier2);
+
+  private:
+    void FlushLegacy(VkCommandBuffer commandBuffer);
+
+    std::vector<VkBufferMemoryBarrier2> m_BufferBarriers;
+    std::vector<VkImageMemoryBarrier2> m_ImageBarriers;
+};
@@ -1,12 +1,16 @@
 #pragma once
 #include <filesystem>
+#include <vector>
 
 #include <vulkan/vulkan.h>
 
+#include "ShaderReflection.h"
+
 class ShaderModule
 {
   public:
     ShaderModule(const VkDevice& vkDevice, const std::vector<char>& bytes);
+    ShaderModule(const VkDevice& vkDevice, const std::vector<uint32_t>& code);
     ShaderModule(const ShaderModule &) = delete;
     ShaderModule(ShaderModule &&other);
     ~ShaderModule();
@@ -16,7 +20,12 @@ class ShaderModule
 
     static ShaderModule LoadFromDisk(const VkDevice& vkDevice, const std::filesystem::path &filename);
     const VkShaderModule &Get() const;
+    /// <summary>
+    /// The stage and resources of the module, read from the SPIR-V when loading it
+    /// </summary>
+    const ShaderReflection &GetReflection() const;
   private:
     const VkDevice &m_Device;
     VkShaderModule m_ShaderModule;
+    ShaderReflection m_Reflection;
 };
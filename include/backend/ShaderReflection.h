@@ -0,0 +1,49 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+struct ReflectedBinding
+{
+    uint32_t Set;
+    // `stageFlags` only contains the stages that actually use the binding
+    VkDescriptorSetLayoutBinding Binding;
+    // A storage buffer declared `readonly`
+    bool ReadOnly = false;
+};
+
+/// <summary>
+/// The resources a single SPIR-V module uses, as declared in the module itself
+/// </summary>
+struct ShaderReflection
+{
+    VkShaderStageFlagBits Stage;
+    std::vector<ReflectedBinding> Bindings;
+    std::optional<VkPushConstantRange> PushConstants;
+
+    /// <summary>
+    /// Reads the entry point, descriptor bindings and push constant block from `code`. Throws if `code`
+    /// isn't valid SPIR-V
+    /// </summary>
+    static ShaderReflection Reflect(std::span<const uint32_t> code);
+};
+
+/// <summary>
+/// The combined resource interface of all stages of a pipeline, from which its layouts can be derived
+/// </summary>
+struct PipelineInterface
+{
+    // Indexed by set, bindings sorted by binding index
+    std::vector<std::vector<VkDescriptorSetLayoutBinding>> Sets;
+    // Indexed by set, the storage buffers that none of the stages write
+    std::vector<std::vector<uint32_t>> ReadOnlyBindings;
+    std::vector<VkPushConstantRange> PushConstantRanges;
+
+    /// <summary>
+    /// Merges the bindings of `stages`, where the stage mask of each binding is the union of the stages using it
+    /// </summary>
+    static PipelineInterface Merge(std::span<const ShaderReflection> stages);
+};
@@ -0,0 +1,54 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <typeindex>
+#include <typeinfo>
+#include <vector>
+
+#include "ObjectCache.h"
+
+/// <summary>
+/// The values of the `layout(constant_id = ...)` constants of a shader stage, taken from a struct. Each member
+/// is assigned to its constant id with `Map`, so that the driver compiles the stage with the values folded in
+/// </summary>
+class SpecializationConstants
+{
+  public:
+    template <typename T> explicit SpecializationConstants(const T &values) : m_Type(typeid(T)), m_Data(sizeof(T))
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "Specialization data is copied byte-wise");
+        static_assert(std::is_standard_layout_v<T>, "Specialization data needs a predictable layout");
+        std::memcpy(m_Data.data(), &values, sizeof(T));
+    }
+
+    /// <summary>
+    /// Assigns `member` of the struct the constants were created from to `constantId`
+    /// </summary>
+    template <typename T, typename Member> SpecializationConstants &Map(uint32_t constantId, Member T::*member)
+    {
+        static_assert(std::is_arithmetic_v<Member> && (sizeof(Member) == 4 || sizeof(Member) == 8),
+                      "Specialization constants are 32 or 64 bit scalars, use VkBool32 for booleans");
+        assert(m_Type == std::type_index(typeid(T)) && "Member of a different struct than the values");
+        T probe{};
+        auto offset = reinterpret_cast<const char *>(&(probe.*member)) - reinterpret_cast<const char *>(&probe);
+        return Map(VkSpecializationMapEntry{constantId, static_cast<uint32_t>(offset), sizeof(Member)});
+    }
+
+    // Only valid for as long as these constants are alive and unmodified
+    VkSpecializationInfo GetInfo() const;
+    /// <summary>
+    /// Adds the ids and values to `key`, as different values result in a different pipeline
+    /// </summary>
+    void AddToKey(StateKey &key) const;
+  private:
+    SpecializationConstants &Map(VkSpecializationMapEntry entry);
+
+    std::type_index m_Type;
+    std::vector<VkSpecializationMapEntry> m_Entries;
+    std::vector<char> m_Data;
+};
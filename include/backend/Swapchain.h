@@ -5,14 +5,12 @@
 #include <optional>
 #include <memory>
 
-#include "Framebuffer.h"
 #include "Queue.h"
+#include "RenderingInfo.h"
+#include "Texture.h"
 
 class PhysicalDevice;
-class RenderPass;
 class Semaphore;
-class Swapchain;
-class DepthAttachment;
 
 struct SwapchainCreateInfo
 {
@@ -22,27 +20,22 @@ struct SwapchainCreateInfo
     uint32_t MinImageCount;
 };
 
-class SwapchainFramebuffer
+/// <summary>
+/// A swapchain that was replaced, with its image views. Kept alive until the frames that were rendered to it
+/// finished, as destroying it stalls otherwise
+/// </summary>
+class RetiredSwapchain
 {
   public:
-    SwapchainFramebuffer(const Swapchain& swapchain, std::vector<Framebuffer>&& swapchainFramebuffers, 
-        const RenderPass& renderPass, DepthAttachment* depthAttachment);
-    SwapchainFramebuffer(const SwapchainFramebuffer&) = delete;
-    SwapchainFramebuffer(SwapchainFramebuffer&&) = default;
-
-    SwapchainFramebuffer &operator=(const SwapchainFramebuffer &&other) = delete;
-    SwapchainFramebuffer &operator=(SwapchainFramebuffer &&other) = default;
-
-    const Framebuffer &GetCurrent() const;
-    const RenderPass &GetRenderPass() const;
-    DepthAttachment *GeDepthAttachment() const;
+    RetiredSwapchain(VkDevice device, VkSwapchainKHR swapchain, std::vector<VkImageView> &&imageViews);
+    RetiredSwapchain(const RetiredSwapchain &) = delete;
+    RetiredSwapchain(RetiredSwapchain &&other);
+    ~RetiredSwapchain();
 
   private:
-    DepthAttachment* m_DepthAttachment;
-    // TODO: Make this a weak ptr for validation reasons?
-    std::reference_wrapper<const Swapchain> m_Swapchain;
-    std::vector<Framebuffer> m_Framebuffers;
-    std::reference_wrapper<const RenderPass> m_Renderpass;
+    VkDevice m_Device;
+    VkSwapchainKHR m_Swapchain;
+    std::vector<VkImageView> m_ImageViews;
 };
 
 enum class SwapchainState
@@ -62,7 +55,8 @@ class Swapchain
 
     Viewport GetViewportDescription() const;
     VkAttachmentDescription AttachmentDescription() const;
-    SwapchainFramebuffer CreateFramebuffersFor(const RenderPass &renderPass, DepthAttachment* depthAttachment) const;
+    // The acquired image, e.g. for a `RenderGraph` to track its layout. Only valid until the swapchain is recreated
+    const Texture &GetCurrentTexture() const;
     uint32_t CurrentIndex() const;
     
     // Callers should check that the SwapchainState != SwapchainState::OutOfDate
@@ -71,7 +65,12 @@ class Swapchain
     // Callers should check that the SwapchainState != SwapchainState::OutOfDate
     [[nodiscard]] 
         SwapchainState Present(std::span<Semaphore> waitSemaphores);
-    void Recreate(std::vector<std::unique_ptr<SwapchainFramebuffer>> &oldFramebuffers, VkExtent2D newExtents);
+    /// <summary>
+    /// Creates a swapchain of `newExtents` that replaces this one, passing this one as the old swapchain so that
+    /// presentation can continue. The replaced swapchain is returned instead of destroyed, as frames in flight may
+    /// still use it
+    /// </summary>
+    [[nodiscard]] RetiredSwapchain Recreate(VkExtent2D newExtents);
     SwapchainState GetCurrentState() const;
   private:
     void Create(const SwapchainCreateInfo& createInfo, const VkSurfaceKHR& surface, VkDevice device, const PhysicalDevice& vulkanDevice, VkSwapchainKHR oldSwapchain);
@@ -85,6 +84,8 @@ class Swapchain
     SwapchainCreateInfo m_OriginalCreateInfo;
     std::vector<VkImage> m_Images;
     std::vector<VkImageView> m_ImageViews;
+    // Wrap `m_Images` without owning them
+    std::vector<Texture> m_Textures;
     uint32_t m_CurrentImageIndex = 0xFFFFFFFF;
     Queue m_TargetPresentQueue;
     SwapchainState m_State;
@@ -1,11 +1,16 @@
 #pragma once
 #include <span>
 #include <memory>
+#include <optional>
+#include <vector>
 
 #include <vulkan/vulkan.h>
 
 #include "Buffer.h"
 #include "Fence.h"
+#include "Queue.h"
+#include "ResourceState.h"
+#include "RenderingInfo.h"
 
 class PhysicalDevice;
 
@@ -23,13 +28,24 @@ struct TextureCreateInfo
     uint32_t Width;
     uint32_t Height;
     VkFormat Format;
-    VkImageUsageFlags Usage;
+    // Derived from the format if left 0
+    VkImageUsageFlags Usage = 0;
 };
 
 class Texture
 {
   public:
     Texture(VkDevice device, const PhysicalDevice& physicalDevice, const TextureCreateInfo& createInfo);
+    /// <summary>
+    /// Creates the image without any memory, which has to be bound with `BindMemory` before use.
+    /// Allows placing multiple textures in the same allocation, e.g. to alias them
+    /// </summary>
+    Texture(VkDevice device, const TextureCreateInfo& createInfo);
+    /// <summary>
+    /// Tracks the state of an image that is owned elsewhere, e.g. a swapchain image. Neither the image nor `view`
+    /// are destroyed along with the texture
+    /// </summary>
+    Texture(VkDevice device, VkImage image, VkImageView view, const TextureCreateInfo& createInfo);
     Texture(const Texture &) = delete;
     Texture(Texture &&other);
 
@@ -43,28 +59,41 @@ class Texture
     uint32_t GetWidth() const;
     uint32_t GetHeight() const;
     VkDescriptorImageInfo GetDescriptorInfo() const;
+    VkFormat GetFormat() const;
+    uint32_t GetMipLevels() const;
+    uint32_t GetArrayLayers() const;
     /// <summary>
-    /// Perform a transition layout and optionally perform a QFOT-release, returning the acquire.
+    /// The range covering all mip levels and array layers of the image
     /// </summary>
-    /// <param name="from">Source layout</param>
-    /// <param name="to">Target layout</param>
-    /// <param name="commandBuffer">Command buffer to perform the transition on</param>
-    /// <param name="destinationQueue">The queue to transfer the image to, if desired</param>
-    /// <returns>The matching acquire operation for the QFOT release, if it was needed for the target queue</returns>
-    std::optional<ImageMemoryBarrier> TransitionLayout(VkImageLayout from, VkImageLayout to, CommandBuffer &commandBuffer, std::optional<Queue> destinationQueue);
-    VkFormat GetFormat() const;
+    VkImageSubresourceRange GetFullRange() const;
+    /// <summary>
+    /// The access state of a single subresource as of the last command recorded on it, used by `CommandBuffer`
+    /// to derive barriers. Subresources are tracked separately so that e.g. mip levels can be in different layouts
+    /// </summary>
+    ResourceState &GetState(uint32_t mipLevel, uint32_t arrayLayer) const;
+    VkMemoryRequirements GetMemoryRequirements() const;
+    /// <summary>
+    /// Binds memory that is owned by the caller and creates the view. Only valid for textures created without memory
+    /// </summary>
+    void BindMemory(VkDeviceMemory memory, VkDeviceSize offset);
   private:
-    void BindMemory();
+    void CreateView();
     void Destroy();
 
     VkDevice m_Device;
     VkImage m_Image = VK_NULL_HANDLE;
-    VkDeviceMemory m_Memory;
-    VkImageView m_ImageView;
+    // Only set if the texture owns its memory
+    VkDeviceMemory m_Memory = VK_NULL_HANDLE;
+    VkImageView m_ImageView = VK_NULL_HANDLE;
+    bool m_OwnsImage = true;
 
     uint32_t m_Width;
     uint32_t m_Height;
     VkFormat m_Format;
+    uint32_t m_MipLevels = 1;
+    uint32_t m_ArrayLayers = 1;
+    // Indexed by mip level first, then array layer
+    mutable std::vector<ResourceState> m_SubresourceStates;
 };
 
 struct DepthAttachmentCreateInfo
@@ -81,6 +110,10 @@ public:
 
     VkAttachmentDescription GetAttachmentDescription() const;
     VkImageView GetView();
+    /// <summary>
+    /// The underlying image, once its initial transition has finished
+    /// </summary>
+    const Texture &GetTexture();
 
   private:
     VkFormat DetermineDepthFormat(const PhysicalDevice &physicalDevice);
@@ -101,15 +134,25 @@ public:
     ~Texture2D();
 
     VkImage Get();
+    /// <summary>
+    /// The underlying image, once the upload has finished
+    /// </summary>
+    Texture &GetTexture();
 
     uint32_t GetWidth() const;
     uint32_t GetHeight() const;
 
+    VkDescriptorImageInfo GetDescriptorInfo();
     /// <summary>
-    /// Takes the transfer acquire barrier, if there is any, for a previously enqueued release barrier used for uploading data
+    /// The view of the image, without waiting for the upload, as writing a descriptor doesn't access the image
     /// </summary>
-    std::optional<ImageMemoryBarrier> TakePendingAcquire();
-    VkDescriptorImageInfo GetDescriptorInfo();
+    VkImageView GetView() const;
+    /// <summary>
+    /// The index in the bindless texture table, if the device registered it there. Shaders may only sample it
+    /// after `GetTexture` waited for the upload
+    /// </summary>
+    std::optional<uint32_t> GetBindlessIndex() const;
+    void SetBindlessIndex(uint32_t bindlessIndex);
   private:
     VkSampler CreateTextureSampler(VkDevice device, const PhysicalDevice& physicalDevice);
     DeviceBuffer CreateStagingBuffer(size_t size, const PhysicalDevice &physicalDevice, VkDevice device) const;
@@ -119,7 +162,7 @@ public:
     DeviceBuffer m_StagingBuffer;
     Texture m_Texture;
 
-    std::optional<ImageMemoryBarrier> m_PendingAcquireBarrier;
     Fence* m_PendingTransferFence = nullptr;
     VkSampler m_Sampler;
+    std::optional<uint32_t> m_BindlessIndex;
 };
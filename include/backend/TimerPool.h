@@ -1,24 +1,74 @@
 #pragma once
-#include <vulkan/Vulkan.h>
+#include <vulkan/vulkan.h>
 #include <unordered_map>
+#include <map>
 #include <chrono>
+#include <functional>
+#include <optional>
+#include <ostream>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include <backend/Timer.h>
 #include <backend/Buffer.h>
 
+class ExtensionFunctionMapping;
+
+/// <summary>
+/// Device timestamps converted to nanoseconds. They share a time base across all pools of a device, so spans of
+/// different frames can be compared, e.g. to find the time the GPU idled between them
+/// </summary>
+struct GpuTimeSpan
+{
+    std::chrono::nanoseconds Begin;
+    std::chrono::nanoseconds End;
+};
+
+/// <summary>
+/// A single scope of a resolved frame, e.g. "Draw" nested in "Frame Total"
+/// </summary>
+struct ResolvedGpuScope
+{
+    // Interned by the pool, stays valid as long as the pool does
+    std::string_view Name;
+    GpuTimeSpan Span;
+    std::chrono::nanoseconds Duration;
+    // Index of the enclosing scope in `ResolvedTimerPool::Scopes`, empty for scopes at the top of the frame
+    std::optional<uint32_t> Parent;
+    uint32_t Depth;
+    std::vector<uint32_t> Children;
+};
+
 struct ResolvedTimerPool
 {
-    std::unordered_map<std::string, std::chrono::nanoseconds> Timings;
+    // Keyed by the names interned by the pool, like `ResolvedGpuScope::Name`, so resolving doesn't copy them
+    std::unordered_map<std::string_view, std::chrono::nanoseconds> Timings;
+    // From the first begin to the last end of all scopes with the same name
+    std::unordered_map<std::string_view, GpuTimeSpan> Spans;
+    // The tree of scopes of the frame in the order they began, so parents always precede their children
+    std::vector<ResolvedGpuScope> Scopes;
+    std::vector<uint32_t> Roots;
+
+    /// <summary>
+    /// Prints the scopes indented by their depth, e.g. for a console overlay
+    /// </summary>
+    void PrintTree(std::ostream &output) const;
 };
 
-// TODO: Embed this as part of a CommandBuffer directly, as that knows when the
-// command buffer has executed fully and therefore written its timestamps (i.e. 
-// whehter the fence has been signaled).
+/// <summary>
+/// Timestamp queries for a ring of `frameCount` frames, each with its own range of the query pool. Results are
+/// polled through their availability, so resolving never waits for the GPU: a frame whose timestamps were not written
+/// yet is resolved on a later call, or dropped once its range is reused.
+/// Scopes nest: a scope begun while another one is open becomes its child. Each scope is also wrapped in a debug utils
+/// label, so capture tools such as RenderDoc show the same hierarchy.
+/// </summary>
 class TimerPool
 {
   public:
-    TimerPool(VkDevice device, const PhysicalDevice& physicalDevice);
+    // Labels are only emitted if `functionMapping` is set
+    TimerPool(VkDevice device, const PhysicalDevice &physicalDevice, uint32_t frameCount = 1,
+              const ExtensionFunctionMapping *functionMapping = nullptr);
 
     TimerPool(const TimerPool &) = delete;
     TimerPool(TimerPool && other);
@@ -28,18 +78,67 @@ class TimerPool
 
     ~TimerPool();
 
-    Timer BeginScope(VkCommandBuffer commandBuffer, std::string name);
+    /// <summary>
+    /// Begins a child of the innermost open scope. Scope names are interned, so a scope only allocates the first time
+    /// its name is used
+    /// </summary>
+    Timer BeginScope(VkCommandBuffer commandBuffer, std::string_view name);
 
+    /// <summary>
+    /// Advances to the next frame of the ring and resets the queries it used last time. Needs to be recorded before
+    /// the first scope of each frame
+    /// </summary>
     void Reset(VkCommandBuffer commandBuffer);
     VkQueryPool GetQueryPool() const;
+    /// <summary>
+    /// Resolves the oldest frame that was not resolved yet, if all its timestamps are available. Returns no timings
+    /// otherwise, without waiting
+    /// </summary>
     ResolvedTimerPool Resolve();
+    /// <summary>
+    /// Frames that were still unavailable when their range of the pool was reset
+    /// </summary>
+    uint64_t GetDroppedFrameCount() const;
+
   private:
-    uint32_t m_Counter = 0;
+    friend class Timer;
+
+    struct ScopeRecord
+    {
+        uint32_t NameId;
+        std::optional<uint32_t> Parent;
+    };
+
+    struct FrameQueries
+    {
+        // Starts out as the whole range, as queries need to be reset once after the pool was created
+        uint32_t UsedQueries;
+        // Scope `i` uses the queries `2 * i` and `2 * i + 1` of the frame's range
+        std::vector<ScopeRecord> Scopes;
+    };
+
+    void EndScope(VkCommandBuffer commandBuffer, TimestampId timestampId);
+    uint32_t GetFirstQuery(uint64_t frame) const;
+    uint32_t InternScopeName(std::string_view name);
+
     VkDevice m_Device;
     VkQueryPool m_QueryPool;
-    // Index is the beginning of the timestamp
-    std::vector<std::string> m_TimestampIdNames;
-    // For caching purposes. Allows not re-allocating every frame
+    // Nanoseconds per timestamp tick
+    float m_TimestampPeriod;
+    uint32_t m_QueriesPerFrame;
+    std::vector<FrameQueries> m_Frames;
+    // Frames that were reset so far, the last one is the frame being recorded
+    uint64_t m_RecordedFrames = 0;
+    // Frames that were resolved or dropped so far
+    uint64_t m_ResolvedFrames = 0;
+    uint64_t m_DroppedFrames = 0;
+    // Indices into the scopes of the frame being recorded, innermost last
+    std::vector<uint32_t> m_OpenScopes;
+    // Point to the keys of `m_ScopeIds`, which don't move, so resolved scopes can refer to them
+    std::vector<const std::string *> m_ScopeNames;
+    std::map<std::string, uint32_t, std::less<>> m_ScopeIds;
+    PFN_vkCmdBeginDebugUtilsLabelEXT m_BeginLabel = nullptr;
+    PFN_vkCmdEndDebugUtilsLabelEXT m_EndLabel = nullptr;
+    // For caching purposes. Allows not re-allocating every frame, holds a value and its availability per query
     std::vector<uint64_t> m_ResultBuffer;
-    uint64_t m_TimerResolution;
 };
@@ -18,6 +18,7 @@ public:
     }
 
     VkDescriptorBufferInfo GetDescriptorInfo() const;
+    const DeviceBuffer &GetBuffer() const;
   private:
     DeviceBuffer& CreateBuffer(VulkanDevice& vulkanDevice, size_t size);
 
@@ -1,4 +1,5 @@
 #pragma once
+#include <chrono>
 #include <functional>
 #include <optional>
 #include <set>
@@ -6,23 +7,34 @@
 #include <vulkan/vulkan.h>
 #include <filesystem>
 #include <typeinfo>
+#include <ostream>
 
 #include "DeviceExtensionMapping.h"
 #include "ExtensionFunctionMapping.h"
 #include "VulkanSurface.h"
 #include "Swapchain.h"
+#include "OffscreenSwapchain.h"
 #include "Pipeline.h"
+#include "ComputePipeline.h"
 #include "CommandBufferPool.h"
 #include "Fence.h"
 #include "Semaphore.h"
 #include "Queue.h"
 #include "VertexBuffer.h"
 #include "UniformBuffer.h"
-#include "DescriptorPool.h"
+#include "DynamicUniformBuffer.h"
+#include "DescriptorAllocator.h"
+#include "BindlessTextureTable.h"
 #include "Buffer.h"
 #include "Texture.h"
 #include "DescriptorSetBuilder.h"
 #include "TimerPool.h"
+#include "RenderGraph.h"
+#include "PipelineCache.h"
+#include "PipelineCompiler.h"
+#include "PipelineLayout.h"
+#include "ObjectCache.h"
+#include "DeferredDeletionQueue.h"
 
 class PhysicalDevice;
 struct GLFWwindow;
@@ -37,7 +49,7 @@ class VulkanDevice
     VulkanDevice(PhysicalDevice &physicalDevice, VkPhysicalDevice physicalDeviceHandle,
                         const VulkanInstance& instance,
                         const std::vector<const char*> &validationLayers, std::vector<EDeviceExtension> extensions,
-                        const DeviceExtensionMapping &deviceExtensionMapping, GLFWwindow& window);
+                        const DeviceExtensionMapping &deviceExtensionMapping, GLFWwindow* window);
     VulkanDevice(const VulkanDevice &other) = delete;
     VulkanDevice(VulkanDevice &&other);
     ~VulkanDevice();
@@ -46,17 +58,88 @@ class VulkanDevice
     void WaitForIdle() const;
     Swapchain& CreateSwapchain(GLFWwindow& window, const VulkanSurface& surface);
     Swapchain &GetSwapchain();
-    RasterPipeline CreateRasterPipeline(RasterPipelineBuilder &&pipelineBuilder, const RenderPass& renderPass);
-    RenderPass CreateRenderPass(DepthAttachment& depthAttachment);
-    const SwapchainFramebuffer& CreateSwapchainFramebuffers(const RenderPass &renderpass, DepthAttachment* depthAttachment);
+    /// <summary>
+    /// Renders into offscreen images instead of a swapchain, for devices created without a window. Requires
+    /// dynamic rendering, as there are no swapchain framebuffers
+    /// </summary>
+    OffscreenSwapchain &CreateOffscreenSwapchain(const OffscreenSwapchainCreateInfo &createInfo);
+    // Whether frames render to an `OffscreenSwapchain` rather than a window
+    bool IsHeadless() const;
+    /// <summary>
+    /// Creates the pipeline, or returns the existing one if an identical pipeline was created before for a
+    /// compatible render pass. Pipelines are owned by the device
+    /// </summary>
+    const RasterPipeline &CreateRasterPipeline(RasterPipelineBuilder &&pipelineBuilder, const RenderPass& renderPass);
+    /// <summary>
+    /// Creates the pipeline for `rendering`, which is for dynamic rendering if it has no compatible render pass
+    /// </summary>
+    const RasterPipeline &CreateRasterPipeline(RasterPipelineBuilder &&pipelineBuilder, const RenderingLayout &rendering);
+    /// <summary>
+    /// Compiles the pipeline on a worker thread, including loading its shaders. The render pass of `rendering`, if
+    /// any, and the descriptor set layout of the builder have to stay alive until the pipeline is ready
+    /// </summary>
+    PendingRasterPipeline CreateRasterPipelineAsync(RasterPipelineBuilder &&pipelineBuilder, RenderingLayout rendering);
+    ComputePipeline CreateComputePipeline(ComputePipelineBuilder &&pipelineBuilder);
+    ComputePipeline CreateComputePipeline(const std::filesystem::path &computeShaderPath, const DescriptorSetLayout &descriptorSetLayout);
+    /// <summary>
+    /// Creates the pipeline with the layout derived from the shader
+    /// </summary>
+    ComputePipeline CreateComputePipeline(const std::filesystem::path &computeShaderPath);
+    /// <summary>
+    /// Whether `VK_KHR_dynamic_rendering` is enabled, so that passes can render to image views directly
+    /// instead of through render pass and framebuffer objects
+    /// </summary>
+    bool SupportsDynamicRendering() const;
+    /// <summary>
+    /// Whether descriptor indexing is enabled, in which case textures are registered in the bindless texture table
+    /// when they are created
+    /// </summary>
+    bool SupportsBindless() const;
+    BindlessTextureTable &GetBindlessTextures();
+    /// <summary>
+    /// The attachment formats of rendering to the swapchain, or to the offscreen swapchain when headless, e.g. to
+    /// import them into a `RenderGraph`
+    /// </summary>
+    RenderingLayout GetSwapchainRenderingLayout(const DepthAttachment *depthAttachment) const;
+    /// <summary>
+    /// The acquired image of the swapchain or of the offscreen swapchain, e.g. to import into a `RenderGraph`
+    /// </summary>
+    const Texture &GetSwapchainTexture() const;
+    /// <summary>
+    /// Incremented whenever the swapchain images and depth attachments are recreated
+    /// </summary>
+    uint64_t GetSwapchainGeneration() const;
+    /// <summary>
+    /// The CPU time spent recreating the swapchain since the last call, zero if it wasn't recreated. Recreation
+    /// happens within `AcquireNext` and `Present`, so this is the stall a resize adds to them
+    /// </summary>
+    std::chrono::nanoseconds TakeSwapchainRecreateTime();
+    /// <summary>
+    /// The viewport of the images frames render to, i.e. of the swapchain or of the offscreen swapchain when headless
+    /// </summary>
+    Viewport GetSwapchainViewport() const;
     // TODO: Make a getter, just construct it in the constructor 
     CommandBufferPool CreateGraphicsCommandBufferPool();
     CommandBuffer &GetTransferCommandBuffer();
     CommandBufferPool &GetGraphicsCommandBufferPool();
+    CommandBufferPool &GetComputeCommandBufferPool();
     Semaphore &CreateDeviceSemaphore();
     Queue GetGraphicsQueue() const;
     Queue GetTransferQueue() const;
-    TimerPool &CreateTimerPool();
+    Queue GetComputeQueue() const;
+    const PhysicalDevice &GetPhysicalDevice() const;
+    TimerPool &CreateTimerPool(uint32_t frameCount = 1);
+    /// <summary>
+    /// Creates an empty graph to execute in graphics command buffers. It owns its render passes and transient textures,
+    /// so it must not outlive the device
+    /// </summary>
+    RenderGraph CreateRenderGraph();
+    /// <summary>
+    /// The cache all pipelines are created with. It is saved when the device is destroyed, but can be saved
+    /// earlier with `SavePipelineCache`, e.g. after loading a level, so that a crash doesn't lose it
+    /// </summary>
+    const PipelineCache &GetPipelineCache() const;
+    void SavePipelineCache() const;
     void AcquireNext(const Semaphore& toSignal);
     void Present(std::span<Semaphore> waitSemaphores);
     void HandleResizeEvent(const WindowResizeEvent &resizeEvent);
@@ -79,17 +162,70 @@ class VulkanDevice
     {
         return *m_UniformBuffers.emplace_back(std::make_unique<UniformBuffer>(*this, m_Device, sizeof(T)));
     }
+    /// <summary>
+    /// A ring that many small uploads share through dynamic offsets, e.g. one per frame in flight for per-draw data
+    /// </summary>
+    DynamicUniformBuffer &CreateDynamicUniformBuffer(const DynamicUniformBufferCreateInfo &createInfo = {});
 
     DeviceBuffer &CreateBuffer(const CreateBufferInfo& createBufferInfo);
     Texture2D &CreateTexture(const Texture2DCreateInfo& createDesc);
+    /// <summary>
+    /// Creates an image with undefined contents that only the GPU writes, e.g. a storage image of a compute shader
+    /// </summary>
+    Texture &CreateTexture(const TextureCreateInfo& createInfo);
     DepthAttachment &CreateSwapchainDepthAttachment();
-    // TODO: Store for re-use
+    /// <summary>
+    /// Allocates a set that lives as long as the device, from pools that grow as needed
+    /// </summary>
     DescriptorSet CreateDescriptorSet(const DescriptorSetLayout& layout);
+    /// <summary>
+    /// Allocates `count` sets at once, e.g. one per material or draw
+    /// </summary>
+    std::vector<DescriptorSet> CreateDescriptorSets(const DescriptorSetLayout& layout, uint32_t count);
+    /// <summary>
+    /// Creates the layout, or returns the existing one with identical bindings
+    /// </summary>
     const DescriptorSetLayout& CreateDescriptorSetLayout(DescriptorSetBuilder builder);
+    /// <summary>
+    /// Creates the layout of descriptor set `set` as used by the shaders at `shaderPaths`, with only the stages
+    /// that use a binding in its stage mask. Matches the layout derived for pipelines using the same shaders
+    /// </summary>
+    const DescriptorSetLayout& CreateReflectedDescriptorSetLayout(std::span<const std::filesystem::path> shaderPaths,
+                                                                  uint32_t set = 0);
+    /// <summary>
+    /// Same as above, with the uniform buffers at `dynamicBindings` made dynamic, which reflection can't tell apart.
+    /// Pipelines using the layout have to be given it explicitly
+    /// </summary>
+    const DescriptorSetLayout& CreateReflectedDescriptorSetLayout(std::span<const std::filesystem::path> shaderPaths,
+                                                                  std::span<const uint32_t> dynamicBindings,
+                                                                  uint32_t set = 0);
+    /// <summary>
+    /// Creates the layout, or returns the existing one with identical set layouts and push constant ranges
+    /// </summary>
+    const PipelineLayout &CreatePipelineLayout(std::span<const VkDescriptorSetLayout> descriptorSetLayouts,
+                                               std::span<const VkPushConstantRange> pushConstantRanges);
+    /// <summary>
+    /// Prints the hit rates of the pipeline and layout caches
+    /// </summary>
+    void ReportObjectCaches(std::ostream &stream) const;
+    /// <summary>
+    /// Creates an allocator separate from the one used by `CreateDescriptorSet`, for sets that are freed together,
+    /// e.g. one per frame in flight for transient sets, reset once the frame's fence signaled
+    /// </summary>
+    DescriptorAllocator& CreateDescriptorAllocator(const DescriptorAllocatorCreateInfo& createInfo = {});
   private:
     CommandBufferPool CreateTransferCommandBufferPool() const;
+    CommandBufferPool CreateComputeCommandBufferPool() const;
     void RecreateSwapchain(VkExtent2D newSize);
     ShaderModule LoadShaderModule(const std::filesystem::path &filename);
+    /// <summary>
+    /// Reflects each shader only once, even if it's used by many pipelines
+    /// </summary>
+    PipelineInterface ReflectShaders(std::span<const std::filesystem::path> shaderPaths);
+    /// <summary>
+    /// The layouts of the reflected sets, where `BindlessSetIndex` is the bindless texture table's layout
+    /// </summary>
+    std::vector<VkDescriptorSetLayout> CreateReflectedSetLayouts(const PipelineInterface &pipelineInterface);
     static std::vector<VkDeviceQueueCreateInfo> GetQueueCreateInfos(const PhysicalDevice &physicalDevice);
     VkSurfaceFormatKHR SelectSurfaceFormat() const;
     VkPresentModeKHR SelectPresentMode() const;
@@ -97,29 +233,48 @@ class VulkanDevice
 
     VkDevice m_Device;
     const VulkanInstance &m_Instance;
-    GLFWwindow &m_Window;
+    // Null when headless
+    GLFWwindow *m_Window;
     PhysicalDevice &m_PhysicalDevice;
     std::optional<Queue> m_GraphicsQueue;
     std::optional<Queue> m_PresentQueue;
     std::optional<Queue> m_TransferQueue;
+    std::optional<Queue> m_ComputeQueue;
+    // Null unless synchronization2 is enabled
+    PFN_vkCmdPipelineBarrier2KHR m_PipelineBarrier2 = nullptr;
+    DynamicRenderingFunctions m_DynamicRendering;
+    std::unique_ptr<PipelineCache> m_PipelineCache;
+    std::unique_ptr<PipelineCompiler> m_PipelineCompiler;
     std::optional<Swapchain> m_Swapchain = std::nullopt;
+    // Only set when headless, in place of `m_Swapchain`
+    std::optional<OffscreenSwapchain> m_OffscreenSwapchain = std::nullopt;
     std::unique_ptr<CommandBufferPool> m_GraphicsCommandBufferPool;
     std::unique_ptr<CommandBufferPool> m_TransferCommandBufferPool = nullptr;
+    std::unique_ptr<CommandBufferPool> m_ComputeCommandBufferPool = nullptr;
     std::vector<std::unique_ptr<TimerPool>> m_TimerPools;
     // TODO: Don't hold the semaphores here (unless for pooling).
     // Let objects logically decide if they need to provide one.
     std::vector<std::unique_ptr<Semaphore>> m_Semaphores;
-    // TODO: Manage this better using a delete queue/stack so that 
-    // this doesn't have to manually manage these handles
-    std::vector<std::unique_ptr<SwapchainFramebuffer>> m_SwapchainFramebuffers;
     std::vector<std::unique_ptr<VertexBuffer>> m_VertexBuffers;
     std::vector<std::unique_ptr<IndexBuffer>> m_IndexBuffers;
     std::vector<std::unique_ptr<UniformBuffer>> m_UniformBuffers;
+    std::vector<std::unique_ptr<DynamicUniformBuffer>> m_DynamicUniformBuffers;
     std::vector<std::unique_ptr<Texture2D>> m_Textures;
+    std::vector<std::unique_ptr<Texture>> m_DeviceTextures;
     std::vector<std::unique_ptr<DepthAttachment>> m_DepthAttachments;
     std::vector<std::unique_ptr<DeviceBuffer>> m_Buffers; 
     std::optional<VkExtent2D> m_LastUnhandledResize;
-    std::vector<std::unique_ptr<DescriptorSetLayout>> m_DescriptorSetLayouts;
-    std::unique_ptr<DescriptorPool> m_DescriptorPool;
+    uint64_t m_SwapchainGeneration = 0;
+    std::chrono::nanoseconds m_SwapchainRecreateTime{0};
+    ObjectCache<DescriptorSetLayout> m_DescriptorSetLayouts;
+    ObjectCache<PipelineLayout> m_PipelineLayouts;
+    ObjectCache<RasterPipeline> m_RasterPipelines;
+    ObjectCache<ShaderReflection> m_ShaderReflections;
+    std::unique_ptr<DescriptorAllocator> m_DescriptorAllocator;
+    std::vector<std::unique_ptr<DescriptorAllocator>> m_DescriptorAllocators;
+    // Null unless descriptor indexing is supported
+    std::unique_ptr<BindlessTextureTable> m_BindlessTextures;
+    // Swapchains and attachments replaced on resize, until the frames that used them finished
+    DeferredDeletionQueue m_DeletionQueue;
 };
 
@@ -15,6 +15,7 @@
 #include "VulkanDevice.h"
 #include "PhysicalDevice.h"
 #include "VulkanSurface.h"
+#include "OffscreenSwapchain.h"
 #include "../ManualScope.h"
 
 struct GLFWwindow;
@@ -58,6 +59,11 @@ class VulkanInstance
 {
   public:
     VulkanInstance(const InstanceCreateInfo &createInfo, GLFWwindow &window);
+    /// <summary>
+    /// Creates the instance without a surface, for rendering headless into `offscreenTarget`. Software devices
+    /// such as lavapipe are accepted, but only picked if there is no hardware device
+    /// </summary>
+    VulkanInstance(const InstanceCreateInfo &createInfo, const OffscreenSwapchainCreateInfo &offscreenTarget);
     ~VulkanInstance();
     VulkanInstance(const VulkanInstance &other) = delete;
     VulkanInstance(VulkanInstance &&other);
@@ -67,13 +73,17 @@ class VulkanInstance
   private:
     static std::vector<const char *> CheckValidationLayers(const std::vector<ValidationLayer> &validationLayers);
     VkDebugUtilsMessengerEXT CreateDebugMessenger() const;
-    VkInstance CreateInstance(const InstanceCreateInfo &createInfo);
-    PhysicalDevice CreatePhysicalDevice(const VulkanSurface &targetSurface,
+    // Without surface extensions when there is no window
+    VkInstance CreateInstance(const InstanceCreateInfo &createInfo, bool withSurface);
+    PhysicalDevice CreatePhysicalDevice(std::optional<std::reference_wrapper<const VulkanSurface>> targetSurface,
                                       std::span<const EDeviceExtension> deviceExtensions) const;
+    void CreateDevice(const InstanceCreateInfo &createInfo, GLFWwindow *window);
 
     // Ugly hack to just store the validation layers here
     // TODO: Don't have this be init order dependent
     std::vector<const char *> m_ValidationLayers;
+    // Set by `CreateInstance`, false when headless
+    bool m_HasSurface = false;
     VkInstance m_VkInstance;
     ExtensionFunctionMapping m_ExtensionMapper;
     DeviceExtensionMapping m_DeviceExtensionMapper;
@@ -0,0 +1,16 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout(location = 0) in vec3 vertexColor;
+layout(location = 1) in vec2 uv;
+layout(location = 2) flat in uint textureIndex;
+
+layout(location = 0) out vec4 outColor;
+
+// The bindless texture table at `BindlessSetIndex`
+layout(set = 1, binding = 0) uniform texture2D Textures[];
+layout(set = 1, binding = 1) uniform sampler Samplers[];
+
+void main() {
+	outColor = texture(sampler2D(Textures[nonuniformEXT(textureIndex)], Samplers[0]), uv);
+}
@@ -0,0 +1,36 @@
+#version 450
+
+layout(location = 0) in vec3 vertexPosition;
+layout(location = 1) in vec3 vertexColor;
+layout(location = 2) in vec2 uv;
+
+layout(location = 0) out vec3 outColor;
+layout(location = 1) out vec2 outUv;
+
+layout(binding = 0) uniform UniformBufferObject {
+	mat4 model;
+	mat4 view;
+	mat4 projection;
+} Params;
+
+struct ObjectData {
+	mat4 transform;
+	vec4 boundingSphere;
+	uint indexCount;
+	uint firstIndex;
+	int vertexOffset;
+	uint padding;
+};
+
+layout(std430, binding = 2) readonly buffer Objects {
+	uint objectCount;
+	ObjectData objects[];
+};
+
+void main() {
+	// First instance of every culled draw is the index of the object
+	mat4 transform = objects[gl_InstanceIndex].transform;
+	gl_Position = Params.projection * Params.view * Params.model * transform * vec4(vertexPosition, 1.0);
+	outColor = vertexColor;
+	outUv = uv;
+}
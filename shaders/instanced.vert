@@ -0,0 +1,26 @@
+#version 450
+
+layout(location = 0) in vec3 vertexPosition;
+layout(location = 1) in vec3 vertexColor;
+layout(location = 2) in vec2 uv;
+
+// Per-instance stream, see InstanceData
+layout(location = 3) in mat4 instanceTransform;
+layout(location = 7) in uint instanceMaterialIndex;
+
+layout(location = 0) out vec3 outColor;
+layout(location = 1) out vec2 outUv;
+layout(location = 2) flat out uint outMaterialIndex;
+
+layout(binding = 0) uniform UniformBufferObject {
+	mat4 model;
+	mat4 view;
+	mat4 projection;
+} Params;
+
+void main() {
+	gl_Position = Params.projection * Params.view * Params.model * instanceTransform * vec4(vertexPosition, 1.0);
+	outColor = vertexColor;
+	outUv = uv;
+	outMaterialIndex = instanceMaterialIndex;
+}
@@ -0,0 +1,37 @@
+#version 450
+
+layout(location = 0) in vec3 vertexColor;
+layout(location = 1) in vec2 uv;
+
+layout(location = 0) out vec4 outColor;
+
+layout(binding = 1) uniform sampler2D textureSampler;
+
+// Matches ShadingSpecialization in ShaderVariantBenchmark.h. Without specialization, the settings
+// are read from the push constants instead, so that the loop and branch are evaluated at runtime
+layout(constant_id = 0) const bool UseSpecialization = false;
+layout(constant_id = 1) const uint SpecializedTapCount = 1;
+layout(constant_id = 2) const bool SpecializedGrayscale = false;
+
+// Matches ShadingSettings in ShaderVariantBenchmark.h
+layout(push_constant) uniform ShadingSettings {
+	uint TapCount;
+	uint Grayscale;
+} Settings;
+
+void main() {
+	uint tapCount = UseSpecialization ? SpecializedTapCount : Settings.TapCount;
+	bool grayscale = UseSpecialization ? SpecializedGrayscale : Settings.Grayscale != 0;
+
+	// A horizontal blur, only to make the shader expensive enough to be measurable
+	vec4 color = vec4(0.0);
+	for (uint i = 0; i < tapCount; i++) {
+		color += texture(textureSampler, uv + vec2(float(i) / 512.0, 0.0));
+	}
+	color /= float(max(tapCount, 1));
+
+	if (grayscale) {
+		color.rgb = vec3(dot(color.rgb, vec3(0.299, 0.587, 0.114)));
+	}
+	outColor = color;
+}
@@ -3,73 +3,191 @@
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
 #include <vector>
+#include <array>
+#include <algorithm>
 
 #include <chrono>
+#include <filesystem>
 #include <glm/gtc/matrix_transform.hpp>
 
 #include <backend/ShaderModule.h>
 #include <backend/DebugMarker.h>
+#include <backend/IndexBuffer.h>
 
-const InstanceCreateInfo DefaultCreateInfo()
+namespace
+{
+const std::array<std::filesystem::path, 2> SceneShaderPaths = {"shaders/indirect.vert.spv", "shaders/triangle.frag.spv"};
+// The scene constants, uploaded to the ring of the frame in flight
+constexpr std::array<uint32_t, 1> SceneDynamicBindings = {0};
+}
+
+const InstanceCreateInfo DefaultCreateInfo(bool headless)
 {
     InstanceCreateInfo createInfo;
     createInfo.Name = "ArtifactVK";
     createInfo.ValidationLayers =
         std::vector<ValidationLayer>{ValidationLayer{EValidationLayer::KhronosValidation, false}};
+    if (headless)
+    {
+        // There are no swapchain framebuffers to fall back to when rendering offscreen
+        createInfo.RequiredExtensions = std::vector<EDeviceExtension>{EDeviceExtension::DynamicRendering};
+        createInfo.OptionalExtensions = std::vector<EDeviceExtension>{EDeviceExtension::Synchronization2};
+        return createInfo;
+    }
     createInfo.RequiredExtensions = std::vector<EDeviceExtension>{EDeviceExtension::Swapchain};
+    // Used for batched barriers and rendering without render pass objects, both of which fall back to the
+    // legacy paths when not available
+    createInfo.OptionalExtensions =
+        std::vector<EDeviceExtension>{EDeviceExtension::Synchronization2, EDeviceExtension::DynamicRendering};
     return createInfo;
 }
 
-App::App()
-    : m_Window(WindowCreateInfo{800, 600, "ArtifactVK"}),
-      m_VulkanInstance(m_Window.CreateVulkanInstance(DefaultCreateInfo())),
+App::App(std::optional<BenchmarkCreateInfo> benchmark, uint32_t framesInFlight, std::optional<HeadlessCreateInfo> headless, const FrameStatisticsCreateInfo &statistics)
+    : m_FramesInFlight(std::clamp(framesInFlight, MIN_FRAMES_IN_FLIGHT, MAX_FRAMES_IN_FLIGHT)),
+      m_HeadlessFrameCount(headless.has_value() ? std::optional(headless->FrameCount) : std::nullopt),
+      m_VulkanInstance(CreateVulkanInstance(headless)),
       m_DepthAttachment(m_VulkanInstance.GetActiveDevice().CreateSwapchainDepthAttachment()),
-      m_MainPass(m_VulkanInstance.GetActiveDevice().CreateRenderPass(m_DepthAttachment)),
-      m_SwapchainFramebuffers(m_VulkanInstance.GetActiveDevice().CreateSwapchainFramebuffers(m_MainPass, &m_DepthAttachment)),
-      m_DescriptorSetLayout(BuildDescriptorSetLayout(m_VulkanInstance.GetActiveDevice())),
+      m_DescriptorSetLayout(m_VulkanInstance.GetActiveDevice().CreateReflectedDescriptorSetLayout(
+          SceneShaderPaths, SceneDynamicBindings)),
       m_PerFrameState(CreatePerFrameState(m_VulkanInstance.GetActiveDevice())),
-      m_RenderFullscreen(LoadShaderPipeline(m_VulkanInstance.GetActiveDevice(), m_MainPass)),
-      m_Swapchain(m_VulkanInstance.GetActiveDevice().GetSwapchain()),
+      m_TimerPool(m_VulkanInstance.GetActiveDevice().CreateTimerPool(m_FramesInFlight)),
       m_Model(LoadModel()),
       m_VertexBuffer(m_VulkanInstance.GetActiveDevice().CreateVertexBuffer(GetVertices())),
       m_IndexBuffer(m_VulkanInstance.GetActiveDevice().CreateIndexBuffer(GetIndices())), 
-      m_Texture(LoadImage())
+      m_Texture(LoadImage()),
+      m_IndirectCuller(m_VulkanInstance.GetActiveDevice(),
+                       IndirectCullerCreateInfo{OBJECT_GRID_SIZE * OBJECT_GRID_SIZE, m_FramesInFlight}),
+      m_FrameGraph(m_VulkanInstance.GetActiveDevice().CreateRenderGraph()),
+      m_MainPass(BuildFrameGraph()),
+      m_RenderFullscreen(LoadShaderPipeline(m_VulkanInstance.GetActiveDevice(), m_MainPass.GetRenderingLayout())),
+      m_FramePacing(m_FramesInFlight),
+      m_Statistics(statistics)
 {
+    auto objects = CreateObjectGrid();
+    m_IndirectCuller.SetObjects(objects);
+    if (benchmark.has_value())
+    {
+        m_Benchmark =
+            Benchmark::Create(m_VulkanInstance.GetActiveDevice(), m_MainPass.GetRenderingLayout(), *benchmark,
+                              m_FramesInFlight);
+    }
 }
 
 App::~App()
 {
+    // The compile reads the render pass of the frame graph's main pass, which is destroyed before the device drains
+    // its compiler
+    m_RenderFullscreen.WaitForCompletion();
     for (auto &perFrameState : m_PerFrameState)
     {
         perFrameState.CommandBuffer.WaitFence();
     }
-    glfwTerminate();
+    // GLFW is only initialized along with the window
+    if (m_Window.has_value())
+    {
+        glfwTerminate();
+    }
+}
+
+VulkanInstance App::CreateVulkanInstance(const std::optional<HeadlessCreateInfo> &headless)
+{
+    if (headless.has_value())
+    {
+        // No GLFW at all, so that it runs on machines without a display
+        return VulkanInstance(DefaultCreateInfo(true), headless->Target);
+    }
+    if (glfwInit() == GLFW_FALSE)
+    {
+        throw std::runtime_error("Could not initialize GLFW");
+    }
+    m_Window.emplace(WindowCreateInfo{800, 600, "ArtifactVK"});
+    return m_Window->CreateVulkanInstance(DefaultCreateInfo(false));
+}
+
+bool App::ShouldClose() const
+{
+    if (IsBenchmarkFinished())
+    {
+        return true;
+    }
+    return m_Window.has_value() ? m_Window->ShouldClose() : m_CurrentFrameIndex >= *m_HeadlessFrameCount;
+}
+
+void App::RecordNextFrame()
+{
+    RecordFrame(m_PerFrameState[m_CurrentFrameIndex % m_FramesInFlight]);
+    m_CurrentFrameIndex += 1;
 }
 
 void App::RunRenderLoop()
 {
-    while (!m_Window.ShouldClose())
+    if (!m_Window.has_value())
+    {
+        // The scene is skipped while its pipeline compiles, and those empty frames would count towards the fixed
+        // number of headless frames
+        m_RenderFullscreen.Wait();
+    }
+    while (!ShouldClose())
     {
-        if (!m_Window.IsMinimized())
+        if (!m_Window.has_value())
+        {
+            // Nothing to poll or to wait for without a window
+            RecordNextFrame();
+        }
+        else if (!m_Window->IsMinimized())
         {
-            auto resizeEvent = m_Window.PollEvents();
-            if (resizeEvent.has_value() && !m_Window.IsMinimized())
+            auto resizeEvent = m_Window->PollEvents();
+            if (resizeEvent.has_value() && !m_Window->IsMinimized())
             {
                 m_VulkanInstance.GetActiveDevice().HandleResizeEvent(*resizeEvent);
             }
             
-            if (m_Window.IsMinimized())
+            if (m_Window->IsMinimized())
             {
-                m_Window.WaitForRender();
+                m_Window->WaitForRender();
             }
             else
             {
-				RecordFrame(m_PerFrameState[m_CurrentFrameIndex % MAX_FRAMES_IN_FLIGHT]);
-				m_CurrentFrameIndex += 1;
+                RecordNextFrame();
             }
 
         }
     }
+    m_VulkanInstance.GetActiveDevice().GetPipelineCache().Report(std::cout);
+    m_VulkanInstance.GetActiveDevice().ReportObjectCaches(std::cout);
+    m_CommandStatistics.Report(std::cout);
+    if (m_Benchmark)
+    {
+        m_Benchmark->Report(std::cout);
+    }
+    m_FramePacing.Report(std::cout);
+    if (auto dropped = m_TimerPool.GetDroppedFrameCount(); dropped > 0)
+    {
+        std::cout << std::format("GPU timings of {} frame(s) were dropped, as they were not available in time\n", dropped);
+    }
+    if (!m_LastGpuTimings.Scopes.empty())
+    {
+        std::cout << "GPU scopes of the last frame\n";
+        m_LastGpuTimings.PrintTree(std::cout);
+    }
+    m_Statistics.Report(std::cout);
+    m_Statistics.Save();
+}
+
+BenchmarkFrame App::GetBenchmarkFrame(PerFrameState &state, uint32_t frameIndex)
+{
+    return BenchmarkFrame{frameIndex, state.CommandBuffer, state.UniformBuffer, m_Texture, m_VertexBuffer,
+                          m_IndexBuffer};
+}
+
+bool App::IsBenchmarking() const
+{
+    return m_Benchmark && m_Benchmark->ReplacesScene();
+}
+
+bool App::IsBenchmarkFinished() const
+{
+    return m_Benchmark && m_Benchmark->IsFinished();
 }
 
 Texture2D& App::LoadImage()
@@ -100,57 +218,170 @@ UniformConstants App::GetUniforms()
     constants.view = glm::lookAt(glm::vec3(2.0f, 2.0f, 2.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
     
     constants.projection = glm::perspective(
-        glm::radians(45.0f), m_VulkanInstance.GetActiveDevice().GetSwapchain().GetViewportDescription().AspectRatio(),
-        0.1f, 10.0f);
+        glm::radians(45.0f), m_VulkanInstance.GetActiveDevice().GetSwapchainViewport().AspectRatio(), 0.1f, 10.0f);
     constants.projection[1][1] *= -1;
     return constants;
 }
 
-RasterPipeline App::LoadShaderPipeline(VulkanDevice &vulkanDevice, const RenderPass &renderPass) const
+PendingRasterPipeline App::LoadShaderPipeline(VulkanDevice &vulkanDevice, const RenderingLayout &rendering) const
 {
-    auto builder = RasterPipelineBuilder("shaders/triangle.vert.spv", "shaders/triangle.frag.spv");
-    builder.SetVertexBindingDescription(Vertex::GetVertexBindingDescription());
-
-    // TODO: Have nicer outer bindings for it (i.e. less directly translated from Vulkan)_
-    builder.SetDescriptorSetLayout(m_DescriptorSetLayout);
-    return vulkanDevice.CreateRasterPipeline(std::move(builder), renderPass);
+    auto builder = RasterPipelineBuilder(SceneShaderPaths[0].string(), SceneShaderPaths[1].string());
+    builder.SetVertexBindingDescription(Vertex::GetVertexBindingDescription())
+        .SetDescriptorSetLayout(m_DescriptorSetLayout);
+    return vulkanDevice.CreateRasterPipelineAsync(std::move(builder), rendering);
 }
 
 void App::RecordFrame(PerFrameState& state)
 {
     auto &activeDevice = m_VulkanInstance.GetActiveDevice();
-    activeDevice.AcquireNext(state.ImageAvailable);
-    // TODO: Can probably be moved to CommandBuffer->Begin()
-    state.CommandBuffer.WaitFence();
+    auto frameStart = std::chrono::steady_clock::now();
+    if (m_LastFrameStart.has_value())
+    {
+        m_Statistics.AddSample("CPU Frame", frameStart - *m_LastFrameStart);
+    }
+    m_LastFrameStart = frameStart;
+    {
+        auto waitTimer = ScopedCpuTimer(m_Statistics, "CPU Wait Fence");
+        // TODO: Can probably be moved to CommandBuffer->Begin()
+        state.CommandBuffer.WaitFence();
+    }
+    // Before acquiring, which may block on the presentation engine and isn't part of reusing the slot
+    auto slotReused = std::chrono::steady_clock::now();
+    {
+        auto acquireTimer = ScopedCpuTimer(m_Statistics, "CPU Acquire");
+        // Only after the wait, as the semaphore may still be waited on by the previous frame of this slot, which is
+        // always the case with a single frame in flight
+        activeDevice.AcquireNext(state.ImageAvailable);
+    }
 
-    auto previousResults = state.TimerPool.Resolve();
+    auto frameIndex = m_CurrentFrameIndex % m_FramesInFlight;
+    auto previousResults = m_TimerPool.Resolve();
+    auto previousFrameSpan = previousResults.Spans.find("Frame Total");
+    m_FramePacing.CompleteFrame(frameIndex, slotReused, previousFrameSpan != previousResults.Spans.end()
+                                                             ? std::optional(previousFrameSpan->second)
+                                                             : std::nullopt);
+    m_Statistics.AddGpuTimings(previousResults);
     std::chrono::duration<double, std::milli> millis = previousResults.Timings["Frame Total"];
-    m_Window.SetTitle(std::format("GPU: {:.5f} ms", millis.count()));
+    if (m_Window.has_value())
+    {
+        m_Window->SetTitle(std::format("GPU: {:.5f} ms", millis.count()));
+    }
+    if (m_Benchmark && previousResults.Timings.contains("Draw"))
+    {
+        m_Benchmark->AddGpuTime(previousResults.Timings["Draw"]);
+    }
+    if (!previousResults.Scopes.empty())
+    {
+        m_LastGpuTimings = std::move(previousResults);
+    }
     state.CommandBuffer.Begin();
 
 	// TODO: Shouldn't be the user's burden
-	state.CommandBuffer.ResetTimerPool(state.TimerPool);
+	state.CommandBuffer.ResetTimerPool(m_TimerPool);
+    std::vector<SemaphoreWait> waits = {
+        SemaphoreWait{state.ImageAvailable, VkPipelineStageFlagBits::VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT}};
     {
-        state.TimerPool.BeginScope(state.CommandBuffer.Get(), "Frame Total");
+        auto frameTimer = m_TimerPool.BeginScope(state.CommandBuffer.Get(), "Frame Total");
 
+        // Events were polled right before recording, so the uniforms reflect the latest input
+        m_FramePacing.SampleInput(frameIndex);
         auto uniforms = GetUniforms();
-        state.UniformBuffer.UploadData(GetUniforms());
-        auto bindSet = state.DescriptorSet.BindUniformBuffer(state.UniformBuffer).BindTexture(m_Texture);
-        state.TimerPool.BeginScope(state.CommandBuffer.Get(), "Draw");
-        state.CommandBuffer.DrawIndexed(m_SwapchainFramebuffers.GetCurrent(), m_MainPass, m_RenderFullscreen,
-                                        m_VertexBuffer, m_IndexBuffer, std::move(bindSet));
-        //state.CommandBuffer.Draw(m_SwapchainFramebuffers.GetCurrent(), m_MainPass, m_RenderFullscreen, m_VertexBuffer,
-         //                        std::move(bindSet));
-    }
-    state.CommandBuffer.End(std::span{ &state.ImageAvailable, 1 }, std::span{ &state.RenderFinished, 1 });
+        state.Constants.Reset();
+        state.ConstantsOffset = state.Constants.Upload(uniforms);
+        if (!IsBenchmarking())
+        {
+            waits.emplace_back(
+                m_IndirectCuller.Cull(frameIndex, CullCamera{uniforms.model, uniforms.view, uniforms.projection}));
+        }
+        // Begun before updating the benchmark, so that its GPU time includes work it records ahead of the main pass
+        auto drawTimer = m_TimerPool.BeginScope(state.CommandBuffer.Get(), "Draw");
+        if (m_Benchmark)
+        {
+            state.UniformBuffer.UploadData(uniforms);
+            m_Benchmark->Update(GetBenchmarkFrame(state, frameIndex));
+        }
+        m_FrameGraph.Execute(state.CommandBuffer);
+    }
+    state.CommandBuffer.End(std::span<const SemaphoreWait>(waits), std::span{ &state.RenderFinished, 1 });
+    m_CommandStatistics += state.CommandBuffer.GetStatistics();
     
-    activeDevice.Present(std::span{&state.RenderFinished, 1});
+    {
+        auto presentTimer = ScopedCpuTimer(m_Statistics, "CPU Present");
+        activeDevice.Present(std::span{&state.RenderFinished, 1});
+    }
+    // Only frames that recreated the swapchain have a sample, which is also part of the acquire or present time
+    if (auto recreateTime = activeDevice.TakeSwapchainRecreateTime(); recreateTime.count() > 0)
+    {
+        m_Statistics.AddSample("CPU Swapchain Recreate", recreateTime);
+    }
+    m_Statistics.EndFrame(std::cout);
+}
+
+RenderGraphPass &App::BuildFrameGraph()
+{
+    auto texture = m_FrameGraph.ImportTexture(m_Texture.GetTexture());
+    auto vertexBuffer = m_FrameGraph.ImportBuffer(m_VertexBuffer.GetBuffer());
+    auto indexBuffer = m_FrameGraph.ImportBuffer(m_IndexBuffer.GetBuffer());
+
+    auto &device = m_VulkanInstance.GetActiveDevice();
+    auto formats = device.GetSwapchainRenderingLayout(&m_DepthAttachment);
+    auto getGeneration = [&device]() { return device.GetSwapchainGeneration(); };
+    // The acquire semaphore is waited on at the color attachment output stage
+    auto swapchain = m_FrameGraph.ImportFrameTexture(RenderGraphFrameTexture{
+        formats.ColorFormats.front(), [&device]() -> const Texture & { return device.GetSwapchainTexture(); },
+        getGeneration, EResourceAccess::ColorAttachmentWrite});
+    // Shared by all frames in flight, so the previous frame's depth tests have to finish first
+    auto depth = m_FrameGraph.ImportFrameTexture(RenderGraphFrameTexture{
+        formats.DepthFormat, [this]() -> const Texture & { return m_DepthAttachment.GetTexture(); },
+        getGeneration, EResourceAccess::DepthStencilAttachment});
+
+    auto &mainPass = m_FrameGraph.AddRasterPass("Main", [this](RenderPassScope &pass) { RecordMainPass(pass); })
+                         .WriteColor(swapchain)
+                         .WriteDepth(depth)
+                         .Read(texture, EResourceAccess::GraphicsShaderRead)
+                         .Read(vertexBuffer, EResourceAccess::VertexBufferRead)
+                         .Read(indexBuffer, EResourceAccess::IndexBufferRead)
+                         // Declared even for benchmarks that replace the scene, as they're created after the graph
+                         .Read(m_FrameGraph.ImportBuffer(m_IndirectCuller.GetObjectBuffer()),
+                               EResourceAccess::GraphicsShaderRead);
+    // The offscreen swapchain has no presentation engine to hand the image to
+    if (!device.IsHeadless())
+    {
+        m_FrameGraph.AddPass("Present", [](CommandBuffer &) {})
+            .Read(swapchain, EResourceAccess::Present)
+            .SetSideEffects();
+    }
+    m_FrameGraph.Compile();
+    return mainPass;
+}
+
+void App::RecordMainPass(RenderPassScope &mainPass)
+{
+    auto frameIndex = m_CurrentFrameIndex % m_FramesInFlight;
+    auto &state = m_PerFrameState[frameIndex];
+    if (IsBenchmarking())
+    {
+        m_Benchmark->Record(mainPass, GetBenchmarkFrame(state, frameIndex));
+    }
+    // The scene is skipped until its pipeline finished compiling in the background
+    else if (auto pipeline = m_RenderFullscreen.TryGet())
+    {
+        auto bindSet = state.DescriptorSet.BindDynamicUniformBuffer(state.Constants)
+                           .BindTexture(m_Texture)
+                           .BindStorageBuffer(m_IndirectCuller.GetObjectBuffer());
+        std::array<uint32_t, 1> offsets = {state.ConstantsOffset};
+        mainPass.BindPipeline(*pipeline)
+            .BindVertexBuffer(m_VertexBuffer)
+            .BindIndexBuffer(m_IndexBuffer)
+            .BindDescriptorSet(std::move(bindSet), offsets);
+        m_IndirectCuller.Draw(mainPass, frameIndex);
+    }
 }
 
 std::vector<std::reference_wrapper<Semaphore>> App::CreateSemaphorePerInFlightFrame()
 {
     std::vector<std::reference_wrapper<Semaphore>> semaphores;
-    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    for (uint32_t i = 0; i < m_FramesInFlight; i++)
     {
         semaphores.emplace_back(m_VulkanInstance.GetActiveDevice().CreateDeviceSemaphore());
     }
@@ -161,21 +392,23 @@ std::vector<PerFrameState> App::CreatePerFrameState(VulkanDevice &vulkanDevice)
 {
     std::vector<PerFrameState> perFrameState;
     auto commandBuffers = vulkanDevice.GetGraphicsCommandBufferPool().CreateCommandBuffers(
-        MAX_FRAMES_IN_FLIGHT, m_VulkanInstance.GetActiveDevice().GetGraphicsQueue());
+        m_FramesInFlight, m_VulkanInstance.GetActiveDevice().GetGraphicsQueue());
 
-    perFrameState.reserve(MAX_FRAMES_IN_FLIGHT);
+    perFrameState.reserve(m_FramesInFlight);
     
-    for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    for (uint32_t i = 0; i < m_FramesInFlight; i++)
     {
         auto &uniformBuffer = vulkanDevice.CreateUniformBuffer<UniformConstants>();
+        // The scene uploads its constants once per frame
+        auto &constants = vulkanDevice.CreateDynamicUniformBuffer(
+            DynamicUniformBufferCreateInfo{.MaxUploads = 1, .MaxUploadSize = sizeof(UniformConstants)});
         auto descriptorSet = vulkanDevice.CreateDescriptorSet(m_DescriptorSetLayout);
+        descriptorSet.SetName("Descriptor Set frame index " + std::to_string(i), m_VulkanInstance.GetExtensionFunctionMapping());
 
         perFrameState.emplace_back(PerFrameState{vulkanDevice.CreateDeviceSemaphore(),
                                                  vulkanDevice.CreateDeviceSemaphore(), commandBuffers[i],
-                                                 uniformBuffer,
-                                                 descriptorSet, vulkanDevice.CreateTimerPool()
-            });
-        descriptorSet.SetName("Descriptor Set frame index " + std::to_string(i), m_VulkanInstance.GetExtensionFunctionMapping());
+                                                 uniformBuffer, constants,
+                                                 std::move(descriptorSet)});
         commandBuffers[i].get().SetName("Graphics CMD frame index " + std::to_string(i), m_VulkanInstance.GetExtensionFunctionMapping());
 
     }
@@ -238,8 +471,22 @@ std::vector<uint32_t> App::GetIndices() const
     */
 }
 
-const DescriptorSetLayout& App::BuildDescriptorSetLayout(VulkanDevice &vulkanDevice) const
+
+std::vector<IndirectObject> App::CreateObjectGrid() const
 {
-    return vulkanDevice.CreateDescriptorSetLayout(DescriptorSetBuilder().AddUniformBuffer().AddTexture());
-}
+    const float spacing = 2.5f;
+    const float gridOffset = (OBJECT_GRID_SIZE - 1) * spacing * 0.5f;
 
+    std::vector<IndirectObject> objects;
+    objects.reserve(OBJECT_GRID_SIZE * OBJECT_GRID_SIZE);
+    for (uint32_t x = 0; x < OBJECT_GRID_SIZE; x++)
+    {
+        for (uint32_t y = 0; y < OBJECT_GRID_SIZE; y++)
+        {
+            glm::vec3 position = {x * spacing - gridOffset, y * spacing - gridOffset, 0.0f};
+            objects.emplace_back(IndirectObject{glm::translate(glm::mat4(1.0f), position), m_Model.GetBoundingSphere(),
+                                                static_cast<uint32_t>(m_Model.GetIndices().size()), 0, 0});
+        }
+    }
+    return objects;
+}
@@ -0,0 +1,110 @@
+#include <Benchmark.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <PerDrawDataBenchmark.h>
+#include <ShaderVariantBenchmark.h>
+#include <DescriptorUpdateBenchmark.h>
+#include <ComputeBlurBenchmark.h>
+
+namespace
+{
+// Frames that are not measured, so that the first frames (e.g. pipeline warm-up, swapchain creation, cold caches in
+// the driver) don't skew the results
+constexpr uint32_t WarmupFrameCount = 16;
+}
+
+std::unique_ptr<Benchmark> Benchmark::Create(VulkanDevice &device, const RenderingLayout &rendering,
+                                             const BenchmarkCreateInfo &createInfo, uint32_t framesInFlight)
+{
+    if (auto mode = PerDrawDataBenchmark::ParseMode(createInfo.Name))
+    {
+        return std::make_unique<PerDrawDataBenchmark>(device, rendering, *mode, createInfo, framesInFlight);
+    }
+    if (auto mode = ShaderVariantBenchmark::ParseMode(createInfo.Name))
+    {
+        return std::make_unique<ShaderVariantBenchmark>(device, rendering, *mode, createInfo, framesInFlight);
+    }
+    if (auto mode = DescriptorUpdateBenchmark::ParseMode(createInfo.Name))
+    {
+        return std::make_unique<DescriptorUpdateBenchmark>(device, *mode, createInfo, framesInFlight);
+    }
+    if (ComputeBlurBenchmark::IsName(createInfo.Name))
+    {
+        return std::make_unique<ComputeBlurBenchmark>(device, createInfo, framesInFlight);
+    }
+    throw std::runtime_error("Unknown benchmark " + createInfo.Name);
+}
+
+bool Benchmark::IsKnown(std::string_view name)
+{
+    return PerDrawDataBenchmark::ParseMode(name).has_value() || ShaderVariantBenchmark::ParseMode(name).has_value() ||
+           DescriptorUpdateBenchmark::ParseMode(name).has_value() || ComputeBlurBenchmark::IsName(name);
+}
+
+Benchmark::Benchmark(uint32_t frameCount, EBenchmarkTimings timings) : m_FrameCount(frameCount), m_Timings(timings)
+{
+}
+
+void Benchmark::Update(const BenchmarkFrame &frame)
+{
+}
+
+void Benchmark::Record(RenderPassScope &renderPass, const BenchmarkFrame &frame)
+{
+}
+
+void Benchmark::AddGpuTime(std::chrono::nanoseconds gpuTime)
+{
+    // Results arrive a few frames late, so this skips a few more than just the warm-up frames
+    if (m_Timings != EBenchmarkTimings::Cpu && m_Frames > WarmupFrameCount && m_GpuSamples < m_FrameCount)
+    {
+        m_GpuTime += gpuTime;
+        m_GpuSamples++;
+    }
+}
+
+bool Benchmark::IsFinished() const
+{
+    bool cpuFinished = m_Timings == EBenchmarkTimings::Gpu || m_CpuSamples >= m_FrameCount;
+    bool gpuFinished = m_Timings == EBenchmarkTimings::Cpu || m_GpuSamples >= m_FrameCount;
+    return cpuFinished && gpuFinished;
+}
+
+bool Benchmark::AddFrame(std::optional<std::chrono::nanoseconds> cpuTime)
+{
+    m_Frames++;
+    if (!cpuTime.has_value() || m_Frames <= WarmupFrameCount || m_CpuSamples >= m_FrameCount)
+    {
+        return false;
+    }
+    m_CpuTime += *cpuTime;
+    m_CpuSamples++;
+    return true;
+}
+
+uint32_t Benchmark::GetCpuSampleCount() const
+{
+    return m_CpuSamples;
+}
+
+uint32_t Benchmark::GetGpuSampleCount() const
+{
+    return m_GpuSamples;
+}
+
+std::chrono::duration<double, std::milli> Benchmark::GetAverageCpuTime() const
+{
+    return m_CpuTime / std::max(m_CpuSamples, 1u);
+}
+
+std::chrono::duration<double, std::milli> Benchmark::GetAverageGpuTime() const
+{
+    return m_GpuTime / std::max(m_GpuSamples, 1u);
+}
+
+std::chrono::nanoseconds Benchmark::GetTotalCpuTime() const
+{
+    return m_CpuTime;
+}
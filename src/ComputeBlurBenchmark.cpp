@@ -0,0 +1,91 @@
+#include <ComputeBlurBenchmark.h>
+
+#include <array>
+#include <filesystem>
+#include <format>
+#include <span>
+
+#include <backend/VulkanDevice.h>
+#include <backend/Buffer.h>
+#include <backend/CommandBufferPool.h>
+#include <backend/Texture.h>
+
+namespace
+{
+const std::array<std::filesystem::path, 1> ShaderPaths = {"shaders/blur.comp.spv"};
+// Fixed, so that results don't depend on the window size
+constexpr uint32_t OutputWidth = 1920;
+constexpr uint32_t OutputHeight = 1080;
+// Matches local_size_x/y in blur.comp
+constexpr uint32_t GroupSize = 8;
+
+ComputePipeline CreatePipeline(VulkanDevice &device, const DescriptorSetLayout &descriptorSetLayout)
+{
+    auto builder = ComputePipelineBuilder(std::filesystem::path(ShaderPaths[0]));
+    builder.SetDescriptorSetLayout(descriptorSetLayout).AddPushConstantRange<BlurSettings>();
+    return device.CreateComputePipeline(std::move(builder));
+}
+}
+
+ComputeBlurBenchmark::ComputeBlurBenchmark(VulkanDevice &device, const BenchmarkCreateInfo &createInfo,
+                                           uint32_t framesInFlight)
+    : Benchmark(createInfo.FrameCount, EBenchmarkTimings::Gpu),
+      m_Settings{static_cast<int32_t>(createInfo.BlurRadius)},
+      m_DescriptorSetLayout(device.CreateReflectedDescriptorSetLayout(ShaderPaths)),
+      m_Pipeline(CreatePipeline(device, m_DescriptorSetLayout)), m_ArgumentBuffer(CreateArgumentBuffer(device))
+{
+    m_Outputs.reserve(framesInFlight);
+    m_DescriptorSets.reserve(framesInFlight);
+    for (uint32_t i = 0; i < framesInFlight; i++)
+    {
+        m_Outputs.emplace_back(device.CreateTexture(TextureCreateInfo{
+            OutputWidth, OutputHeight, VkFormat::VK_FORMAT_R8G8B8A8_UNORM,
+            VkImageUsageFlagBits::VK_IMAGE_USAGE_STORAGE_BIT}));
+        m_DescriptorSets.emplace_back(device.CreateDescriptorSet(m_DescriptorSetLayout));
+    }
+}
+
+DeviceBuffer &ComputeBlurBenchmark::CreateArgumentBuffer(VulkanDevice &device) const
+{
+    CreateBufferInfo bufferInfo;
+    bufferInfo.Size = sizeof(VkDispatchIndirectCommand);
+    bufferInfo.BufferUsage = VkBufferUsageFlagBits::VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+    bufferInfo.MemoryProperties = VkMemoryPropertyFlagBits::VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                  VkMemoryPropertyFlagBits::VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    auto &buffer = device.CreateBuffer(bufferInfo);
+    // Written once, the group counts don't change between frames
+    std::array arguments = {VkDispatchIndirectCommand{(OutputWidth + GroupSize - 1) / GroupSize,
+                                                      (OutputHeight + GroupSize - 1) / GroupSize, 1}};
+    buffer.UploadData(std::span(arguments));
+    return buffer;
+}
+
+bool ComputeBlurBenchmark::ReplacesScene() const
+{
+    return true;
+}
+
+void ComputeBlurBenchmark::Update(const BenchmarkFrame &frame)
+{
+    auto slot = frame.FrameIndex % m_Outputs.size();
+    auto &commandBuffer = frame.CommandBuffer;
+    commandBuffer.BindComputePipeline(m_Pipeline);
+    commandBuffer.BindComputeDescriptorSet(
+        m_DescriptorSets[slot].BindTexture(frame.Texture).BindStorageImage(m_Outputs[slot].get()), m_Pipeline);
+    commandBuffer.PushConstants(m_Pipeline, m_Settings);
+    commandBuffer.DispatchIndirect(m_ArgumentBuffer);
+    AddFrame();
+}
+
+void ComputeBlurBenchmark::Report(std::ostream &output) const
+{
+    auto width = 2 * m_Settings.Radius + 1;
+    output << std::format("Compute blur to a {}x{} storage image, {} taps per texel, {} frames\n", OutputWidth,
+                          OutputHeight, width * width, GetGpuSampleCount())
+           << std::format("  GPU dispatch: {:.4f} ms/frame\n", GetAverageGpuTime().count());
+}
+
+bool ComputeBlurBenchmark::IsName(std::string_view name)
+{
+    return name == "compute-blur";
+}
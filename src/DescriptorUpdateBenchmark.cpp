@@ -0,0 +1,109 @@
+#include <DescriptorUpdateBenchmark.h>
+
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <format>
+
+#include <backend/VulkanDevice.h>
+#include <backend/UniformBuffer.h>
+
+namespace
+{
+// The sets are never bound, the layout is only that of a typical textured draw
+const std::array<std::filesystem::path, 2> ShaderPaths = {"shaders/triangle.vert.spv", "shaders/triangle.frag.spv"};
+}
+
+DescriptorUpdateBenchmark::DescriptorUpdateBenchmark(VulkanDevice &device, DescriptorUpdateMode mode,
+                                                     const BenchmarkCreateInfo &createInfo, uint32_t framesInFlight)
+    : Benchmark(createInfo.FrameCount, EBenchmarkTimings::Cpu), m_Mode(mode), m_SetCount(createInfo.SetCount),
+      m_DescriptorSetLayout(device.CreateReflectedDescriptorSetLayout(ShaderPaths))
+{
+    if (!m_Mode.Transient)
+    {
+        m_DescriptorSets = device.CreateDescriptorSets(m_DescriptorSetLayout, m_SetCount);
+        return;
+    }
+    m_FrameAllocators.reserve(framesInFlight);
+    for (uint32_t i = 0; i < framesInFlight; i++)
+    {
+        m_FrameAllocators.emplace_back(device.CreateDescriptorAllocator());
+    }
+}
+
+bool DescriptorUpdateBenchmark::ReplacesScene() const
+{
+    // The sets are never bound, so the scene is drawn as usual
+    return false;
+}
+
+void DescriptorUpdateBenchmark::Update(const BenchmarkFrame &frame)
+{
+    uint32_t updates = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    if (m_Mode.Transient)
+    {
+        // Called after waiting for the fence of this frame slot, so the sets allocated for it before are retired
+        auto &allocator = m_FrameAllocators[frame.FrameIndex % m_FrameAllocators.size()].get();
+        allocator.Reset();
+        auto descriptorSets = allocator.Allocate(m_DescriptorSetLayout, m_SetCount);
+        updates = UpdateSets(descriptorSets, frame);
+    }
+    else
+    {
+        for (auto &descriptorSet : m_DescriptorSets)
+        {
+            // Otherwise binding the same resources again would skip the update
+            descriptorSet.InvalidateWrites();
+        }
+        updates = UpdateSets(m_DescriptorSets, frame);
+    }
+    auto duration = std::chrono::high_resolution_clock::now() - start;
+
+    if (AddFrame(std::chrono::duration_cast<std::chrono::nanoseconds>(duration)))
+    {
+        m_Updates += updates;
+    }
+}
+
+uint32_t DescriptorUpdateBenchmark::UpdateSets(std::span<DescriptorSet> descriptorSets, const BenchmarkFrame &frame)
+{
+    uint32_t updates = 0;
+    for (auto &descriptorSet : descriptorSets)
+    {
+        updates += descriptorSet.BindUniformBuffer(frame.Camera).BindTexture(frame.Texture).FlushWrites(m_Mode.Path);
+    }
+    return updates;
+}
+
+void DescriptorUpdateBenchmark::Report(std::ostream &output) const
+{
+    std::chrono::duration<double> cpuSeconds = GetTotalCpuTime();
+    auto setUpdates = static_cast<double>(GetCpuSampleCount()) * m_SetCount;
+    bool usesTemplate =
+        m_Mode.Path == EDescriptorUpdatePath::Template && m_DescriptorSetLayout.GetUpdateTemplate() != VK_NULL_HANDLE;
+    output << std::format("Descriptor updates through {}, {} {} sets, {} frames\n",
+                          usesTemplate ? "an update template" : "descriptor writes", m_SetCount,
+                          m_Mode.Transient ? "transient" : "persistent", GetCpuSampleCount())
+           << std::format("  CPU update: {:.4f} ms/frame\n", GetAverageCpuTime().count())
+           << std::format("  Sets:        {:.0f} updates/s\n", setUpdates / std::max(cpuSeconds.count(), 1e-9))
+           << std::format("  Descriptors: {:.0f} updates/s\n",
+                          static_cast<double>(m_Updates) / std::max(cpuSeconds.count(), 1e-9));
+}
+
+std::optional<DescriptorUpdateMode> DescriptorUpdateBenchmark::ParseMode(std::string_view name)
+{
+    if (name == "descriptor-writes")
+    {
+        return DescriptorUpdateMode{EDescriptorUpdatePath::Writes};
+    }
+    if (name == "descriptor-template")
+    {
+        return DescriptorUpdateMode{EDescriptorUpdatePath::Template};
+    }
+    if (name == "descriptor-transient")
+    {
+        return DescriptorUpdateMode{EDescriptorUpdatePath::Template, true};
+    }
+    return std::nullopt;
+}
@@ -0,0 +1,87 @@
+#include <FramePacing.h>
+
+#include <algorithm>
+#include <cassert>
+#include <format>
+#include <utility>
+
+uint32_t GetFramesInFlight(EFramePacingPreset preset)
+{
+    switch (preset)
+    {
+    case EFramePacingPreset::LowLatency:
+        return 1;
+    case EFramePacingPreset::MaxThroughput:
+        return 3;
+    default:
+        return DEFAULT_FRAMES_IN_FLIGHT;
+    }
+}
+
+std::optional<EFramePacingPreset> ParseFramePacingPreset(std::string_view name)
+{
+    if (name == "low-latency")
+    {
+        return EFramePacingPreset::LowLatency;
+    }
+    if (name == "max-throughput")
+    {
+        return EFramePacingPreset::MaxThroughput;
+    }
+    return std::nullopt;
+}
+
+FramePacingMonitor::FramePacingMonitor(uint32_t framesInFlight)
+    : m_FramesInFlight(framesInFlight), m_InputTimes(framesInFlight)
+{
+}
+
+void FramePacingMonitor::SampleInput(uint32_t frameSlot)
+{
+    assert(frameSlot < m_InputTimes.size() && "Frame slot out of range");
+    m_InputTimes[frameSlot] = std::chrono::steady_clock::now();
+}
+
+void FramePacingMonitor::CompleteFrame(uint32_t frameSlot, std::chrono::steady_clock::time_point slotReused,
+                                       std::optional<GpuTimeSpan> gpuFrame)
+{
+    assert(frameSlot < m_InputTimes.size() && "Frame slot out of range");
+    if (auto inputTime = std::exchange(m_InputTimes[frameSlot], std::nullopt))
+    {
+        // Ends with the fence wait when GPU bound, otherwise with recording the other frames in flight
+        auto inputToSlotReuse = std::chrono::duration_cast<std::chrono::nanoseconds>(slotReused - *inputTime);
+        m_TotalInputToSlotReuse += inputToSlotReuse;
+        m_MaxInputToSlotReuse = std::max(m_MaxInputToSlotReuse, inputToSlotReuse);
+        m_SlotReuseSamples++;
+    }
+    if (!gpuFrame.has_value())
+    {
+        // E.g. timers were not recorded, so the next frame can't be related to this one
+        m_LastGpuFrameEnd.reset();
+        return;
+    }
+    m_TotalGpuBusy += gpuFrame->End - gpuFrame->Begin;
+    if (m_LastGpuFrameEnd.has_value())
+    {
+        // Frames may overlap on the GPU when the next one started before the previous timestamp was written
+        auto bubble = std::max(gpuFrame->Begin - *m_LastGpuFrameEnd, std::chrono::nanoseconds(0));
+        m_TotalBubble += bubble;
+        m_MaxBubble = std::max(m_MaxBubble, bubble);
+        m_BubbleSamples++;
+    }
+    m_LastGpuFrameEnd = gpuFrame->End;
+}
+
+void FramePacingMonitor::Report(std::ostream &output) const
+{
+    using Millis = std::chrono::duration<double, std::milli>;
+    Millis averageInputToSlotReuse = m_TotalInputToSlotReuse / std::max(m_SlotReuseSamples, 1u);
+    Millis averageBubble = m_TotalBubble / std::max(m_BubbleSamples, 1u);
+    auto busyAndIdle = m_TotalGpuBusy + m_TotalBubble;
+    double idleShare = busyAndIdle.count() > 0 ? 100.0 * m_TotalBubble.count() / busyAndIdle.count() : 0.0;
+    output << std::format("Frame pacing with {} frame(s) in flight, {} frames\n", m_FramesInFlight, m_SlotReuseSamples)
+           << std::format("  Input to frame slot reuse: {:.3f} ms average, {:.3f} ms max\n",
+                          averageInputToSlotReuse.count(), Millis(m_MaxInputToSlotReuse).count())
+           << std::format("  GPU idle between frames: {:.3f} ms average, {:.3f} ms max, {:.1f}% of GPU time\n",
+                          averageBubble.count(), Millis(m_MaxBubble).count(), idleShare);
+}
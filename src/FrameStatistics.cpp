@@ -0,0 +1,166 @@
+#include <FrameStatistics.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <format>
+#include <fstream>
+#include <numeric>
+#include <stdexcept>
+
+namespace
+{
+using Millis = std::chrono::duration<double, std::milli>;
+
+// Nearest-rank percentile of sorted samples
+double Percentile(const std::vector<double> &sorted, double percentile)
+{
+    auto rank = static_cast<size_t>(std::ceil(percentile / 100.0 * static_cast<double>(sorted.size())));
+    return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+}
+
+FrameStatistics::FrameStatistics(const FrameStatisticsCreateInfo &createInfo) : m_CreateInfo(createInfo)
+{
+    assert(createInfo.WindowSize > 0 && "Statistics need a window of at least one sample");
+}
+
+void FrameStatistics::AddSample(std::string_view series, std::chrono::nanoseconds duration)
+{
+    auto found = m_Series.find(series);
+    if (found == m_Series.end())
+    {
+        found = m_Series.emplace(std::string(series), Series{}).first;
+        found->second.Samples.reserve(m_CreateInfo.WindowSize);
+    }
+    auto &samples = found->second;
+    if (samples.Samples.size() < m_CreateInfo.WindowSize)
+    {
+        samples.Samples.emplace_back(duration);
+    }
+    else
+    {
+        samples.Samples[samples.Next] = duration;
+    }
+    samples.Next = (samples.Next + 1) % m_CreateInfo.WindowSize;
+}
+
+void FrameStatistics::AddGpuTimings(const ResolvedTimerPool &timings)
+{
+    for (const auto &[name, duration] : timings.Timings)
+    {
+        m_GpuSeriesName.assign("GPU ");
+        m_GpuSeriesName.append(name);
+        AddSample(m_GpuSeriesName, duration);
+    }
+}
+
+void FrameStatistics::EndFrame(std::ostream &output)
+{
+    m_FrameCount++;
+    if (m_CreateInfo.ReportInterval != 0 && m_FrameCount % m_CreateInfo.ReportInterval == 0)
+    {
+        Report(output);
+    }
+}
+
+FrameStatisticsSummary FrameStatistics::Summarize(std::string_view series) const
+{
+    auto found = m_Series.find(series);
+    if (found == m_Series.end() || found->second.Samples.empty())
+    {
+        return FrameStatisticsSummary{};
+    }
+    std::vector<double> sorted;
+    sorted.reserve(found->second.Samples.size());
+    for (auto sample : found->second.Samples)
+    {
+        sorted.emplace_back(Millis(sample).count());
+    }
+    std::sort(sorted.begin(), sorted.end());
+
+    FrameStatisticsSummary summary;
+    summary.Count = sorted.size();
+    summary.Min = sorted.front();
+    summary.Max = sorted.back();
+    summary.Mean = std::accumulate(sorted.begin(), sorted.end(), 0.0) / static_cast<double>(sorted.size());
+    summary.P50 = Percentile(sorted, 50.0);
+    summary.P95 = Percentile(sorted, 95.0);
+    summary.P99 = Percentile(sorted, 99.0);
+    return summary;
+}
+
+void FrameStatistics::Report(std::ostream &output) const
+{
+    output << std::format("Frame statistics after {} frames, last {} samples (ms)\n", m_FrameCount,
+                          m_CreateInfo.WindowSize)
+           << std::format("  {:<20} {:>9} {:>9} {:>9} {:>9} {:>9} {:>9}\n", "", "min", "mean", "p50", "p95", "p99",
+                          "max");
+    for (const auto &[name, series] : m_Series)
+    {
+        auto summary = Summarize(name);
+        output << std::format("  {:<20} {:>9.3f} {:>9.3f} {:>9.3f} {:>9.3f} {:>9.3f} {:>9.3f}\n", name, summary.Min,
+                              summary.Mean, summary.P50, summary.P95, summary.P99, summary.Max);
+    }
+}
+
+void FrameStatistics::WriteCsv(std::ostream &output) const
+{
+    output << "series,count,min_ms,mean_ms,p50_ms,p95_ms,p99_ms,max_ms\n";
+    for (const auto &[name, series] : m_Series)
+    {
+        auto summary = Summarize(name);
+        output << std::format("{},{},{:.6f},{:.6f},{:.6f},{:.6f},{:.6f},{:.6f}\n", name, summary.Count, summary.Min,
+                              summary.Mean, summary.P50, summary.P95, summary.P99, summary.Max);
+    }
+}
+
+void FrameStatistics::WriteJson(std::ostream &output) const
+{
+    // Series names are scope names chosen in code, so they need no escaping
+    output << std::format("{{\n  \"frames\": {},\n  \"window\": {},\n  \"series\": {{", m_FrameCount,
+                          m_CreateInfo.WindowSize);
+    bool first = true;
+    for (const auto &[name, series] : m_Series)
+    {
+        auto summary = Summarize(name);
+        output << (first ? "\n" : ",\n")
+               << std::format("    \"{}\": {{\"count\": {}, \"min_ms\": {:.6f}, \"mean_ms\": {:.6f}, \"p50_ms\": {:.6f}, "
+                              "\"p95_ms\": {:.6f}, \"p99_ms\": {:.6f}, \"max_ms\": {:.6f}}}",
+                              name, summary.Count, summary.Min, summary.Mean, summary.P50, summary.P95, summary.P99,
+                              summary.Max);
+        first = false;
+    }
+    output << "\n  }\n}\n";
+}
+
+void FrameStatistics::Save() const
+{
+    if (!m_CreateInfo.OutputPath.has_value())
+    {
+        return;
+    }
+    std::ofstream file(*m_CreateInfo.OutputPath);
+    if (!file)
+    {
+        throw std::runtime_error("Could not open " + m_CreateInfo.OutputPath->string() + " to write statistics to");
+    }
+    if (m_CreateInfo.OutputPath->extension() == ".json")
+    {
+        WriteJson(file);
+    }
+    else
+    {
+        WriteCsv(file);
+    }
+}
+
+ScopedCpuTimer::ScopedCpuTimer(FrameStatistics &statistics, std::string_view series)
+    : m_Statistics(statistics), m_Series(series), m_Start(std::chrono::steady_clock::now())
+{
+}
+
+ScopedCpuTimer::~ScopedCpuTimer()
+{
+    m_Statistics.AddSample(m_Series, std::chrono::steady_clock::now() - m_Start);
+}
@@ -0,0 +1,152 @@
+#include <IndirectCuller.h>
+
+#include <array>
+#include <cassert>
+#include <stdexcept>
+#include <string>
+
+#include <backend/VulkanDevice.h>
+#include <backend/PhysicalDevice.h>
+#include <backend/RenderPassScope.h>
+
+namespace
+{
+const std::filesystem::path CullShaderPath = "shaders/cull.comp.spv";
+// Matches local_size_x in cull.comp
+constexpr uint32_t CullGroupSize = 64;
+}
+
+IndirectCuller::IndirectCuller(VulkanDevice &device, const IndirectCullerCreateInfo &createInfo)
+    : m_MaxObjectCount(createInfo.MaxObjectCount),
+      m_UseDrawCount(device.GetPhysicalDevice().GetVulkan12Features().drawIndirectCount),
+      m_UseMultiDraw(device.GetPhysicalDevice().GetFeatures().multiDrawIndirect),
+      m_QueueFamilies({device.GetGraphicsQueue().GetFamilyIndex(), device.GetComputeQueue().GetFamilyIndex()}),
+      m_DescriptorSetLayout(device.CreateReflectedDescriptorSetLayout(std::array{CullShaderPath})),
+      m_CullPipeline(device.CreateComputePipeline(CullShaderPath)),
+      m_Objects(CreateSharedBuffer(device, sizeof(ObjectBufferHeader) + sizeof(IndirectObject) * createInfo.MaxObjectCount,
+                                   VkBufferUsageFlagBits::VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)),
+      m_PerFrameState(CreatePerFrameState(device, createInfo.FramesInFlight))
+{
+    // The object index is passed to the vertex shader through the first instance
+    if (!device.GetPhysicalDevice().GetFeatures().drawIndirectFirstInstance)
+    {
+        throw std::runtime_error("Indirect culling requires the drawIndirectFirstInstance feature");
+    }
+}
+
+void IndirectCuller::SetObjects(std::span<const IndirectObject> objects)
+{
+    assert(objects.size() <= m_MaxObjectCount && "More objects than the culler was created for");
+    m_ObjectCount = static_cast<uint32_t>(objects.size());
+    ObjectBufferHeader header{m_ObjectCount};
+    m_Objects.UploadData(std::span<const ObjectBufferHeader>(&header, 1));
+    m_Objects.UploadData(objects, sizeof(ObjectBufferHeader));
+}
+
+SemaphoreWait IndirectCuller::Cull(uint32_t frameIndex, const CullCamera &camera)
+{
+    auto &state = m_PerFrameState[frameIndex % m_PerFrameState.size()];
+    auto &commandBuffer = state.CullCommandBuffer.get();
+    // Assumes the graphics work that consumed the previous results of this frame has finished,
+    // i.e. that the caller already waited for the frame's graphics command buffer.
+    commandBuffer.WaitFence();
+    state.Camera.get().UploadData(std::span<const CullCamera>(&camera, 1));
+    commandBuffer.Begin();
+
+    commandBuffer.FillBuffer(state.DrawCount, 0);
+    if (!m_UseDrawCount)
+    {
+        // Without a count, all `m_MaxObjectCount` commands are drawn, so the ones beyond
+        // the compacted visible set have to be empty draws
+        commandBuffer.FillBuffer(state.DrawCommands, 0);
+    }
+
+    // Binding the buffers for the compute shader makes it wait for the fills above
+    commandBuffer.BindComputePipeline(m_CullPipeline);
+    commandBuffer.BindComputeDescriptorSet(state.CullDescriptorSet.BindStorageBuffer(state.Camera)
+                                               .BindStorageBuffer(m_Objects)
+                                               .BindStorageBuffer(state.DrawCommands)
+                                               .BindStorageBuffer(state.DrawCount),
+                                           m_CullPipeline);
+    commandBuffer.Dispatch((m_ObjectCount + CullGroupSize - 1) / CullGroupSize, 1, 1);
+
+    // The semaphore signal makes the results available to everything waiting on it, so no
+    // barrier is needed even when the graphics queue is a different family. Buffers are shared
+    // concurrently, so there's no ownership transfer either.
+    commandBuffer.End(std::span<const SemaphoreWait>(), std::span{&state.CullFinished.get(), 1});
+    return SemaphoreWait{state.CullFinished, VkPipelineStageFlagBits::VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT};
+}
+
+void IndirectCuller::Draw(RenderPassScope &renderPass, uint32_t frameIndex) const
+{
+    const auto &state = m_PerFrameState[frameIndex % m_PerFrameState.size()];
+    if (m_UseDrawCount)
+    {
+        renderPass.DrawIndexedIndirectCount(state.DrawCommands, state.DrawCount, m_ObjectCount);
+    }
+    else if (m_UseMultiDraw)
+    {
+        renderPass.DrawIndexedIndirect(state.DrawCommands, m_ObjectCount);
+    }
+    else
+    {
+        // Without multiDrawIndirect an indirect draw can only hold a single command, so each object gets its own.
+        // Commands past the visible objects were zeroed before culling, so those draws are empty
+        for (uint32_t i = 0; i < m_ObjectCount; i++)
+        {
+            renderPass.DrawIndexedIndirect(state.DrawCommands, 1, i);
+        }
+    }
+}
+
+const DeviceBuffer &IndirectCuller::GetObjectBuffer() const
+{
+    return m_Objects;
+}
+
+std::vector<IndirectCuller::PerFrameCullState> IndirectCuller::CreatePerFrameState(VulkanDevice &device,
+                                                                                   uint32_t framesInFlight)
+{
+    auto commandBuffers =
+        device.GetComputeCommandBufferPool().CreateCommandBuffers(framesInFlight, device.GetComputeQueue());
+
+    std::vector<PerFrameCullState> perFrameState;
+    perFrameState.reserve(framesInFlight);
+    for (uint32_t i = 0; i < framesInFlight; i++)
+    {
+        auto &drawCommands = CreateSharedBuffer(device, sizeof(VkDrawIndexedIndirectCommand) * m_MaxObjectCount,
+                                                VkBufferUsageFlagBits::VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                                                    VkBufferUsageFlagBits::VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+                                                    VkBufferUsageFlagBits::VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+        auto &drawCount = CreateSharedBuffer(device, sizeof(uint32_t),
+                                             VkBufferUsageFlagBits::VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                                                 VkBufferUsageFlagBits::VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+                                                 VkBufferUsageFlagBits::VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+        // Written by the host every frame, read by the compute queue only
+        auto &camera = CreateSharedBuffer(device, sizeof(CullCamera),
+                                          VkBufferUsageFlagBits::VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+        auto descriptorSet = device.CreateDescriptorSet(m_DescriptorSetLayout);
+        descriptorSet.SetName("Cull Descriptor Set frame index " + std::to_string(i),
+                              device.GetExtensionFunctionMapping());
+        commandBuffers[i].get().SetName("Cull CMD frame index " + std::to_string(i),
+                                        device.GetExtensionFunctionMapping());
+        perFrameState.emplace_back(
+            PerFrameCullState{commandBuffers[i], device.CreateDeviceSemaphore(), std::move(descriptorSet), camera, drawCommands, drawCount});
+    }
+    return perFrameState;
+}
+
+DeviceBuffer &IndirectCuller::CreateSharedBuffer(VulkanDevice &device, VkDeviceSize size, VkBufferUsageFlags usage) const
+{
+    CreateBufferInfo bufferInfo;
+    bufferInfo.Size = size;
+    bufferInfo.BufferUsage = usage;
+    bufferInfo.MemoryProperties = VkMemoryPropertyFlagBits::VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                  VkMemoryPropertyFlagBits::VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    if (m_QueueFamilies[0] != m_QueueFamilies[1])
+    {
+        bufferInfo.SharingMode = VkSharingMode::VK_SHARING_MODE_CONCURRENT;
+        bufferInfo.QueueFamilies = m_QueueFamilies;
+    }
+    return device.CreateBuffer(bufferInfo);
+}
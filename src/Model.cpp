@@ -3,6 +3,7 @@
 #include <stdexcept>
 #include <iostream>
 #include <unordered_map>
+#include <algorithm>
 
 #include <tinyobj/tiny_obj_loader.h>
 
@@ -43,6 +44,7 @@ Model::Model(const std::string &path)
 			m_Indices.emplace_back(static_cast<uint32_t>(m_Indices.size()));
         }
     }
+    m_BoundingSphere = CalculateBoundingSphere();
 }
 
 const std::vector<Vertex>& Model::GetVertices() const
@@ -54,3 +56,32 @@ const std::vector<uint32_t>& Model::GetIndices() const
 {
     return m_Indices;
 }
+
+glm::vec4 Model::GetBoundingSphere() const
+{
+    return m_BoundingSphere;
+}
+
+glm::vec4 Model::CalculateBoundingSphere() const
+{
+    if (m_Vertices.empty())
+    {
+        return glm::vec4(0.0f);
+    }
+
+    // Not the tightest sphere, but cheap and good enough for culling
+    glm::vec3 min = m_Vertices.front().Position;
+    glm::vec3 max = m_Vertices.front().Position;
+    for (const auto &vertex : m_Vertices)
+    {
+        min = glm::min(min, vertex.Position);
+        max = glm::max(max, vertex.Position);
+    }
+    glm::vec3 center = (min + max) * 0.5f;
+    float radius = 0.0f;
+    for (const auto &vertex : m_Vertices)
+    {
+        radius = std::max(radius, glm::length(vertex.Position - center));
+    }
+    return glm::vec4(center, radius);
+}
@@ -0,0 +1,322 @@
+#include <PerDrawDataBenchmark.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <filesystem>
+#include <format>
+#include <stdexcept>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <backend/VulkanDevice.h>
+#include <backend/RenderPassScope.h>
+#include <backend/UniformBuffer.h>
+#include <backend/DynamicUniformBuffer.h>
+#include <backend/VertexBuffer.h>
+#include <backend/IndexBuffer.h>
+#include <backend/BindlessTextureTable.h>
+#include <backend/Texture.h>
+
+#include <Vertex.h>
+#include <InstanceData.h>
+
+namespace
+{
+// The `PerDrawObject` block in perdraw.vert
+constexpr uint32_t PerDrawBinding = 2;
+}
+
+PerDrawDataBenchmark::PerDrawDataBenchmark(VulkanDevice &device, const RenderingLayout &rendering,
+                                           EPerDrawDataMode mode, const BenchmarkCreateInfo &createInfo,
+                                           uint32_t framesInFlight)
+    : Benchmark(createInfo.FrameCount, EBenchmarkTimings::CpuAndGpu), m_Mode(mode), m_DrawCount(createInfo.DrawCount),
+      m_DescriptorSetLayout(BuildDescriptorSetLayout(device)), m_Pipeline(CreatePipeline(device, rendering)),
+      m_PerFrameState(CreatePerFrameState(device, framesInFlight)), m_Transforms(CreateTransforms())
+{
+    if (m_Mode == EPerDrawDataMode::Bindless)
+    {
+        m_BindlessTextures = &device.GetBindlessTextures();
+        return;
+    }
+    if (m_Mode != EPerDrawDataMode::Instanced)
+    {
+        return;
+    }
+    std::vector<InstanceData> instances;
+    instances.reserve(m_Transforms.size());
+    for (const auto &transform : m_Transforms)
+    {
+        instances.emplace_back(InstanceData{transform, 0});
+    }
+    m_InstanceBuffer = &device.CreateVertexBuffer(std::move(instances));
+}
+
+bool PerDrawDataBenchmark::ReplacesScene() const
+{
+    return true;
+}
+
+void PerDrawDataBenchmark::Record(RenderPassScope &renderPass, const BenchmarkFrame &frame)
+{
+    auto &state = m_PerFrameState[frame.FrameIndex % m_PerFrameState.size()];
+    auto indexCount = static_cast<uint32_t>(frame.IndexBuffer.GetIndexCount());
+
+    auto start = std::chrono::high_resolution_clock::now();
+    renderPass.BindPipeline(m_Pipeline).BindVertexBuffer(frame.VertexBuffer).BindIndexBuffer(frame.IndexBuffer);
+    if (m_Mode == EPerDrawDataMode::PushConstants)
+    {
+        RecordPushConstants(renderPass, state, frame.Camera, frame.Texture, indexCount);
+    }
+    else if (m_Mode == EPerDrawDataMode::DynamicUniformBuffer)
+    {
+        RecordDynamicUniformBuffer(renderPass, state, frame.Camera, frame.Texture, indexCount);
+    }
+    else if (m_Mode == EPerDrawDataMode::Instanced)
+    {
+        RecordInstanced(renderPass, state, frame.Camera, frame.Texture, indexCount);
+    }
+    else if (m_Mode == EPerDrawDataMode::Bindless)
+    {
+        RecordBindless(renderPass, state, frame.Camera, frame.Texture, indexCount);
+    }
+    else
+    {
+        RecordUniformBuffers(renderPass, state, frame.Camera, frame.Texture, indexCount);
+    }
+    AddFrame(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start));
+}
+
+void PerDrawDataBenchmark::Report(std::ostream &output) const
+{
+    std::chrono::duration<double, std::nano> cpuNanosPerDraw =
+        GetTotalCpuTime() / std::max(GetCpuSampleCount() * m_DrawCount, 1u);
+    output << std::format("Per draw data through {}, {} draws, {} frames\n", GetModeName(), m_DrawCount,
+                          GetCpuSampleCount())
+           << std::format("  CPU record: {:.4f} ms/frame ({:.1f} ns/draw)\n", GetAverageCpuTime().count(),
+                          cpuNanosPerDraw.count())
+           << std::format("  GPU draw:   {:.4f} ms/frame\n", GetAverageGpuTime().count());
+}
+
+std::optional<EPerDrawDataMode> PerDrawDataBenchmark::ParseMode(std::string_view name)
+{
+    if (name == "push-constants")
+    {
+        return EPerDrawDataMode::PushConstants;
+    }
+    if (name == "uniform-buffer")
+    {
+        return EPerDrawDataMode::UniformBuffer;
+    }
+    if (name == "dynamic-uniform-buffer")
+    {
+        return EPerDrawDataMode::DynamicUniformBuffer;
+    }
+    if (name == "instanced")
+    {
+        return EPerDrawDataMode::Instanced;
+    }
+    if (name == "bindless")
+    {
+        return EPerDrawDataMode::Bindless;
+    }
+    return std::nullopt;
+}
+
+const DescriptorSetLayout &PerDrawDataBenchmark::BuildDescriptorSetLayout(VulkanDevice &device) const
+{
+    if (m_Mode == EPerDrawDataMode::Bindless && !device.SupportsBindless())
+    {
+        throw std::runtime_error("The bindless benchmark needs descriptor indexing, which the device doesn't support");
+    }
+    if (m_Mode == EPerDrawDataMode::DynamicUniformBuffer)
+    {
+        // Reflection can't tell the per draw binding is dynamic
+        return device.CreateReflectedDescriptorSetLayout(
+            std::array<std::filesystem::path, 2>{GetVertexShaderPath(), GetFragmentShaderPath()},
+            std::array<uint32_t, 1>{PerDrawBinding});
+    }
+    // The uniform buffer variant has the extra per draw binding in its vertex shader
+    return device.CreateReflectedDescriptorSetLayout(
+        std::array<std::filesystem::path, 2>{GetVertexShaderPath(), GetFragmentShaderPath()});
+}
+
+const RasterPipeline &PerDrawDataBenchmark::CreatePipeline(VulkanDevice &device, const RenderingLayout &rendering) const
+{
+    bool usePushConstants = m_Mode == EPerDrawDataMode::PushConstants;
+    auto builder = RasterPipelineBuilder(GetVertexShaderPath(), GetFragmentShaderPath());
+    builder.SetVertexBindingDescription(Vertex::GetVertexBindingDescription());
+    if (m_Mode == EPerDrawDataMode::Bindless)
+    {
+        // Reflected, which puts the texture table's layout at `BindlessSetIndex` and takes the push constant range
+        // from the shader
+        return device.CreateRasterPipeline(std::move(builder), rendering);
+    }
+    builder.SetDescriptorSetLayout(m_DescriptorSetLayout);
+    if (m_Mode == EPerDrawDataMode::Instanced)
+    {
+        builder.AddVertexBindingDescription(InstanceData::GetVertexBindingDescription());
+    }
+    if (usePushConstants)
+    {
+        builder.AddPushConstantRange<PerDrawConstants>(VkShaderStageFlagBits::VK_SHADER_STAGE_VERTEX_BIT);
+    }
+    return device.CreateRasterPipeline(std::move(builder), rendering);
+}
+
+std::filesystem::path PerDrawDataBenchmark::GetVertexShaderPath() const
+{
+    switch (m_Mode)
+    {
+    case EPerDrawDataMode::PushConstants:
+        return "shaders/pushconstant.vert.spv";
+    case EPerDrawDataMode::Instanced:
+        return "shaders/instanced.vert.spv";
+    case EPerDrawDataMode::Bindless:
+        return "shaders/bindless.vert.spv";
+    default:
+        return "shaders/perdraw.vert.spv";
+    }
+}
+
+std::filesystem::path PerDrawDataBenchmark::GetFragmentShaderPath() const
+{
+    return m_Mode == EPerDrawDataMode::Bindless ? "shaders/bindless.frag.spv" : "shaders/triangle.frag.spv";
+}
+
+std::vector<PerDrawDataBenchmark::PerFrameDrawState> PerDrawDataBenchmark::CreatePerFrameState(VulkanDevice &device,
+                                                                                              uint32_t framesInFlight) const
+{
+    std::vector<PerFrameDrawState> perFrameState(framesInFlight);
+    if (m_Mode != EPerDrawDataMode::UniformBuffer)
+    {
+        for (auto &state : perFrameState)
+        {
+            state.SharedDescriptorSet.emplace(device.CreateDescriptorSet(m_DescriptorSetLayout));
+            if (m_Mode == EPerDrawDataMode::DynamicUniformBuffer)
+            {
+                // An upload per draw
+                state.DrawRing = &device.CreateDynamicUniformBuffer(DynamicUniformBufferCreateInfo{
+                    .MaxUploads = std::max(m_DrawCount, 1u), .MaxUploadSize = sizeof(PerDrawConstants)});
+            }
+        }
+        return perFrameState;
+    }
+
+    for (auto &state : perFrameState)
+    {
+        state.DrawDescriptorSets = device.CreateDescriptorSets(m_DescriptorSetLayout, m_DrawCount);
+        state.DrawUniformBuffers.reserve(m_DrawCount);
+        for (uint32_t i = 0; i < m_DrawCount; i++)
+        {
+            state.DrawUniformBuffers.emplace_back(device.CreateUniformBuffer<PerDrawConstants>());
+        }
+    }
+    return perFrameState;
+}
+
+std::vector<glm::mat4> PerDrawDataBenchmark::CreateTransforms() const
+{
+    // Shrink all copies into a grid that fits in the same space as the single model
+    auto gridSize = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<float>(m_DrawCount))));
+    float scale = 1.0f / gridSize;
+
+    std::vector<glm::mat4> transforms;
+    transforms.reserve(m_DrawCount);
+    for (uint32_t i = 0; i < m_DrawCount; i++)
+    {
+        glm::vec3 position = {((i % gridSize) + 0.5f) * scale * 2.0f - 1.0f,
+                              ((i / gridSize) + 0.5f) * scale * 2.0f - 1.0f, 0.0f};
+        transforms.emplace_back(glm::scale(glm::translate(glm::mat4(1.0f), position), glm::vec3(scale)));
+    }
+    return transforms;
+}
+
+void PerDrawDataBenchmark::RecordPushConstants(RenderPassScope &renderPass, PerFrameDrawState &state,
+                                               const UniformBuffer &camera, Texture2D &texture, uint32_t indexCount)
+{
+    renderPass.BindDescriptorSet(state.SharedDescriptorSet->BindUniformBuffer(camera).BindTexture(texture));
+    for (const auto &transform : m_Transforms)
+    {
+        renderPass.PushConstants(VkShaderStageFlagBits::VK_SHADER_STAGE_VERTEX_BIT, PerDrawConstants{transform});
+        renderPass.DrawIndexed(DrawIndexedParameters{indexCount});
+    }
+}
+
+void PerDrawDataBenchmark::RecordUniformBuffers(RenderPassScope &renderPass, PerFrameDrawState &state,
+                                                const UniformBuffer &camera, Texture2D &texture, uint32_t indexCount)
+{
+    for (uint32_t i = 0; i < m_DrawCount; i++)
+    {
+        auto &uniformBuffer = state.DrawUniformBuffers[i].get();
+        uniformBuffer.UploadData(PerDrawConstants{m_Transforms[i]});
+        renderPass.BindDescriptorSet(
+            state.DrawDescriptorSets[i].BindUniformBuffer(camera).BindTexture(texture).BindUniformBuffer(uniformBuffer));
+        renderPass.DrawIndexed(DrawIndexedParameters{indexCount});
+    }
+}
+
+void PerDrawDataBenchmark::RecordDynamicUniformBuffer(RenderPassScope &renderPass, PerFrameDrawState &state,
+                                                      const UniformBuffer &camera, Texture2D &texture,
+                                                      uint32_t indexCount)
+{
+    // The frame's fence was waited on before recording, so its previous slices are no longer read
+    auto &ring = *state.DrawRing;
+    ring.Reset();
+    for (uint32_t i = 0; i < m_DrawCount; i++)
+    {
+        std::array<uint32_t, 1> offsets = {ring.Upload(PerDrawConstants{m_Transforms[i]})};
+        if (i == 0)
+        {
+            renderPass.BindDescriptorSet(
+                state.SharedDescriptorSet->BindUniformBuffer(camera).BindTexture(texture).BindDynamicUniformBuffer(ring),
+                offsets);
+        }
+        else
+        {
+            renderPass.BindDescriptorSet(*state.SharedDescriptorSet, offsets);
+        }
+        renderPass.DrawIndexed(DrawIndexedParameters{indexCount});
+    }
+}
+
+void PerDrawDataBenchmark::RecordInstanced(RenderPassScope &renderPass, PerFrameDrawState &state,
+                                           const UniformBuffer &camera, Texture2D &texture, uint32_t indexCount)
+{
+    renderPass.BindVertexBuffer(*m_InstanceBuffer, 1)
+        .BindDescriptorSet(state.SharedDescriptorSet->BindUniformBuffer(camera).BindTexture(texture));
+    renderPass.DrawIndexedInstanced(indexCount, m_DrawCount);
+}
+
+void PerDrawDataBenchmark::RecordBindless(RenderPassScope &renderPass, PerFrameDrawState &state,
+                                          const UniformBuffer &camera, Texture2D &texture, uint32_t indexCount)
+{
+    // The table isn't tracked, but the main pass already declares its read of the scene texture
+    uint32_t textureIndex = *texture.GetBindlessIndex();
+    renderPass.BindDescriptorSet(state.SharedDescriptorSet->BindUniformBuffer(camera))
+        .BindBindlessTextures(*m_BindlessTextures);
+    for (const auto &transform : m_Transforms)
+    {
+        renderPass.PushConstants(VkShaderStageFlagBits::VK_SHADER_STAGE_VERTEX_BIT,
+                                 BindlessDrawConstants{transform, textureIndex});
+        renderPass.DrawIndexed(DrawIndexedParameters{indexCount});
+    }
+}
+
+const char *PerDrawDataBenchmark::GetModeName() const
+{
+    switch (m_Mode)
+    {
+    case EPerDrawDataMode::PushConstants:
+        return "push constants";
+    case EPerDrawDataMode::UniformBuffer:
+        return "uniform buffers";
+    case EPerDrawDataMode::DynamicUniformBuffer:
+        return "a dynamic uniform buffer";
+    case EPerDrawDataMode::Instanced:
+        return "a per-instance vertex stream";
+    case EPerDrawDataMode::Bindless:
+        return "push constants indexing bindless textures";
+    }
+    return "unknown";
+}
@@ -0,0 +1,87 @@
+#include <ShaderVariantBenchmark.h>
+
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <format>
+
+#include <backend/VulkanDevice.h>
+#include <backend/RenderPassScope.h>
+#include <backend/UniformBuffer.h>
+#include <backend/VertexBuffer.h>
+#include <backend/IndexBuffer.h>
+
+#include <Vertex.h>
+
+namespace
+{
+const std::array<std::filesystem::path, 2> ShaderPaths = {"shaders/triangle.vert.spv", "shaders/variant.frag.spv"};
+}
+
+ShaderVariantBenchmark::ShaderVariantBenchmark(VulkanDevice &device, const RenderingLayout &rendering,
+                                               EShaderVariantMode mode, const BenchmarkCreateInfo &createInfo,
+                                               uint32_t framesInFlight)
+    : Benchmark(createInfo.FrameCount, EBenchmarkTimings::Gpu), m_Mode(mode),
+      m_Settings{createInfo.TapCount, createInfo.Grayscale ? VK_TRUE : VK_FALSE}, m_DescriptorSetLayout(device.CreateReflectedDescriptorSetLayout(ShaderPaths)),
+      m_Pipeline(CreatePipeline(device, rendering))
+{
+    m_DescriptorSets.reserve(framesInFlight);
+    for (uint32_t i = 0; i < framesInFlight; i++)
+    {
+        m_DescriptorSets.emplace_back(device.CreateDescriptorSet(m_DescriptorSetLayout));
+    }
+}
+
+bool ShaderVariantBenchmark::ReplacesScene() const
+{
+    return true;
+}
+
+void ShaderVariantBenchmark::Record(RenderPassScope &renderPass, const BenchmarkFrame &frame)
+{
+    auto &descriptorSet = m_DescriptorSets[frame.FrameIndex % m_DescriptorSets.size()];
+    renderPass.BindPipeline(m_Pipeline).BindVertexBuffer(frame.VertexBuffer).BindIndexBuffer(frame.IndexBuffer);
+    renderPass.BindDescriptorSet(descriptorSet.BindUniformBuffer(frame.Camera).BindTexture(frame.Texture));
+    // Also pushed when specialized, where the shader ignores them, so that only the shader differs
+    renderPass.PushConstants(VkShaderStageFlagBits::VK_SHADER_STAGE_FRAGMENT_BIT, m_Settings);
+    renderPass.DrawIndexed(DrawIndexedParameters{static_cast<uint32_t>(frame.IndexBuffer.GetIndexCount())});
+    AddFrame();
+}
+
+void ShaderVariantBenchmark::Report(std::ostream &output) const
+{
+    output << std::format("Shading settings through {}, {} taps, grayscale {}, {} frames\n",
+                          m_Mode == EShaderVariantMode::Specialized ? "specialization constants" : "push constants",
+                          m_Settings.TapCount, m_Settings.Grayscale ? "on" : "off", GetGpuSampleCount())
+           << std::format("  GPU draw:   {:.4f} ms/frame\n", GetAverageGpuTime().count());
+}
+
+std::optional<EShaderVariantMode> ShaderVariantBenchmark::ParseMode(std::string_view name)
+{
+    if (name == "runtime-branching")
+    {
+        return EShaderVariantMode::RuntimeBranching;
+    }
+    if (name == "specialized")
+    {
+        return EShaderVariantMode::Specialized;
+    }
+    return std::nullopt;
+}
+
+const RasterPipeline &ShaderVariantBenchmark::CreatePipeline(VulkanDevice &device, const RenderingLayout &rendering) const
+{
+    auto builder = RasterPipelineBuilder(ShaderPaths[0].string(), ShaderPaths[1].string());
+    builder.SetVertexBindingDescription(Vertex::GetVertexBindingDescription()).SetDescriptorSetLayout(m_DescriptorSetLayout);
+    builder.AddPushConstantRange<ShadingSettings>(VkShaderStageFlagBits::VK_SHADER_STAGE_FRAGMENT_BIT);
+    if (m_Mode == EShaderVariantMode::Specialized)
+    {
+        auto values = ShadingSpecialization{VK_TRUE, m_Settings.TapCount, m_Settings.Grayscale};
+        builder.SetSpecializationConstants(VkShaderStageFlagBits::VK_SHADER_STAGE_FRAGMENT_BIT,
+                                           SpecializationConstants(values)
+                                               .Map(0, &ShadingSpecialization::UseSpecialization)
+                                               .Map(1, &ShadingSpecialization::TapCount)
+                                               .Map(2, &ShadingSpecialization::Grayscale));
+    }
+    return device.CreateRasterPipeline(std::move(builder), rendering);
+}
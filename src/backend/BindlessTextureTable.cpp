@@ -0,0 +1,177 @@
+#include <backend/BindlessTextureTable.h>
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <span>
+#include <stdexcept>
+#include <utility>
+
+namespace
+{
+constexpr uint32_t TextureBinding = 0;
+constexpr uint32_t SamplerBinding = 1;
+
+std::vector<VkDescriptorSetLayoutBinding> GetBindings(const BindlessTextureTableCreateInfo &createInfo)
+{
+    auto stages = VkShaderStageFlagBits::VK_SHADER_STAGE_VERTEX_BIT | VkShaderStageFlagBits::VK_SHADER_STAGE_FRAGMENT_BIT |
+                  VkShaderStageFlagBits::VK_SHADER_STAGE_COMPUTE_BIT;
+    return {
+        VkDescriptorSetLayoutBinding{TextureBinding, VkDescriptorType::VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+                                     createInfo.MaxTextures, static_cast<VkShaderStageFlags>(stages), nullptr},
+        VkDescriptorSetLayoutBinding{SamplerBinding, VkDescriptorType::VK_DESCRIPTOR_TYPE_SAMPLER,
+                                     createInfo.MaxSamplers, static_cast<VkShaderStageFlags>(stages), nullptr}};
+}
+
+DescriptorSetLayout CreateLayout(VkDevice device, const BindlessTextureTableCreateInfo &createInfo)
+{
+    // Entries that no shader reads don't have to be written, and may be written while the set is bound
+    VkDescriptorBindingFlags flags = VkDescriptorBindingFlagBits::VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+                                     VkDescriptorBindingFlagBits::VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT;
+    std::array<VkDescriptorBindingFlags, 2> bindingFlags = {flags, flags};
+    return DescriptorSetLayout(device, GetBindings(createInfo),
+                               VkDescriptorSetLayoutCreateFlagBits::VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT,
+                               bindingFlags);
+}
+
+DescriptorPool CreatePool(VkDevice device, const BindlessTextureTableCreateInfo &createInfo)
+{
+    std::array<VkDescriptorPoolSize, 2> poolSizes = {
+        VkDescriptorPoolSize{VkDescriptorType::VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, createInfo.MaxTextures},
+        VkDescriptorPoolSize{VkDescriptorType::VK_DESCRIPTOR_TYPE_SAMPLER, createInfo.MaxSamplers}};
+    return DescriptorPool(device, poolSizes, 1,
+                          VkDescriptorPoolCreateFlagBits::VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT);
+}
+}
+
+BindlessTextureTable::BindlessTextureTable(VkDevice device, const BindlessTextureTableCreateInfo &createInfo)
+    : m_Device(device), m_MaxTextures(createInfo.MaxTextures), m_MaxSamplers(createInfo.MaxSamplers),
+      m_Layout(CreateLayout(device, createInfo)), m_Pool(CreatePool(device, createInfo))
+{
+    assert(createInfo.MaxSamplers > 0 && "Needs room for the default sampler");
+    auto layout = m_Layout.Get();
+    if (m_Pool.TryAllocate(std::span(&layout, 1), std::span(&m_DescriptorSet, 1)) != VkResult::VK_SUCCESS)
+    {
+        throw std::runtime_error("Could not allocate bindless descriptor set");
+    }
+    m_DefaultSampler = CreateDefaultSampler(createInfo.MaxAnisotropy);
+    RegisterSampler(m_DefaultSampler);
+}
+
+BindlessTextureTable::BindlessTextureTable(BindlessTextureTable &&other)
+    : m_Device(other.m_Device), m_MaxTextures(other.m_MaxTextures), m_MaxSamplers(other.m_MaxSamplers),
+      m_Layout(std::move(other.m_Layout)), m_Pool(std::move(other.m_Pool)),
+      m_DescriptorSet(std::exchange(other.m_DescriptorSet, VK_NULL_HANDLE)),
+      m_DefaultSampler(std::exchange(other.m_DefaultSampler, VK_NULL_HANDLE)), m_Samplers(std::move(other.m_Samplers)),
+      m_FreeTextureSlots(std::move(other.m_FreeTextureSlots)), m_NextTextureSlot(other.m_NextTextureSlot)
+{
+}
+
+BindlessTextureTable::~BindlessTextureTable()
+{
+    // The set is freed with the pool
+    if (m_DefaultSampler != VK_NULL_HANDLE)
+    {
+        vkDestroySampler(m_Device, m_DefaultSampler, nullptr);
+    }
+}
+
+uint32_t BindlessTextureTable::RegisterTexture(VkImageView view)
+{
+    uint32_t index;
+    if (!m_FreeTextureSlots.empty())
+    {
+        index = m_FreeTextureSlots.back();
+        m_FreeTextureSlots.pop_back();
+    }
+    else
+    {
+        if (m_NextTextureSlot == m_MaxTextures)
+        {
+            throw std::runtime_error("Bindless texture table is full");
+        }
+        index = m_NextTextureSlot++;
+    }
+    Write(TextureBinding, index, VkDescriptorType::VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+          VkDescriptorImageInfo{VK_NULL_HANDLE, view, VkImageLayout::VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL});
+    return index;
+}
+
+void BindlessTextureTable::UnregisterTexture(uint32_t textureIndex)
+{
+    assert(textureIndex < m_NextTextureSlot &&
+           std::find(m_FreeTextureSlots.begin(), m_FreeTextureSlots.end(), textureIndex) == m_FreeTextureSlots.end() &&
+           "Texture is not registered");
+    // The stale entry is left as is, which is fine as long as no shader reads it
+    m_FreeTextureSlots.emplace_back(textureIndex);
+}
+
+uint32_t BindlessTextureTable::RegisterSampler(VkSampler sampler)
+{
+    auto existing = std::find(m_Samplers.begin(), m_Samplers.end(), sampler);
+    if (existing != m_Samplers.end())
+    {
+        return static_cast<uint32_t>(std::distance(m_Samplers.begin(), existing));
+    }
+    if (m_Samplers.size() == m_MaxSamplers)
+    {
+        throw std::runtime_error("Bindless sampler table is full");
+    }
+    auto index = static_cast<uint32_t>(m_Samplers.size());
+    m_Samplers.emplace_back(sampler);
+    Write(SamplerBinding, index, VkDescriptorType::VK_DESCRIPTOR_TYPE_SAMPLER,
+          VkDescriptorImageInfo{sampler, VK_NULL_HANDLE, VkImageLayout::VK_IMAGE_LAYOUT_UNDEFINED});
+    return index;
+}
+
+const DescriptorSetLayout &BindlessTextureTable::GetLayout() const
+{
+    return m_Layout;
+}
+
+VkDescriptorSet BindlessTextureTable::Get() const
+{
+    return m_DescriptorSet;
+}
+
+void BindlessTextureTable::Write(uint32_t binding, uint32_t arrayElement, VkDescriptorType descriptorType,
+                                 const VkDescriptorImageInfo &imageInfo)
+{
+    VkWriteDescriptorSet write{};
+    write.sType = VkStructureType::VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = m_DescriptorSet;
+    write.dstBinding = binding;
+    write.dstArrayElement = arrayElement;
+    write.descriptorType = descriptorType;
+    write.descriptorCount = 1;
+    write.pImageInfo = &imageInfo;
+    vkUpdateDescriptorSets(m_Device, 1, &write, 0, nullptr);
+}
+
+VkSampler BindlessTextureTable::CreateDefaultSampler(float maxAnisotropy) const
+{
+    VkSamplerCreateInfo samplerInfo{};
+    samplerInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = VkFilter::VK_FILTER_LINEAR;
+    samplerInfo.minFilter = VkFilter::VK_FILTER_LINEAR;
+    samplerInfo.addressModeU = VkSamplerAddressMode::VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.addressModeV = VkSamplerAddressMode::VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.addressModeW = VkSamplerAddressMode::VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.anisotropyEnable = maxAnisotropy > 1.0f ? VK_TRUE : VK_FALSE;
+    samplerInfo.maxAnisotropy = maxAnisotropy;
+    samplerInfo.borderColor = VkBorderColor::VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+    samplerInfo.unnormalizedCoordinates = VK_FALSE;
+    samplerInfo.compareEnable = VK_FALSE;
+    samplerInfo.compareOp = VkCompareOp::VK_COMPARE_OP_ALWAYS;
+    samplerInfo.mipmapMode = VkSamplerMipmapMode::VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    samplerInfo.mipLodBias = 0.0f;
+    samplerInfo.minLod = 0.0f;
+    samplerInfo.maxLod = 0.0f;
+
+    VkSampler sampler;
+    if (vkCreateSampler(m_Device, &samplerInfo, nullptr, &sampler) != VkResult::VK_SUCCESS)
+    {
+        throw std::runtime_error("Could not create default bindless sampler");
+    }
+    return sampler;
+}
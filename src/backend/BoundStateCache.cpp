@@ -0,0 +1,168 @@
+#include <backend/BoundStateCache.h>
+
+#include <algorithm>
+#include <cassert>
+#include <format>
+#include <numeric>
+
+namespace
+{
+constexpr std::array<const char *, static_cast<size_t>(EBoundState::Count)> BoundStateNames = {
+    "Pipeline", "Viewport", "Scissor", "Vertex buffer", "Index buffer", "Descriptor set", "Descriptor write"};
+}
+
+uint32_t CommandStatistics::GetEmitted(EBoundState state) const
+{
+    return Emitted[static_cast<size_t>(state)];
+}
+
+uint32_t CommandStatistics::GetSkipped(EBoundState state) const
+{
+    return Skipped[static_cast<size_t>(state)];
+}
+
+uint32_t CommandStatistics::GetTotalEmitted() const
+{
+    return std::accumulate(Emitted.begin(), Emitted.end(), 0u);
+}
+
+uint32_t CommandStatistics::GetTotalSkipped() const
+{
+    return std::accumulate(Skipped.begin(), Skipped.end(), 0u);
+}
+
+CommandStatistics &CommandStatistics::operator+=(const CommandStatistics &other)
+{
+    for (size_t i = 0; i < Emitted.size(); i++)
+    {
+        Emitted[i] += other.Emitted[i];
+        Skipped[i] += other.Skipped[i];
+    }
+    DescriptorUpdates += other.DescriptorUpdates;
+    return *this;
+}
+
+void CommandStatistics::Report(std::ostream &stream) const
+{
+    stream << std::format("Bound state: {} emitted, {} skipped as redundant\n", GetTotalEmitted(), GetTotalSkipped());
+    for (size_t i = 0; i < BoundStateNames.size(); i++)
+    {
+        stream << std::format("  {}: {} emitted, {} skipped\n", BoundStateNames[i], Emitted[i], Skipped[i]);
+    }
+    stream << std::format("  Descriptor updates: {}\n", DescriptorUpdates);
+}
+
+void BoundStateCache::Invalidate()
+{
+    m_BindPoints = {};
+    m_Viewport.reset();
+    m_Scissor.reset();
+    m_VertexBuffers.clear();
+    m_IndexBuffer.reset();
+}
+
+void BoundStateCache::ResetStatistics()
+{
+    m_Statistics = {};
+}
+
+const CommandStatistics &BoundStateCache::GetStatistics() const
+{
+    return m_Statistics;
+}
+
+bool BoundStateCache::SetPipeline(VkPipelineBindPoint bindPoint, VkPipeline pipeline)
+{
+    auto &bound = m_BindPoints[BindPointIndex(bindPoint)].Pipeline;
+    bool changed = bound != pipeline;
+    bound = pipeline;
+    return Record(EBoundState::Pipeline, changed);
+}
+
+bool BoundStateCache::SetViewport(const VkViewport &viewport)
+{
+    bool changed = !m_Viewport.has_value() || m_Viewport->x != viewport.x || m_Viewport->y != viewport.y ||
+                   m_Viewport->width != viewport.width || m_Viewport->height != viewport.height ||
+                   m_Viewport->minDepth != viewport.minDepth || m_Viewport->maxDepth != viewport.maxDepth;
+    m_Viewport = viewport;
+    return Record(EBoundState::Viewport, changed);
+}
+
+bool BoundStateCache::SetScissor(const VkRect2D &scissor)
+{
+    bool changed = !m_Scissor.has_value() || m_Scissor->offset.x != scissor.offset.x ||
+                   m_Scissor->offset.y != scissor.offset.y || m_Scissor->extent.width != scissor.extent.width ||
+                   m_Scissor->extent.height != scissor.extent.height;
+    m_Scissor = scissor;
+    return Record(EBoundState::Scissor, changed);
+}
+
+bool BoundStateCache::SetVertexBuffer(uint32_t binding, VkBuffer buffer, VkDeviceSize offset)
+{
+    if (binding >= m_VertexBuffers.size())
+    {
+        m_VertexBuffers.resize(binding + 1);
+    }
+    auto &bound = m_VertexBuffers[binding];
+    bool changed = bound.Buffer != buffer || bound.Offset != offset;
+    bound = BoundVertexBuffer{buffer, offset};
+    return Record(EBoundState::VertexBuffer, changed);
+}
+
+bool BoundStateCache::SetIndexBuffer(VkBuffer buffer, VkDeviceSize offset, VkIndexType indexType)
+{
+    bool changed = !m_IndexBuffer.has_value() || m_IndexBuffer->Buffer != buffer || m_IndexBuffer->Offset != offset ||
+                   m_IndexBuffer->IndexType != indexType;
+    m_IndexBuffer = BoundIndexBuffer{buffer, offset, indexType};
+    return Record(EBoundState::IndexBuffer, changed);
+}
+
+bool BoundStateCache::SetDescriptorSet(VkPipelineBindPoint bindPoint, VkPipelineLayout layout, uint32_t setIndex,
+                                       VkDescriptorSet descriptorSet, std::span<const uint32_t> dynamicOffsets)
+{
+    auto &descriptorSets = m_BindPoints[BindPointIndex(bindPoint)].DescriptorSets;
+    if (setIndex >= descriptorSets.size())
+    {
+        descriptorSets.resize(setIndex + 1);
+    }
+    auto &bound = descriptorSets[setIndex];
+    bool layoutChanged = bound.Layout != layout;
+    bool changed = layoutChanged || bound.DescriptorSet != descriptorSet ||
+                   !std::equal(bound.DynamicOffsets.begin(), bound.DynamicOffsets.end(), dynamicOffsets.begin(),
+                               dynamicOffsets.end());
+    if (layoutChanged)
+    {
+        // Binding with a different layout may disturb any of the higher sets, so
+        // conservatively assume they are no longer bound
+        descriptorSets.resize(setIndex + 1);
+    }
+    bound.Layout = layout;
+    bound.DescriptorSet = descriptorSet;
+    bound.DynamicOffsets.assign(dynamicOffsets.begin(), dynamicOffsets.end());
+    return Record(EBoundState::DescriptorSet, changed);
+}
+
+void BoundStateCache::RecordDescriptorWrites(uint32_t written, uint32_t skipped)
+{
+    m_Statistics.Emitted[static_cast<size_t>(EBoundState::DescriptorWrite)] += written;
+    m_Statistics.Skipped[static_cast<size_t>(EBoundState::DescriptorWrite)] += skipped;
+    if (written > 0)
+    {
+        m_Statistics.DescriptorUpdates++;
+    }
+}
+
+size_t BoundStateCache::BindPointIndex(VkPipelineBindPoint bindPoint)
+{
+    assert((bindPoint == VkPipelineBindPoint::VK_PIPELINE_BIND_POINT_GRAPHICS ||
+            bindPoint == VkPipelineBindPoint::VK_PIPELINE_BIND_POINT_COMPUTE) &&
+           "Unsupported pipeline bind point");
+    return bindPoint == VkPipelineBindPoint::VK_PIPELINE_BIND_POINT_GRAPHICS ? 0 : 1;
+}
+
+bool BoundStateCache::Record(EBoundState state, bool changed)
+{
+    auto &counters = changed ? m_Statistics.Emitted : m_Statistics.Skipped;
+    counters[static_cast<size_t>(state)]++;
+    return changed;
+}
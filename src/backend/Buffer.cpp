@@ -13,6 +13,12 @@ DeviceBuffer::DeviceBuffer(VkDevice device, const PhysicalDevice &physicalDevice
 	bufferCreateInfo.size = bufferInfo.Size;
 	bufferCreateInfo.usage = bufferInfo.BufferUsage;
 	bufferCreateInfo.sharingMode = bufferInfo.SharingMode;
+    if (bufferInfo.SharingMode == VkSharingMode::VK_SHARING_MODE_CONCURRENT)
+    {
+        assert(bufferInfo.QueueFamilies.size() > 1 && "Concurrent sharing requires at least two queue families");
+        bufferCreateInfo.queueFamilyIndexCount = static_cast<uint32_t>(bufferInfo.QueueFamilies.size());
+        bufferCreateInfo.pQueueFamilyIndices = bufferInfo.QueueFamilies.data();
+    }
 	bufferCreateInfo.flags = 0;
 
 	if (vkCreateBuffer(m_Device, &bufferCreateInfo, nullptr, &m_Buffer))
@@ -48,7 +54,7 @@ DeviceBuffer::DeviceBuffer(VkDevice device, const PhysicalDevice &physicalDevice
 DeviceBuffer::DeviceBuffer(DeviceBuffer &&other)
     : m_Device(other.m_Device), m_Buffer(std::exchange(other.m_Buffer, VK_NULL_HANDLE)),
       m_Memory(std::exchange(other.m_Memory, VK_NULL_HANDLE)), m_CreateInfo(std::move(other.m_CreateInfo)),
-      m_MappedBuffer(std::move(other.m_MappedBuffer))
+      m_MappedBuffer(std::move(other.m_MappedBuffer)), m_State(std::move(other.m_State))
 {
 }
 
@@ -59,6 +65,7 @@ DeviceBuffer &DeviceBuffer::operator=(DeviceBuffer &&other)
     m_Memory = std::exchange(other.m_Memory, VK_NULL_HANDLE);
     m_CreateInfo = std::move(other.m_CreateInfo);
     m_MappedBuffer = std::move(other.m_MappedBuffer);
+    m_State = std::move(other.m_State);
     return *this;
 }
 
@@ -82,37 +89,9 @@ VkDeviceSize DeviceBuffer::GetSize() const
     return m_CreateInfo.Size;
 }
 
-void DeviceBuffer::Transfer(TransferOp transferOperation, const CommandBuffer& commandBuffer)
+ResourceState &DeviceBuffer::GetState() const
 {
-    assert(!m_PendingAcquireBarrier.has_value() && "Re-release before acquire");
-    BufferMemoryBarrier releaseBarrier{
-        (*this),
-        {{commandBuffer.GetQueue(), transferOperation.Destination}},
-        VkAccessFlagBits::VK_ACCESS_TRANSFER_WRITE_BIT,
-        0,
-        VkPipelineStageFlagBits::VK_PIPELINE_STAGE_TRANSFER_BIT,
-        VkPipelineStageFlagBits::VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
-    };
-	commandBuffer.InsertBarrier(releaseBarrier);
-	
-    BufferMemoryBarrier acquireBarrier{
-        (*this),
-        {{commandBuffer.GetQueue(), transferOperation.Destination}},
-        0,
-        transferOperation.DestinationAccessMask,
-        VkPipelineStageFlagBits::VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-        transferOperation.DestinationPipelineStage,
-    };
-    m_PendingAcquireBarrier.emplace(acquireBarrier);
-}
-
-std::optional<BufferMemoryBarrier> DeviceBuffer::TakePendingAcquire()
-{
-    if (m_PendingReleaseFence)
-    {
-        m_PendingReleaseFence->WaitAndReset();
-    }
-    return std::move(m_PendingAcquireBarrier);
+    return m_State;
 }
 
 VkDescriptorBufferInfo DeviceBuffer::GetDescriptorInfo() const
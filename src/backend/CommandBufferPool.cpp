@@ -5,6 +5,9 @@
 #include <stdexcept>
 #include <iostream>
 #include <span>
+#include <array>
+#include <atomic>
+#include <algorithm>
 
 #include <backend/VulkanDevice.h>
 #include <backend/Framebuffer.h>
@@ -12,17 +15,107 @@
 #include <backend/VertexBuffer.h>
 #include <backend/IndexBuffer.h>
 #include <backend/Pipeline.h>
+#include <backend/ComputePipeline.h>
 #include <backend/Barrier.h>
 #include <backend/DescriptorSetBuilder.h>
 #include <backend/ExtensionFunctionMapping.h>
 #include <backend/DebugMarker.h>
 #include <backend/VulkanInstance.h>
+#include <backend/Viewport.h>
+#include <backend/Texture.h>
 
-CommandBuffer::CommandBuffer(VkCommandBuffer &&commandBuffer, VkDevice device, Queue queue) : 
+namespace
+{
+// Unique across all command buffers, so that resource state can tell recordings apart
+std::atomic<uint64_t> RecordingCounter = 0;
+
+/// <summary>
+/// Transitions every subresource of `range` and adds the resulting barriers. Emits a single barrier
+/// for the range when all subresources need the same transition. Returns whether any were added
+/// </summary>
+template <typename TransitionFunction>
+bool AddImageTransitions(BarrierBatch &batch, const Texture &texture, VkImageSubresourceRange range,
+                         TransitionFunction transition)
+{
+    if (range.levelCount == VK_REMAINING_MIP_LEVELS)
+    {
+        range.levelCount = texture.GetMipLevels() - range.baseMipLevel;
+    }
+    if (range.layerCount == VK_REMAINING_ARRAY_LAYERS)
+    {
+        range.layerCount = texture.GetArrayLayers() - range.baseArrayLayer;
+    }
+
+    std::vector<std::optional<StateTransition>> transitions;
+    transitions.reserve(range.levelCount * range.layerCount);
+    for (uint32_t layer = range.baseArrayLayer; layer < range.baseArrayLayer + range.layerCount; layer++)
+    {
+        for (uint32_t mip = range.baseMipLevel; mip < range.baseMipLevel + range.levelCount; mip++)
+        {
+            transitions.emplace_back(transition(texture.GetState(mip, layer)));
+        }
+    }
+
+    if (std::all_of(transitions.begin(), transitions.end(),
+                    [&transitions](const auto &transition) { return transition == transitions.front(); }))
+    {
+        if (!transitions.front().has_value())
+        {
+            return false;
+        }
+        batch.Add(texture.Get(), range, *transitions.front());
+        return true;
+    }
+
+    bool added = false;
+    for (uint32_t i = 0; i < transitions.size(); i++)
+    {
+        if (transitions[i].has_value())
+        {
+            auto subresource = range;
+            subresource.baseArrayLayer = range.baseArrayLayer + i / range.levelCount;
+            subresource.baseMipLevel = range.baseMipLevel + i % range.levelCount;
+            subresource.layerCount = 1;
+            subresource.levelCount = 1;
+            batch.Add(texture.Get(), subresource, *transitions[i]);
+            added = true;
+        }
+    }
+    return added;
+}
+
+EResourceAccess GetDescriptorAccess(VkDescriptorType descriptorType, VkPipelineBindPoint bindPoint, bool readOnly)
+{
+    bool compute = bindPoint == VkPipelineBindPoint::VK_PIPELINE_BIND_POINT_COMPUTE;
+    switch (descriptorType)
+    {
+    case VkDescriptorType::VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+    case VkDescriptorType::VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+        return compute ? EResourceAccess::ComputeUniformRead : EResourceAccess::GraphicsUniformRead;
+    case VkDescriptorType::VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+        // Layouts reflected from shaders know which buffers are never written, so binds of those can stay reads
+        if (compute)
+        {
+            return readOnly ? EResourceAccess::ComputeShaderRead : EResourceAccess::ComputeShaderReadWrite;
+        }
+        return EResourceAccess::GraphicsShaderRead;
+    case VkDescriptorType::VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+        return compute ? EResourceAccess::ComputeShaderRead : EResourceAccess::GraphicsShaderRead;
+    case VkDescriptorType::VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+        return compute ? EResourceAccess::ComputeShaderReadWrite : EResourceAccess::GraphicsStorageImageRead;
+    default:
+        assert(false && "Descriptor type has no known access");
+        return compute ? EResourceAccess::ComputeShaderReadWrite : EResourceAccess::GraphicsShaderRead;
+    }
+}
+}
+
+CommandBuffer::CommandBuffer(VkCommandBuffer &&commandBuffer, VkDevice device, Queue queue,
+                             PFN_vkCmdPipelineBarrier2KHR pipelineBarrier2, DynamicRenderingFunctions dynamicRendering) : 
     m_CommandBuffer(commandBuffer), 
     // Start the Fence signaled so that we can query for correct usage prior to beginning the command buffer (again)
     m_InFlight(std::make_unique<Fence>(device)), m_Queue(queue),
-    m_Device(device)
+    m_Device(device), m_PipelineBarrier2(pipelineBarrier2), m_DynamicRendering(dynamicRendering)
 {
 }
 
@@ -30,8 +123,11 @@ CommandBuffer::CommandBuffer(CommandBuffer &&other)
     : m_Name(std::move(other.m_Name)), 
       m_ExtensionFunctionMapping(std::move(other.m_ExtensionFunctionMapping)),
       m_CommandBuffer(other.m_CommandBuffer), m_InFlight(std::move(other.m_InFlight)), m_Status(other.m_Status),
-      m_Queue(other.m_Queue), m_PendingBarriers(std::move(other.m_PendingBarriers)),
-      m_Device(other.m_Device)
+      m_InsideRenderPass(other.m_InsideRenderPass), m_InsideDynamicRendering(other.m_InsideDynamicRendering),
+      m_EndRenderingBarriers(std::move(other.m_EndRenderingBarriers)), m_BoundState(std::move(other.m_BoundState)), m_Queue(other.m_Queue),
+      m_DynamicRendering(other.m_DynamicRendering),
+      m_PipelineBarrier2(other.m_PipelineBarrier2), m_RecordingId(other.m_RecordingId),
+      m_PendingBarriers(std::move(other.m_PendingBarriers)), m_Device(other.m_Device)
 {
     other.m_Moved = true;
 }
@@ -63,6 +159,15 @@ void CommandBuffer::WaitFence()
     }
 }
 
+Fence *CommandBuffer::GetPendingFence()
+{
+    if (m_Status != CommandBufferStatus::Submitted || m_InFlight->QueryStatus() != FenceStatus::UnsignaledOrReset)
+    {
+        return nullptr;
+    }
+    return m_InFlight.get();
+}
+
 // TODO: Consider doing begin on first command invocation
 void CommandBuffer::Begin()
 {
@@ -82,11 +187,14 @@ void CommandBuffer::Begin()
         throw std::runtime_error("Could not begin command buffer");
     }
     m_Status = CommandBufferStatus::Recording;
+    m_RecordingId = ++RecordingCounter;
+    // All state is undefined at the start of a command buffer
+    m_BoundState.Invalidate();
+    m_BoundState.ResetStatistics();
 }
 
 void CommandBuffer::BeginSingleTake()
 {
-    // TODO: Needs to handle pending acquires?
     // TODO: Use `Begin` instead and allow for a one-time fire
     VkCommandBufferBeginInfo beginInfo{};
     beginInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -96,41 +204,50 @@ void CommandBuffer::BeginSingleTake()
         throw std::runtime_error("Could not begin command buffer");
     }
     m_Status = CommandBufferStatus::Recording;
+    m_RecordingId = ++RecordingCounter;
+    // All state is undefined at the start of a command buffer
+    m_BoundState.Invalidate();
+    m_BoundState.ResetStatistics();
 }
 
-void CommandBuffer::Draw(const Framebuffer& frameBuffer, const RenderPass& renderPass, const RasterPipeline& pipeline, 
-    VertexBuffer& vertexBuffer, BindSet&& bindSet)
+RenderPassScope CommandBuffer::BeginRenderPass(const Framebuffer &frameBuffer, const RenderPass &renderPass)
 {
-    assert(m_Status == CommandBufferStatus::Recording && "Calling draw before starting recording of command buffer");
-    VkRenderPassBeginInfo renderPassBeginInfo{};
-    renderPassBeginInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-    renderPassBeginInfo.framebuffer = frameBuffer.Get();
-    renderPassBeginInfo.renderPass = renderPass.Get();
-
-    auto viewport = frameBuffer.GetViewport();
-    // Should only be rendering to the scissor area, not the entire viewport
-    renderPassBeginInfo.renderArea = viewport.Scissor;
-
-    VkClearValue clearColor = {{{0.0f, 0.0f, 0.0f, 1.0f}}};
-    renderPassBeginInfo.clearValueCount = 1;
-    renderPassBeginInfo.pClearValues = &clearColor;
-    
-    vkCmdBeginRenderPass(m_CommandBuffer, &renderPassBeginInfo, VkSubpassContents::VK_SUBPASS_CONTENTS_INLINE);
-    FlushPendingBarriers();
+    return RenderPassScope(*this, frameBuffer, renderPass);
+}
 
-    pipeline.Bind(m_CommandBuffer, viewport);
-    BindVertexBuffer(vertexBuffer);
-    BindDescriptorSet(bindSet, pipeline);
-    // TODO: Give user control over what to draw
+RenderPassScope CommandBuffer::BeginRendering(const RenderingInfo &renderingInfo)
+{
+    return RenderPassScope(*this, renderingInfo);
+}
 
-    vkCmdDraw(m_CommandBuffer, static_cast<uint32_t>(vertexBuffer.VertexCount()), 1, 0, 0);
-    vkCmdEndRenderPass(m_CommandBuffer);
+void CommandBuffer::Draw(const Framebuffer& frameBuffer, const RenderPass& renderPass, const RasterPipeline& pipeline, 
+    VertexBuffer& vertexBuffer, BindSet&& bindSet)
+{
+    RequireAccess(vertexBuffer.GetBuffer(), EResourceAccess::VertexBufferRead);
+    RequireAccess(bindSet, VkPipelineBindPoint::VK_PIPELINE_BIND_POINT_GRAPHICS);
+    auto renderPassScope = BeginRenderPass(frameBuffer, renderPass);
+    renderPassScope.BindPipeline(pipeline).BindVertexBuffer(vertexBuffer).BindDescriptorSet(std::move(bindSet));
+    renderPassScope.Draw(DrawParameters{static_cast<uint32_t>(vertexBuffer.VertexCount())});
 }
 
 void CommandBuffer::DrawIndexed(const Framebuffer& frameBuffer, const RenderPass& renderPass, const RasterPipeline& pipeline,
     VertexBuffer& vertexBuffer, IndexBuffer& indexBuffer, BindSet&& bindSet)
 {
-    assert(m_Status == CommandBufferStatus::Recording && "Calling draw before starting recording of command buffer");
+    RequireAccess(vertexBuffer.GetBuffer(), EResourceAccess::VertexBufferRead);
+    RequireAccess(indexBuffer.GetBuffer(), EResourceAccess::IndexBufferRead);
+    RequireAccess(bindSet, VkPipelineBindPoint::VK_PIPELINE_BIND_POINT_GRAPHICS);
+    auto renderPassScope = BeginRenderPass(frameBuffer, renderPass);
+    renderPassScope.BindPipeline(pipeline)
+        .BindVertexBuffer(vertexBuffer)
+        .BindIndexBuffer(indexBuffer)
+        .BindDescriptorSet(std::move(bindSet));
+    renderPassScope.DrawIndexed(DrawIndexedParameters{static_cast<uint32_t>(indexBuffer.GetIndexCount())});
+}
+
+void CommandBuffer::BeginRenderPassInternal(const Framebuffer &frameBuffer, const RenderPass &renderPass)
+{
+    assert(m_Status == CommandBufferStatus::Recording && "Beginning render pass before starting recording of command buffer");
+    assert(!m_InsideRenderPass && "Render passes cannot be nested");
     VkRenderPassBeginInfo renderPassBeginInfo{};
     renderPassBeginInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
     renderPassBeginInfo.framebuffer = frameBuffer.Get();
@@ -140,33 +257,161 @@ void CommandBuffer::DrawIndexed(const Framebuffer& frameBuffer, const RenderPass
     // Should only be rendering to the scissor area, not the entire viewport
     renderPassBeginInfo.renderArea = viewport.Scissor;
 
-    std::array<VkClearValue, 2> clearValues{};
-    
-    clearValues[0].color = {0.0f, 0.0f, 0.0f, 1.0f};
-    clearValues[1].depthStencil = { 1.0f, 0 };
+    auto clearValues = renderPass.GetClearValues();
     renderPassBeginInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
     renderPassBeginInfo.pClearValues = clearValues.data();
     
+    // Everything used within the render pass must be synchronized before it begins
+    FlushBarriers();
     vkCmdBeginRenderPass(m_CommandBuffer, &renderPassBeginInfo, VkSubpassContents::VK_SUBPASS_CONTENTS_INLINE);
+    m_InsideRenderPass = true;
+}
+
+void CommandBuffer::BeginRenderingInternal(const RenderingInfo &renderingInfo)
+{
+    assert(m_Status == CommandBufferStatus::Recording && "Beginning rendering before starting recording of command buffer");
+    assert(!m_InsideRenderPass && "Render passes cannot be nested");
+    assert(m_DynamicRendering.BeginRendering != nullptr && "Dynamic rendering is not enabled on the device");
+
+    // Without a render pass, the layout transitions and the dependency on earlier use of the attachments
+    // are recorded here, unless they are tracked. Untracked attachments are cleared, so their previous layout
+    // doesn't matter
+    std::vector<VkImageMemoryBarrier> beginBarriers;
+    m_EndRenderingBarriers.clear();
+    auto addAttachment = [&](const RenderingAttachment &attachment, VkImageLayout layout, VkAccessFlags writeAccess,
+                             VkAccessFlags readAccess) {
+        VkRenderingAttachmentInfoKHR attachmentInfo{};
+        attachmentInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+        attachmentInfo.imageView = attachment.View;
+        attachmentInfo.imageLayout = layout;
+        attachmentInfo.resolveMode = VkResolveModeFlagBits::VK_RESOLVE_MODE_NONE;
+        attachmentInfo.loadOp = attachment.Tracked ? attachment.LoadOp : VkAttachmentLoadOp::VK_ATTACHMENT_LOAD_OP_CLEAR;
+        attachmentInfo.storeOp = attachment.StoreOp;
+        attachmentInfo.clearValue = attachment.ClearValue;
+        if (attachment.Tracked)
+        {
+            return attachmentInfo;
+        }
+
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VkStructureType::VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = writeAccess;
+        barrier.dstAccessMask = writeAccess | readAccess;
+        barrier.oldLayout = VkImageLayout::VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = layout;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = attachment.Image;
+        barrier.subresourceRange = VkImageSubresourceRange{attachment.AspectMask, 0, 1, 0, 1};
+        beginBarriers.emplace_back(barrier);
+        if (attachment.FinalLayout != layout)
+        {
+            barrier.dstAccessMask = 0;
+            barrier.oldLayout = layout;
+            barrier.newLayout = attachment.FinalLayout;
+            m_EndRenderingBarriers.emplace_back(barrier);
+        }
+        return attachmentInfo;
+    };
+
+    std::vector<VkRenderingAttachmentInfoKHR> colorAttachments;
+    colorAttachments.reserve(renderingInfo.ColorAttachments.size());
+    for (const auto &attachment : renderingInfo.ColorAttachments)
+    {
+        colorAttachments.emplace_back(addAttachment(attachment, VkImageLayout::VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                                                    VkAccessFlagBits::VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                                                    VkAccessFlagBits::VK_ACCESS_COLOR_ATTACHMENT_READ_BIT));
+    }
+    std::optional<VkRenderingAttachmentInfoKHR> depthAttachment;
+    if (renderingInfo.DepthAttachment.has_value())
+    {
+        depthAttachment = addAttachment(*renderingInfo.DepthAttachment,
+                                        VkImageLayout::VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+                                        VkAccessFlagBits::VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                                        VkAccessFlagBits::VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT);
+    }
+
+    // Everything used within the render pass must be synchronized before it begins
+    FlushBarriers();
+    // Color waits on the acquire semaphore at this stage, depth on the previous frame's depth writes
+    VkPipelineStageFlags attachmentStages = VkPipelineStageFlagBits::VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+                                            VkPipelineStageFlagBits::VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+                                            VkPipelineStageFlagBits::VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    if (!beginBarriers.empty())
+    {
+        vkCmdPipelineBarrier(m_CommandBuffer, attachmentStages, attachmentStages, 0, 0, nullptr, 0, nullptr,
+                             static_cast<uint32_t>(beginBarriers.size()), beginBarriers.data());
+    }
+
+    VkRenderingInfoKHR vkRenderingInfo{};
+    vkRenderingInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_RENDERING_INFO_KHR;
+    // Should only be rendering to the scissor area, not the entire viewport
+    vkRenderingInfo.renderArea = renderingInfo.Viewport.Scissor;
+    vkRenderingInfo.layerCount = 1;
+    vkRenderingInfo.colorAttachmentCount = static_cast<uint32_t>(colorAttachments.size());
+    vkRenderingInfo.pColorAttachments = colorAttachments.data();
+    vkRenderingInfo.pDepthAttachment = depthAttachment.has_value() ? &*depthAttachment : nullptr;
+    m_DynamicRendering.BeginRendering(m_CommandBuffer, &vkRenderingInfo);
+    m_InsideRenderPass = true;
+    m_InsideDynamicRendering = true;
+}
 
-    for (const auto &barrierArray : m_PendingBarriers)
+void CommandBuffer::EndRenderPassInternal()
+{
+    assert(m_InsideRenderPass && "Ending a render pass that was never begun");
+    if (m_InsideDynamicRendering)
     {
-        InsertBarriers(barrierArray);
+        m_DynamicRendering.EndRendering(m_CommandBuffer);
+        if (!m_EndRenderingBarriers.empty())
+        {
+            // E.g. to the present layout, which the present semaphore orders further
+            vkCmdPipelineBarrier(m_CommandBuffer, VkPipelineStageFlagBits::VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+                                                      VkPipelineStageFlagBits::VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+                                 VkPipelineStageFlagBits::VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr,
+                                 static_cast<uint32_t>(m_EndRenderingBarriers.size()), m_EndRenderingBarriers.data());
+        }
+        m_InsideDynamicRendering = false;
     }
-    m_PendingBarriers.clear();
-    pipeline.Bind(m_CommandBuffer, viewport);
-    BindVertexBuffer(vertexBuffer);
-    BindIndexBuffer(indexBuffer);
-    BindDescriptorSet(bindSet, pipeline);
+    else
+    {
+        vkCmdEndRenderPass(m_CommandBuffer);
+    }
+    m_InsideRenderPass = false;
+}
 
-    // TODO: Give user control over what to draw
-    vkCmdDrawIndexed(m_CommandBuffer, static_cast<uint32_t>(indexBuffer.GetIndexCount()), 1, 0, 0, 0);
-    vkCmdEndRenderPass(m_CommandBuffer);
+void CommandBuffer::BindPipeline(const RasterPipeline &pipeline, const Viewport &viewport)
+{
+    if (m_BoundState.SetPipeline(VkPipelineBindPoint::VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.Get()))
+    {
+        vkCmdBindPipeline(m_CommandBuffer, VkPipelineBindPoint::VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.Get());
+    }
+    if (m_BoundState.SetViewport(viewport.Viewport))
+    {
+        vkCmdSetViewport(m_CommandBuffer, 0, 1, &viewport.Viewport);
+    }
+    if (m_BoundState.SetScissor(viewport.Scissor))
+    {
+        vkCmdSetScissor(m_CommandBuffer, 0, 1, &viewport.Scissor);
+    }
 }
 
 // TODO: Bind command buffer to a queue at creation time
 Fence& CommandBuffer::End(std::span<Semaphore> waitSemaphores, std::span<Semaphore> signalSemaphores)
 {
+    // TODO: Ugly allocation, cache this somehow?
+    std::vector<SemaphoreWait> waits;
+    waits.reserve(waitSemaphores.size());
+    for (auto& semaphore : waitSemaphores)
+    {
+        waits.emplace_back(SemaphoreWait{semaphore, VkPipelineStageFlagBits::VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT});
+    }
+    return End(std::span<const SemaphoreWait>(waits), signalSemaphores);
+}
+
+Fence& CommandBuffer::End(std::span<const SemaphoreWait> waitSemaphores, std::span<Semaphore> signalSemaphores)
+{
+    assert(!m_InsideRenderPass && "Ending command buffer with an active render pass. Destroy the RenderPassScope first");
+    FlushBarriers();
     if (vkEndCommandBuffer(m_CommandBuffer) != VK_SUCCESS)
     {
         throw std::runtime_error("Could not end command buffer");
@@ -175,10 +420,13 @@ Fence& CommandBuffer::End(std::span<Semaphore> waitSemaphores, std::span<Semapho
     // TODO: Ugly allocation, cache this somehow? Or reinterpret_cast
     // this somehow
     std::vector<VkSemaphore> waitSemaphoreHandles;
+    std::vector<VkPipelineStageFlags> waitStages;
     waitSemaphoreHandles.reserve(waitSemaphores.size());
-    for (const auto& semaphore : waitSemaphores)
+    waitStages.reserve(waitSemaphores.size());
+    for (const auto& wait : waitSemaphores)
     {
-        waitSemaphoreHandles.emplace_back(semaphore.Get());
+        waitSemaphoreHandles.emplace_back(wait.WaitSemaphore.get().Get());
+        waitStages.emplace_back(wait.WaitStage);
     }
 
     // TODO: Ugly allocation, cache this somehow? Or reinterpret_cast
@@ -190,16 +438,12 @@ Fence& CommandBuffer::End(std::span<Semaphore> waitSemaphores, std::span<Semapho
         signalSemaphoreHandles.emplace_back(semaphore.Get());
     }
 
-    // TODO: Expose to caller, next: cache from last inserted command
-    // in previous cmd buffer
-    VkPipelineStageFlags waitStages[] = {VkPipelineStageFlagBits::VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-
     VkSubmitInfo submitInfo{};
     submitInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
     submitInfo.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphoreHandles.size());
     submitInfo.pWaitSemaphores = waitSemaphoreHandles.data();
-    submitInfo.pWaitDstStageMask = waitStages;
+    submitInfo.pWaitDstStageMask = waitStages.data();
     
     submitInfo.signalSemaphoreCount = static_cast<uint32_t>(signalSemaphoreHandles.size());
     submitInfo.pSignalSemaphores = signalSemaphoreHandles.data();
@@ -220,81 +464,125 @@ Fence &CommandBuffer::End()
     return End(std::span<Semaphore>(), std::span<Semaphore>());
 }
 
-void CommandBuffer::BindVertexBuffer(VertexBuffer &vertexBuffer)
+void CommandBuffer::BindVertexBuffer(VertexBuffer &vertexBuffer, uint32_t binding)
 {
     auto& buffer = vertexBuffer.GetBuffer();
     VkBuffer vertexBuffers = {buffer.Get()};
     VkDeviceSize offsets[] = {0};
-    HandleAcquire(buffer.TakePendingAcquire());
-    FlushPendingBarriers();
-    vkCmdBindVertexBuffers(m_CommandBuffer, 0, 1, &vertexBuffers, offsets);
+    RequireAccess(buffer, EResourceAccess::VertexBufferRead);
+    if (m_BoundState.SetVertexBuffer(binding, vertexBuffers, offsets[0]))
+    {
+        vkCmdBindVertexBuffers(m_CommandBuffer, binding, 1, &vertexBuffers, offsets);
+    }
 }
 
 void CommandBuffer::BindIndexBuffer(IndexBuffer &indexBuffer)
 {
     auto& buffer = indexBuffer.GetBuffer();
     VkBuffer indexBuffers = {buffer.Get()};
-    VkDeviceSize offsets[] = {0};
-    HandleAcquire(buffer.TakePendingAcquire());
-    FlushPendingBarriers();
-    vkCmdBindIndexBuffer(m_CommandBuffer, indexBuffers, 0, VkIndexType::VK_INDEX_TYPE_UINT32);
+    RequireAccess(buffer, EResourceAccess::IndexBufferRead);
+    if (m_BoundState.SetIndexBuffer(indexBuffers, 0, VkIndexType::VK_INDEX_TYPE_UINT32))
+    {
+        vkCmdBindIndexBuffer(m_CommandBuffer, indexBuffers, 0, VkIndexType::VK_INDEX_TYPE_UINT32);
+    }
 }
 
-void CommandBuffer::BindDescriptorSet(BindSet &bindSet, const RasterPipeline& pipeline)
+void CommandBuffer::BindDescriptorSet(BindSet &bindSet, const RasterPipeline& pipeline,
+                                      std::span<const uint32_t> dynamicOffsets)
 {
-    bindSet.FlushWrites();
-    for (auto barrier : bindSet.TakePendingAcquires())
-    {
-        HandleAcquire(std::move(barrier));
-    }
-    FlushPendingBarriers();
-    auto descriptorSetHandle = bindSet.GetDescriptorSet().Get();
-    vkCmdBindDescriptorSets(m_CommandBuffer, VkPipelineBindPoint::VK_PIPELINE_BIND_POINT_GRAPHICS,
-                            pipeline.GetPipelineLayout(), 0, 1, &descriptorSetHandle, 0, nullptr);
+    BindDescriptorSet(bindSet, VkPipelineBindPoint::VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.GetPipelineLayout(),
+                      dynamicOffsets);
 }
 
-void CommandBuffer::HandleAcquire(std::optional<BufferMemoryBarrier> pendingAcquire)
+void CommandBuffer::BindDescriptorSet(BindSet &bindSet, VkPipelineBindPoint bindPoint, VkPipelineLayout pipelineLayout,
+                                      std::span<const uint32_t> dynamicOffsets)
 {
-    if (pendingAcquire.has_value())
+    assert(dynamicOffsets.size() == bindSet.GetDescriptorSet().GetLayout().GetDynamicOffsetCount() &&
+           "Need an offset for every dynamic binding");
+    RequireAccess(bindSet, bindPoint);
+    auto written = bindSet.FlushWrites();
+    m_BoundState.RecordDescriptorWrites(written,
+                                        static_cast<uint32_t>(bindSet.GetBoundResources().size()) - written);
+    BindDescriptorSet(bindSet.GetDescriptorSet().Get(), 0, bindPoint, pipelineLayout, dynamicOffsets);
+}
+
+void CommandBuffer::BindDescriptorSet(VkDescriptorSet descriptorSet, uint32_t setIndex, VkPipelineBindPoint bindPoint,
+                                      VkPipelineLayout pipelineLayout, std::span<const uint32_t> dynamicOffsets)
+{
+    // Binding the same set with other offsets is all a new slice of a dynamic uniform buffer needs
+    if (m_BoundState.SetDescriptorSet(bindPoint, pipelineLayout, setIndex, descriptorSet, dynamicOffsets))
     {
-        auto array = std::find_if(m_PendingBarriers.begin(), m_PendingBarriers.end(),
-                     [&pendingAcquire](const BarrierArray &array) {
-                         return array.DestinationStageMask == pendingAcquire->DestinationStageMask &&
-                                array.SourceStageMask == pendingAcquire->SourceStageMask;
-                     });
-        if (array != m_PendingBarriers.end())
-        {
-            array->BufferBarriers.emplace_back(std::move(pendingAcquire->Barrier));
-        }
-        else
-        {
-            m_PendingBarriers.emplace_back(BarrierArray(std::move(*pendingAcquire)));
-        }
+        vkCmdBindDescriptorSets(m_CommandBuffer, bindPoint, pipelineLayout, setIndex, 1, &descriptorSet,
+                                static_cast<uint32_t>(dynamicOffsets.size()), dynamicOffsets.data());
     }
 }
 
-void CommandBuffer::HandleAcquire(std::optional<ImageMemoryBarrier> pendingAcquire)
+void CommandBuffer::PushConstantsInternal(const RasterPipeline &pipeline, VkShaderStageFlags stages, uint32_t offset,
+                                          uint32_t size, const void *data)
+{
+    assert(m_Status == CommandBufferStatus::Recording && "Pushing constants before starting recording of command buffer");
+    assert(IsValidPushConstantUpdate(pipeline.GetPushConstantRanges(), stages, offset, size) &&
+           "Push constant update is not covered by the ranges of the pipeline");
+    vkCmdPushConstants(m_CommandBuffer, pipeline.GetPipelineLayout(), stages, offset, size, data);
+}
+
+void CommandBuffer::PushConstantsInternal(const ComputePipeline &pipeline, uint32_t offset, uint32_t size,
+                                          const void *data)
 {
-    if (pendingAcquire.has_value())
+    assert(m_Status == CommandBufferStatus::Recording && "Pushing constants before starting recording of command buffer");
+    assert(IsValidPushConstantUpdate(pipeline.GetPushConstantRanges(), VkShaderStageFlagBits::VK_SHADER_STAGE_COMPUTE_BIT,
+                                     offset, size) &&
+           "Push constant update is not covered by the ranges of the pipeline");
+    vkCmdPushConstants(m_CommandBuffer, pipeline.GetPipelineLayout(), VkShaderStageFlagBits::VK_SHADER_STAGE_COMPUTE_BIT,
+                       offset, size, data);
+}
+
+void CommandBuffer::BindComputePipeline(const ComputePipeline &pipeline)
+{
+    assert(m_Status == CommandBufferStatus::Recording && "Binding pipeline before starting recording of command buffer");
+    if (m_BoundState.SetPipeline(VkPipelineBindPoint::VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.Get()))
     {
-        auto array = std::find_if(m_PendingBarriers.begin(), m_PendingBarriers.end(),
-                     [&pendingAcquire](const BarrierArray &array) {
-                         return array.DestinationStageMask == pendingAcquire->DestinationStageMask &&
-                                array.SourceStageMask == pendingAcquire->SourceStageMask;
-                     });
-        if (array != m_PendingBarriers.end())
-        {
-            array->ImageBarriers.emplace_back(std::move(pendingAcquire->Barrier));
-        }
-        else
-        {
-            m_PendingBarriers.emplace_back(BarrierArray(std::move(*pendingAcquire)));
-        }
+        vkCmdBindPipeline(m_CommandBuffer, VkPipelineBindPoint::VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.Get());
     }
 }
 
+void CommandBuffer::BindComputeDescriptorSet(BindSet &&bindSet, const ComputePipeline &pipeline,
+                                             std::span<const uint32_t> dynamicOffsets)
+{
+    BindDescriptorSet(bindSet, VkPipelineBindPoint::VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.GetPipelineLayout(),
+                      dynamicOffsets);
+}
+
+void CommandBuffer::Dispatch(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ)
+{
+    assert(!m_InsideRenderPass && "Dispatches are not allowed inside a render pass");
+    FlushBarriers();
+    vkCmdDispatch(m_CommandBuffer, groupCountX, groupCountY, groupCountZ);
+}
+
+void CommandBuffer::DispatchIndirect(const DeviceBuffer &argumentBuffer, VkDeviceSize offset)
+{
+    assert(!m_InsideRenderPass && "Dispatches are not allowed inside a render pass");
+    assert(offset % 4 == 0 && "Indirect dispatch offset must be a multiple of 4");
+    RequireAccess(argumentBuffer, EResourceAccess::IndirectBufferRead);
+    FlushBarriers();
+    vkCmdDispatchIndirect(m_CommandBuffer, argumentBuffer.Get(), offset);
+}
+
+void CommandBuffer::FillBuffer(DeviceBuffer &buffer, uint32_t value)
+{
+    assert(!m_InsideRenderPass && "Transfer commands are not allowed inside a render pass");
+    RequireAccess(buffer, EResourceAccess::TransferWrite);
+    FlushBarriers();
+    vkCmdFillBuffer(m_CommandBuffer, buffer.Get(), 0, VK_WHOLE_SIZE, value);
+}
+
 void CommandBuffer::Copy(const DeviceBuffer &source, const DeviceBuffer &destination)
 {
+    assert(!m_InsideRenderPass && "Transfer commands are not allowed inside a render pass");
+    RequireAccess(source, EResourceAccess::TransferRead);
+    RequireAccess(destination, EResourceAccess::TransferWrite);
+    FlushBarriers();
     VkBufferCopy bufferCopy{};
     bufferCopy.srcOffset = 0;
     bufferCopy.dstOffset = 0;
@@ -302,8 +590,16 @@ void CommandBuffer::Copy(const DeviceBuffer &source, const DeviceBuffer &destina
     vkCmdCopyBuffer(m_CommandBuffer, source.Get(), destination.Get(), 1, &bufferCopy);
 }
 
-void CommandBuffer::CopyBufferToImage(const DeviceBuffer &source, Texture2D &texture)
+void CommandBuffer::CopyBufferToImage(const DeviceBuffer &source, const Texture &texture)
 {
+    assert(!m_InsideRenderPass && "Transfer commands are not allowed inside a render pass");
+    RequireAccess(source, EResourceAccess::TransferRead);
+    VkImageSubresourceRange firstMip = texture.GetFullRange();
+    firstMip.levelCount = 1;
+    firstMip.layerCount = 1;
+    RequireAccess(texture, EResourceAccess::TransferWrite, firstMip);
+    FlushBarriers();
+
     VkBufferImageCopy bufferImageCopy{};
     bufferImageCopy.bufferOffset = 0;
     bufferImageCopy.bufferRowLength = 0;
@@ -321,6 +617,117 @@ void CommandBuffer::CopyBufferToImage(const DeviceBuffer &source, Texture2D &tex
                            VkImageLayout::VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &bufferImageCopy);
 }
 
+void CommandBuffer::RequireAccess(const DeviceBuffer &buffer, EResourceAccess access)
+{
+    // A second transition of the same buffer has to wait for the first, so they can't share a batch
+    if (m_PendingBarriers.ContainsBuffer(buffer.Get()))
+    {
+        FlushBarriers();
+    }
+    auto transition = TransitionState(buffer.GetState(), access, m_RecordingId, m_Queue.GetFamilyIndex(), false);
+    if (transition.has_value())
+    {
+        assert(!m_InsideRenderPass && "Resource needs a barrier inside a render pass, "
+                                      "declare accesses with RequireAccess before BeginRenderPass");
+        m_PendingBarriers.Add(buffer.Get(), *transition);
+    }
+}
+
+void CommandBuffer::RequireAccess(const Texture &texture, EResourceAccess access)
+{
+    RequireAccess(texture, access, texture.GetFullRange());
+}
+
+void CommandBuffer::RequireAccess(const Texture &texture, EResourceAccess access, const VkImageSubresourceRange &range)
+{
+    if (m_PendingBarriers.ContainsImage(texture.Get()))
+    {
+        FlushBarriers();
+    }
+    auto familyIndex = m_Queue.GetFamilyIndex();
+    bool added = AddImageTransitions(m_PendingBarriers, texture, range, [&](ResourceState &state) {
+        return TransitionState(state, access, m_RecordingId, familyIndex, true);
+    });
+    assert((!added || !m_InsideRenderPass) && "Resource needs a barrier inside a render pass, "
+                                               "declare accesses with RequireAccess before BeginRenderPass");
+}
+
+void CommandBuffer::RequireAccess(const BindSet &bindSet, VkPipelineBindPoint bindPoint)
+{
+    for (const auto &resource : bindSet.GetBoundResources())
+    {
+        auto access = GetDescriptorAccess(resource.DescriptorType, bindPoint, resource.ReadOnly);
+        if (resource.Buffer != nullptr)
+        {
+            RequireAccess(*resource.Buffer, access);
+        }
+        else
+        {
+            RequireAccess(*resource.Image, access);
+        }
+    }
+}
+
+void CommandBuffer::DiscardContents(const Texture &texture, EResourceAccess previousAccess)
+{
+    assert(!m_InsideRenderPass && "Contents can't be discarded inside a render pass");
+    // A pending transition of the image was recorded against the state that is about to be replaced
+    if (m_PendingBarriers.ContainsImage(texture.Get()))
+    {
+        FlushBarriers();
+    }
+    for (uint32_t mipLevel = 0; mipLevel < texture.GetMipLevels(); mipLevel++)
+    {
+        for (uint32_t arrayLayer = 0; arrayLayer < texture.GetArrayLayers(); arrayLayer++)
+        {
+            DiscardState(texture.GetState(mipLevel, arrayLayer), previousAccess, m_RecordingId);
+        }
+    }
+}
+
+void CommandBuffer::DiscardContents(const Texture &texture, std::span<const ResourceState *const> previousOccupants)
+{
+    assert(!m_InsideRenderPass && "Contents can't be discarded inside a render pass");
+    if (m_PendingBarriers.ContainsImage(texture.Get()))
+    {
+        FlushBarriers();
+    }
+    for (uint32_t mipLevel = 0; mipLevel < texture.GetMipLevels(); mipLevel++)
+    {
+        for (uint32_t arrayLayer = 0; arrayLayer < texture.GetArrayLayers(); arrayLayer++)
+        {
+            DiscardState(texture.GetState(mipLevel, arrayLayer), previousOccupants, m_RecordingId);
+        }
+    }
+}
+
+void CommandBuffer::ReleaseOwnership(const DeviceBuffer &buffer, Queue destination)
+{
+    assert(!m_InsideRenderPass && "Ownership can't be released inside a render pass");
+    if (m_PendingBarriers.ContainsBuffer(buffer.Get()))
+    {
+        FlushBarriers();
+    }
+    m_PendingBarriers.Add(buffer.Get(),
+                          ReleaseState(buffer.GetState(), VkImageLayout::VK_IMAGE_LAYOUT_UNDEFINED, m_RecordingId,
+                                       m_Queue.GetFamilyIndex(), destination.GetFamilyIndex()));
+}
+
+void CommandBuffer::ReleaseOwnership(const Texture &texture, EResourceAccess nextAccess, Queue destination)
+{
+    assert(!m_InsideRenderPass && "Ownership can't be released inside a render pass");
+    if (m_PendingBarriers.ContainsImage(texture.Get()))
+    {
+        FlushBarriers();
+    }
+    auto layout = GetAccessInfo(nextAccess).Layout;
+    auto sourceFamily = m_Queue.GetFamilyIndex();
+    auto destinationFamily = destination.GetFamilyIndex();
+    AddImageTransitions(m_PendingBarriers, texture, texture.GetFullRange(), [&](ResourceState &state) {
+        return std::optional(ReleaseState(state, layout, m_RecordingId, sourceFamily, destinationFamily));
+    });
+}
+
 void CommandBuffer::InsertBarrier(const BufferMemoryBarrier &barrier) const
 {
     VkBufferMemoryBarrier vkBarrier{};
@@ -401,12 +808,14 @@ void CommandBuffer::InsertBarriers(const BarrierArray &barriers) const
     }
 
     std::vector<VkImageMemoryBarrier> imageBarriers{};
-    imageBarriers.reserve(barriers.BufferBarriers.size());
+    imageBarriers.reserve(barriers.ImageBarriers.size());
     for (auto &barrier : barriers.ImageBarriers)
     {
 		VkImageMemoryBarrier vkBarrier{};
-		vkBarrier.sType = VkStructureType::VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		vkBarrier.sType = VkStructureType::VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
 		vkBarrier.image = barrier.Texture.get().Get();
+		vkBarrier.oldLayout = barrier.SourceLayout;
+		vkBarrier.newLayout = barrier.DestinationLayout;
 		vkBarrier.srcAccessMask = barrier.SourceAccessMask;
 		vkBarrier.dstAccessMask = barrier.DestinationAccessMask;
         if (barrier.Queues.has_value())
@@ -424,7 +833,7 @@ void CommandBuffer::InsertBarriers(const BarrierArray &barriers) const
     }
 
     vkCmdPipelineBarrier(m_CommandBuffer, barriers.SourceStageMask, barriers.DestinationStageMask, 0, 0, nullptr, static_cast<uint32_t>(bufferBarriers.size()),
-                         bufferBarriers.data(), 0, nullptr);
+                         bufferBarriers.data(), static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
 }
 
 Queue CommandBuffer::GetQueue() const
@@ -437,6 +846,11 @@ void CommandBuffer::ResetTimerPool(TimerPool &timerPool) const
     timerPool.Reset(m_CommandBuffer);
 }
 
+const CommandStatistics &CommandBuffer::GetStatistics() const
+{
+    return m_BoundState.GetStatistics();
+}
+
 void CommandBuffer::Reset()
 {
     vkResetCommandBuffer(m_CommandBuffer, 0);
@@ -448,17 +862,15 @@ void CommandBuffer::Reset()
     m_Status = CommandBufferStatus::Reset;
 }
 
-void CommandBuffer::FlushPendingBarriers()
+void CommandBuffer::FlushBarriers()
 {
-    for (const auto &barrierArray : m_PendingBarriers)
-    {
-        InsertBarriers(barrierArray);
-    }
-    m_PendingBarriers.clear();
+    assert((!m_InsideRenderPass || m_PendingBarriers.IsEmpty()) && "Barriers cannot be recorded inside a render pass");
+    m_PendingBarriers.Flush(m_CommandBuffer, m_PipelineBarrier2);
 }
 
 CommandBufferPool::CommandBufferPool(VkDevice device, CommandBufferPoolCreateInfo createInfo, const VulkanInstance& instance) : 
-   m_Instance(instance), m_Device(device)
+   m_Instance(instance), m_Device(device), m_PipelineBarrier2(createInfo.PipelineBarrier2),
+   m_DynamicRendering(createInfo.DynamicRendering)
 {
     VkCommandPoolCreateInfo commandPoolCreateInfo{};
     commandPoolCreateInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
@@ -474,6 +886,8 @@ CommandBufferPool::CommandBufferPool(VkDevice device, CommandBufferPoolCreateInf
 CommandBufferPool::CommandBufferPool(CommandBufferPool &&other) : 
     m_Device(other.m_Device),
     m_CommandBufferPool(std::exchange(other.m_CommandBufferPool, VK_NULL_HANDLE)),
+    m_PipelineBarrier2(other.m_PipelineBarrier2),
+    m_DynamicRendering(other.m_DynamicRendering),
     m_CommandBuffers(std::move(other.m_CommandBuffers)), m_Instance(other.m_Instance)
 {
 }
@@ -505,7 +919,7 @@ std::vector<std::reference_wrapper<CommandBuffer>> CommandBufferPool::CreateComm
     std::vector<std::reference_wrapper<CommandBuffer>> commandBufferHandles;
     for (auto&& vkCommandBuffer : commandBuffers)
     {
-        commandBufferHandles.emplace_back(*m_CommandBuffers.emplace_back(std::make_unique<CommandBuffer>(std::move(vkCommandBuffer), m_Device, queue)));
+        commandBufferHandles.emplace_back(*m_CommandBuffers.emplace_back(std::make_unique<CommandBuffer>(std::move(vkCommandBuffer), m_Device, queue, m_PipelineBarrier2, m_DynamicRendering)));
     }
 
     return commandBufferHandles;
@@ -516,6 +930,19 @@ CommandBuffer &CommandBufferPool::CreateCommandBuffer(Queue queue)
     return CreateCommandBuffers(1, queue)[0];
 }
 
+std::vector<Fence *> CommandBufferPool::GetPendingFences()
+{
+    std::vector<Fence *> fences;
+    for (auto &commandBuffer : m_CommandBuffers)
+    {
+        if (auto *fence = commandBuffer->GetPendingFence())
+        {
+            fences.emplace_back(fence);
+        }
+    }
+    return fences;
+}
+
 void CommandBufferPool::SetName(const std::string &name, ExtensionFunctionMapping mapping)
 {
     DebugMarker::SetName(m_Device, mapping, m_CommandBufferPool, name);
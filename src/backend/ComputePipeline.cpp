@@ -0,0 +1,95 @@
+#include <backend/ComputePipeline.h>
+
+#include <cassert>
+#include <stdexcept>
+#include <utility>
+
+ComputePipeline::ComputePipeline(VkDevice vulkanDevice, ComputePipelineCreateInfo createInfo)
+    : m_VulkanDevice(vulkanDevice), m_Layout(createInfo.Layout)
+{
+    VkComputePipelineCreateInfo vkCreateInfo{};
+    vkCreateInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    vkCreateInfo.stage = createInfo.ShaderStage;
+    vkCreateInfo.layout = m_Layout.Get();
+    // Unused
+    vkCreateInfo.basePipelineHandle = VK_NULL_HANDLE;
+    vkCreateInfo.basePipelineIndex = -1;
+    if (vkCreateComputePipelines(vulkanDevice, createInfo.PipelineCache, 1, &vkCreateInfo, nullptr, &m_Pipeline))
+    {
+        throw std::runtime_error("Could not create compute pipeline");
+    }
+}
+
+ComputePipeline::ComputePipeline(ComputePipeline &&other)
+    : m_VulkanDevice(other.m_VulkanDevice),
+      m_Layout(other.m_Layout),
+      m_Pipeline(std::exchange(other.m_Pipeline, VK_NULL_HANDLE))
+{
+}
+
+ComputePipeline::~ComputePipeline()
+{
+    if (m_Pipeline != VK_NULL_HANDLE)
+    {
+        vkDestroyPipeline(m_VulkanDevice, m_Pipeline, nullptr);
+    }
+}
+
+VkPipelineLayout ComputePipeline::GetPipelineLayout() const
+{
+    return m_Layout.Get();
+}
+
+VkPipeline ComputePipeline::Get() const
+{
+    return m_Pipeline;
+}
+
+const std::vector<VkPushConstantRange> &ComputePipeline::GetPushConstantRanges() const
+{
+    return m_Layout.GetPushConstantRanges();
+}
+
+ComputePipelineBuilder::ComputePipelineBuilder(std::filesystem::path &&computeShaderPath)
+    : m_ComputeShaderPath(std::move(computeShaderPath))
+{
+}
+
+ComputePipelineBuilder &ComputePipelineBuilder::SetDescriptorSetLayout(const DescriptorSetLayout &descriptorSetLayout)
+{
+    m_DescriptorSetLayout = descriptorSetLayout;
+    return *this;
+}
+
+ComputePipelineBuilder &ComputePipelineBuilder::SetSpecializationConstants(SpecializationConstants constants)
+{
+    m_Specialization.emplace(std::move(constants));
+    return *this;
+}
+
+const std::filesystem::path &ComputePipelineBuilder::GetComputeShaderPath() const
+{
+    return m_ComputeShaderPath;
+}
+
+std::optional<std::reference_wrapper<const DescriptorSetLayout>> ComputePipelineBuilder::GetDescriptorSetLayout() const
+{
+    return m_DescriptorSetLayout;
+}
+
+const std::vector<VkPushConstantRange> &ComputePipelineBuilder::GetPushConstantRanges() const
+{
+    return m_PushConstantRanges;
+}
+
+const std::optional<SpecializationConstants> &ComputePipelineBuilder::GetSpecializationConstants() const
+{
+    return m_Specialization;
+}
+
+ComputePipelineBuilder &ComputePipelineBuilder::AddPushConstantRange(VkPushConstantRange range)
+{
+    assert(m_PushConstantRanges.empty() && "Compute pipelines have a single stage, so at most one push constant range");
+    m_PushConstantRanges.emplace_back(range);
+    return *this;
+}
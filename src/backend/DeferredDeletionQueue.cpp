@@ -0,0 +1,48 @@
+#include <backend/DeferredDeletionQueue.h>
+
+#include <algorithm>
+#include <cassert>
+
+#include <backend/Fence.h>
+
+DeferredDeletionQueue::~DeferredDeletionQueue()
+{
+    assert(m_Deletions.empty() && "Objects pending deletion, call Flush before the device is destroyed");
+}
+
+void DeferredDeletionQueue::Collect()
+{
+    // Work is submitted in order, so the first deletion that hasn't finished blocks the ones after it. This keeps
+    // the destruction order the same as the push order
+    while (!m_Deletions.empty() && HasFinished(m_Deletions.front()))
+    {
+        m_Deletions.pop_front();
+    }
+}
+
+void DeferredDeletionQueue::Flush()
+{
+    for (auto &deletion : m_Deletions)
+    {
+        for (auto *fence : deletion.PendingWork)
+        {
+            fence->Wait();
+        }
+    }
+    m_Deletions.clear();
+}
+
+size_t DeferredDeletionQueue::GetPendingCount() const
+{
+    return m_Deletions.size();
+}
+
+bool DeferredDeletionQueue::HasFinished(PendingDeletion &deletion)
+{
+    // A fence that was reset since was waited on by its owner, which means the work finished as well
+    auto &pendingWork = deletion.PendingWork;
+    pendingWork.erase(std::remove_if(pendingWork.begin(), pendingWork.end(),
+                                     [](Fence *fence) { return fence->QueryStatus() != FenceStatus::UnsignaledOrReset; }),
+                      pendingWork.end());
+    return pendingWork.empty();
+}
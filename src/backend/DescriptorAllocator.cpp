@@ -0,0 +1,125 @@
+#include <backend/DescriptorAllocator.h>
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace
+{
+bool IsPoolExhausted(VkResult result)
+{
+    return result == VkResult::VK_ERROR_OUT_OF_POOL_MEMORY || result == VkResult::VK_ERROR_FRAGMENTED_POOL;
+}
+}
+
+DescriptorAllocator::DescriptorAllocator(VkDevice device, const DescriptorAllocatorCreateInfo &createInfo)
+    : m_Device(device), m_CreateInfo(createInfo), m_NextPoolSets(createInfo.InitialSetsPerPool)
+{
+    assert(createInfo.InitialSetsPerPool > 0 && createInfo.InitialSetsPerPool <= createInfo.MaxSetsPerPool &&
+           "Invalid pool sizes");
+}
+
+DescriptorSet DescriptorAllocator::Allocate(const DescriptorSetLayout &layout)
+{
+    auto sets = Allocate(layout, 1);
+    return std::move(sets.front());
+}
+
+std::vector<DescriptorSet> DescriptorAllocator::Allocate(const DescriptorSetLayout &layout, uint32_t count)
+{
+    RecordUsage(layout, count);
+    std::vector<VkDescriptorSetLayout> layouts(count, layout.Get());
+    std::vector<VkDescriptorSet> handles(count, VK_NULL_HANDLE);
+
+    uint32_t allocated = 0;
+    uint32_t batchSize = count;
+    while (allocated < count)
+    {
+        if (m_CurrentPool == m_Pools.size())
+        {
+            m_Pools.emplace_back(CreatePool(layout));
+            m_Statistics.PoolCount++;
+        }
+        batchSize = std::min(batchSize, count - allocated);
+        auto result = m_Pools[m_CurrentPool].TryAllocate(std::span(layouts).subspan(allocated, batchSize),
+                                                         std::span(handles).subspan(allocated, batchSize));
+        m_Statistics.AllocateCalls++;
+        if (result == VkResult::VK_SUCCESS)
+        {
+            allocated += batchSize;
+            continue;
+        }
+        if (!IsPoolExhausted(result))
+        {
+            throw std::runtime_error("Failed to allocate descriptor sets");
+        }
+        // Allocations are all or nothing, so try fewer sets before moving on to the next pool
+        if (batchSize > 1)
+        {
+            batchSize /= 2;
+        }
+        else
+        {
+            m_CurrentPool++;
+            batchSize = count - allocated;
+        }
+    }
+    m_Statistics.AllocatedSets += count;
+
+    std::vector<DescriptorSet> sets;
+    sets.reserve(count);
+    for (auto handle : handles)
+    {
+        sets.emplace_back(layout, m_Device, handle);
+    }
+    return sets;
+}
+
+void DescriptorAllocator::Reset()
+{
+    for (auto &pool : m_Pools)
+    {
+        pool.Reset();
+    }
+    m_CurrentPool = 0;
+    m_Statistics.AllocatedSets = 0;
+    m_Statistics.AllocateCalls = 0;
+}
+
+DescriptorAllocatorStatistics DescriptorAllocator::GetStatistics() const
+{
+    return m_Statistics;
+}
+
+void DescriptorAllocator::RecordUsage(const DescriptorSetLayout &layout, uint32_t count)
+{
+    for (const auto &binding : layout.GetBindings())
+    {
+        m_ObservedDescriptors[binding.descriptorType] += static_cast<uint64_t>(binding.descriptorCount) * count;
+    }
+    m_ObservedSets += count;
+}
+
+DescriptorPool DescriptorAllocator::CreatePool(const DescriptorSetLayout &layout)
+{
+    auto setCount = m_NextPoolSets;
+    m_NextPoolSets = std::min(m_NextPoolSets * 2, m_CreateInfo.MaxSetsPerPool);
+
+    std::vector<VkDescriptorPoolSize> poolSizes;
+    poolSizes.reserve(m_ObservedDescriptors.size());
+    for (auto [descriptorType, observed] : m_ObservedDescriptors)
+    {
+        // The average per set so far, rounded up
+        auto perPool = (observed * setCount + m_ObservedSets - 1) / m_ObservedSets;
+        poolSizes.emplace_back(VkDescriptorPoolSize{descriptorType, static_cast<uint32_t>(perPool)});
+    }
+    // Also fit at least one set of the layout that didn't fit the previous pools, whatever the averages
+    for (const auto &binding : layout.GetBindings())
+    {
+        auto poolSize = std::find_if(poolSizes.begin(), poolSizes.end(), [&binding](const VkDescriptorPoolSize &size) {
+            return size.type == binding.descriptorType;
+        });
+        poolSize->descriptorCount = std::max(poolSize->descriptorCount, binding.descriptorCount);
+    }
+    return DescriptorPool(m_Device, poolSizes, setCount);
+}
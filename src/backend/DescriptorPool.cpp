@@ -1,12 +1,13 @@
 #include <backend/DescriptorPool.h>
 #include <backend/UniformBuffer.h>
 
+#include <cassert>
 #include <stdexcept>
 
-DescriptorPool::DescriptorPool(VkDevice device, const DescriptorPoolCreateInfo &descriptorPoolCreateInfo) 
-    : m_Device(device)
+namespace
+{
+std::vector<VkDescriptorPoolSize> GetPoolSizes(const DescriptorPoolCreateInfo &descriptorPoolCreateInfo)
 {
-    // TODO: Might not need a Vector here
     std::vector<VkDescriptorPoolSize> poolSizes;
     poolSizes.reserve(descriptorPoolCreateInfo.Types.size());
     for (auto descriptorType : descriptorPoolCreateInfo.Types)
@@ -16,12 +17,25 @@ DescriptorPool::DescriptorPool(VkDevice device, const DescriptorPoolCreateInfo &
 		poolSize.descriptorCount = static_cast<uint32_t>(descriptorPoolCreateInfo.SizePerType);
         poolSizes.emplace_back(poolSize);
     }
-		
+    return poolSizes;
+}
+}
+
+DescriptorPool::DescriptorPool(VkDevice device, const DescriptorPoolCreateInfo &descriptorPoolCreateInfo) 
+    : DescriptorPool(device, GetPoolSizes(descriptorPoolCreateInfo), descriptorPoolCreateInfo.SizePerType)
+{
+}
+
+DescriptorPool::DescriptorPool(VkDevice device, std::span<const VkDescriptorPoolSize> poolSizes, uint32_t maxSets,
+                               VkDescriptorPoolCreateFlags flags)
+    : m_Device(device)
+{
 	VkDescriptorPoolCreateInfo poolInfo{};
 	poolInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
 	poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
 	poolInfo.pPoolSizes = poolSizes.data();
-	poolInfo.maxSets = static_cast<uint32_t>(descriptorPoolCreateInfo.SizePerType);
+	poolInfo.maxSets = maxSets;
+	poolInfo.flags = flags;
 
 	if (vkCreateDescriptorPool(m_Device, &poolInfo, nullptr, &m_DescriptorPool) != VkResult::VK_SUCCESS)
 	{
@@ -60,3 +74,19 @@ DescriptorSet DescriptorPool::CreateDescriptorSet(const DescriptorSetLayout& lay
     }
     return DescriptorSet(layout, m_Device, descriptorSet);
 }
+
+VkResult DescriptorPool::TryAllocate(std::span<const VkDescriptorSetLayout> layouts, std::span<VkDescriptorSet> sets)
+{
+    assert(layouts.size() == sets.size() && "Need a layout for every set");
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = m_DescriptorPool;
+    allocInfo.descriptorSetCount = static_cast<uint32_t>(layouts.size());
+    allocInfo.pSetLayouts = layouts.data();
+    return vkAllocateDescriptorSets(m_Device, &allocInfo, sets.data());
+}
+
+void DescriptorPool::Reset()
+{
+    vkResetDescriptorPool(m_Device, m_DescriptorPool, 0);
+}
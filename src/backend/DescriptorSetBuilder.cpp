@@ -1,10 +1,14 @@
 #include <backend/DescriptorSetBuilder.h>
 #include <backend/UniformBuffer.h>
+#include <backend/DynamicUniformBuffer.h>
+#include <backend/Buffer.h>
 #include <backend/Texture.h>
 #include <backend/DescriptorPool.h>
 #include <backend/DebugMarker.h>
 
-BindSet::BindSet(const DescriptorSet &descriptorSet, VkDevice device) : 
+#include <algorithm>
+
+BindSet::BindSet(DescriptorSet &descriptorSet, VkDevice device) : 
     m_DescriptorSet(descriptorSet),
     m_Device(device)
 {
@@ -22,6 +26,24 @@ BindSet& BindSet::BindUniformBuffer(const UniformBuffer& buffer) &
     return *this;
 }
 
+BindSet& BindSet::BindDynamicUniformBuffer(const DynamicUniformBuffer& buffer) &
+{
+    BindDynamicUniformBufferInternal(buffer);
+    return *this;
+}
+
+BindSet& BindSet::BindStorageBuffer(const DeviceBuffer& buffer) &
+{
+    BindBufferInternal(buffer, VkDescriptorType::VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+    return *this;
+}
+
+BindSet& BindSet::BindStorageImage(const Texture& texture) &
+{
+    BindStorageImageInternal(texture);
+    return *this;
+}
+
 BindSet&& BindSet::BindTexture(Texture2D &texture) &&
 {
     BindTextureInternal(texture);
@@ -34,13 +56,31 @@ BindSet&& BindSet::BindUniformBuffer(const UniformBuffer& buffer) &&
     return std::move(*this);
 }
 
+BindSet&& BindSet::BindDynamicUniformBuffer(const DynamicUniformBuffer& buffer) &&
+{
+    BindDynamicUniformBufferInternal(buffer);
+    return std::move(*this);
+}
+
+BindSet&& BindSet::BindStorageBuffer(const DeviceBuffer& buffer) &&
+{
+    BindBufferInternal(buffer, VkDescriptorType::VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+    return std::move(*this);
+}
+
+BindSet&& BindSet::BindStorageImage(const Texture& texture) &&
+{
+    BindStorageImageInternal(texture);
+    return std::move(*this);
+}
+
 void BindSet::BindTextureInternal(Texture2D &texture)
 {
 	// TODO: Verify which slot this goes into with original layout
 	VkWriteDescriptorSet descriptorWriteInfo{};
 	descriptorWriteInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
 	descriptorWriteInfo.dstSet = m_DescriptorSet.Get();
-	descriptorWriteInfo.dstBinding = static_cast<uint32_t>(m_Entries.size());
+	descriptorWriteInfo.dstBinding = static_cast<uint32_t>(m_Writes.size());
 
 	descriptorWriteInfo.descriptorType = VkDescriptorType::VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 	// TODO: Support array bindings
@@ -49,68 +89,139 @@ void BindSet::BindTextureInternal(Texture2D &texture)
 
     // We fill this in once we combine all the writes into one invocation!
 	descriptorWriteInfo.pImageInfo = nullptr;
-    m_Entries.emplace_back(BindEntry{descriptorWriteInfo, {.ImageInfo = texture.GetDescriptorInfo()}});
-    auto pendingAcquire = texture.TakePendingAcquire();
-    if (pendingAcquire.has_value())
-    {
-        m_PendingAcquires.emplace_back(*pendingAcquire);
-    }
+    m_Writes.emplace_back(descriptorWriteInfo);
+    m_Infos.emplace_back(DescriptorInfo{.ImageInfo = texture.GetDescriptorInfo()});
+    m_BoundResources.emplace_back(BoundResource{.Image = &texture.GetTexture(), .DescriptorType = descriptorWriteInfo.descriptorType});
 }
 
 void BindSet::BindUniformBufferInternal(const UniformBuffer &buffer)
+{
+    BindBufferInternal(buffer.GetBuffer(), VkDescriptorType::VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
+}
+
+void BindSet::BindDynamicUniformBufferInternal(const DynamicUniformBuffer &buffer)
+{
+    BindBufferInternal(buffer.GetBuffer(), VkDescriptorType::VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+                       buffer.GetDescriptorInfo());
+}
+
+void BindSet::BindBufferInternal(const DeviceBuffer &buffer, VkDescriptorType descriptorType)
+{
+    BindBufferInternal(buffer, descriptorType, buffer.GetDescriptorInfo());
+}
+
+void BindSet::BindBufferInternal(const DeviceBuffer &buffer, VkDescriptorType descriptorType,
+                                 const VkDescriptorBufferInfo &bufferInfo)
 {
 	// TODO: Verify which slot this goes into with original layout
 	VkWriteDescriptorSet descriptorWriteInfo{};
 	descriptorWriteInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
 	descriptorWriteInfo.dstSet = m_DescriptorSet.Get();
-	descriptorWriteInfo.dstBinding = static_cast<uint32_t>(m_Entries.size());
+	descriptorWriteInfo.dstBinding = static_cast<uint32_t>(m_Writes.size());
 
-	descriptorWriteInfo.descriptorType = VkDescriptorType::VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	descriptorWriteInfo.descriptorType = descriptorType;
 	// TODO: Support array bindings
 	descriptorWriteInfo.dstArrayElement = 0;
 	descriptorWriteInfo.descriptorCount = 1;
 
     // We fill this in once we combine all the writes into one invocation!
 	descriptorWriteInfo.pBufferInfo = nullptr;
-    m_Entries.emplace_back(BindEntry{descriptorWriteInfo, {.BufferInfo = buffer.GetDescriptorInfo()}});
+    m_Writes.emplace_back(descriptorWriteInfo);
+    m_Infos.emplace_back(DescriptorInfo{.BufferInfo = bufferInfo});
+    bool readOnly = m_DescriptorSet.GetLayout().IsReadOnly(descriptorWriteInfo.dstBinding);
+    m_BoundResources.emplace_back(
+        BoundResource{.Buffer = &buffer, .DescriptorType = descriptorType, .ReadOnly = readOnly});
+}
+
+void BindSet::BindStorageImageInternal(const Texture &texture)
+{
+	VkWriteDescriptorSet descriptorWriteInfo{};
+	descriptorWriteInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	descriptorWriteInfo.dstSet = m_DescriptorSet.Get();
+	descriptorWriteInfo.dstBinding = static_cast<uint32_t>(m_Writes.size());
+
+	descriptorWriteInfo.descriptorType = VkDescriptorType::VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+	descriptorWriteInfo.dstArrayElement = 0;
+	descriptorWriteInfo.descriptorCount = 1;
+
+	descriptorWriteInfo.pImageInfo = nullptr;
+    auto imageInfo = texture.GetDescriptorInfo();
+    // Storage images are accessed in the general layout, see `GetDescriptorAccess`
+    imageInfo.imageLayout = VkImageLayout::VK_IMAGE_LAYOUT_GENERAL;
+    m_Writes.emplace_back(descriptorWriteInfo);
+    m_Infos.emplace_back(DescriptorInfo{.ImageInfo = imageInfo});
+    m_BoundResources.emplace_back(BoundResource{.Image = &texture, .DescriptorType = descriptorWriteInfo.descriptorType});
+}
+
+uint32_t BindSet::FlushWrites(EDescriptorUpdatePath path)
+{
+    // Note that no barriers are needed here, since updating a set doesn't 
+    // actually access the memory. The command buffer derives them from
+    // the bound resources when binding the set instead.
+    const auto &layout = m_DescriptorSet.GetLayout();
+    if (path == EDescriptorUpdatePath::Template && layout.GetUpdateTemplate() != VK_NULL_HANDLE &&
+        m_Writes.size() == layout.GetBindings().size())
+    {
+        return FlushTemplate();
+    }
+    return FlushDescriptorWrites();
 }
 
+uint32_t BindSet::FlushTemplate()
+{
+    bool changed = false;
+    for (size_t i = 0; i < m_Writes.size(); i++)
+    {
+        // Every binding is remembered, even once a change was found, as the template writes all of them
+        changed |= m_DescriptorSet.UpdateWritten(m_Writes[i], m_Infos[i]);
+    }
+    if (!changed)
+    {
+        return 0;
+    }
+    vkUpdateDescriptorSetWithTemplate(m_Device, m_DescriptorSet.Get(), m_DescriptorSet.GetLayout().GetUpdateTemplate(),
+                                      m_Infos.data());
+    return static_cast<uint32_t>(m_Infos.size());
+}
 
-void BindSet::FlushWrites()
+uint32_t BindSet::FlushDescriptorWrites()
 {
-    // TODO: Split the vectors so that we don't have to copy
-    // into this vecotr at the point of submission.
-    std::vector<VkWriteDescriptorSet> writes;
-    writes.reserve(m_Entries.size());
-    for (auto& entry : m_Entries)
+    auto &writes = m_DescriptorSet.m_PendingWrites;
+    writes.clear();
+    for (size_t i = 0; i < m_Writes.size(); i++)
     {
-        // We take the buffer info addresses here, but we're not 
-        // modifying the vector length prior to submission, so at this 
-        // point it's safe
-        switch (entry.StagingDescriptorWrite.descriptorType)
+        if (!m_DescriptorSet.UpdateWritten(m_Writes[i], m_Infos[i]))
+        {
+            continue;
+        }
+        // We take the info addresses here, but we're not modifying the
+        // vector length prior to submission, so at this point it's safe
+        auto &write = writes.emplace_back(m_Writes[i]);
+        switch (write.descriptorType)
         {
         case VkDescriptorType::VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
-            entry.StagingDescriptorWrite.pBufferInfo = &entry.DataInfo.BufferInfo;
+        case VkDescriptorType::VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+        case VkDescriptorType::VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+            write.pBufferInfo = &m_Infos[i].BufferInfo;
             break;
+        case VkDescriptorType::VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
         case VkDescriptorType::VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
-            entry.StagingDescriptorWrite.pImageInfo = &entry.DataInfo.ImageInfo;
-            entry.StagingDescriptorWrite.pBufferInfo = reinterpret_cast<VkDescriptorBufferInfo*>(&entry.DataInfo.ImageInfo);
+            write.pImageInfo = &m_Infos[i].ImageInfo;
             break;
         default:
             assert(false && "Unhandled descriptor type");
         }
-        writes.emplace_back(entry.StagingDescriptorWrite);
     }
-    // Note that we don't have to flush any pending acquires here, since
-    // vkUpdateDescriptorSets doesn't actually access the memory. As long
-    // as we flush them before we bind the descriptor sets, this is fine.
-    vkUpdateDescriptorSets(m_Device, static_cast<uint32_t>(writes.size()),
-		writes.data(), 0, nullptr);
+    if (!writes.empty())
+    {
+        vkUpdateDescriptorSets(m_Device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+    }
+    return static_cast<uint32_t>(writes.size());
 }
 
-std::vector<ImageMemoryBarrier> BindSet::TakePendingAcquires()
+std::span<const BindSet::BoundResource> BindSet::GetBoundResources() const
 {
-    return std::move(m_PendingAcquires);
+    return m_BoundResources;
 }
 
 const DescriptorSet &BindSet::GetDescriptorSet() const
@@ -133,6 +244,42 @@ void DescriptorSet::SetName(const std::string &name, const ExtensionFunctionMapp
     DebugMarker::SetName(m_Device, mapping, m_DescriptorSet, name);
 }
 
+void DescriptorSet::InvalidateWrites()
+{
+    m_Written.clear();
+}
+
+bool DescriptorSet::UpdateWritten(const VkWriteDescriptorSet &write, const DescriptorInfo &info)
+{
+    if (write.dstBinding >= m_Written.size())
+    {
+        m_Written.resize(write.dstBinding + 1);
+    }
+    auto &written = m_Written[write.dstBinding];
+    bool isBuffer = write.descriptorType == VkDescriptorType::VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER ||
+                    write.descriptorType == VkDescriptorType::VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC ||
+                    write.descriptorType == VkDescriptorType::VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    bool unchanged = written.has_value() && written->DescriptorType == write.descriptorType;
+    if (unchanged && isBuffer)
+    {
+        unchanged = written->Info.BufferInfo.buffer == info.BufferInfo.buffer &&
+                    written->Info.BufferInfo.offset == info.BufferInfo.offset &&
+                    written->Info.BufferInfo.range == info.BufferInfo.range;
+    }
+    else if (unchanged)
+    {
+        unchanged = written->Info.ImageInfo.sampler == info.ImageInfo.sampler &&
+                    written->Info.ImageInfo.imageView == info.ImageInfo.imageView &&
+                    written->Info.ImageInfo.imageLayout == info.ImageInfo.imageLayout;
+    }
+    if (unchanged)
+    {
+        return false;
+    }
+    written = WrittenDescriptor{write.descriptorType, info};
+    return true;
+}
+
 DescriptorSet::DescriptorSet(const DescriptorSetLayout &layout, VkDevice device, VkDescriptorSet set)
     : m_Layout(layout), m_Device(device), m_DescriptorSet(set)
 {
@@ -152,17 +299,60 @@ BindSet DescriptorSet::BindUniformBuffer(const UniformBuffer& buffer)
     return bindset;
 }
 
+BindSet DescriptorSet::BindDynamicUniformBuffer(const DynamicUniformBuffer& buffer)
+{
+    auto bindset = BindSet(*this, m_Device);
+    bindset.BindDynamicUniformBuffer(buffer);
+    return bindset;
+}
+
+BindSet DescriptorSet::BindStorageBuffer(const DeviceBuffer& buffer)
+{
+    auto bindset = BindSet(*this, m_Device);
+    bindset.BindStorageBuffer(buffer);
+    return bindset;
+}
+
+BindSet DescriptorSet::BindStorageImage(const Texture& texture)
+{
+    auto bindset = BindSet(*this, m_Device);
+    bindset.BindStorageImage(texture);
+    return bindset;
+}
+
 VkDescriptorSetLayout DescriptorSetLayout::Get() const
 {
     return m_Layout;
 }
 
+std::span<const VkDescriptorSetLayoutBinding> DescriptorSetLayout::GetBindings() const
+{
+    return m_Bindings;
+}
+
+
+DescriptorSetLayout::DescriptorSetLayout(VkDevice device, std::vector<VkDescriptorSetLayoutBinding> bindings,
+                                         std::vector<uint32_t> readOnlyBindings)
+    : DescriptorSetLayout(device, std::move(bindings), 0, {})
+{
+    m_ReadOnlyBindings = std::move(readOnlyBindings);
+}
 
-DescriptorSetLayout::DescriptorSetLayout(VkDevice device, std::vector<VkDescriptorSetLayoutBinding> bindings) : 
-    m_Device(device), m_Bindings(std::move(bindings))
+DescriptorSetLayout::DescriptorSetLayout(VkDevice device, std::vector<VkDescriptorSetLayoutBinding> bindings,
+                                         VkDescriptorSetLayoutCreateFlags flags,
+                                         std::span<const VkDescriptorBindingFlags> bindingFlags)
+    : m_Device(device), m_Bindings(std::move(bindings))
 {
+    assert((bindingFlags.empty() || bindingFlags.size() == m_Bindings.size()) && "Need flags for every binding");
+    VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+    bindingFlagsInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+    bindingFlagsInfo.bindingCount = static_cast<uint32_t>(bindingFlags.size());
+    bindingFlagsInfo.pBindingFlags = bindingFlags.data();
+
 	VkDescriptorSetLayoutCreateInfo createInfo{};
 	createInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    createInfo.pNext = bindingFlags.empty() ? nullptr : &bindingFlagsInfo;
+    createInfo.flags = flags;
 	// TODO: Consider a small vector or even array, as this hould be at most four bindings.
 	createInfo.bindingCount = static_cast<uint32_t>(m_Bindings.size());
 	createInfo.pBindings = m_Bindings.data();
@@ -171,10 +361,107 @@ DescriptorSetLayout::DescriptorSetLayout(VkDevice device, std::vector<VkDescript
     {
         throw std::runtime_error("Could not create descriptor set for uniform buffer");
     }
+    m_UpdateTemplate = CreateUpdateTemplate();
+}
+
+VkDescriptorUpdateTemplate DescriptorSetLayout::CreateUpdateTemplate() const
+{
+    // Matches what a `BindSet` binds, which is one descriptor for each of the bindings in order
+    std::vector<VkDescriptorUpdateTemplateEntry> entries(m_Bindings.size());
+    std::vector<bool> covered(m_Bindings.size(), false);
+    for (const auto &binding : m_Bindings)
+    {
+        if (binding.descriptorCount != 1 || binding.binding >= m_Bindings.size() || covered[binding.binding])
+        {
+            return VK_NULL_HANDLE;
+        }
+        switch (binding.descriptorType)
+        {
+        case VkDescriptorType::VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+        case VkDescriptorType::VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+        case VkDescriptorType::VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+        case VkDescriptorType::VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+        case VkDescriptorType::VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+            break;
+        default:
+            return VK_NULL_HANDLE;
+        }
+        covered[binding.binding] = true;
+        auto &entry = entries[binding.binding];
+        entry.dstBinding = binding.binding;
+        entry.dstArrayElement = 0;
+        entry.descriptorCount = 1;
+        entry.descriptorType = binding.descriptorType;
+        entry.offset = binding.binding * sizeof(DescriptorInfo);
+        entry.stride = sizeof(DescriptorInfo);
+    }
+    if (entries.empty())
+    {
+        return VK_NULL_HANDLE;
+    }
+
+    VkDescriptorUpdateTemplateCreateInfo createInfo{};
+    createInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO;
+    createInfo.descriptorUpdateEntryCount = static_cast<uint32_t>(entries.size());
+    createInfo.pDescriptorUpdateEntries = entries.data();
+    createInfo.templateType = VkDescriptorUpdateTemplateType::VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
+    createInfo.descriptorSetLayout = m_Layout;
+
+    VkDescriptorUpdateTemplate updateTemplate;
+    if (vkCreateDescriptorUpdateTemplate(m_Device, &createInfo, nullptr, &updateTemplate) != VkResult::VK_SUCCESS)
+    {
+        throw std::runtime_error("Could not create descriptor update template");
+    }
+    return updateTemplate;
+}
+
+VkDescriptorUpdateTemplate DescriptorSetLayout::GetUpdateTemplate() const
+{
+    return m_UpdateTemplate;
+}
+
+uint32_t DescriptorSetLayout::GetDynamicOffsetCount() const
+{
+    uint32_t count = 0;
+    for (const auto &binding : m_Bindings)
+    {
+        if (binding.descriptorType == VkDescriptorType::VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC ||
+            binding.descriptorType == VkDescriptorType::VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC)
+        {
+            count += binding.descriptorCount;
+        }
+    }
+    return count;
+}
+
+bool DescriptorSetLayout::IsReadOnly(uint32_t binding) const
+{
+    return std::find(m_ReadOnlyBindings.begin(), m_ReadOnlyBindings.end(), binding) != m_ReadOnlyBindings.end();
+}
+
+StateKey DescriptorSetLayout::GetStateKey(std::span<const VkDescriptorSetLayoutBinding> bindings,
+                                          std::span<const uint32_t> readOnlyBindings)
+{
+    StateKey key;
+    for (const auto &binding : bindings)
+    {
+        // Immutable samplers aren't used
+        key.Add(binding.binding).Add(binding.descriptorType).Add(binding.descriptorCount).Add(binding.stageFlags);
+    }
+    // Identical to Vulkan, but bound sets of either layout need different barriers
+    for (auto binding : readOnlyBindings)
+    {
+        key.Add(binding);
+    }
+    return key;
 }
 
 DescriptorSetLayout::~DescriptorSetLayout()
 {
+    if (m_UpdateTemplate != VK_NULL_HANDLE)
+    {
+        vkDestroyDescriptorUpdateTemplate(m_Device, m_UpdateTemplate, nullptr);
+    }
     if (m_Layout != VK_NULL_HANDLE)
     {
         vkDestroyDescriptorSetLayout(m_Device, m_Layout, nullptr);
@@ -182,42 +469,72 @@ DescriptorSetLayout::~DescriptorSetLayout()
 }
 
 DescriptorSetLayout::DescriptorSetLayout(DescriptorSetLayout &&other)
-    : m_Layout(std::exchange(other.m_Layout, VK_NULL_HANDLE)), m_Device(other.m_Device), m_Bindings(std::move(other.m_Bindings))
+    : m_Layout(std::exchange(other.m_Layout, VK_NULL_HANDLE)),
+      m_UpdateTemplate(std::exchange(other.m_UpdateTemplate, VK_NULL_HANDLE)), m_Device(other.m_Device),
+      m_Bindings(std::move(other.m_Bindings)), m_ReadOnlyBindings(std::move(other.m_ReadOnlyBindings))
+{
+}
+
+DescriptorSetBuilder &DescriptorSetBuilder::AddUniformBuffer(VkShaderStageFlags stages)
 {
+    return AddNextBinding(VkDescriptorType::VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, stages);
 }
 
-DescriptorSetBuilder &DescriptorSetBuilder::AddUniformBuffer()
+DescriptorSetBuilder &DescriptorSetBuilder::AddDynamicUniformBuffer(VkShaderStageFlags stages)
 {
-	VkDescriptorSetLayoutBinding uboLayoutBinding{};
-	uboLayoutBinding.binding = static_cast<uint32_t>(m_Bindings.size());
-	uboLayoutBinding.descriptorType = VkDescriptorType::VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	uboLayoutBinding.descriptorCount = 1;
-    uboLayoutBinding.stageFlags = VkShaderStageFlagBits::VK_SHADER_STAGE_VERTEX_BIT |
-                                  VkShaderStageFlagBits::VK_SHADER_STAGE_FRAGMENT_BIT |
-                                  VkShaderStageFlagBits::VK_SHADER_STAGE_COMPUTE_BIT;
-	uboLayoutBinding.pImmutableSamplers = nullptr;  
+    return AddNextBinding(VkDescriptorType::VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, stages);
+}
 
-	m_Bindings.emplace_back(uboLayoutBinding);
-    return *this;
+DescriptorSetBuilder &DescriptorSetBuilder::AddTexture(VkShaderStageFlags stages)
+{
+    return AddNextBinding(VkDescriptorType::VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, stages);
+}
+
+DescriptorSetBuilder &DescriptorSetBuilder::AddStorageBuffer(VkShaderStageFlags stages, bool readOnly)
+{
+    return AddNextBinding(VkDescriptorType::VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, stages, readOnly);
+}
+
+DescriptorSetBuilder &DescriptorSetBuilder::AddStorageImage(VkShaderStageFlags stages)
+{
+    return AddNextBinding(VkDescriptorType::VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, stages);
 }
 
-DescriptorSetBuilder &DescriptorSetBuilder::AddTexture()
+DescriptorSetBuilder &DescriptorSetBuilder::AddNextBinding(VkDescriptorType descriptorType, VkShaderStageFlags stages,
+                                                           bool readOnly)
 {
-	VkDescriptorSetLayoutBinding textureLayoutBinding{};
-	textureLayoutBinding.binding = static_cast<uint32_t>(m_Bindings.size());
-	textureLayoutBinding.descriptorType = VkDescriptorType::VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	textureLayoutBinding.descriptorCount = 1;
-    textureLayoutBinding.stageFlags = VkShaderStageFlagBits::VK_SHADER_STAGE_VERTEX_BIT |
-                                      VkShaderStageFlagBits::VK_SHADER_STAGE_FRAGMENT_BIT |
-                                      VkShaderStageFlagBits::VK_SHADER_STAGE_COMPUTE_BIT;
-	textureLayoutBinding.pImmutableSamplers = nullptr;  
+    VkDescriptorSetLayoutBinding binding{};
+    binding.binding = static_cast<uint32_t>(m_Bindings.size());
+    binding.descriptorType = descriptorType;
+    binding.descriptorCount = 1;
+    binding.stageFlags = stages;
+    binding.pImmutableSamplers = nullptr;
+    return AddBinding(binding, readOnly);
+}
 
-	m_Bindings.emplace_back(textureLayoutBinding);
+DescriptorSetBuilder &DescriptorSetBuilder::AddBinding(const VkDescriptorSetLayoutBinding &binding, bool readOnly)
+{
+    assert((!readOnly || binding.descriptorType == VkDescriptorType::VK_DESCRIPTOR_TYPE_STORAGE_BUFFER) &&
+           "Only storage buffers can be read only");
+    m_Bindings.emplace_back(binding);
+    if (readOnly)
+    {
+        m_ReadOnlyBindings.emplace_back(binding.binding);
+    }
     return *this;
 }
 
 DescriptorSetLayout DescriptorSetBuilder::Build(VkDevice device)
 {
-    return DescriptorSetLayout{device, std::move(m_Bindings)};
+    return DescriptorSetLayout{device, std::move(m_Bindings), std::move(m_ReadOnlyBindings)};
 }
 
+std::span<const VkDescriptorSetLayoutBinding> DescriptorSetBuilder::GetBindings() const
+{
+    return m_Bindings;
+}
+
+std::span<const uint32_t> DescriptorSetBuilder::GetReadOnlyBindings() const
+{
+    return m_ReadOnlyBindings;
+}
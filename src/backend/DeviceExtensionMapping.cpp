@@ -40,5 +40,7 @@ std::vector<const char *> DeviceExtensionMapping::ReverseMap(std::span<const EDe
 
 std::unordered_map<std::string_view, EDeviceExtension> DeviceExtensionMapping::CreateNameMapping()
 {
-    return {{VK_KHR_SWAPCHAIN_EXTENSION_NAME, EDeviceExtension::Swapchain}};
+    return {{VK_KHR_SWAPCHAIN_EXTENSION_NAME, EDeviceExtension::Swapchain},
+            {VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME, EDeviceExtension::Synchronization2},
+            {VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME, EDeviceExtension::DynamicRendering}};
 }
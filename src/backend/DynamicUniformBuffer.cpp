@@ -0,0 +1,63 @@
+#include <backend/DynamicUniformBuffer.h>
+
+#include <backend/VulkanDevice.h>
+
+namespace
+{
+VkDeviceSize AlignUp(VkDeviceSize size, VkDeviceSize alignment)
+{
+    return (size + alignment - 1) / alignment * alignment;
+}
+}
+
+DynamicUniformBuffer::DynamicUniformBuffer(VulkanDevice &vulkanDevice, const DynamicUniformBufferCreateInfo &createInfo,
+                                           VkDeviceSize offsetAlignment)
+    : m_Buffer(CreateBuffer(vulkanDevice,
+                            createInfo.MaxUploads * AlignUp(createInfo.MaxUploadSize, offsetAlignment))),
+      m_MaxUploadSize(createInfo.MaxUploadSize),
+      // Every slice covers the whole range of the descriptor, so that no read runs into the next slice
+      m_SliceStride(AlignUp(createInfo.MaxUploadSize, offsetAlignment))
+{
+    assert(createInfo.MaxUploads > 0 && "Buffer can't hold a single upload");
+}
+
+void DynamicUniformBuffer::Reset()
+{
+    m_Head = 0;
+}
+
+VkDescriptorBufferInfo DynamicUniformBuffer::GetDescriptorInfo() const
+{
+    // The offset is added to the dynamic offset given when binding
+    return VkDescriptorBufferInfo{m_Buffer.Get(), 0, m_MaxUploadSize};
+}
+
+const DeviceBuffer &DynamicUniformBuffer::GetBuffer() const
+{
+    return m_Buffer;
+}
+
+VkDeviceSize DynamicUniformBuffer::GetUsedSize() const
+{
+    return m_Head;
+}
+
+uint32_t DynamicUniformBuffer::Allocate()
+{
+    assert(m_Head + m_SliceStride <= m_Buffer.GetSize() &&
+           "More uploads than the `MaxUploads` budget since the last reset");
+    auto offset = m_Head;
+    m_Head += m_SliceStride;
+    return static_cast<uint32_t>(offset);
+}
+
+DeviceBuffer &DynamicUniformBuffer::CreateBuffer(VulkanDevice &vulkanDevice, VkDeviceSize size)
+{
+	CreateBufferInfo bufferInfo;
+	bufferInfo.BufferUsage = VkBufferUsageFlagBits::VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+	bufferInfo.MemoryProperties = VkMemoryPropertyFlagBits::VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VkMemoryPropertyFlagBits::VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    bufferInfo.Size = size;
+    bufferInfo.PersistentlyMapped = true;
+
+    return vulkanDevice.CreateBuffer(bufferInfo);
+}
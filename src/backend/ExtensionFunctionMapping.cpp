@@ -11,6 +11,8 @@ std::unordered_map<EExtensionFunction, const char *> ExtensionFunctionMapping::C
     nameMapping.insert({EExtensionFunction::CreateDebugUtilsMessenger, "vkCreateDebugUtilsMessengerEXT"});
     nameMapping.insert({EExtensionFunction::DestroyDebugUtilsMessenger, "vkDestroyDebugUtilsMessengerEXT"});
     nameMapping.insert({EExtensionFunction::DebugUtilsSetObjectName, "vkSetDebugUtilsObjectNameEXT"});
+    nameMapping.insert({EExtensionFunction::CmdBeginDebugUtilsLabel, "vkCmdBeginDebugUtilsLabelEXT"});
+    nameMapping.insert({EExtensionFunction::CmdEndDebugUtilsLabel, "vkCmdEndDebugUtilsLabelEXT"});
     return nameMapping;
 }
 
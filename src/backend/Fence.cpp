@@ -57,6 +57,21 @@ void Fence::WaitAndReset()
     m_Status = FenceStatus::Reset;
 }
 
+void Fence::Wait()
+{
+    // A reset fence may never be signaled again, and its work has finished when it was reset
+    if (m_Status == FenceStatus::Reset)
+    {
+        return;
+    }
+    auto result = vkWaitForFences(m_Device, 1, &m_Fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+    if (result != VkResult::VK_SUCCESS)
+    {
+        throw std::runtime_error("Wait unsuccesful");
+    }
+    m_Status = FenceStatus::Signaled;
+}
+
 VkFence Fence::Get() const
 {
     // Cannot know whether the fence maybe enter an unsignaled state,
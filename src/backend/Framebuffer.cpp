@@ -6,19 +6,18 @@
 Framebuffer::Framebuffer(VkDevice device, const FramebufferCreateInfo &createInfo)
     : m_Device(device), m_OriginalCreateInfo(createInfo)
 {
-	VkImageView swapchainColorAttachment[] = {createInfo.ColorOutputView, createInfo.DepthAttachmentView};
 	VkFramebufferCreateInfo framebufferCreateInfo{}; 
 	framebufferCreateInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
 	framebufferCreateInfo.renderPass = createInfo.RenderPass.Get();
-	framebufferCreateInfo.attachmentCount = 2;
-	framebufferCreateInfo.pAttachments = swapchainColorAttachment;
+	framebufferCreateInfo.attachmentCount = static_cast<uint32_t>(createInfo.Attachments.size());
+	framebufferCreateInfo.pAttachments = createInfo.Attachments.data();
 	framebufferCreateInfo.width = static_cast<uint32_t>(createInfo.Viewport.Viewport.width);
 	framebufferCreateInfo.height = static_cast<uint32_t>(createInfo.Viewport.Viewport.height);
 	framebufferCreateInfo.layers = 1;
 
 	if (vkCreateFramebuffer(device, &framebufferCreateInfo, nullptr, &m_Framebuffer) != VK_SUCCESS)
 	{
-		throw std::runtime_error("Could not create swapchain framebuffers");
+		throw std::runtime_error("Could not create framebuffer");
 	}
 }
 
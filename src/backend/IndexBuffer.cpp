@@ -20,10 +20,7 @@ IndexBuffer::IndexBuffer(CreateIndexBufferInfo bufferInfo, VkDevice device, cons
 	if (bufferInfo.SharingMode == VkSharingMode::VK_SHARING_MODE_EXCLUSIVE
 		&& transferCommandBuffer.GetQueue().GetFamilyIndex() != bufferInfo.DestinationQueue->GetFamilyIndex())
 	{
-		m_StagingBuffer.Transfer(TransferOp{*bufferInfo.DestinationQueue,
-											VkAccessFlagBits::VK_ACCESS_INDEX_READ_BIT,
-											VkPipelineStageFlagBits::VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT |
-												VkPipelineStageFlagBits::VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT}, transferCommandBuffer);
+		transferCommandBuffer.ReleaseOwnership(m_IndexBuffer, *bufferInfo.DestinationQueue);
 	}
 	
 	// TODO: Use semaphore instead, allow fetching the semaphore
@@ -0,0 +1,97 @@
+#include <backend/OffscreenSwapchain.h>
+
+#include <cassert>
+#include <stdexcept>
+
+#include <backend/PhysicalDevice.h>
+#include <backend/Semaphore.h>
+
+OffscreenSwapchain::OffscreenSwapchain(VkDevice device, const PhysicalDevice &physicalDevice,
+                                       const OffscreenSwapchainCreateInfo &createInfo, Queue queue)
+    : m_CreateInfo(createInfo), m_Queue(queue)
+{
+    assert(createInfo.ImageCount > 0 && "Need at least one image to render to");
+    m_Images.reserve(createInfo.ImageCount);
+    for (uint32_t i = 0; i < createInfo.ImageCount; i++)
+    {
+        // Transfer source, so that frames can be read back like a screenshot
+        m_Images.emplace_back(device, physicalDevice,
+                              TextureCreateInfo{createInfo.Width, createInfo.Height, createInfo.Format,
+                                                VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT});
+    }
+    // Starts at the last image, so that the first acquire returns the first one
+    m_CurrentImageIndex = createInfo.ImageCount - 1;
+}
+
+Viewport OffscreenSwapchain::GetViewportDescription() const
+{
+    VkViewport viewport{};
+    viewport.x = 0.0f;
+    viewport.y = 0.0f;
+    viewport.width = static_cast<float>(m_CreateInfo.Width);
+    viewport.height = static_cast<float>(m_CreateInfo.Height);
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+
+    VkRect2D scissorRect{};
+    scissorRect.extent = VkExtent2D{m_CreateInfo.Width, m_CreateInfo.Height};
+    return {viewport, scissorRect};
+}
+
+VkFormat OffscreenSwapchain::GetFormat() const
+{
+    return m_CreateInfo.Format;
+}
+
+const Texture &OffscreenSwapchain::GetCurrentTexture() const
+{
+    return m_Images[CurrentIndex()];
+}
+
+uint32_t OffscreenSwapchain::CurrentIndex() const
+{
+    assert(m_Acquired && "No image acquired, make sure you called AcquireNext");
+    return m_CurrentImageIndex;
+}
+
+void OffscreenSwapchain::AcquireNext(const Semaphore &toSignal)
+{
+    m_CurrentImageIndex = (m_CurrentImageIndex + 1) % m_CreateInfo.ImageCount;
+    m_Acquired = true;
+
+    VkSemaphore semaphore = toSignal.Get();
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores = &semaphore;
+    Submit(submitInfo);
+}
+
+void OffscreenSwapchain::Present(std::span<Semaphore> waitSemaphores)
+{
+    assert(m_Acquired && "No image acquired, make sure you called AcquireNext");
+    std::vector<VkSemaphore> semaphoreHandles;
+    semaphoreHandles.reserve(waitSemaphores.size());
+    for (const auto &semaphore : waitSemaphores)
+    {
+        semaphoreHandles.emplace_back(semaphore.Get());
+    }
+    std::vector<VkPipelineStageFlags> waitStages(semaphoreHandles.size(),
+                                                 VkPipelineStageFlagBits::VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.waitSemaphoreCount = static_cast<uint32_t>(semaphoreHandles.size());
+    submitInfo.pWaitSemaphores = semaphoreHandles.data();
+    submitInfo.pWaitDstStageMask = waitStages.data();
+    Submit(submitInfo);
+    m_Acquired = false;
+}
+
+void OffscreenSwapchain::Submit(const VkSubmitInfo &submitInfo) const
+{
+    if (vkQueueSubmit(m_Queue.Get(), 1, &submitInfo, VK_NULL_HANDLE) != VkResult::VK_SUCCESS)
+    {
+        throw std::runtime_error("Could not submit to offscreen swapchain queue");
+    }
+}
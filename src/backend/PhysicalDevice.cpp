@@ -6,10 +6,13 @@ PhysicalDevice::PhysicalDevice(VkPhysicalDevice physicalDevice,
                            std::span<const EDeviceExtension> requestedExtensions)
     : m_ExtensionMapping(extensionMapping), m_PhysicalDevice(physicalDevice),
       m_QueueFamilies(FindQueueFamilies(targetSurface)), m_Properties(QueryDeviceProperties()),
-      m_Features(QueryDeviceFeatures()), 
+      m_Features(QueryDeviceFeatures()), m_Vulkan12Features(QueryVulkan12Features()),
+      m_Vulkan12Properties(QueryVulkan12Properties()),
       m_MemoryProperties(QueryMemoryProperties()),
       m_SurfaceProperties(QuerySurfaceProperties(targetSurface)),
-      m_AvailableExtensions(QueryExtensions(extensionMapping)), m_Valid(Validate(requestedExtensions)),
+      m_AvailableExtensions(QueryExtensions(extensionMapping)),
+      m_SupportsSynchronization2(QuerySynchronization2Support()),
+      m_SupportsDynamicRendering(QueryDynamicRenderingSupport()), m_Valid(Validate(requestedExtensions)),
       m_TargetSurface(targetSurface)
 {
 }
@@ -34,6 +37,33 @@ const VkPhysicalDeviceFeatures &PhysicalDevice::GetFeatures() const
     return m_Features;
 }
 
+const VkPhysicalDeviceVulkan12Features &PhysicalDevice::GetVulkan12Features() const
+{
+    return m_Vulkan12Features;
+}
+
+const VkPhysicalDeviceVulkan12Properties &PhysicalDevice::GetVulkan12Properties() const
+{
+    return m_Vulkan12Properties;
+}
+
+bool PhysicalDevice::SupportsSynchronization2() const
+{
+    return m_SupportsSynchronization2;
+}
+
+bool PhysicalDevice::SupportsDynamicRendering() const
+{
+    return m_SupportsDynamicRendering;
+}
+
+bool PhysicalDevice::SupportsBindless() const
+{
+    return m_Vulkan12Features.runtimeDescriptorArray && m_Vulkan12Features.descriptorBindingPartiallyBound &&
+           m_Vulkan12Features.descriptorBindingSampledImageUpdateAfterBind &&
+           m_Vulkan12Features.shaderSampledImageArrayNonUniformIndexing;
+}
+
 std::vector<EDeviceExtension> PhysicalDevice::FilterAvailableExtensions(
     std::span<const EDeviceExtension> desiredExtensions) const
 {
@@ -41,13 +71,16 @@ std::vector<EDeviceExtension> PhysicalDevice::FilterAvailableExtensions(
     desiredAvailableExtensions.reserve(desiredExtensions.size());
     for (EDeviceExtension extension : desiredExtensions)
     {
-        desiredAvailableExtensions.emplace_back(extension);
+        if (m_AvailableExtensions.find(extension) != m_AvailableExtensions.end())
+        {
+            desiredAvailableExtensions.emplace_back(extension);
+        }
     }
     return desiredAvailableExtensions;
 }
 
 VulkanDevice PhysicalDevice::CreateLogicalDevice(const std::vector<const char*> &validationLayers,
-                                                 std::vector<EDeviceExtension> extensions, GLFWwindow &window,
+                                                 std::vector<EDeviceExtension> extensions, GLFWwindow *window,
                                                  const VulkanInstance &instance)
 {
     return VulkanDevice(*this, m_PhysicalDevice, instance, validationLayers, extensions, m_ExtensionMapping, window);
@@ -83,6 +116,77 @@ VkPhysicalDeviceFeatures PhysicalDevice::QueryDeviceFeatures() const
     return features;
 }
 
+VkPhysicalDeviceVulkan12Features PhysicalDevice::QueryVulkan12Features() const
+{
+    VkPhysicalDeviceVulkan12Features vulkan12Features{};
+    vulkan12Features.sType = VkStructureType::VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    if (m_Properties.apiVersion < VK_API_VERSION_1_2)
+    {
+        return vulkan12Features;
+    }
+
+    VkPhysicalDeviceFeatures2 features{};
+    features.sType = VkStructureType::VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features.pNext = &vulkan12Features;
+    vkGetPhysicalDeviceFeatures2(m_PhysicalDevice, &features);
+    // Don't leave a dangling pointer to the local chain
+    vulkan12Features.pNext = nullptr;
+    return vulkan12Features;
+}
+
+VkPhysicalDeviceVulkan12Properties PhysicalDevice::QueryVulkan12Properties() const
+{
+    VkPhysicalDeviceVulkan12Properties vulkan12Properties{};
+    vulkan12Properties.sType = VkStructureType::VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+    if (m_Properties.apiVersion < VK_API_VERSION_1_2)
+    {
+        return vulkan12Properties;
+    }
+
+    VkPhysicalDeviceProperties2 properties{};
+    properties.sType = VkStructureType::VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    properties.pNext = &vulkan12Properties;
+    vkGetPhysicalDeviceProperties2(m_PhysicalDevice, &properties);
+    vulkan12Properties.pNext = nullptr;
+    return vulkan12Properties;
+}
+
+bool PhysicalDevice::QuerySynchronization2Support() const
+{
+    // Only queried through vkGetPhysicalDeviceFeatures2, which the 1.2 path already relies on
+    if (m_Properties.apiVersion < VK_API_VERSION_1_2 ||
+        m_AvailableExtensions.find(EDeviceExtension::Synchronization2) == m_AvailableExtensions.end())
+    {
+        return false;
+    }
+
+    VkPhysicalDeviceSynchronization2FeaturesKHR synchronization2Features{};
+    synchronization2Features.sType = VkStructureType::VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR;
+    VkPhysicalDeviceFeatures2 features{};
+    features.sType = VkStructureType::VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features.pNext = &synchronization2Features;
+    vkGetPhysicalDeviceFeatures2(m_PhysicalDevice, &features);
+    return synchronization2Features.synchronization2 == VK_TRUE;
+}
+
+bool PhysicalDevice::QueryDynamicRenderingSupport() const
+{
+    // The extension depends on VK_KHR_create_renderpass2 and VK_KHR_depth_stencil_resolve, which are core in 1.2
+    if (m_Properties.apiVersion < VK_API_VERSION_1_2 ||
+        m_AvailableExtensions.find(EDeviceExtension::DynamicRendering) == m_AvailableExtensions.end())
+    {
+        return false;
+    }
+
+    VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamicRenderingFeatures{};
+    dynamicRenderingFeatures.sType = VkStructureType::VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+    VkPhysicalDeviceFeatures2 features{};
+    features.sType = VkStructureType::VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features.pNext = &dynamicRenderingFeatures;
+    vkGetPhysicalDeviceFeatures2(m_PhysicalDevice, &features);
+    return dynamicRenderingFeatures.dynamicRendering == VK_TRUE;
+}
+
 SurfaceProperties PhysicalDevice::QuerySurfaceProperties(
     std::optional<std::reference_wrapper<const VulkanSurface>> surface) const
 {
@@ -104,14 +208,21 @@ VkPhysicalDeviceMemoryProperties PhysicalDevice::QueryMemoryProperties() const
     return memoryProperties;
 }
 
+bool PhysicalDevice::IsCpu() const
+{
+    return m_Properties.deviceType == VkPhysicalDeviceType::VK_PHYSICAL_DEVICE_TYPE_CPU;
+}
+
 bool PhysicalDevice::Validate(std::span<const EDeviceExtension> requiredExtensions) const
 {
-    return (m_Properties.deviceType == VkPhysicalDeviceType::VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU ||
-            m_Properties.deviceType == VkPhysicalDeviceType::VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU) &&
-           m_Features.geometryShader && m_QueueFamilies.GraphicsFamilyIndex.has_value() &&
-           m_QueueFamilies.PresentFamilyIndex.has_value() && !m_SurfaceProperties.Formats.empty() &&
-           !m_SurfaceProperties.PresentModes.empty() && AllExtensionsAvailable(requiredExtensions) &&
-           m_Features.samplerAnisotropy;
+    bool headless = !m_TargetSurface.has_value();
+    bool supportedType = m_Properties.deviceType == VkPhysicalDeviceType::VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU ||
+                         m_Properties.deviceType == VkPhysicalDeviceType::VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU ||
+                         (headless && IsCpu());
+    bool canPresent = headless || (m_QueueFamilies.PresentFamilyIndex.has_value() &&
+                                   !m_SurfaceProperties.Formats.empty() && !m_SurfaceProperties.PresentModes.empty());
+    return supportedType && m_Features.geometryShader && m_QueueFamilies.GraphicsFamilyIndex.has_value() &&
+           canPresent && AllExtensionsAvailable(requiredExtensions) && m_Features.samplerAnisotropy;
 }
 
 bool PhysicalDevice::AllExtensionsAvailable(std::span<const EDeviceExtension> extensions) const
@@ -1,6 +1,10 @@
 #include <backend/Pipeline.h>
 #include <backend/VulkanDevice.h>
 
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+
 RasterPipelineBuilder::RasterPipelineBuilder(std::filesystem::path&& vertexShaderPath,
                                              std::filesystem::path&& fragmentShaderPath)
     : m_VertexShaderPath(vertexShaderPath), m_FragmentShaderPath(fragmentShaderPath)
@@ -9,7 +13,18 @@ RasterPipelineBuilder::RasterPipelineBuilder(std::filesystem::path&& vertexShade
 
 RasterPipelineBuilder & RasterPipelineBuilder::SetVertexBindingDescription(const VertexBindingDescription & vertexBinding)
 {
-    m_VertexBindingDescription.emplace(vertexBinding);
+    m_VertexBindingDescriptions.clear();
+    return AddVertexBindingDescription(vertexBinding);
+}
+
+RasterPipelineBuilder &RasterPipelineBuilder::AddVertexBindingDescription(const VertexBindingDescription &vertexBinding)
+{
+    assert(std::none_of(m_VertexBindingDescriptions.begin(), m_VertexBindingDescriptions.end(),
+                        [&vertexBinding](const VertexBindingDescription &existing) {
+                            return existing.Description.binding == vertexBinding.Description.binding;
+                        }) &&
+           "Vertex binding index is already in use");
+    m_VertexBindingDescriptions.emplace_back(vertexBinding);
     return *this;
 }
 
@@ -19,9 +34,37 @@ RasterPipelineBuilder &RasterPipelineBuilder::SetDescriptorSetLayout(const Descr
     return *this;
 }
 
-const std::optional<VertexBindingDescription>& RasterPipelineBuilder::GetVertexBindingDescription() const
+RasterPipelineBuilder &RasterPipelineBuilder::SetSpecializationConstants(VkShaderStageFlagBits stage,
+                                                                         SpecializationConstants constants)
+{
+    if (stage == VkShaderStageFlagBits::VK_SHADER_STAGE_VERTEX_BIT)
+    {
+        m_VertexSpecialization.emplace(std::move(constants));
+    }
+    else
+    {
+        assert(stage == VkShaderStageFlagBits::VK_SHADER_STAGE_FRAGMENT_BIT && "Raster pipelines only have a vertex and fragment stage");
+        m_FragmentSpecialization.emplace(std::move(constants));
+    }
+    return *this;
+}
+
+const std::vector<VertexBindingDescription>& RasterPipelineBuilder::GetVertexBindingDescriptions() const
 {
-    return m_VertexBindingDescription;
+    return m_VertexBindingDescriptions;
+}
+
+VertexInputState RasterPipelineBuilder::GetVertexInputState() const
+{
+    VertexInputState inputState;
+    inputState.Bindings.reserve(m_VertexBindingDescriptions.size());
+    for (const auto &binding : m_VertexBindingDescriptions)
+    {
+        inputState.Bindings.emplace_back(binding.Description);
+        inputState.Attributes.insert(inputState.Attributes.end(), binding.AttributeDescriptions.begin(),
+                                     binding.AttributeDescriptions.end());
+    }
+    return inputState;
 }
 
 const std::filesystem::path &RasterPipelineBuilder::GetVertexShaderPath() const
@@ -39,29 +82,151 @@ std::optional<std::reference_wrapper<const DescriptorSetLayout>> RasterPipelineB
     return m_DescriptorSetLayout;
 }
 
-RasterPipeline::RasterPipeline(VkDevice vulkanDevice, PipelineCreateInfo createInfo)
-    : m_VulkanDevice(vulkanDevice) 
+const std::vector<VkPushConstantRange> &RasterPipelineBuilder::GetPushConstantRanges() const
 {
-    VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo{};
-    pipelineLayoutCreateInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    pipelineLayoutCreateInfo.setLayoutCount = static_cast<uint32_t>(createInfo.Descriptors.size());
-    pipelineLayoutCreateInfo.pSetLayouts = createInfo.Descriptors.data();
-    pipelineLayoutCreateInfo.pushConstantRangeCount = 0;
-    pipelineLayoutCreateInfo.pPushConstantRanges = nullptr;
+    return m_PushConstantRanges;
+}
+
+const std::optional<SpecializationConstants> &RasterPipelineBuilder::GetSpecializationConstants(
+    VkShaderStageFlagBits stage) const
+{
+    return stage == VkShaderStageFlagBits::VK_SHADER_STAGE_VERTEX_BIT ? m_VertexSpecialization : m_FragmentSpecialization;
+}
+
+StateKey RasterPipelineBuilder::GetStateKey(const VkGraphicsPipelineCreateInfo &createInfo,
+                                            const PipelineLayout &layout, const RenderingLayout &rendering) const
+{
+    StateKey key;
+    key.Add(m_VertexShaderPath.string()).Add(m_FragmentShaderPath.string());
+    for (const auto *specialization : {&m_VertexSpecialization, &m_FragmentSpecialization})
+    {
+        key.Add(specialization->has_value());
+        if (specialization->has_value())
+        {
+            (*specialization)->AddToKey(key);
+        }
+    }
+    // Layouts are shared, so the handle identifies the descriptor set layouts and push constant ranges
+    key.Add(layout.Get());
+
+    for (const auto &binding : m_VertexBindingDescriptions)
+    {
+        key.Add(binding.Description.binding).Add(binding.Description.stride).Add(binding.Description.inputRate);
+        for (const auto &attribute : binding.AttributeDescriptions)
+        {
+            key.Add(attribute.location).Add(attribute.binding).Add(attribute.format).Add(attribute.offset);
+        }
+    }
+
+    const auto &inputAssembly = *createInfo.pInputAssemblyState;
+    key.Add(inputAssembly.topology).Add(inputAssembly.primitiveRestartEnable);
+
+    const auto &rasterization = *createInfo.pRasterizationState;
+    key.Add(rasterization.depthClampEnable)
+        .Add(rasterization.rasterizerDiscardEnable)
+        .Add(rasterization.polygonMode)
+        .Add(rasterization.cullMode)
+        .Add(rasterization.frontFace)
+        .Add(rasterization.depthBiasEnable)
+        .Add(rasterization.depthBiasConstantFactor)
+        .Add(rasterization.depthBiasClamp)
+        .Add(rasterization.depthBiasSlopeFactor)
+        .Add(rasterization.lineWidth);
+
+    const auto &multisample = *createInfo.pMultisampleState;
+    key.Add(multisample.rasterizationSamples)
+        .Add(multisample.sampleShadingEnable)
+        .Add(multisample.minSampleShading)
+        .Add(multisample.alphaToCoverageEnable)
+        .Add(multisample.alphaToOneEnable);
+
+    const auto &depthStencil = *createInfo.pDepthStencilState;
+    key.Add(depthStencil.depthTestEnable)
+        .Add(depthStencil.depthWriteEnable)
+        .Add(depthStencil.depthCompareOp)
+        .Add(depthStencil.depthBoundsTestEnable)
+        .Add(depthStencil.stencilTestEnable)
+        .Add(depthStencil.minDepthBounds)
+        .Add(depthStencil.maxDepthBounds);
+
+    const auto &colorBlend = *createInfo.pColorBlendState;
+    key.Add(colorBlend.logicOpEnable).Add(colorBlend.logicOp);
+    for (auto constant : colorBlend.blendConstants)
+    {
+        key.Add(constant);
+    }
+    for (uint32_t i = 0; i < colorBlend.attachmentCount; i++)
+    {
+        const auto &attachment = colorBlend.pAttachments[i];
+        key.Add(attachment.blendEnable)
+            .Add(attachment.srcColorBlendFactor)
+            .Add(attachment.dstColorBlendFactor)
+            .Add(attachment.colorBlendOp)
+            .Add(attachment.srcAlphaBlendFactor)
+            .Add(attachment.dstAlphaBlendFactor)
+            .Add(attachment.alphaBlendOp)
+            .Add(attachment.colorWriteMask);
+    }
+
+    const auto &dynamicState = *createInfo.pDynamicState;
+    for (uint32_t i = 0; i < dynamicState.dynamicStateCount; i++)
+    {
+        key.Add(dynamicState.pDynamicStates[i]);
+    }
 
-    if (vkCreatePipelineLayout(vulkanDevice, &pipelineLayoutCreateInfo, nullptr, &m_PipelineLayout) != VK_SUCCESS)
+    // Render passes are compatible if their attachments have the same formats and sample counts. Pipelines for
+    // dynamic rendering can't be used in render passes, and vice versa
+    key.Add(rendering.CompatibleRenderPass != nullptr);
+    key.Add(rendering.ColorFormats.size());
+    for (auto format : rendering.ColorFormats)
     {
-        throw std::runtime_error("Could not create pipeline layout");
+        key.Add(format);
     }
+    key.Add(rendering.DepthFormat).Add(rendering.Samples);
+    return key;
+}
+
+RasterPipelineBuilder &RasterPipelineBuilder::AddPushConstantRange(VkPushConstantRange range)
+{
+    // Stages can each only be part of a single range in a pipeline layout
+    assert(std::none_of(m_PushConstantRanges.begin(), m_PushConstantRanges.end(),
+                        [&range](const VkPushConstantRange &existing) {
+                            return (existing.stageFlags & range.stageFlags) != 0;
+                        }) &&
+           "Shader stage already has a push constant range");
+    m_PushConstantRanges.emplace_back(range);
+    return *this;
+}
+
+RasterPipeline::RasterPipeline(VkDevice vulkanDevice, PipelineCreateInfo createInfo)
+    : m_VulkanDevice(vulkanDevice), m_Layout(createInfo.Layout)
+{
     VkGraphicsPipelineCreateInfo vkCreateInfo = std::move(createInfo.CreateInfo);
-    vkCreateInfo.layout = m_PipelineLayout;
-    vkCreateInfo.renderPass = createInfo.RenderPass.Get();
+    vkCreateInfo.layout = m_Layout.Get();
     vkCreateInfo.subpass = 0;
 
+    const auto &rendering = createInfo.Rendering;
+    VkPipelineRenderingCreateInfoKHR renderingCreateInfo{};
+    renderingCreateInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR;
+    renderingCreateInfo.colorAttachmentCount = static_cast<uint32_t>(rendering.ColorFormats.size());
+    renderingCreateInfo.pColorAttachmentFormats = rendering.ColorFormats.data();
+    renderingCreateInfo.depthAttachmentFormat = rendering.DepthFormat;
+    renderingCreateInfo.stencilAttachmentFormat = VK_FORMAT_UNDEFINED;
+    if (rendering.CompatibleRenderPass != nullptr)
+    {
+        vkCreateInfo.renderPass = rendering.CompatibleRenderPass->Get();
+    }
+    else
+    {
+        vkCreateInfo.renderPass = VK_NULL_HANDLE;
+        renderingCreateInfo.pNext = vkCreateInfo.pNext;
+        vkCreateInfo.pNext = &renderingCreateInfo;
+    }
+
     // Unused
     vkCreateInfo.basePipelineHandle = VK_NULL_HANDLE;
     vkCreateInfo.basePipelineIndex = -1;
-    if (vkCreateGraphicsPipelines(vulkanDevice, VK_NULL_HANDLE, 1, &vkCreateInfo, nullptr, &m_Pipeline))
+    if (vkCreateGraphicsPipelines(vulkanDevice, createInfo.PipelineCache, 1, &vkCreateInfo, nullptr, &m_Pipeline))
     {
         throw std::runtime_error("Could not create pipeline");
     }
@@ -69,7 +234,7 @@ RasterPipeline::RasterPipeline(VkDevice vulkanDevice, PipelineCreateInfo createI
 
 RasterPipeline::RasterPipeline(RasterPipeline &&other) : 
     m_VulkanDevice(other.m_VulkanDevice),
-    m_PipelineLayout(std::exchange(other.m_PipelineLayout, VK_NULL_HANDLE)),
+    m_Layout(other.m_Layout),
     m_Pipeline(std::exchange(other.m_Pipeline, VK_NULL_HANDLE))
 {
     // TODO: Somehow ensure that this signals the render pass is still bound by this (?)
@@ -77,43 +242,59 @@ RasterPipeline::RasterPipeline(RasterPipeline &&other) :
 
 RasterPipeline::~RasterPipeline()
 {
-    if (m_PipelineLayout != VK_NULL_HANDLE)
+    if (m_Pipeline != VK_NULL_HANDLE)
     {
         vkDestroyPipeline(m_VulkanDevice, m_Pipeline, nullptr);
-        vkDestroyPipelineLayout(m_VulkanDevice, m_PipelineLayout, nullptr);
     }
 }
 
 VkPipelineLayout RasterPipeline::GetPipelineLayout() const
 {
-    return m_PipelineLayout;
+    return m_Layout.Get();
 }
 
-void RasterPipeline::Bind(const VkCommandBuffer &commandBuffer, const Viewport &viewport) const
+VkPipeline RasterPipeline::Get() const
 {
-    vkCmdBindPipeline(commandBuffer, VkPipelineBindPoint::VK_PIPELINE_BIND_POINT_GRAPHICS, m_Pipeline);
-    vkCmdSetViewport(commandBuffer, 0, 1, &viewport.Viewport);
-    vkCmdSetScissor(commandBuffer, 0, 1, &viewport.Scissor);
+    return m_Pipeline;
 }
 
-VkPipelineVertexInputStateCreateInfo VertexBindingDescription::GetVkPipelineInputStateCreateInfo() const
+const std::vector<VkPushConstantRange> &RasterPipeline::GetPushConstantRanges() const
 {
-    VkPipelineVertexInputStateCreateInfo vertexInputCreateInfo{};
-    vertexInputCreateInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-    vertexInputCreateInfo.vertexBindingDescriptionCount = 1;
-    vertexInputCreateInfo.pVertexBindingDescriptions = &Description;
-    vertexInputCreateInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(AttributeDescriptions.size());
-    vertexInputCreateInfo.pVertexAttributeDescriptions = AttributeDescriptions.data();
-    return vertexInputCreateInfo;
+    return m_Layout.GetPushConstantRanges();
+}
+
+PendingRasterPipeline::PendingRasterPipeline(std::shared_future<const RasterPipeline *> pipeline)
+    : m_Pipeline(std::move(pipeline))
+{
+}
+
+bool PendingRasterPipeline::IsReady() const
+{
+    return m_Pipeline.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+const RasterPipeline *PendingRasterPipeline::TryGet() const
+{
+    return IsReady() ? m_Pipeline.get() : nullptr;
+}
+
+const RasterPipeline &PendingRasterPipeline::Wait() const
+{
+    return *m_Pipeline.get();
+}
+
+void PendingRasterPipeline::WaitForCompletion() const
+{
+    m_Pipeline.wait();
 }
 
-VkPipelineVertexInputStateCreateInfo VertexBindingDescription::DefaultPipelineInputStateCreateInfo()
+VkPipelineVertexInputStateCreateInfo VertexInputState::GetVkPipelineInputStateCreateInfo() const
 {
     VkPipelineVertexInputStateCreateInfo vertexInputCreateInfo{};
     vertexInputCreateInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-    vertexInputCreateInfo.vertexBindingDescriptionCount = 0;
-    vertexInputCreateInfo.pVertexBindingDescriptions = nullptr;
-    vertexInputCreateInfo.vertexAttributeDescriptionCount = 0;
-    vertexInputCreateInfo.pVertexAttributeDescriptions = nullptr;
+    vertexInputCreateInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(Bindings.size());
+    vertexInputCreateInfo.pVertexBindingDescriptions = Bindings.empty() ? nullptr : Bindings.data();
+    vertexInputCreateInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(Attributes.size());
+    vertexInputCreateInfo.pVertexAttributeDescriptions = Attributes.empty() ? nullptr : Attributes.data();
     return vertexInputCreateInfo;
 }
@@ -0,0 +1,128 @@
+#include <backend/PipelineCache.h>
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+
+#include <backend/PhysicalDevice.h>
+
+PipelineCache::PipelineCache(VkDevice device, const PhysicalDevice &physicalDevice, std::filesystem::path path)
+    : m_Device(device), m_Path(std::move(path))
+{
+    auto initialData = LoadValidatedData(physicalDevice);
+    m_Statistics.LoadedFromDisk = !initialData.empty();
+
+    VkPipelineCacheCreateInfo createInfo{};
+    createInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    createInfo.initialDataSize = initialData.size();
+    createInfo.pInitialData = initialData.empty() ? nullptr : initialData.data();
+    if (vkCreatePipelineCache(m_Device, &createInfo, nullptr, &m_PipelineCache) != VkResult::VK_SUCCESS)
+    {
+        throw std::runtime_error("Could not create pipeline cache");
+    }
+}
+
+PipelineCache::PipelineCache(PipelineCache &&other)
+    : m_Device(other.m_Device), m_PipelineCache(std::exchange(other.m_PipelineCache, VK_NULL_HANDLE)),
+      m_Path(std::move(other.m_Path)), m_Statistics(other.m_Statistics)
+{
+}
+
+PipelineCache::~PipelineCache()
+{
+    if (m_PipelineCache != VK_NULL_HANDLE)
+    {
+        vkDestroyPipelineCache(m_Device, m_PipelineCache, nullptr);
+    }
+}
+
+VkPipelineCache PipelineCache::Get() const
+{
+    return m_PipelineCache;
+}
+
+void PipelineCache::Save() const
+{
+    size_t size = 0;
+    if (vkGetPipelineCacheData(m_Device, m_PipelineCache, &size, nullptr) != VkResult::VK_SUCCESS)
+    {
+        throw std::runtime_error("Could not query pipeline cache size");
+    }
+    std::vector<char> data(size);
+    if (vkGetPipelineCacheData(m_Device, m_PipelineCache, &size, data.data()) != VkResult::VK_SUCCESS)
+    {
+        throw std::runtime_error("Could not read pipeline cache data");
+    }
+
+    auto temporaryPath = m_Path;
+    temporaryPath += ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            throw std::runtime_error(std::string("Couldn't open file at ") + temporaryPath.string());
+        }
+        file.write(data.data(), static_cast<std::streamsize>(size));
+        if (!file.good())
+        {
+            throw std::runtime_error(std::string("Couldn't write pipeline cache to ") + temporaryPath.string());
+        }
+    }
+    // Replaces the existing file in a single step
+    std::filesystem::rename(temporaryPath, m_Path);
+}
+
+void PipelineCache::RecordCreation(std::chrono::duration<double, std::milli> creationTime)
+{
+    std::unique_lock lock(m_StatisticsMutex);
+    m_Statistics.PipelineCount++;
+    m_Statistics.CreationTime += creationTime;
+}
+
+PipelineCacheStatistics PipelineCache::GetStatistics() const
+{
+    std::unique_lock lock(m_StatisticsMutex);
+    return m_Statistics;
+}
+
+void PipelineCache::Report(std::ostream &stream) const
+{
+    auto statistics = GetStatistics();
+    stream << "Pipeline creation (" << (statistics.LoadedFromDisk ? "warm" : "cold") << " cache): "
+           << statistics.PipelineCount << " pipelines in " << statistics.CreationTime.count() << " ms\n";
+}
+
+std::vector<char> PipelineCache::LoadValidatedData(const PhysicalDevice &physicalDevice) const
+{
+    std::ifstream file(m_Path, std::ios::ate | std::ios::binary);
+    if (!file.is_open())
+    {
+        // No cache yet, e.g. on the first launch
+        return {};
+    }
+    size_t fileSize = static_cast<size_t>(file.tellg());
+    if (fileSize < sizeof(VkPipelineCacheHeaderVersionOne))
+    {
+        std::cout << "Ignoring truncated pipeline cache at " << m_Path << "\n";
+        return {};
+    }
+    std::vector<char> data(fileSize);
+    file.seekg(0);
+    file.read(data.data(), fileSize);
+
+    // Drivers should reject incompatible data themselves, but not all of them do so reliably
+    VkPipelineCacheHeaderVersionOne header;
+    std::memcpy(&header, data.data(), sizeof(header));
+    const auto &properties = physicalDevice.GetProperties();
+    if (header.headerSize < sizeof(header) || header.headerSize > fileSize ||
+        header.headerVersion != VkPipelineCacheHeaderVersion::VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+        header.vendorID != properties.vendorID || header.deviceID != properties.deviceID ||
+        std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+    {
+        std::cout << "Ignoring pipeline cache at " << m_Path << " created for a different device or driver\n";
+        return {};
+    }
+    return data;
+}
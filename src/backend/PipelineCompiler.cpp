@@ -0,0 +1,60 @@
+#include <backend/PipelineCompiler.h>
+
+#include <algorithm>
+
+PipelineCompiler::PipelineCompiler(uint32_t workerCount)
+{
+    if (workerCount == 0)
+    {
+        // Leave a core for the thread recording frames. hardware_concurrency may report 0 if unknown
+        workerCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+    }
+    m_Workers.reserve(workerCount);
+    for (uint32_t i = 0; i < workerCount; i++)
+    {
+        m_Workers.emplace_back([this] { RunWorker(); });
+    }
+}
+
+PipelineCompiler::~PipelineCompiler()
+{
+    {
+        std::unique_lock lock(m_Mutex);
+        m_Stopping = true;
+        // Destroying the tasks breaks their promises, so that nobody waits on them forever
+        m_Tasks.clear();
+    }
+    m_TaskAvailable.notify_all();
+    for (auto &worker : m_Workers)
+    {
+        worker.join();
+    }
+}
+
+void PipelineCompiler::Enqueue(std::function<void()> task)
+{
+    {
+        std::unique_lock lock(m_Mutex);
+        m_Tasks.emplace_back(std::move(task));
+    }
+    m_TaskAvailable.notify_one();
+}
+
+void PipelineCompiler::RunWorker()
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock lock(m_Mutex);
+            m_TaskAvailable.wait(lock, [this] { return m_Stopping || !m_Tasks.empty(); });
+            if (m_Stopping)
+            {
+                return;
+            }
+            task = std::move(m_Tasks.front());
+            m_Tasks.pop_front();
+        }
+        task();
+    }
+}
@@ -0,0 +1,45 @@
+#include <backend/PipelineLayout.h>
+
+#include <stdexcept>
+#include <utility>
+
+PipelineLayout::PipelineLayout(VkDevice device, std::span<const VkDescriptorSetLayout> descriptorSetLayouts,
+                               std::span<const VkPushConstantRange> pushConstantRanges)
+    : m_Device(device), m_PushConstantRanges(pushConstantRanges.begin(), pushConstantRanges.end())
+{
+    VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo{};
+    pipelineLayoutCreateInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutCreateInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
+    pipelineLayoutCreateInfo.pSetLayouts = descriptorSetLayouts.empty() ? nullptr : descriptorSetLayouts.data();
+    pipelineLayoutCreateInfo.pushConstantRangeCount = static_cast<uint32_t>(m_PushConstantRanges.size());
+    pipelineLayoutCreateInfo.pPushConstantRanges = m_PushConstantRanges.empty() ? nullptr : m_PushConstantRanges.data();
+
+    if (vkCreatePipelineLayout(device, &pipelineLayoutCreateInfo, nullptr, &m_PipelineLayout) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Could not create pipeline layout");
+    }
+}
+
+PipelineLayout::PipelineLayout(PipelineLayout &&other)
+    : m_Device(other.m_Device), m_PipelineLayout(std::exchange(other.m_PipelineLayout, VK_NULL_HANDLE)),
+      m_PushConstantRanges(std::move(other.m_PushConstantRanges))
+{
+}
+
+PipelineLayout::~PipelineLayout()
+{
+    if (m_PipelineLayout != VK_NULL_HANDLE)
+    {
+        vkDestroyPipelineLayout(m_Device, m_PipelineLayout, nullptr);
+    }
+}
+
+VkPipelineLayout PipelineLayout::Get() const
+{
+    return m_PipelineLayout;
+}
+
+const std::vector<VkPushConstantRange> &PipelineLayout::GetPushConstantRanges() const
+{
+    return m_PushConstantRanges;
+}
@@ -0,0 +1,20 @@
+#include <backend/PushConstants.h>
+
+bool IsValidPushConstantUpdate(std::span<const VkPushConstantRange> ranges, VkShaderStageFlags stages,
+                               uint32_t offset, uint32_t size)
+{
+    VkShaderStageFlags coveredStages = 0;
+    for (const auto &range : ranges)
+    {
+        bool overlaps = offset < range.offset + range.size && range.offset < offset + size;
+        if (overlaps && (range.stageFlags & stages) != range.stageFlags)
+        {
+            return false;
+        }
+        if (range.offset <= offset && offset + size <= range.offset + range.size)
+        {
+            coveredStages |= range.stageFlags & stages;
+        }
+    }
+    return coveredStages == stages;
+}
@@ -0,0 +1,758 @@
+#include <backend/RenderGraph.h>
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+#include <utility>
+
+#include <backend/CommandBufferPool.h>
+#include <backend/PhysicalDevice.h>
+#include <backend/RenderPassScope.h>
+
+namespace
+{
+VkImageUsageFlags GetImageUsage(EResourceAccess access)
+{
+    switch (access)
+    {
+    case EResourceAccess::TransferRead:
+        return VkImageUsageFlagBits::VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    case EResourceAccess::TransferWrite:
+        return VkImageUsageFlagBits::VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    case EResourceAccess::GraphicsShaderRead:
+    case EResourceAccess::ComputeShaderRead:
+        return VkImageUsageFlagBits::VK_IMAGE_USAGE_SAMPLED_BIT;
+    case EResourceAccess::GraphicsStorageImageRead:
+    case EResourceAccess::ComputeShaderReadWrite:
+        return VkImageUsageFlagBits::VK_IMAGE_USAGE_STORAGE_BIT;
+    case EResourceAccess::ColorAttachmentWrite:
+        return VkImageUsageFlagBits::VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    case EResourceAccess::DepthStencilAttachment:
+        return VkImageUsageFlagBits::VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+    default:
+        assert(false && "Access is not valid for textures");
+        return 0;
+    }
+}
+
+VkAttachmentLoadOp GetLoadOp(EAttachmentLoad load)
+{
+    switch (load)
+    {
+    case EAttachmentLoad::Clear:
+        return VkAttachmentLoadOp::VK_ATTACHMENT_LOAD_OP_CLEAR;
+    case EAttachmentLoad::Load:
+        return VkAttachmentLoadOp::VK_ATTACHMENT_LOAD_OP_LOAD;
+    default:
+        return VkAttachmentLoadOp::VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    }
+}
+
+VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+}
+
+RenderGraphPass::RenderGraphPass(std::string name, std::function<void(CommandBuffer &)> execute)
+    : m_Name(std::move(name)), m_Execute(std::move(execute))
+{
+}
+
+RenderGraphPass::RenderGraphPass(std::string name, std::function<void(RenderPassScope &)> execute)
+    : m_Name(std::move(name)), m_ExecuteRaster(std::move(execute))
+{
+}
+
+RenderGraphPass &RenderGraphPass::Read(RenderGraphTexture texture, EResourceAccess access)
+{
+    assert(!GetAccessInfo(access).Write && "Declare writing accesses with `Write`");
+    m_Accesses.emplace_back(ResourceAccess{texture.Index, true, access, false});
+    return *this;
+}
+
+RenderGraphPass &RenderGraphPass::Read(RenderGraphBuffer buffer, EResourceAccess access)
+{
+    assert(!GetAccessInfo(access).Write && "Declare writing accesses with `Write`");
+    m_Accesses.emplace_back(ResourceAccess{buffer.Index, false, access, false});
+    return *this;
+}
+
+RenderGraphPass &RenderGraphPass::Write(RenderGraphTexture texture, EResourceAccess access)
+{
+    assert(GetAccessInfo(access).Write && "Declare reading accesses with `Read`");
+    m_Accesses.emplace_back(ResourceAccess{texture.Index, true, access, true});
+    return *this;
+}
+
+RenderGraphPass &RenderGraphPass::Write(RenderGraphBuffer buffer, EResourceAccess access)
+{
+    assert(GetAccessInfo(access).Write && "Declare reading accesses with `Read`");
+    m_Accesses.emplace_back(ResourceAccess{buffer.Index, false, access, true});
+    return *this;
+}
+
+RenderGraphPass &RenderGraphPass::WriteColor(RenderGraphTexture texture, EAttachmentLoad load)
+{
+    assert(IsRaster() && "Only raster passes have attachments");
+    m_ColorAttachments.emplace_back(Attachment{texture, load});
+    return *this;
+}
+
+RenderGraphPass &RenderGraphPass::WriteDepth(RenderGraphTexture texture, EAttachmentLoad load)
+{
+    assert(IsRaster() && "Only raster passes have attachments");
+    assert(!m_DepthAttachment.has_value() && "A pass can only have one depth attachment");
+    m_DepthAttachment = Attachment{texture, load};
+    return *this;
+}
+
+RenderGraphPass &RenderGraphPass::SetSideEffects()
+{
+    m_SideEffects = true;
+    return *this;
+}
+
+const std::string &RenderGraphPass::GetName() const
+{
+    return m_Name;
+}
+
+bool RenderGraphPass::IsRaster() const
+{
+    return static_cast<bool>(m_ExecuteRaster);
+}
+
+const RenderPass &RenderGraphPass::GetRenderPass() const
+{
+    assert(m_RenderPass != nullptr && "Render pass only exists for raster passes once the graph is compiled");
+    return *m_RenderPass;
+}
+
+const RenderingLayout &RenderGraphPass::GetRenderingLayout() const
+{
+    assert(IsRaster() && (!m_RenderingLayout.ColorFormats.empty() ||
+                          m_RenderingLayout.DepthFormat != VK_FORMAT_UNDEFINED) &&
+           "Rendering layout only exists for raster passes once the graph is compiled");
+    return m_RenderingLayout;
+}
+
+RenderGraph::RenderGraph(VkDevice device, const PhysicalDevice &physicalDevice, CommandBufferPool &commandBufferPool,
+                         bool dynamicRendering)
+    : m_Device(device), m_PhysicalDevice(physicalDevice), m_CommandBufferPool(commandBufferPool),
+      m_DynamicRendering(dynamicRendering)
+{
+}
+
+RenderGraph::RenderGraph(RenderGraph &&other)
+    : m_Device(other.m_Device), m_PhysicalDevice(other.m_PhysicalDevice),
+      m_CommandBufferPool(other.m_CommandBufferPool), m_DynamicRendering(other.m_DynamicRendering),
+      m_Passes(std::move(other.m_Passes)), m_Textures(std::move(other.m_Textures)),
+      m_Buffers(std::move(other.m_Buffers)), m_ExecutionOrder(std::move(other.m_ExecutionOrder)),
+      m_TransientMemory(std::exchange(other.m_TransientMemory, VK_NULL_HANDLE)), m_Statistics(other.m_Statistics),
+      m_RetiredFramebuffers(std::move(other.m_RetiredFramebuffers))
+{
+}
+
+RenderGraph::~RenderGraph()
+{
+    Reset();
+}
+
+RenderGraphTexture RenderGraph::CreateTexture(const std::string &name, const RenderGraphTextureCreateInfo &createInfo)
+{
+    m_Textures.emplace_back(TextureResource{name, nullptr, createInfo});
+    return RenderGraphTexture{static_cast<uint32_t>(m_Textures.size() - 1)};
+}
+
+RenderGraphTexture RenderGraph::ImportTexture(const Texture &texture)
+{
+    m_Textures.emplace_back(TextureResource{"Imported", &texture});
+    return RenderGraphTexture{static_cast<uint32_t>(m_Textures.size() - 1)};
+}
+
+RenderGraphTexture RenderGraph::ImportFrameTexture(RenderGraphFrameTexture texture)
+{
+    TextureResource resource{"Imported frame texture"};
+    resource.CreateInfo.Format = texture.Format;
+    resource.GetCurrent = std::move(texture.GetCurrent);
+    resource.GetGeneration = std::move(texture.GetGeneration);
+    resource.PreviousAccess = texture.PreviousAccess;
+    m_Textures.emplace_back(std::move(resource));
+    return RenderGraphTexture{static_cast<uint32_t>(m_Textures.size() - 1)};
+}
+
+RenderGraphBuffer RenderGraph::ImportBuffer(const DeviceBuffer &buffer)
+{
+    m_Buffers.emplace_back(&buffer);
+    return RenderGraphBuffer{static_cast<uint32_t>(m_Buffers.size() - 1)};
+}
+
+RenderGraphPass &RenderGraph::AddPass(std::string name, std::function<void(CommandBuffer &)> execute)
+{
+    return *m_Passes.emplace_back(std::make_unique<RenderGraphPass>(std::move(name), std::move(execute)));
+}
+
+RenderGraphPass &RenderGraph::AddRasterPass(std::string name, std::function<void(RenderPassScope &)> execute)
+{
+    return *m_Passes.emplace_back(std::make_unique<RenderGraphPass>(std::move(name), std::move(execute)));
+}
+
+void RenderGraph::Compile()
+{
+    Reset();
+
+    auto needed = CullPasses();
+    for (uint32_t i = 0; i < m_Passes.size(); i++)
+    {
+        if (needed[i])
+        {
+            m_ExecutionOrder.emplace_back(i);
+        }
+    }
+    m_Statistics.PassCount = static_cast<uint32_t>(m_Passes.size());
+    m_Statistics.CulledPassCount = static_cast<uint32_t>(m_Passes.size() - m_ExecutionOrder.size());
+
+    for (uint32_t executionIndex = 0; executionIndex < m_ExecutionOrder.size(); executionIndex++)
+    {
+        const auto &pass = *m_Passes[m_ExecutionOrder[executionIndex]];
+        for (const auto &access : pass.m_Accesses)
+        {
+            if (access.IsTexture)
+            {
+                m_Textures[access.Resource].Usage |= GetImageUsage(access.Access);
+            }
+        }
+        for (const auto &attachment : pass.m_ColorAttachments)
+        {
+            m_Textures[attachment.Texture.Index].Usage |= VkImageUsageFlagBits::VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+        }
+        if (pass.m_DepthAttachment.has_value())
+        {
+            m_Textures[pass.m_DepthAttachment->Texture.Index].Usage |=
+                VkImageUsageFlagBits::VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+        }
+        for (const auto &use : GetUses(pass))
+        {
+            if (use.IsTexture)
+            {
+                auto &texture = m_Textures[use.Resource];
+                texture.FirstUse = texture.FirstUse.value_or(executionIndex);
+                texture.LastUse = executionIndex;
+            }
+        }
+    }
+
+    CreateTransientTextures();
+    for (uint32_t executionIndex = 0; executionIndex < m_ExecutionOrder.size(); executionIndex++)
+    {
+        auto &pass = *m_Passes[m_ExecutionOrder[executionIndex]];
+        if (pass.IsRaster())
+        {
+            CreateRenderPass(pass, executionIndex);
+        }
+    }
+}
+
+void RenderGraph::Execute(CommandBuffer &commandBuffer)
+{
+    m_RetiredFramebuffers.Collect();
+
+    std::vector<const ResourceState *> previousOccupants;
+    for (uint32_t executionIndex = 0; executionIndex < m_ExecutionOrder.size(); executionIndex++)
+    {
+        auto &pass = *m_Passes[m_ExecutionOrder[executionIndex]];
+        for (auto &texture : m_Textures)
+        {
+            if (texture.Transient != nullptr && texture.FirstUse == executionIndex)
+            {
+                // The contents of transient textures don't survive between frames, nor do those of the
+                // textures that used the memory before, in this frame or in the frames still in flight
+                previousOccupants.clear();
+                for (auto occupant : texture.PreviousOccupants)
+                {
+                    previousOccupants.emplace_back(&m_Textures[occupant].Transient->GetState(0, 0));
+                }
+                commandBuffer.DiscardContents(*texture.Transient, previousOccupants);
+            }
+            else if (texture.PreviousAccess.has_value() && texture.FirstUse == executionIndex)
+            {
+                // Nothing the graph recorded wrote the current image yet, so its first access only has to wait
+                // for the access before the graph
+                commandBuffer.DiscardContents(texture.GetCurrent(), *texture.PreviousAccess);
+            }
+        }
+
+        for (const auto &access : pass.m_Accesses)
+        {
+            if (access.IsTexture)
+            {
+                commandBuffer.RequireAccess(GetTexture(RenderGraphTexture{access.Resource}), access.Access);
+            }
+            else
+            {
+                commandBuffer.RequireAccess(*m_Buffers[access.Resource], access.Access);
+            }
+        }
+        for (const auto &attachment : pass.m_ColorAttachments)
+        {
+            commandBuffer.RequireAccess(GetTexture(attachment.Texture), EResourceAccess::ColorAttachmentWrite);
+        }
+        if (pass.m_DepthAttachment.has_value())
+        {
+            commandBuffer.RequireAccess(GetTexture(pass.m_DepthAttachment->Texture),
+                                        EResourceAccess::DepthStencilAttachment);
+        }
+
+        if (pass.IsRaster() && m_DynamicRendering)
+        {
+            auto renderPassScope = commandBuffer.BeginRendering(GetRenderingInfo(pass, executionIndex));
+            pass.m_ExecuteRaster(renderPassScope);
+        }
+        else if (pass.IsRaster())
+        {
+            auto renderPassScope = commandBuffer.BeginRenderPass(GetFramebuffer(pass), *pass.m_RenderPass);
+            pass.m_ExecuteRaster(renderPassScope);
+        }
+        else
+        {
+            pass.m_Execute(commandBuffer);
+        }
+    }
+}
+
+const Texture &RenderGraph::GetTexture(RenderGraphTexture texture) const
+{
+    const auto &resource = m_Textures[texture.Index];
+    if (resource.Imported != nullptr)
+    {
+        return *resource.Imported;
+    }
+    if (resource.GetCurrent)
+    {
+        return resource.GetCurrent();
+    }
+    assert(resource.Transient != nullptr && "Transient texture is culled or the graph isn't compiled");
+    return *resource.Transient;
+}
+
+const RenderGraphStatistics &RenderGraph::GetStatistics() const
+{
+    return m_Statistics;
+}
+
+std::vector<RenderGraph::ResourceUse> RenderGraph::GetUses(const RenderGraphPass &pass)
+{
+    std::vector<ResourceUse> uses;
+    auto addUse = [&uses](uint32_t resource, bool isTexture, bool reads, bool writes) {
+        auto existing = std::find_if(uses.begin(), uses.end(), [&](const ResourceUse &use) {
+            return use.Resource == resource && use.IsTexture == isTexture;
+        });
+        if (existing == uses.end())
+        {
+            uses.emplace_back(ResourceUse{resource, isTexture, reads, writes});
+            return;
+        }
+        existing->Reads |= reads;
+        existing->Writes |= writes;
+    };
+
+    for (const auto &access : pass.m_Accesses)
+    {
+        // Read-write accesses such as storage images keep the contents
+        bool reads = !access.Write || access.Access == EResourceAccess::ComputeShaderReadWrite;
+        addUse(access.Resource, access.IsTexture, reads, access.Write);
+    }
+    for (const auto &attachment : pass.m_ColorAttachments)
+    {
+        addUse(attachment.Texture.Index, true, attachment.Load == EAttachmentLoad::Load, true);
+    }
+    if (pass.m_DepthAttachment.has_value())
+    {
+        addUse(pass.m_DepthAttachment->Texture.Index, true, pass.m_DepthAttachment->Load == EAttachmentLoad::Load,
+               true);
+    }
+    return uses;
+}
+
+std::vector<bool> RenderGraph::CullPasses() const
+{
+    // Walks backwards, so that all consumers of a resource are known before its producers. A pass is needed
+    // if it has side effects, or writes a resource that outlives the graph or that a needed pass reads later
+    std::vector<bool> needed(m_Passes.size(), false);
+    std::vector<bool> textureContentsUsed(m_Textures.size(), false);
+    for (size_t i = m_Passes.size(); i-- > 0;)
+    {
+        const auto &pass = *m_Passes[i];
+        auto uses = GetUses(pass);
+        needed[i] = pass.m_SideEffects || std::any_of(uses.begin(), uses.end(), [this, &textureContentsUsed](const auto &use) {
+                        // Buffers can only be imported
+                        return use.Writes && (!use.IsTexture || m_Textures[use.Resource].IsImported() ||
+                                              textureContentsUsed[use.Resource]);
+                    });
+        if (!needed[i])
+        {
+            continue;
+        }
+
+        for (const auto &use : uses)
+        {
+            if (use.IsTexture && use.Writes && !use.Reads)
+            {
+                // Overwritten, so earlier writes only matter if something before this pass reads them
+                textureContentsUsed[use.Resource] = false;
+            }
+        }
+        for (const auto &use : uses)
+        {
+            if (use.IsTexture && use.Reads)
+            {
+                textureContentsUsed[use.Resource] = true;
+            }
+        }
+    }
+    return needed;
+}
+
+void RenderGraph::CreateTransientTextures()
+{
+    struct Placement
+    {
+        uint32_t Texture;
+        VkDeviceSize Offset;
+        VkDeviceSize Size;
+    };
+
+    std::vector<uint32_t> transients;
+    std::vector<VkMemoryRequirements> requirements(m_Textures.size());
+    for (uint32_t i = 0; i < m_Textures.size(); i++)
+    {
+        auto &texture = m_Textures[i];
+        if (!texture.IsImported() && texture.FirstUse.has_value())
+        {
+            texture.Transient = std::make_unique<Texture>(
+                m_Device, TextureCreateInfo{texture.CreateInfo.Width, texture.CreateInfo.Height,
+                                            texture.CreateInfo.Format, texture.Usage});
+            requirements[i] = texture.Transient->GetMemoryRequirements();
+            transients.emplace_back(i);
+        }
+    }
+    if (transients.empty())
+    {
+        return;
+    }
+
+    // Largest first, each at the lowest offset that doesn't overlap with any texture that is alive at the same time
+    std::sort(transients.begin(), transients.end(),
+              [&requirements](uint32_t lhs, uint32_t rhs) { return requirements[lhs].size > requirements[rhs].size; });
+    auto lifetimesOverlap = [this](uint32_t lhs, uint32_t rhs) {
+        return m_Textures[lhs].FirstUse <= m_Textures[rhs].LastUse && m_Textures[rhs].FirstUse <= m_Textures[lhs].LastUse;
+    };
+
+    std::vector<Placement> placements;
+    uint32_t memoryTypeBits = ~0u;
+    for (auto texture : transients)
+    {
+        const auto &textureRequirements = requirements[texture];
+        memoryTypeBits &= textureRequirements.memoryTypeBits;
+        m_Statistics.UnaliasedMemorySize += textureRequirements.size;
+
+        std::vector<VkDeviceSize> candidates = {0};
+        for (const auto &placement : placements)
+        {
+            if (lifetimesOverlap(texture, placement.Texture))
+            {
+                candidates.emplace_back(placement.Offset + placement.Size);
+            }
+        }
+        std::sort(candidates.begin(), candidates.end());
+        for (auto candidate : candidates)
+        {
+            auto offset = AlignUp(candidate, textureRequirements.alignment);
+            bool fits = std::none_of(placements.begin(), placements.end(), [&](const Placement &placement) {
+                return lifetimesOverlap(texture, placement.Texture) && offset < placement.Offset + placement.Size &&
+                       placement.Offset < offset + textureRequirements.size;
+            });
+            if (fits)
+            {
+                placements.emplace_back(Placement{texture, offset, textureRequirements.size});
+                m_Statistics.TransientMemorySize = std::max(m_Statistics.TransientMemorySize, offset + textureRequirements.size);
+                break;
+            }
+        }
+    }
+    if (memoryTypeBits == 0)
+    {
+        throw std::runtime_error("Transient textures have no memory type in common");
+    }
+
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = m_Statistics.TransientMemorySize;
+    allocInfo.memoryTypeIndex =
+        m_PhysicalDevice.FindMemoryType(memoryTypeBits, VkMemoryPropertyFlagBits::VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    if (vkAllocateMemory(m_Device, &allocInfo, nullptr, &m_TransientMemory) != VkResult::VK_SUCCESS)
+    {
+        throw std::runtime_error("Could not allocate render graph memory");
+    }
+
+    for (const auto &placement : placements)
+    {
+        m_Textures[placement.Texture].Transient->BindMemory(m_TransientMemory, placement.Offset);
+        for (const auto &other : placements)
+        {
+            bool memoryOverlaps = placement.Offset < other.Offset + other.Size && other.Offset < placement.Offset + placement.Size;
+            // Memory is shared by all frames in flight, so this includes the texture itself and those that use
+            // the memory later in the frame, as their last use may be in a frame that is still in flight
+            if (memoryOverlaps)
+            {
+                m_Textures[placement.Texture].PreviousOccupants.emplace_back(other.Texture);
+            }
+        }
+    }
+}
+
+void RenderGraph::CreateRenderPass(RenderGraphPass &pass, uint32_t executionIndex)
+{
+    if (m_DynamicRendering)
+    {
+        // Pipelines only need the formats, the attachments are given when the pass begins
+        for (const auto &attachment : pass.m_ColorAttachments)
+        {
+            pass.m_RenderingLayout.ColorFormats.emplace_back(GetFormat(attachment.Texture));
+        }
+        if (pass.m_DepthAttachment.has_value())
+        {
+            pass.m_RenderingLayout.DepthFormat = GetFormat(pass.m_DepthAttachment->Texture);
+        }
+        return;
+    }
+
+    auto describe = [this, executionIndex](const RenderGraphPass::Attachment &attachment, VkImageLayout layout) {
+        VkAttachmentDescription description{};
+        description.format = GetFormat(attachment.Texture);
+        description.samples = VkSampleCountFlagBits::VK_SAMPLE_COUNT_1_BIT;
+        description.loadOp = GetLoadOp(attachment.Load);
+        description.storeOp = KeepsContents(attachment.Texture, executionIndex)
+                                  ? VkAttachmentStoreOp::VK_ATTACHMENT_STORE_OP_STORE
+                                  : VkAttachmentStoreOp::VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        description.stencilLoadOp = VkAttachmentLoadOp::VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        description.stencilStoreOp = VkAttachmentStoreOp::VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        // The graph transitions the layouts prior to beginning the pass
+        description.initialLayout = layout;
+        description.finalLayout = layout;
+        return description;
+    };
+
+    RenderPassCreateInfo createInfo;
+    bool hasFrameTextures = false;
+    for (const auto &attachment : pass.m_ColorAttachments)
+    {
+        createInfo.ColorAttachments.emplace_back(
+            describe(attachment, VkImageLayout::VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL));
+        hasFrameTextures |= m_Textures[attachment.Texture.Index].GetCurrent != nullptr;
+    }
+    if (pass.m_DepthAttachment.has_value())
+    {
+        createInfo.DepthAttachment =
+            describe(*pass.m_DepthAttachment, VkImageLayout::VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+        hasFrameTextures |= m_Textures[pass.m_DepthAttachment->Texture.Index].GetCurrent != nullptr;
+    }
+    assert((!pass.m_ColorAttachments.empty() || pass.m_DepthAttachment.has_value()) &&
+           "Raster passes need at least one attachment");
+
+    pass.m_RenderPass = std::make_unique<RenderPass>(m_Device, std::move(createInfo));
+    pass.m_RenderingLayout = pass.m_RenderPass->GetRenderingLayout();
+    if (!hasFrameTextures)
+    {
+        // Frame textures may be different images every execution, so their framebuffers are created when executing
+        pass.m_Framebuffer = std::make_unique<Framebuffer>(m_Device, FramebufferCreateInfo{*pass.m_RenderPass,
+                                                                                           GetViews(pass),
+                                                                                           GetViewport(pass)});
+    }
+}
+
+const Framebuffer &RenderGraph::GetFramebuffer(RenderGraphPass &pass)
+{
+    if (pass.m_Framebuffer != nullptr)
+    {
+        return *pass.m_Framebuffer;
+    }
+
+    std::vector<uint64_t> generations;
+    auto addGeneration = [this, &generations](RenderGraphTexture texture) {
+        if (const auto &resource = m_Textures[texture.Index]; resource.GetCurrent)
+        {
+            generations.emplace_back(resource.GetGeneration());
+        }
+    };
+    for (const auto &attachment : pass.m_ColorAttachments)
+    {
+        addGeneration(attachment.Texture);
+    }
+    if (pass.m_DepthAttachment.has_value())
+    {
+        addGeneration(pass.m_DepthAttachment->Texture);
+    }
+
+    // The old images of recreated frame textures are never rendered to again, but may still be in use by
+    // submitted work. Released before looking up the views, as those of destroyed images may be reused
+    std::vector<std::unique_ptr<Framebuffer>> retired;
+    std::erase_if(pass.m_FrameFramebuffers, [&](auto &framebuffer) {
+        if (framebuffer.Generations == generations)
+        {
+            return false;
+        }
+        retired.emplace_back(std::move(framebuffer.Framebuffer));
+        return true;
+    });
+    if (!retired.empty())
+    {
+        m_RetiredFramebuffers.Push(m_CommandBufferPool.GetPendingFences(), std::move(retired));
+    }
+
+    auto views = GetViews(pass);
+    auto cached = std::find_if(pass.m_FrameFramebuffers.begin(), pass.m_FrameFramebuffers.end(),
+                               [&views](const auto &framebuffer) { return framebuffer.Views == views; });
+    if (cached != pass.m_FrameFramebuffers.end())
+    {
+        return *cached->Framebuffer;
+    }
+    auto framebuffer = std::make_unique<Framebuffer>(
+        m_Device, FramebufferCreateInfo{*pass.m_RenderPass, views, GetViewport(pass)});
+    return *pass.m_FrameFramebuffers
+                .emplace_back(RenderGraphPass::FrameFramebuffer{std::move(generations), views, std::move(framebuffer)})
+                .Framebuffer;
+}
+
+RenderingInfo RenderGraph::GetRenderingInfo(const RenderGraphPass &pass, uint32_t executionIndex) const
+{
+    // The attachments were transitioned through `RequireAccess` and stay in their attachment layout, so that
+    // the graph keeps tracking them
+    auto toAttachment = [this, executionIndex](const RenderGraphPass::Attachment &attachment,
+                                               VkImageAspectFlags aspectMask, VkImageLayout layout,
+                                               VkClearValue clearValue) {
+        const auto &texture = GetTexture(attachment.Texture);
+        RenderingAttachment renderingAttachment{texture.Get(), texture.GetView(), aspectMask, clearValue};
+        renderingAttachment.StoreOp = KeepsContents(attachment.Texture, executionIndex)
+                                          ? VkAttachmentStoreOp::VK_ATTACHMENT_STORE_OP_STORE
+                                          : VkAttachmentStoreOp::VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        renderingAttachment.FinalLayout = layout;
+        renderingAttachment.Tracked = true;
+        renderingAttachment.LoadOp = GetLoadOp(attachment.Load);
+        return renderingAttachment;
+    };
+
+    RenderingInfo renderingInfo{};
+    // Same clear values as `RenderPass`
+    VkClearValue colorClear{};
+    colorClear.color = {0.0f, 0.0f, 0.0f, 1.0f};
+    for (const auto &attachment : pass.m_ColorAttachments)
+    {
+        renderingInfo.ColorAttachments.emplace_back(
+            toAttachment(attachment, VkImageAspectFlagBits::VK_IMAGE_ASPECT_COLOR_BIT,
+                         VkImageLayout::VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, colorClear));
+    }
+    if (pass.m_DepthAttachment.has_value())
+    {
+        VkClearValue depthClear{};
+        depthClear.depthStencil = {1.0f, 0};
+        renderingInfo.DepthAttachment =
+            toAttachment(*pass.m_DepthAttachment, VkImageAspectFlagBits::VK_IMAGE_ASPECT_DEPTH_BIT,
+                         VkImageLayout::VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, depthClear);
+    }
+    renderingInfo.Viewport = GetViewport(pass);
+    return renderingInfo;
+}
+
+std::vector<VkImageView> RenderGraph::GetViews(const RenderGraphPass &pass) const
+{
+    std::vector<VkImageView> views;
+    for (const auto &attachment : pass.m_ColorAttachments)
+    {
+        views.emplace_back(GetTexture(attachment.Texture).GetView());
+    }
+    if (pass.m_DepthAttachment.has_value())
+    {
+        views.emplace_back(GetTexture(pass.m_DepthAttachment->Texture).GetView());
+    }
+    return views;
+}
+
+Viewport RenderGraph::GetViewport(const RenderGraphPass &pass) const
+{
+    const auto &firstAttachment = pass.m_ColorAttachments.empty() ? pass.m_DepthAttachment->Texture
+                                                                  : pass.m_ColorAttachments.front().Texture;
+    const auto &extentSource = GetTexture(firstAttachment);
+    VkExtent2D extent{extentSource.GetWidth(), extentSource.GetHeight()};
+    return Viewport{
+        VkViewport{0.0f, 0.0f, static_cast<float>(extent.width), static_cast<float>(extent.height), 0.0f, 1.0f},
+        VkRect2D{VkOffset2D{0, 0}, extent}};
+}
+
+VkFormat RenderGraph::GetFormat(RenderGraphTexture texture) const
+{
+    const auto &resource = m_Textures[texture.Index];
+    // Frame textures may not be available before executing, e.g. no swapchain image is acquired yet
+    if (resource.Imported != nullptr)
+    {
+        return resource.Imported->GetFormat();
+    }
+    return resource.CreateInfo.Format;
+}
+
+bool RenderGraph::IsReadAfter(RenderGraphTexture texture, uint32_t executionIndex) const
+{
+    for (auto i = executionIndex + 1; i < m_ExecutionOrder.size(); i++)
+    {
+        const auto &pass = *m_Passes[m_ExecutionOrder[i]];
+        for (const auto &use : GetUses(pass))
+        {
+            if (use.IsTexture && use.Resource == texture.Index)
+            {
+                if (use.Reads)
+                {
+                    return true;
+                }
+                if (use.Writes)
+                {
+                    return false;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+bool RenderGraph::KeepsContents(RenderGraphTexture texture, uint32_t executionIndex) const
+{
+    return m_Textures[texture.Index].IsImported() || IsReadAfter(texture, executionIndex);
+}
+
+void RenderGraph::Reset()
+{
+    m_RetiredFramebuffers.Flush();
+    for (auto &pass : m_Passes)
+    {
+        // The framebuffers refer to the render pass
+        pass->m_Framebuffer.reset();
+        pass->m_FrameFramebuffers.clear();
+        pass->m_RenderPass.reset();
+        pass->m_RenderingLayout = RenderingLayout{};
+    }
+    for (auto &texture : m_Textures)
+    {
+        texture.Transient.reset();
+        texture.FirstUse.reset();
+        texture.LastUse = 0;
+        texture.Usage = 0;
+        texture.PreviousOccupants.clear();
+    }
+    if (m_TransientMemory != VK_NULL_HANDLE)
+    {
+        vkFreeMemory(m_Device, m_TransientMemory, nullptr);
+        m_TransientMemory = VK_NULL_HANDLE;
+    }
+    m_ExecutionOrder.clear();
+    m_Statistics = RenderGraphStatistics{};
+}
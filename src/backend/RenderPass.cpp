@@ -1,29 +1,43 @@
 #include <backend/RenderPass.h>
 
 #include <stdexcept>
-#include <array>
+#include <vector>
 
 #include <backend/Texture.h>
 
-RenderPass::RenderPass(VkDevice device, RenderPassCreateInfo &&createInfo) : m_Device(device)
+RenderPass::RenderPass(VkDevice device, RenderPassCreateInfo &&createInfo)
+    : m_Device(device), m_ColorAttachmentCount(static_cast<uint32_t>(createInfo.ColorAttachments.size()))
 {
-    VkAttachmentReference swapchainAttachmentRef{};
-    swapchainAttachmentRef.attachment = 0;
-    swapchainAttachmentRef.layout = VkImageLayout::VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    std::vector<VkAttachmentDescription> attachments = createInfo.ColorAttachments;
+    std::vector<VkAttachmentReference> colorAttachmentRefs;
+    colorAttachmentRefs.reserve(createInfo.ColorAttachments.size());
+    for (uint32_t i = 0; i < createInfo.ColorAttachments.size(); i++)
+    {
+        colorAttachmentRefs.emplace_back(
+            VkAttachmentReference{i, VkImageLayout::VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL});
+        VkClearValue clearValue{};
+        clearValue.color = {0.0f, 0.0f, 0.0f, 1.0f};
+        m_ClearValues.emplace_back(clearValue);
+    }
 
     VkAttachmentReference depthAttachmentRef{};
-    depthAttachmentRef.attachment = 1;
+    depthAttachmentRef.attachment = static_cast<uint32_t>(attachments.size());
     depthAttachmentRef.layout = VkImageLayout::VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 
     VkSubpassDescription subpass{};
     subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-    subpass.colorAttachmentCount = 1;
-    subpass.pColorAttachments = &swapchainAttachmentRef;
-    subpass.pDepthStencilAttachment = &depthAttachmentRef;
+    subpass.colorAttachmentCount = static_cast<uint32_t>(colorAttachmentRefs.size());
+    subpass.pColorAttachments = colorAttachmentRefs.data();
+    if (createInfo.DepthAttachment.has_value())
+    {
+        attachments.emplace_back(*createInfo.DepthAttachment);
+        subpass.pDepthStencilAttachment = &depthAttachmentRef;
+        VkClearValue clearValue{};
+        clearValue.depthStencil = {1.0f, 0};
+        m_ClearValues.emplace_back(clearValue);
+    }
 
     VkRenderPassCreateInfo renderPassCreateInfo{};
-    std::array<VkAttachmentDescription, 2> attachments = {createInfo.SwapchainAttachmentDescription,
-                                                          createInfo.DepthAttachment};
     renderPassCreateInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
     renderPassCreateInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
     renderPassCreateInfo.pAttachments = attachments.data();
@@ -52,6 +66,7 @@ RenderPass::RenderPass(VkDevice device, RenderPassCreateInfo &&createInfo) : m_D
     {
         throw std::runtime_error("Could not create render pass");
     }
+    m_Attachments = std::move(attachments);
 }
 
 RenderPass::~RenderPass()
@@ -63,7 +78,9 @@ RenderPass::~RenderPass()
 }
 
 RenderPass::RenderPass(RenderPass &&other) : 
-    m_Device(other.m_Device), m_RenderPass(std::exchange(other.m_RenderPass, VK_NULL_HANDLE))
+    m_Device(other.m_Device), m_RenderPass(std::exchange(other.m_RenderPass, VK_NULL_HANDLE)),
+    m_Attachments(std::move(other.m_Attachments)), m_ColorAttachmentCount(other.m_ColorAttachmentCount),
+    m_ClearValues(std::move(other.m_ClearValues))
 {
 }
 
@@ -72,3 +89,37 @@ VkRenderPass RenderPass::Get() const
     return m_RenderPass;
 }
 
+std::span<const VkClearValue> RenderPass::GetClearValues() const
+{
+    return m_ClearValues;
+}
+
+
+std::span<const VkAttachmentDescription> RenderPass::GetAttachments() const
+{
+    return m_Attachments;
+}
+
+uint32_t RenderPass::GetColorAttachmentCount() const
+{
+    return m_ColorAttachmentCount;
+}
+
+RenderingLayout RenderPass::GetRenderingLayout() const
+{
+    RenderingLayout layout;
+    layout.CompatibleRenderPass = this;
+    for (uint32_t i = 0; i < m_Attachments.size(); i++)
+    {
+        if (i < m_ColorAttachmentCount)
+        {
+            layout.ColorFormats.emplace_back(m_Attachments[i].format);
+        }
+        else
+        {
+            layout.DepthFormat = m_Attachments[i].format;
+        }
+        layout.Samples = m_Attachments[i].samples;
+    }
+    return layout;
+}
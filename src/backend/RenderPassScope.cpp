@@ -0,0 +1,133 @@
+#include <backend/RenderPassScope.h>
+
+#include <cassert>
+#include <utility>
+
+#include <backend/CommandBufferPool.h>
+#include <backend/Framebuffer.h>
+#include <backend/DescriptorSetBuilder.h>
+#include <backend/Buffer.h>
+#include <backend/BindlessTextureTable.h>
+#include <backend/Pipeline.h>
+
+RenderPassScope::RenderPassScope(CommandBuffer &commandBuffer, const Framebuffer &framebuffer,
+                                 const RenderPass &renderPass)
+    : m_CommandBuffer(&commandBuffer), m_Viewport(framebuffer.GetViewport())
+{
+    m_CommandBuffer->BeginRenderPassInternal(framebuffer, renderPass);
+}
+
+RenderPassScope::RenderPassScope(CommandBuffer &commandBuffer, const RenderingInfo &renderingInfo)
+    : m_CommandBuffer(&commandBuffer), m_Viewport(renderingInfo.Viewport)
+{
+    m_CommandBuffer->BeginRenderingInternal(renderingInfo);
+}
+
+RenderPassScope::RenderPassScope(RenderPassScope &&other)
+    : m_CommandBuffer(std::exchange(other.m_CommandBuffer, nullptr)), m_Viewport(other.m_Viewport),
+      m_BoundPipeline(other.m_BoundPipeline)
+{
+}
+
+RenderPassScope::~RenderPassScope()
+{
+    if (m_CommandBuffer != nullptr)
+    {
+        m_CommandBuffer->EndRenderPassInternal();
+    }
+}
+
+RenderPassScope &RenderPassScope::BindPipeline(const RasterPipeline &pipeline)
+{
+    m_CommandBuffer->BindPipeline(pipeline, m_Viewport);
+    m_BoundPipeline = &pipeline;
+    return *this;
+}
+
+RenderPassScope &RenderPassScope::BindVertexBuffer(VertexBuffer &vertexBuffer, uint32_t binding)
+{
+    m_CommandBuffer->BindVertexBuffer(vertexBuffer, binding);
+    return *this;
+}
+
+RenderPassScope &RenderPassScope::BindIndexBuffer(IndexBuffer &indexBuffer)
+{
+    m_CommandBuffer->BindIndexBuffer(indexBuffer);
+    return *this;
+}
+
+RenderPassScope &RenderPassScope::BindDescriptorSet(BindSet &&bindSet, std::span<const uint32_t> dynamicOffsets)
+{
+    assert(m_BoundPipeline != nullptr && "Bind a pipeline before binding descriptor sets");
+    m_CommandBuffer->BindDescriptorSet(bindSet, *m_BoundPipeline, dynamicOffsets);
+    return *this;
+}
+
+RenderPassScope &RenderPassScope::BindDescriptorSet(const DescriptorSet &descriptorSet,
+                                                    std::span<const uint32_t> dynamicOffsets)
+{
+    assert(m_BoundPipeline != nullptr && "Bind a pipeline before binding descriptor sets");
+    assert(dynamicOffsets.size() == descriptorSet.GetLayout().GetDynamicOffsetCount() &&
+           "Need an offset for every dynamic binding");
+    m_CommandBuffer->BindDescriptorSet(descriptorSet.Get(), 0, VkPipelineBindPoint::VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                       m_BoundPipeline->GetPipelineLayout(), dynamicOffsets);
+    return *this;
+}
+
+RenderPassScope &RenderPassScope::BindBindlessTextures(const BindlessTextureTable &table)
+{
+    assert(m_BoundPipeline != nullptr && "Bind a pipeline before binding descriptor sets");
+    m_CommandBuffer->BindDescriptorSet(table.Get(), BindlessSetIndex, VkPipelineBindPoint::VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                       m_BoundPipeline->GetPipelineLayout());
+    return *this;
+}
+
+RenderPassScope &RenderPassScope::PushConstantsInternal(VkShaderStageFlags stages, uint32_t offset, uint32_t size,
+                                                        const void *data)
+{
+    assert(m_BoundPipeline != nullptr && "Bind a pipeline before pushing constants");
+    m_CommandBuffer->PushConstantsInternal(*m_BoundPipeline, stages, offset, size, data);
+    return *this;
+}
+
+void RenderPassScope::Draw(const DrawParameters &parameters)
+{
+    assert(m_BoundPipeline != nullptr && "Bind a pipeline before drawing");
+    vkCmdDraw(m_CommandBuffer->Get(), parameters.VertexCount, parameters.InstanceCount, parameters.FirstVertex,
+              parameters.FirstInstance);
+}
+
+void RenderPassScope::DrawIndexed(const DrawIndexedParameters &parameters)
+{
+    assert(m_BoundPipeline != nullptr && "Bind a pipeline before drawing");
+    vkCmdDrawIndexed(m_CommandBuffer->Get(), parameters.IndexCount, parameters.InstanceCount, parameters.FirstIndex,
+                     parameters.VertexOffset, parameters.FirstInstance);
+}
+
+void RenderPassScope::DrawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount, uint32_t firstInstance)
+{
+    DrawIndexed(DrawIndexedParameters{.IndexCount = indexCount, .InstanceCount = instanceCount, .FirstInstance = firstInstance});
+}
+
+void RenderPassScope::DrawIndexedIndirect(const DeviceBuffer &arguments, uint32_t drawCount, uint32_t firstDraw)
+{
+    assert(m_BoundPipeline != nullptr && "Bind a pipeline before drawing");
+    m_CommandBuffer->RequireAccess(arguments, EResourceAccess::IndirectBufferRead);
+    vkCmdDrawIndexedIndirect(m_CommandBuffer->Get(), arguments.Get(), firstDraw * sizeof(VkDrawIndexedIndirectCommand),
+                             drawCount, sizeof(VkDrawIndexedIndirectCommand));
+}
+
+void RenderPassScope::DrawIndexedIndirectCount(const DeviceBuffer &arguments, const DeviceBuffer &count,
+                                               uint32_t maxDrawCount)
+{
+    assert(m_BoundPipeline != nullptr && "Bind a pipeline before drawing");
+    m_CommandBuffer->RequireAccess(arguments, EResourceAccess::IndirectBufferRead);
+    m_CommandBuffer->RequireAccess(count, EResourceAccess::IndirectBufferRead);
+    vkCmdDrawIndexedIndirectCount(m_CommandBuffer->Get(), arguments.Get(), 0, count.Get(), 0, maxDrawCount,
+                                  sizeof(VkDrawIndexedIndirectCommand));
+}
+
+const Viewport &RenderPassScope::GetViewport() const
+{
+    return m_Viewport;
+}
@@ -0,0 +1,337 @@
+#include <backend/ResourceState.h>
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+// All stage and access bits used below have the same value as their synchronization1 counterparts,
+// so that they can be narrowed for `vkCmdPipelineBarrier` when synchronization2 is unavailable
+AccessInfo GetAccessInfo(EResourceAccess access)
+{
+    switch (access)
+    {
+    case EResourceAccess::TransferRead:
+        return AccessInfo{VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_READ_BIT,
+                          VkImageLayout::VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, false};
+    case EResourceAccess::TransferWrite:
+        return AccessInfo{VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                          VkImageLayout::VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, true};
+    case EResourceAccess::VertexBufferRead:
+        return AccessInfo{VK_PIPELINE_STAGE_2_VERTEX_INPUT_BIT, VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT,
+                          VkImageLayout::VK_IMAGE_LAYOUT_UNDEFINED, false};
+    case EResourceAccess::IndexBufferRead:
+        return AccessInfo{VK_PIPELINE_STAGE_2_VERTEX_INPUT_BIT, VK_ACCESS_2_INDEX_READ_BIT,
+                          VkImageLayout::VK_IMAGE_LAYOUT_UNDEFINED, false};
+    case EResourceAccess::IndirectBufferRead:
+        return AccessInfo{VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT, VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT,
+                          VkImageLayout::VK_IMAGE_LAYOUT_UNDEFINED, false};
+    case EResourceAccess::GraphicsUniformRead:
+        return AccessInfo{VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+                          VK_ACCESS_2_UNIFORM_READ_BIT, VkImageLayout::VK_IMAGE_LAYOUT_UNDEFINED, false};
+    case EResourceAccess::GraphicsShaderRead:
+        return AccessInfo{VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+                          VK_ACCESS_2_SHADER_READ_BIT, VkImageLayout::VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, false};
+    case EResourceAccess::GraphicsStorageImageRead:
+        return AccessInfo{VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+                          VK_ACCESS_2_SHADER_READ_BIT, VkImageLayout::VK_IMAGE_LAYOUT_GENERAL, false};
+    case EResourceAccess::ComputeUniformRead:
+        return AccessInfo{VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_UNIFORM_READ_BIT,
+                          VkImageLayout::VK_IMAGE_LAYOUT_UNDEFINED, false};
+    case EResourceAccess::ComputeShaderRead:
+        return AccessInfo{VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_READ_BIT,
+                          VkImageLayout::VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, false};
+    case EResourceAccess::ComputeShaderReadWrite:
+        return AccessInfo{VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_READ_BIT | VK_ACCESS_2_SHADER_WRITE_BIT,
+                          VkImageLayout::VK_IMAGE_LAYOUT_GENERAL, true};
+    case EResourceAccess::ColorAttachmentWrite:
+        return AccessInfo{VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+                          VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+                          VkImageLayout::VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, true};
+    case EResourceAccess::DepthStencilAttachment:
+        return AccessInfo{VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+                          VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                          VkImageLayout::VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, true};
+    case EResourceAccess::Present:
+        // The presentation engine is synchronized through a semaphore, the barrier only has to transition the layout
+        return AccessInfo{VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE, VkImageLayout::VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+                          false};
+    }
+    throw std::invalid_argument("Unknown resource access");
+}
+
+namespace
+{
+void ForgetAccesses(ResourceState &state)
+{
+    state.WriteStages = 0;
+    state.WriteAccess = 0;
+    state.ReadStages = 0;
+    state.VisibleStages = 0;
+    state.VisibleAccess = 0;
+}
+
+void RecordAccess(ResourceState &state, const AccessInfo &info, bool synchronizedAll)
+{
+    if (info.Write)
+    {
+        state.WriteStages = info.Stages;
+        state.WriteAccess = info.Access;
+        state.ReadStages = 0;
+        state.VisibleStages = 0;
+        state.VisibleAccess = 0;
+    }
+    else if (synchronizedAll)
+    {
+        // A layout transition or acquire behaves like a write that happens before `info.Stages`. Treating
+        // it as one makes reads from other stages still wait for it
+        state.WriteStages = info.Stages;
+        state.WriteAccess = 0;
+        state.ReadStages = info.Stages;
+        state.VisibleStages = info.Stages;
+        state.VisibleAccess = info.Access;
+    }
+    else
+    {
+        state.ReadStages |= info.Stages;
+    }
+}
+}
+
+std::optional<StateTransition> TransitionState(ResourceState &state, EResourceAccess access, uint64_t recordingId,
+                                               uint32_t queueFamily, bool isImage)
+{
+    auto info = GetAccessInfo(access);
+    if (state.RecordingId != recordingId)
+    {
+        ForgetAccesses(state);
+        state.RecordingId = recordingId;
+    }
+
+    if (state.PendingAcquire.has_value())
+    {
+        auto acquire = *state.PendingAcquire;
+        assert(acquire.DestinationFamily == queueFamily && "Resource was released to a different queue family");
+        assert((!isImage || acquire.NewLayout == info.Layout) &&
+               "Resource was released with a different layout than the access requires");
+        state.PendingAcquire.reset();
+        RecordAccess(state, info, true);
+        return StateTransition{VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE, info.Stages, info.Access,
+                               acquire.OldLayout, acquire.NewLayout, acquire};
+    }
+
+    std::optional<StateTransition> transition;
+    bool layoutChange = isImage && state.Layout != info.Layout;
+    if (layoutChange || info.Write)
+    {
+        // Write-after-read only needs an execution dependency, but the previous writes (if any) have
+        // to be made available as well
+        VkPipelineStageFlags2 sourceStages = state.WriteStages | state.ReadStages;
+        if (layoutChange || sourceStages != 0)
+        {
+            auto newLayout = isImage ? info.Layout : state.Layout;
+            transition = StateTransition{sourceStages, state.WriteAccess, info.Stages, info.Access,
+                                         state.Layout, newLayout, std::nullopt};
+            state.Layout = newLayout;
+        }
+        RecordAccess(state, info, layoutChange);
+        return transition;
+    }
+
+    bool alreadyVisible = (info.Stages & ~state.VisibleStages) == 0 && (info.Access & ~state.VisibleAccess) == 0;
+    if (state.WriteStages != 0 && !alreadyVisible)
+    {
+        transition = StateTransition{state.WriteStages, state.WriteAccess, info.Stages, info.Access,
+                                     state.Layout, state.Layout, std::nullopt};
+        state.VisibleStages |= info.Stages;
+        state.VisibleAccess |= info.Access;
+    }
+    RecordAccess(state, info, false);
+    return transition;
+}
+
+StateTransition ReleaseState(ResourceState &state, VkImageLayout newLayout, uint64_t recordingId,
+                             uint32_t sourceFamily, uint32_t destinationFamily)
+{
+    assert(!state.PendingAcquire.has_value() && "Releasing a resource that was never acquired");
+    if (state.RecordingId != recordingId)
+    {
+        ForgetAccesses(state);
+        state.RecordingId = recordingId;
+    }
+
+    auto transfer = QueueOwnershipTransfer{sourceFamily, destinationFamily, state.Layout, newLayout};
+    // The destination scope of a release is ignored, everything after it happens on the other queue
+    auto release = StateTransition{state.WriteStages | state.ReadStages, state.WriteAccess, VK_PIPELINE_STAGE_2_NONE,
+                                   VK_ACCESS_2_NONE, state.Layout, newLayout, transfer};
+    ForgetAccesses(state);
+    state.Layout = newLayout;
+    state.PendingAcquire = transfer;
+    return release;
+}
+
+void DiscardState(ResourceState &state, std::span<const ResourceState *const> previousOccupants,
+                  uint64_t recordingId)
+{
+    // Gathered before resetting, as the resource itself may be among the previous occupants
+    VkPipelineStageFlags2 stages = 0;
+    VkAccessFlags2 access = 0;
+    for (const auto *occupant : previousOccupants)
+    {
+        // Accesses of earlier recordings are kept, as they may be of a frame that is still in flight on the same queue.
+        // Stored as a write so that the layout transition waits for reads as well as writes
+        stages |= occupant->WriteStages | occupant->ReadStages;
+        access |= occupant->WriteAccess;
+    }
+    state = ResourceState{};
+    state.RecordingId = recordingId;
+    state.WriteStages = stages;
+    state.WriteAccess = access;
+}
+
+void DiscardState(ResourceState &state, EResourceAccess previousAccess, uint64_t recordingId)
+{
+    auto info = GetAccessInfo(previousAccess);
+    state = ResourceState{};
+    state.RecordingId = recordingId;
+    // Stored as a write, like the previous occupants above, so that the layout transition waits for it
+    state.WriteStages = info.Stages;
+    state.WriteAccess = info.Access;
+}
+
+void BarrierBatch::Add(VkBuffer buffer, const StateTransition &transition)
+{
+    VkBufferMemoryBarrier2 barrier{};
+    barrier.sType = VkStructureType::VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2;
+    barrier.srcStageMask = transition.SourceStages;
+    barrier.srcAccessMask = transition.SourceAccess;
+    barrier.dstStageMask = transition.DestinationStages;
+    barrier.dstAccessMask = transition.DestinationAccess;
+    barrier.srcQueueFamilyIndex =
+        transition.OwnershipTransfer ? transition.OwnershipTransfer->SourceFamily : VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex =
+        transition.OwnershipTransfer ? transition.OwnershipTransfer->DestinationFamily : VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = buffer;
+    barrier.offset = 0;
+    barrier.size = VK_WHOLE_SIZE;
+    m_BufferBarriers.emplace_back(barrier);
+}
+
+void BarrierBatch::Add(VkImage image, const VkImageSubresourceRange &range, const StateTransition &transition)
+{
+    VkImageMemoryBarrier2 barrier{};
+    barrier.sType = VkStructureType::VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+    barrier.srcStageMask = transition.SourceStages;
+    barrier.srcAccessMask = transition.SourceAccess;
+    barrier.dstStageMask = transition.DestinationStages;
+    barrier.dstAccessMask = transition.DestinationAccess;
+    barrier.oldLayout = transition.OldLayout;
+    barrier.newLayout = transition.NewLayout;
+    barrier.srcQueueFamilyIndex =
+        transition.OwnershipTransfer ? transition.OwnershipTransfer->SourceFamily : VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex =
+        transition.OwnershipTransfer ? transition.OwnershipTransfer->DestinationFamily : VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange = range;
+    m_ImageBarriers.emplace_back(barrier);
+}
+
+bool BarrierBatch::ContainsBuffer(VkBuffer buffer) const
+{
+    return std::any_of(m_BufferBarriers.begin(), m_BufferBarriers.end(),
+                       [buffer](const VkBufferMemoryBarrier2 &barrier) { return barrier.buffer == buffer; });
+}
+
+bool BarrierBatch::ContainsImage(VkImage image) const
+{
+    return std::any_of(m_ImageBarriers.begin(), m_ImageBarriers.end(),
+                       [image](const VkImageMemoryBarrier2 &barrier) { return barrier.image == image; });
+}
+
+bool BarrierBatch::IsEmpty() const
+{
+    return m_BufferBarriers.empty() && m_ImageBarriers.empty();
+}
+
+void BarrierBatch::Flush(VkCommandBuffer commandBuffer, PFN_vkCmdPipelineBarrier2KHR pipelineBarrier2)
+{
+    if (IsEmpty())
+    {
+        return;
+    }
+    if (pipelineBarrier2 != nullptr)
+    {
+        VkDependencyInfo dependencyInfo{};
+        dependencyInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+        dependencyInfo.bufferMemoryBarrierCount = static_cast<uint32_t>(m_BufferBarriers.size());
+        dependencyInfo.pBufferMemoryBarriers = m_BufferBarriers.data();
+        dependencyInfo.imageMemoryBarrierCount = static_cast<uint32_t>(m_ImageBarriers.size());
+        dependencyInfo.pImageMemoryBarriers = m_ImageBarriers.data();
+        pipelineBarrier2(commandBuffer, &dependencyInfo);
+    }
+    else
+    {
+        FlushLegacy(commandBuffer);
+    }
+    m_BufferBarriers.clear();
+    m_ImageBarriers.clear();
+}
+
+void BarrierBatch::FlushLegacy(VkCommandBuffer commandBuffer)
+{
+    // Synchronization1 only has a single pair of stage masks per call, so the batch waits on the union
+    // of all its source stages. Still cheaper than a separate barrier per resource
+    VkPipelineStageFlags sourceStages = 0;
+    VkPipelineStageFlags destinationStages = 0;
+
+    std::vector<VkBufferMemoryBarrier> bufferBarriers;
+    bufferBarriers.reserve(m_BufferBarriers.size());
+    for (const auto &barrier : m_BufferBarriers)
+    {
+        sourceStages |= static_cast<VkPipelineStageFlags>(barrier.srcStageMask);
+        destinationStages |= static_cast<VkPipelineStageFlags>(barrier.dstStageMask);
+
+        VkBufferMemoryBarrier legacyBarrier{};
+        legacyBarrier.sType = VkStructureType::VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        legacyBarrier.srcAccessMask = static_cast<VkAccessFlags>(barrier.srcAccessMask);
+        legacyBarrier.dstAccessMask = static_cast<VkAccessFlags>(barrier.dstAccessMask);
+        legacyBarrier.srcQueueFamilyIndex = barrier.srcQueueFamilyIndex;
+        legacyBarrier.dstQueueFamilyIndex = barrier.dstQueueFamilyIndex;
+        legacyBarrier.buffer = barrier.buffer;
+        legacyBarrier.offset = barrier.offset;
+        legacyBarrier.size = barrier.size;
+        bufferBarriers.emplace_back(legacyBarrier);
+    }
+
+    std::vector<VkImageMemoryBarrier> imageBarriers;
+    imageBarriers.reserve(m_ImageBarriers.size());
+    for (const auto &barrier : m_ImageBarriers)
+    {
+        sourceStages |= static_cast<VkPipelineStageFlags>(barrier.srcStageMask);
+        destinationStages |= static_cast<VkPipelineStageFlags>(barrier.dstStageMask);
+
+        VkImageMemoryBarrier legacyBarrier{};
+        legacyBarrier.sType = VkStructureType::VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        legacyBarrier.srcAccessMask = static_cast<VkAccessFlags>(barrier.srcAccessMask);
+        legacyBarrier.dstAccessMask = static_cast<VkAccessFlags>(barrier.dstAccessMask);
+        legacyBarrier.oldLayout = barrier.oldLayout;
+        legacyBarrier.newLayout = barrier.newLayout;
+        legacyBarrier.srcQueueFamilyIndex = barrier.srcQueueFamilyIndex;
+        legacyBarrier.dstQueueFamilyIndex = barrier.dstQueueFamilyIndex;
+        legacyBarrier.image = barrier.image;
+        legacyBarrier.subresourceRange = barrier.subresourceRange;
+        imageBarriers.emplace_back(legacyBarrier);
+    }
+
+    // An empty stage mask isn't allowed without synchronization2, these are the equivalents of "nothing"
+    if (sourceStages == 0)
+    {
+        sourceStages = VkPipelineStageFlagBits::VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+    }
+    if (destinationStages == 0)
+    {
+        destinationStages = VkPipelineStageFlagBits::VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+    }
+    vkCmdPipelineBarrier(commandBuffer, sourceStages, destinationStages, 0, 0, nullptr,
+                         static_cast<uint32_t>(bufferBarriers.size()), bufferBarriers.data(),
+                         static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+}
@@ -1,23 +1,44 @@
 #include <backend/ShaderModule.h>
 
+#include <cstring>
 #include <fstream>
 #include <iostream>
 
-ShaderModule::ShaderModule(const VkDevice& vkDevice, const std::vector<char>& bytes) : m_Device(vkDevice)
+namespace
+{
+std::vector<uint32_t> ToWords(const std::vector<char> &bytes)
+{
+    if (bytes.size() % sizeof(uint32_t) != 0)
+    {
+        throw std::runtime_error("SPIR-V size is not a multiple of 4 bytes");
+    }
+    // Copied so that the code is properly aligned
+    std::vector<uint32_t> words(bytes.size() / sizeof(uint32_t));
+    std::memcpy(words.data(), bytes.data(), bytes.size());
+    return words;
+}
+}
+
+ShaderModule::ShaderModule(const VkDevice& vkDevice, const std::vector<char>& bytes) : ShaderModule(vkDevice, ToWords(bytes))
+{
+}
+
+ShaderModule::ShaderModule(const VkDevice &vkDevice, const std::vector<uint32_t> &code)
+    : m_Device(vkDevice), m_Reflection(ShaderReflection::Reflect(code))
 {
     VkShaderModuleCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    createInfo.codeSize = bytes.size();
-
-    // TODO: Require buffer to be of right type for proper alignment
-    createInfo.pCode = reinterpret_cast<const uint32_t*>(bytes.data());
+    createInfo.codeSize = code.size() * sizeof(uint32_t);
+    createInfo.pCode = code.data();
     if (vkCreateShaderModule(vkDevice, &createInfo, nullptr, &m_ShaderModule) != VK_SUCCESS)
     {
         throw std::runtime_error("Could not create shader module");
     }
 }
 
-ShaderModule::ShaderModule(ShaderModule &&other) : m_Device(other.m_Device), m_ShaderModule(std::exchange(other.m_ShaderModule, VK_NULL_HANDLE))
+ShaderModule::ShaderModule(ShaderModule &&other)
+    : m_Device(other.m_Device), m_ShaderModule(std::exchange(other.m_ShaderModule, VK_NULL_HANDLE)),
+      m_Reflection(std::move(other.m_Reflection))
 {
 }
 
@@ -51,3 +72,8 @@ const VkShaderModule &ShaderModule::Get() const
 {
     return m_ShaderModule;
 }
+
+const ShaderReflection &ShaderModule::GetReflection() const
+{
+    return m_Reflection;
+}
@@ -0,0 +1,505 @@
+#include <backend/ShaderReflection.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace
+{
+// Subset of the SPIR-V specification that is needed to find the resource interface
+const uint32_t SPIRV_MAGIC = 0x07230203;
+const size_t SPIRV_HEADER_WORDS = 5;
+
+enum class EOp : uint16_t
+{
+    EntryPoint = 15,
+    TypeInt = 21,
+    TypeFloat = 22,
+    TypeVector = 23,
+    TypeMatrix = 24,
+    TypeImage = 25,
+    TypeSampler = 26,
+    TypeSampledImage = 27,
+    TypeArray = 28,
+    TypeRuntimeArray = 29,
+    TypeStruct = 30,
+    TypePointer = 32,
+    Constant = 43,
+    SpecConstant = 50,
+    Variable = 59,
+    Decorate = 71,
+    MemberDecorate = 72,
+    TypeAccelerationStructure = 5341
+};
+
+enum class EDecoration : uint32_t
+{
+    Block = 2,
+    BufferBlock = 3,
+    ArrayStride = 6,
+    MatrixStride = 7,
+    NonWritable = 24,
+    Binding = 33,
+    DescriptorSet = 34,
+    Offset = 35
+};
+
+enum class EStorageClass : uint32_t
+{
+    UniformConstant = 0,
+    Uniform = 2,
+    PushConstant = 9,
+    StorageBuffer = 12
+};
+
+enum class EDim : uint32_t
+{
+    Buffer = 5,
+    SubpassData = 6
+};
+
+struct SpirvType
+{
+    EOp Op;
+    // Operands following the result id
+    std::vector<uint32_t> Operands;
+};
+
+struct SpirvDecorations
+{
+    std::optional<uint32_t> Set;
+    std::optional<uint32_t> Binding;
+    std::optional<uint32_t> ArrayStride;
+    bool Block = false;
+    bool BufferBlock = false;
+    bool NonWritable = false;
+    // Per struct member
+    std::vector<uint32_t> MemberOffsets;
+    std::vector<uint32_t> MemberMatrixStrides;
+    std::vector<bool> MemberNonWritable;
+};
+
+struct SpirvVariable
+{
+    uint32_t Id;
+    uint32_t PointerType;
+    EStorageClass StorageClass;
+};
+
+class SpirvModule
+{
+  public:
+    explicit SpirvModule(std::span<const uint32_t> code)
+    {
+        if (code.size() < SPIRV_HEADER_WORDS || code[0] != SPIRV_MAGIC)
+        {
+            throw std::runtime_error("Shader code is not SPIR-V");
+        }
+        for (size_t offset = SPIRV_HEADER_WORDS; offset < code.size();)
+        {
+            uint32_t wordCount = code[offset] >> 16;
+            auto op = static_cast<EOp>(code[offset] & 0xFFFF);
+            if (wordCount == 0 || offset + wordCount > code.size())
+            {
+                throw std::runtime_error("Malformed SPIR-V instruction");
+            }
+            Parse(op, code.subspan(offset + 1, wordCount - 1));
+            offset += wordCount;
+        }
+    }
+
+    VkShaderStageFlagBits GetStage() const
+    {
+        if (!m_Stage.has_value())
+        {
+            throw std::runtime_error("SPIR-V module has no entry point");
+        }
+        return *m_Stage;
+    }
+
+    const std::vector<SpirvVariable> &GetVariables() const
+    {
+        return m_Variables;
+    }
+
+    const SpirvType &GetType(uint32_t id) const
+    {
+        auto type = m_Types.find(id);
+        if (type == m_Types.end())
+        {
+            throw std::runtime_error("SPIR-V references an unknown type");
+        }
+        return type->second;
+    }
+
+    const SpirvDecorations &GetDecorations(uint32_t id) const
+    {
+        static const SpirvDecorations none;
+        auto decorations = m_Decorations.find(id);
+        return decorations == m_Decorations.end() ? none : decorations->second;
+    }
+
+    uint32_t GetConstant(uint32_t id) const
+    {
+        auto constant = m_Constants.find(id);
+        if (constant == m_Constants.end())
+        {
+            throw std::runtime_error("SPIR-V array length is not a constant");
+        }
+        return constant->second;
+    }
+
+    /// <summary>
+    /// Size in bytes of a type in an explicitly laid out block
+    /// </summary>
+    uint32_t GetSize(uint32_t typeId, uint32_t matrixStride = 0) const
+    {
+        const auto &type = GetType(typeId);
+        switch (type.Op)
+        {
+        case EOp::TypeInt:
+        case EOp::TypeFloat:
+            return type.Operands[0] / 8;
+        case EOp::TypeVector:
+            return GetSize(type.Operands[0]) * type.Operands[1];
+        case EOp::TypeMatrix: {
+            uint32_t columnSize = matrixStride != 0 ? matrixStride : GetSize(type.Operands[0]);
+            return columnSize * type.Operands[1];
+        }
+        case EOp::TypeArray: {
+            auto stride = GetDecorations(typeId).ArrayStride;
+            return (stride.has_value() ? *stride : GetSize(type.Operands[0])) * GetConstant(type.Operands[1]);
+        }
+        case EOp::TypeStruct: {
+            const auto &decorations = GetDecorations(typeId);
+            uint32_t size = 0;
+            for (size_t member = 0; member < type.Operands.size(); member++)
+            {
+                uint32_t offset = member < decorations.MemberOffsets.size() ? decorations.MemberOffsets[member] : 0;
+                uint32_t stride =
+                    member < decorations.MemberMatrixStrides.size() ? decorations.MemberMatrixStrides[member] : 0;
+                size = std::max(size, offset + GetSize(type.Operands[member], stride));
+            }
+            return size;
+        }
+        default:
+            // Runtime arrays have no static size, nor do opaque types
+            return 0;
+        }
+    }
+
+  private:
+    void Parse(EOp op, std::span<const uint32_t> operands)
+    {
+        switch (op)
+        {
+        case EOp::EntryPoint:
+            // Only the first entry point is used, modules are compiled with a single "main"
+            if (!m_Stage.has_value())
+            {
+                m_Stage = GetStage(operands[0]);
+            }
+            break;
+        case EOp::TypeInt:
+        case EOp::TypeFloat:
+        case EOp::TypeVector:
+        case EOp::TypeMatrix:
+        case EOp::TypeImage:
+        case EOp::TypeSampler:
+        case EOp::TypeSampledImage:
+        case EOp::TypeArray:
+        case EOp::TypeRuntimeArray:
+        case EOp::TypeStruct:
+        case EOp::TypePointer:
+        case EOp::TypeAccelerationStructure:
+            m_Types[operands[0]] = SpirvType{op, std::vector<uint32_t>(operands.begin() + 1, operands.end())};
+            break;
+        case EOp::Constant:
+        case EOp::SpecConstant:
+            // Only 32 bit integers can be array lengths. Specialized lengths use their default value
+            if (operands.size() >= 3)
+            {
+                m_Constants[operands[1]] = operands[2];
+            }
+            break;
+        case EOp::Variable:
+            m_Variables.emplace_back(SpirvVariable{operands[1], operands[0], static_cast<EStorageClass>(operands[2])});
+            break;
+        case EOp::Decorate:
+            Decorate(m_Decorations[operands[0]], static_cast<EDecoration>(operands[1]), operands.subspan(2));
+            break;
+        case EOp::MemberDecorate:
+            DecorateMember(m_Decorations[operands[0]], operands[1], static_cast<EDecoration>(operands[2]),
+                           operands.subspan(3));
+            break;
+        default:
+            break;
+        }
+    }
+
+    static void Decorate(SpirvDecorations &decorations, EDecoration decoration, std::span<const uint32_t> literals)
+    {
+        switch (decoration)
+        {
+        case EDecoration::Block:
+            decorations.Block = true;
+            break;
+        case EDecoration::BufferBlock:
+            decorations.BufferBlock = true;
+            break;
+        case EDecoration::ArrayStride:
+            decorations.ArrayStride = literals[0];
+            break;
+        case EDecoration::NonWritable:
+            decorations.NonWritable = true;
+            break;
+        case EDecoration::Binding:
+            decorations.Binding = literals[0];
+            break;
+        case EDecoration::DescriptorSet:
+            decorations.Set = literals[0];
+            break;
+        default:
+            break;
+        }
+    }
+
+    static void DecorateMember(SpirvDecorations &decorations, uint32_t member, EDecoration decoration,
+                               std::span<const uint32_t> literals)
+    {
+        if (decoration == EDecoration::Offset)
+        {
+            decorations.MemberOffsets.resize(std::max<size_t>(decorations.MemberOffsets.size(), member + 1));
+            decorations.MemberOffsets[member] = literals[0];
+        }
+        else if (decoration == EDecoration::MatrixStride)
+        {
+            decorations.MemberMatrixStrides.resize(std::max<size_t>(decorations.MemberMatrixStrides.size(), member + 1));
+            decorations.MemberMatrixStrides[member] = literals[0];
+        }
+        else if (decoration == EDecoration::NonWritable)
+        {
+            decorations.MemberNonWritable.resize(std::max<size_t>(decorations.MemberNonWritable.size(), member + 1));
+            decorations.MemberNonWritable[member] = true;
+        }
+    }
+
+    static VkShaderStageFlagBits GetStage(uint32_t executionModel)
+    {
+        switch (executionModel)
+        {
+        case 0:
+            return VkShaderStageFlagBits::VK_SHADER_STAGE_VERTEX_BIT;
+        case 1:
+            return VkShaderStageFlagBits::VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+        case 2:
+            return VkShaderStageFlagBits::VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+        case 3:
+            return VkShaderStageFlagBits::VK_SHADER_STAGE_GEOMETRY_BIT;
+        case 4:
+            return VkShaderStageFlagBits::VK_SHADER_STAGE_FRAGMENT_BIT;
+        case 5:
+            return VkShaderStageFlagBits::VK_SHADER_STAGE_COMPUTE_BIT;
+        default:
+            throw std::runtime_error("Unsupported SPIR-V execution model");
+        }
+    }
+
+    std::optional<VkShaderStageFlagBits> m_Stage;
+    std::unordered_map<uint32_t, SpirvType> m_Types;
+    std::unordered_map<uint32_t, SpirvDecorations> m_Decorations;
+    std::unordered_map<uint32_t, uint32_t> m_Constants;
+    std::vector<SpirvVariable> m_Variables;
+};
+
+VkDescriptorType GetDescriptorType(const SpirvModule &module, EStorageClass storageClass, uint32_t typeId)
+{
+    const auto &type = module.GetType(typeId);
+    if (storageClass == EStorageClass::StorageBuffer)
+    {
+        return VkDescriptorType::VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    }
+    if (storageClass == EStorageClass::Uniform)
+    {
+        // Older compilers declare storage buffers as uniform blocks decorated with BufferBlock
+        return module.GetDecorations(typeId).BufferBlock ? VkDescriptorType::VK_DESCRIPTOR_TYPE_STORAGE_BUFFER
+                                                         : VkDescriptorType::VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    }
+
+    switch (type.Op)
+    {
+    case EOp::TypeSampledImage:
+        return VkDescriptorType::VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    case EOp::TypeSampler:
+        return VkDescriptorType::VK_DESCRIPTOR_TYPE_SAMPLER;
+    case EOp::TypeAccelerationStructure:
+        return VkDescriptorType::VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
+    case EOp::TypeImage: {
+        // Operands are the sampled type, dim, depth, arrayed, multisampled and sampled
+        auto dim = static_cast<EDim>(type.Operands[1]);
+        bool storage = type.Operands[5] == 2;
+        if (dim == EDim::SubpassData)
+        {
+            return VkDescriptorType::VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+        }
+        if (dim == EDim::Buffer)
+        {
+            return storage ? VkDescriptorType::VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER
+                           : VkDescriptorType::VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+        }
+        return storage ? VkDescriptorType::VK_DESCRIPTOR_TYPE_STORAGE_IMAGE
+                       : VkDescriptorType::VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+    }
+    default:
+        throw std::runtime_error("Unsupported SPIR-V descriptor type");
+    }
+}
+
+// Whether a storage buffer is declared `readonly`, which compilers decorate either the variable or every member of
+// its block with
+bool IsNonWritable(const SpirvModule &module, uint32_t variableId, uint32_t blockTypeId)
+{
+    if (module.GetDecorations(variableId).NonWritable)
+    {
+        return true;
+    }
+    const auto &block = module.GetType(blockTypeId);
+    const auto &members = module.GetDecorations(blockTypeId).MemberNonWritable;
+    return block.Op == EOp::TypeStruct && members.size() == block.Operands.size() &&
+           std::all_of(members.begin(), members.end(), [](bool nonWritable) { return nonWritable; });
+}
+}
+
+ShaderReflection ShaderReflection::Reflect(std::span<const uint32_t> code)
+{
+    SpirvModule module(code);
+    ShaderReflection reflection{module.GetStage()};
+
+    for (const auto &variable : module.GetVariables())
+    {
+        const auto &pointer = module.GetType(variable.PointerType);
+        uint32_t typeId = pointer.Operands[1];
+        if (variable.StorageClass == EStorageClass::PushConstant)
+        {
+            // A module can only have a single push constant block
+            const auto &decorations = module.GetDecorations(typeId);
+            uint32_t offset = decorations.MemberOffsets.empty()
+                                  ? 0
+                                  : *std::min_element(decorations.MemberOffsets.begin(), decorations.MemberOffsets.end());
+            reflection.PushConstants =
+                VkPushConstantRange{reflection.Stage, offset, module.GetSize(typeId) - offset};
+            continue;
+        }
+        if (variable.StorageClass != EStorageClass::UniformConstant && variable.StorageClass != EStorageClass::Uniform &&
+            variable.StorageClass != EStorageClass::StorageBuffer)
+        {
+            continue;
+        }
+
+        const auto &decorations = module.GetDecorations(variable.Id);
+        if (!decorations.Binding.has_value())
+        {
+            continue;
+        }
+        uint32_t count = 1;
+        const auto &type = module.GetType(typeId);
+        if (type.Op == EOp::TypeArray)
+        {
+            count = module.GetConstant(type.Operands[1]);
+            typeId = type.Operands[0];
+        }
+        else if (type.Op == EOp::TypeRuntimeArray)
+        {
+            // Unbounded, which only the bindless set provides a layout for
+            count = 0;
+            typeId = type.Operands[0];
+        }
+
+        VkDescriptorSetLayoutBinding binding{};
+        binding.binding = *decorations.Binding;
+        binding.descriptorType = GetDescriptorType(module, variable.StorageClass, typeId);
+        binding.descriptorCount = count;
+        binding.stageFlags = reflection.Stage;
+        binding.pImmutableSamplers = nullptr;
+        bool readOnly = binding.descriptorType == VkDescriptorType::VK_DESCRIPTOR_TYPE_STORAGE_BUFFER &&
+                        IsNonWritable(module, variable.Id, typeId);
+        reflection.Bindings.emplace_back(ReflectedBinding{decorations.Set.value_or(0), binding, readOnly});
+    }
+    return reflection;
+}
+
+PipelineInterface PipelineInterface::Merge(std::span<const ShaderReflection> stages)
+{
+    PipelineInterface pipelineInterface;
+    std::optional<VkPushConstantRange> pushConstants;
+    // Storage buffers that any stage writes, by set
+    std::vector<std::vector<uint32_t>> writtenBindings;
+    for (const auto &stage : stages)
+    {
+        for (const auto &reflected : stage.Bindings)
+        {
+            if (pipelineInterface.Sets.size() <= reflected.Set)
+            {
+                pipelineInterface.Sets.resize(reflected.Set + 1);
+                writtenBindings.resize(reflected.Set + 1);
+            }
+            if (!reflected.ReadOnly)
+            {
+                writtenBindings[reflected.Set].emplace_back(reflected.Binding.binding);
+            }
+            auto &set = pipelineInterface.Sets[reflected.Set];
+            auto existing = std::find_if(set.begin(), set.end(), [&reflected](const VkDescriptorSetLayoutBinding &binding) {
+                return binding.binding == reflected.Binding.binding;
+            });
+            if (existing == set.end())
+            {
+                set.emplace_back(reflected.Binding);
+                continue;
+            }
+            if (existing->descriptorType != reflected.Binding.descriptorType ||
+                existing->descriptorCount != reflected.Binding.descriptorCount)
+            {
+                throw std::runtime_error("Shader stages declare the same binding differently");
+            }
+            existing->stageFlags |= reflected.Binding.stageFlags;
+        }
+
+        if (stage.PushConstants.has_value())
+        {
+            if (!pushConstants.has_value())
+            {
+                pushConstants = stage.PushConstants;
+                continue;
+            }
+            // Stages can only be part of a single range, so all stages share one range covering every block
+            uint32_t begin = std::min(pushConstants->offset, stage.PushConstants->offset);
+            uint32_t end = std::max(pushConstants->offset + pushConstants->size,
+                                    stage.PushConstants->offset + stage.PushConstants->size);
+            pushConstants = VkPushConstantRange{pushConstants->stageFlags | stage.PushConstants->stageFlags, begin,
+                                                end - begin};
+        }
+    }
+
+    pipelineInterface.ReadOnlyBindings.resize(pipelineInterface.Sets.size());
+    for (uint32_t setIndex = 0; setIndex < pipelineInterface.Sets.size(); setIndex++)
+    {
+        auto &set = pipelineInterface.Sets[setIndex];
+        std::sort(set.begin(), set.end(), [](const VkDescriptorSetLayoutBinding &lhs, const VkDescriptorSetLayoutBinding &rhs) {
+            return lhs.binding < rhs.binding;
+        });
+        const auto &written = writtenBindings[setIndex];
+        for (const auto &binding : set)
+        {
+            if (binding.descriptorType == VkDescriptorType::VK_DESCRIPTOR_TYPE_STORAGE_BUFFER &&
+                std::find(written.begin(), written.end(), binding.binding) == written.end())
+            {
+                pipelineInterface.ReadOnlyBindings[setIndex].emplace_back(binding.binding);
+            }
+        }
+    }
+    if (pushConstants.has_value())
+    {
+        pipelineInterface.PushConstantRanges.emplace_back(*pushConstants);
+    }
+    return pipelineInterface;
+}
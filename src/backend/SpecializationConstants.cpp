@@ -0,0 +1,38 @@
+#include <backend/SpecializationConstants.h>
+
+#include <algorithm>
+
+VkSpecializationInfo SpecializationConstants::GetInfo() const
+{
+    VkSpecializationInfo info{};
+    info.mapEntryCount = static_cast<uint32_t>(m_Entries.size());
+    info.pMapEntries = m_Entries.empty() ? nullptr : m_Entries.data();
+    info.dataSize = m_Data.size();
+    info.pData = m_Data.data();
+    return info;
+}
+
+void SpecializationConstants::AddToKey(StateKey &key) const
+{
+    key.Add(m_Entries.size());
+    for (const auto &entry : m_Entries)
+    {
+        key.Add(entry.constantID).Add(entry.offset).Add(entry.size);
+    }
+    // Only the mapped bytes, as the padding of the struct is unspecified
+    for (const auto &entry : m_Entries)
+    {
+        key.Add(std::string_view(m_Data.data() + entry.offset, entry.size));
+    }
+}
+
+SpecializationConstants &SpecializationConstants::Map(VkSpecializationMapEntry entry)
+{
+    assert(std::none_of(m_Entries.begin(), m_Entries.end(),
+                        [&entry](const VkSpecializationMapEntry &existing) {
+                            return existing.constantID == entry.constantID;
+                        }) &&
+           "Constant id is already mapped");
+    m_Entries.emplace_back(entry);
+    return *this;
+}
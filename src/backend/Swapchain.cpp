@@ -32,6 +32,7 @@ Swapchain::Swapchain(Swapchain &&other)
       m_OriginalCreateInfo(other.m_OriginalCreateInfo),
       m_Images(std::move(other.m_Images)),
       m_ImageViews(std::move(other.m_ImageViews)),
+      m_Textures(std::move(other.m_Textures)),
       m_CurrentImageIndex(std::move(other.m_CurrentImageIndex)),
       m_TargetPresentQueue(std::move(other.m_TargetPresentQueue)), 
       m_State(std::move(other.m_State))
@@ -78,17 +79,9 @@ VkAttachmentDescription Swapchain::AttachmentDescription() const
     return attachmentDescription;
 }
 
-SwapchainFramebuffer Swapchain::CreateFramebuffersFor(const RenderPass &renderPass, DepthAttachment* depthAttachment) const
+const Texture &Swapchain::GetCurrentTexture() const
 {
-    std::vector<Framebuffer> framebuffers;
-    framebuffers.reserve(m_ImageViews.size());
-    for (const auto& imageView : m_ImageViews) 
-    {
-        framebuffers.emplace_back(
-            Framebuffer(m_Device, FramebufferCreateInfo{renderPass, imageView, depthAttachment->GetView(), 
-                GetViewportDescription()}));
-    }
-    return SwapchainFramebuffer(*this, std::move(framebuffers), renderPass, depthAttachment);
+    return m_Textures[CurrentIndex()];
 }
 
 uint32_t Swapchain::CurrentIndex() const
@@ -137,31 +130,17 @@ SwapchainState Swapchain::Present(std::span<Semaphore> waitSempahores)
     return m_State;
 }
 
-void Swapchain::Recreate(std::vector<std::unique_ptr<SwapchainFramebuffer>>& oldFramebuffers, VkExtent2D newExtents)
+RetiredSwapchain Swapchain::Recreate(VkExtent2D newExtents)
 {
-    // TODO: This functionality is probably overkill. Framework should/can assume
-    // there's only a single render pass that ever renders to the final buffer.
-    // All other render passes should blit to intermediate images.
-    std::vector<const RenderPass *> renderPasses;
-    // TODO: There should only be one depth attachment here
-    std::vector<DepthAttachment*> depthAttachments;
-    renderPasses.reserve(oldFramebuffers.size());
-    depthAttachments.reserve(oldFramebuffers.size());
-    for (const auto &framebuffer : oldFramebuffers)
-    {
-        renderPasses.emplace_back(&framebuffer->GetRenderPass());
-        depthAttachments.emplace_back(framebuffer->GeDepthAttachment());
-    }
-    Destroy();
-    
+    auto oldSwapchain = std::exchange(m_Swapchain, VK_NULL_HANDLE);
+    auto oldImageViews = std::exchange(m_ImageViews, {});
+    m_Textures.clear();
+    m_Images.clear();
+
     // TODO: Maybe name this better or just implement this better altogether
     m_OriginalCreateInfo.Extents = newExtents;
-    Create(m_OriginalCreateInfo, m_Surface, m_Device, m_VulkanDevice, VK_NULL_HANDLE);
-
-    for (size_t i = 0; i < renderPasses.size(); i++) 
-    {
-        (*oldFramebuffers[i]) = CreateFramebuffersFor(*renderPasses[i], depthAttachments[i]);
-    }
+    Create(m_OriginalCreateInfo, m_Surface, m_Device, m_VulkanDevice, oldSwapchain);
+    return RetiredSwapchain(m_Device, oldSwapchain, std::move(oldImageViews));
 }
 
 SwapchainState Swapchain::GetCurrentState() const
@@ -220,6 +199,7 @@ void Swapchain::Create(const SwapchainCreateInfo &createInfo, const VkSurfaceKHR
     vkGetSwapchainImagesKHR(m_Device, m_Swapchain, &imageCount, images.data());
 
     m_ImageViews.reserve(images.size());
+    m_Textures.reserve(images.size());
     m_Images = std::move(images);
     for (auto &image : m_Images)
     {
@@ -243,6 +223,9 @@ void Swapchain::Create(const SwapchainCreateInfo &createInfo, const VkSurfaceKHR
             throw std::runtime_error("Could not create image view for swapchain image");
         }
         m_ImageViews.emplace_back(std::move(imageView));
+        m_Textures.emplace_back(m_Device, image, imageView,
+                                TextureCreateInfo{createInfo.Extents.width, createInfo.Extents.height,
+                                                  createInfo.SurfaceFormat.format, vkCreateInfo.imageUsage});
     }
 }
 
@@ -253,6 +236,7 @@ void Swapchain::Destroy()
 		vkDestroyImageView(m_Device, imageView, nullptr);
 	}
     m_ImageViews.clear();
+    m_Textures.clear();
     m_Images.clear();
     
 	vkDestroySwapchainKHR(m_Device, m_Swapchain, nullptr);
@@ -274,24 +258,25 @@ SwapchainState Swapchain::MapResultToState(VkResult result) const
     }
 }
 
-SwapchainFramebuffer::SwapchainFramebuffer(const Swapchain &swapchain, std::vector<Framebuffer> &&swapchainFramebuffers,
-                                           const RenderPass &renderPass, DepthAttachment *depthAttachment)
-    : m_Swapchain(swapchain), m_Framebuffers(std::move(swapchainFramebuffers)), m_Renderpass(renderPass),
-      m_DepthAttachment(depthAttachment)
-{
-}
-
-const Framebuffer &SwapchainFramebuffer::GetCurrent() const
+RetiredSwapchain::RetiredSwapchain(VkDevice device, VkSwapchainKHR swapchain, std::vector<VkImageView> &&imageViews)
+    : m_Device(device), m_Swapchain(swapchain), m_ImageViews(std::move(imageViews))
 {
-    return m_Framebuffers[m_Swapchain.get().CurrentIndex()];
 }
 
-const RenderPass &SwapchainFramebuffer::GetRenderPass() const
+RetiredSwapchain::RetiredSwapchain(RetiredSwapchain &&other)
+    : m_Device(other.m_Device), m_Swapchain(std::exchange(other.m_Swapchain, VK_NULL_HANDLE)),
+      m_ImageViews(std::exchange(other.m_ImageViews, {}))
 {
-    return m_Renderpass;
 }
 
-DepthAttachment *SwapchainFramebuffer::GeDepthAttachment() const
+RetiredSwapchain::~RetiredSwapchain()
 {
-    return m_DepthAttachment;
+    for (auto imageView : m_ImageViews)
+    {
+        vkDestroyImageView(m_Device, imageView, nullptr);
+    }
+    if (m_Swapchain != VK_NULL_HANDLE)
+    {
+        vkDestroySwapchainKHR(m_Device, m_Swapchain, nullptr);
+    }
 }
@@ -1,8 +1,10 @@
 #include <backend/Texture.h>
 
 #include <stdexcept>
+#include <cassert>
 
 #include <backend/PhysicalDevice.h>
+#include <backend/CommandBufferPool.h>
 
 constexpr std::array<VkFormat, 3> g_DepthFormats = {VkFormat::VK_FORMAT_D32_SFLOAT, VkFormat::VK_FORMAT_D32_SFLOAT_S8_UINT,
                                                  VkFormat::VK_FORMAT_D24_UNORM_S8_UINT};
@@ -16,11 +18,7 @@ bool HasStencilComponent(VkFormat format)
 
 VkImageAspectFlags GetMatchingAspectFlags(VkFormat format)
 {
-    if (format == VkFormat::VK_FORMAT_R8G8B8A8_SRGB)
-    {
-        return VkImageAspectFlagBits::VK_IMAGE_ASPECT_COLOR_BIT;
-    }
-    else if (std::find(g_DepthFormats.begin(), g_DepthFormats.end(), format) != g_DepthFormats.end())
+    if (std::find(g_DepthFormats.begin(), g_DepthFormats.end(), format) != g_DepthFormats.end())
     {
         if (HasStencilComponent(format))
         {
@@ -31,7 +29,7 @@ VkImageAspectFlags GetMatchingAspectFlags(VkFormat format)
             return VkImageAspectFlagBits::VK_IMAGE_ASPECT_DEPTH_BIT;
         }
     }
-    throw std::runtime_error("Unsupported format");
+    return VkImageAspectFlagBits::VK_IMAGE_ASPECT_COLOR_BIT;
 }
 
 VkImageUsageFlags GetMatchingUsageFlags(VkFormat format)
@@ -48,17 +46,6 @@ VkImageUsageFlags GetMatchingUsageFlags(VkFormat format)
     throw std::runtime_error("Unsupported format");
 }
 
-VkImageSubresourceRange GetSubResourceRange(VkFormat format)
-{
-    return VkImageSubresourceRange{
-        .aspectMask = GetMatchingAspectFlags(format),
-        .baseMipLevel = 0,
-        .levelCount = 1,
-        .baseArrayLayer = 0,
-        .layerCount = 1,
-    };
-}
-
 VkDeviceSize Texture2DCreateInfo::BufferSize() const
 {
 	// TODO: Fix size for varying channels
@@ -66,19 +53,38 @@ VkDeviceSize Texture2DCreateInfo::BufferSize() const
 }
 
 Texture::Texture(VkDevice device, const PhysicalDevice& physicalDevice, const TextureCreateInfo &createInfo) : 
+    Texture(device, createInfo)
+{
+    auto memoryRequirements = GetMemoryRequirements();
+    
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = memoryRequirements.size;
+    allocInfo.memoryTypeIndex = physicalDevice.FindMemoryType(
+        memoryRequirements.memoryTypeBits, VkMemoryPropertyFlagBits::VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    
+    if (vkAllocateMemory(device, &allocInfo, nullptr, &m_Memory) != VkResult::VK_SUCCESS)
+    {
+        throw std::runtime_error("Could not allocate texture memory");
+    }
+    vkBindImageMemory(m_Device, m_Image, m_Memory, 0);
+    CreateView();
+}
+
+Texture::Texture(VkDevice device, const TextureCreateInfo &createInfo) : 
     m_Device(device), m_Width(createInfo.Width), m_Height(createInfo.Height), m_Format(createInfo.Format)
 {
     VkImageCreateInfo vkCreateInfo{};
     vkCreateInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
     vkCreateInfo.imageType = VkImageType::VK_IMAGE_TYPE_2D;
     vkCreateInfo.extent = {createInfo.Width, createInfo.Height, 1};
-    vkCreateInfo.mipLevels = 1;
-    vkCreateInfo.arrayLayers = 1;
+    vkCreateInfo.mipLevels = m_MipLevels;
+    vkCreateInfo.arrayLayers = m_ArrayLayers;
 
     vkCreateInfo.format = createInfo.Format;
     vkCreateInfo.tiling = VkImageTiling::VK_IMAGE_TILING_OPTIMAL;
     vkCreateInfo.initialLayout = VkImageLayout::VK_IMAGE_LAYOUT_UNDEFINED;
-    vkCreateInfo.usage = GetMatchingUsageFlags(createInfo.Format);
+    vkCreateInfo.usage = createInfo.Usage != 0 ? createInfo.Usage : GetMatchingUsageFlags(createInfo.Format);
     vkCreateInfo.sharingMode = VkSharingMode::VK_SHARING_MODE_EXCLUSIVE;
     vkCreateInfo.samples = VkSampleCountFlagBits::VK_SAMPLE_COUNT_1_BIT;
 
@@ -86,33 +92,14 @@ Texture::Texture(VkDevice device, const PhysicalDevice& physicalDevice, const Te
     {
         throw std::runtime_error("Could not create iamge");
     }
+    m_SubresourceStates.resize(m_MipLevels * m_ArrayLayers);
+}
 
-    VkMemoryRequirements memoryRequirements;
-    vkGetImageMemoryRequirements(device, m_Image, &memoryRequirements);
-    
-    VkMemoryAllocateInfo allocInfo{};
-    allocInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = memoryRequirements.size;
-    allocInfo.memoryTypeIndex = physicalDevice.FindMemoryType(
-        memoryRequirements.memoryTypeBits, VkMemoryPropertyFlagBits::VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-    
-    if (vkAllocateMemory(device, &allocInfo, nullptr, &m_Memory) != VkResult::VK_SUCCESS)
-    {
-        throw std::runtime_error("Could not allocate texture memory");
-    }
-    BindMemory();
-
-    VkImageViewCreateInfo viewInfo{};
-    viewInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-    viewInfo.image = m_Image;
-    viewInfo.viewType = VkImageViewType::VK_IMAGE_VIEW_TYPE_2D;
-    viewInfo.format = createInfo.Format;
-    viewInfo.subresourceRange = GetSubResourceRange(createInfo.Format);
-
-    if (vkCreateImageView(device, &viewInfo, nullptr, &m_ImageView) != VkResult::VK_SUCCESS)
-    {
-        throw std::runtime_error("Failed to create texture image view");
-    }
+Texture::Texture(VkDevice device, VkImage image, VkImageView view, const TextureCreateInfo &createInfo)
+    : m_Device(device), m_Image(image), m_ImageView(view), m_OwnsImage(false), m_Width(createInfo.Width),
+      m_Height(createInfo.Height), m_Format(createInfo.Format)
+{
+    m_SubresourceStates.resize(m_MipLevels * m_ArrayLayers);
 }
 
 Texture::Texture(Texture &&other)
@@ -128,12 +115,17 @@ Texture &Texture::operator=(Texture &&other)
     }
     
     Destroy();
+    m_Device = other.m_Device;
     m_Image = std::exchange(other.m_Image, VK_NULL_HANDLE);
     m_Memory = std::exchange(other.m_Memory, VK_NULL_HANDLE);
     m_ImageView = std::exchange(other.m_ImageView, VK_NULL_HANDLE);
+    m_OwnsImage = other.m_OwnsImage;
     m_Width = other.m_Width;
     m_Height = other.m_Height;
     m_Format = other.m_Format;
+    m_MipLevels = other.m_MipLevels;
+    m_ArrayLayers = other.m_ArrayLayers;
+    m_SubresourceStates = std::move(other.m_SubresourceStates);
     return *this;
 }
 
@@ -144,7 +136,7 @@ Texture::~Texture()
 
 void Texture::Destroy()
 {
-    if (m_Image != VK_NULL_HANDLE)
+    if (m_Image != VK_NULL_HANDLE && m_OwnsImage)
     {
         vkDestroyImageView(m_Device, m_ImageView, nullptr);
         vkDestroyImage(m_Device, m_Image, nullptr);
@@ -172,101 +164,68 @@ VkImageView Texture::GetView() const
     return m_ImageView;
 }
 
-std::optional<ImageMemoryBarrier> Texture::TransitionLayout(VkImageLayout from, VkImageLayout to, CommandBuffer& commandBuffer, std::optional<Queue> destinationQueue)
+VkFormat Texture::GetFormat() const
 {
-    // Only handle transfer requests for post-upload QOT requests
-    // TODO: Properly handle other QOTs as well?
-    assert(destinationQueue.has_value() ^ !(from == VkImageLayout::VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL &&
-                                            to == VkImageLayout::VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL));
-    auto shouldTransfer = destinationQueue.has_value() && destinationQueue->RequiresTransfer(commandBuffer.GetQueue());
-    
-    auto queueSpecifier = shouldTransfer ? QueueSpecifier
-    {
-        .SourceQueue = commandBuffer.GetQueue(), .DestionationQueue = *destinationQueue
-    } : std::optional<QueueSpecifier>(std::nullopt);
-
-    auto barrier = ImageMemoryBarrier{*this,
-        queueSpecifier, 
-        0, 0, from, to, 
-        GetSubResourceRange(m_Format),
-        0, 0};
-    if (from == VkImageLayout::VK_IMAGE_LAYOUT_UNDEFINED && to == VkImageLayout::VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL)
-    {
-        barrier.Barrier.SourceAccessMask = 0;   
-        barrier.Barrier.DestinationAccessMask = VkAccessFlagBits::VK_ACCESS_TRANSFER_WRITE_BIT;
-        barrier.SourceStageMask = VkPipelineStageFlagBits::VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-        barrier.DestinationStageMask = VkPipelineStageFlagBits::VK_PIPELINE_STAGE_TRANSFER_BIT;
-    }
+    return m_Format;
+}
 
-    else if (from == VkImageLayout::VK_IMAGE_LAYOUT_UNDEFINED && to == VkImageLayout::VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL)
-    {
-        barrier.Barrier.SourceAccessMask = 0;
-        barrier.Barrier.DestinationAccessMask = VkAccessFlagBits::VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
-                                                VkAccessFlagBits::VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
-                                                VkAccessFlagBits::VK_ACCESS_MEMORY_READ_BIT |
-                                                VkAccessFlagBits::VK_ACCESS_MEMORY_WRITE_BIT;
-
-        barrier.SourceStageMask = VkPipelineStageFlagBits::VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-        barrier.DestinationStageMask = VkPipelineStageFlagBits::VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
-            VkPipelineStageFlagBits::VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-    }
-    else if (from == VkImageLayout::VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL &&
-             to == VkImageLayout::VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
-    {
-        barrier.Barrier.SourceAccessMask = VkAccessFlagBits::VK_ACCESS_TRANSFER_WRITE_BIT;
-        // We'll split the barrier if we transfer (and VK_ACCESS_SHADER_READ_BIT
-        // won't mean anything when performed on a dedicated transfer queue).
-        // Same for the pipeline stage.
-        // TODO: Allow for more granularity than general shader read?
-        barrier.Barrier.DestinationAccessMask = shouldTransfer ? 0 : VkAccessFlagBits::VK_ACCESS_SHADER_READ_BIT;
-        barrier.SourceStageMask = VkPipelineStageFlagBits::VK_PIPELINE_STAGE_TRANSFER_BIT;
-        // TODO: Be more general or allow specifying it?
-        barrier.DestinationStageMask = shouldTransfer ? VkPipelineStageFlagBits::VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT : 
-            // TODO: Allow reads in vertex/other shader stages?
-            VkPipelineStageFlagBits::VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VkPipelineStageFlagBits::VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
-    }
-    else
-    {
-        throw std::invalid_argument("Combination not supported");
-    }
+uint32_t Texture::GetMipLevels() const
+{
+    return m_MipLevels;
+}
 
-    commandBuffer.InsertBarrier(barrier);
+uint32_t Texture::GetArrayLayers() const
+{
+    return m_ArrayLayers;
+}
 
-    if (shouldTransfer)
-    {
-        ImageMemoryBarrier acquireBarrier
-        {
-            (*this), 
-            queueSpecifier, 
-            // TODO: Allow for more granularity than general shader read?
-            0, VkAccessFlagBits::VK_ACCESS_SHADER_READ_BIT,
-            // See vulkan spec 1.3 - 6.6.1: we need to re-specify the 
-            // layout transition parameters here, even though the transition
-            // already occurred during the release
-            from,
-            to, 
-            GetSubResourceRange(m_Format),
-			VkPipelineStageFlagBits::VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-            // TODO: Allow reads in vertex/other shader stages?
-			VkPipelineStageFlagBits::VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
-                                       VkPipelineStageFlagBits::VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT
-		};
-		return acquireBarrier;
-    }
-    else
-    {
-        return std::nullopt;
-    }
+VkImageSubresourceRange Texture::GetFullRange() const
+{
+    return VkImageSubresourceRange{
+        .aspectMask = GetMatchingAspectFlags(m_Format),
+        .baseMipLevel = 0,
+        .levelCount = m_MipLevels,
+        .baseArrayLayer = 0,
+        .layerCount = m_ArrayLayers,
+    };
 }
 
-VkFormat Texture::GetFormat() const
+ResourceState &Texture::GetState(uint32_t mipLevel, uint32_t arrayLayer) const
 {
-    return m_Format;
+    assert(mipLevel < m_MipLevels && arrayLayer < m_ArrayLayers && "Subresource out of range");
+    return m_SubresourceStates[mipLevel * m_ArrayLayers + arrayLayer];
 }
 
-void Texture::BindMemory()
+VkMemoryRequirements Texture::GetMemoryRequirements() const
 {
-    vkBindImageMemory(m_Device, m_Image, m_Memory, 0);
+    VkMemoryRequirements memoryRequirements;
+    vkGetImageMemoryRequirements(m_Device, m_Image, &memoryRequirements);
+    return memoryRequirements;
+}
+
+void Texture::BindMemory(VkDeviceMemory memory, VkDeviceSize offset)
+{
+    assert(m_Memory == VK_NULL_HANDLE && m_ImageView == VK_NULL_HANDLE && "Texture already has memory bound");
+    if (vkBindImageMemory(m_Device, m_Image, memory, offset) != VkResult::VK_SUCCESS)
+    {
+        throw std::runtime_error("Could not bind texture memory");
+    }
+    CreateView();
+}
+
+void Texture::CreateView()
+{
+    VkImageViewCreateInfo viewInfo{};
+    viewInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image = m_Image;
+    viewInfo.viewType = VkImageViewType::VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = m_Format;
+    viewInfo.subresourceRange = GetFullRange();
+
+    if (vkCreateImageView(m_Device, &viewInfo, nullptr, &m_ImageView) != VkResult::VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create texture image view");
+    }
 }
 
 VkDescriptorImageInfo Texture::GetDescriptorInfo() const
@@ -286,9 +245,7 @@ DepthAttachment::DepthAttachment(VkDevice device, const PhysicalDevice &physical
                 TextureCreateInfo{createInfo.Width, createInfo.Height, DetermineDepthFormat(physicalDevice)})
 {
     graphicsCommandBuffer.BeginSingleTake();
-    
-    m_Texture.TransitionLayout(VkImageLayout::VK_IMAGE_LAYOUT_UNDEFINED, VkImageLayout::VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, graphicsCommandBuffer,
-                               {});
+    graphicsCommandBuffer.RequireAccess(m_Texture, EResourceAccess::DepthStencilAttachment);
     m_PendingTransferFence = &graphicsCommandBuffer.End();
 }
 
@@ -316,6 +273,13 @@ VkImageView DepthAttachment::GetView()
     return m_Texture.GetView();
 }
 
+const Texture &DepthAttachment::GetTexture()
+{
+    // Same as the view, which waits for the transition
+    GetView();
+    return m_Texture;
+}
+
 VkFormat DepthAttachment::DetermineDepthFormat(const PhysicalDevice &physicalDevice)
 {
     VkFormat format = physicalDevice.FindFirstSupportedFormat(
@@ -337,22 +301,25 @@ Texture2D::Texture2D(VkDevice device, const PhysicalDevice &physicalDevice, cons
     m_StagingBuffer.UploadData(textureCreateInfo.Data);
 
     transferCommandBuffer.BeginSingleTake();
-    m_Texture.TransitionLayout(VkImageLayout::VK_IMAGE_LAYOUT_UNDEFINED, VkImageLayout::VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                     transferCommandBuffer,
-                     std::nullopt);
-    transferCommandBuffer.CopyBufferToImage(m_StagingBuffer, *this);
-
-    m_PendingAcquireBarrier = m_Texture.TransitionLayout(VkImageLayout::VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                     VkImageLayout::VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, transferCommandBuffer, destinationQueue);
+    transferCommandBuffer.CopyBufferToImage(m_StagingBuffer, m_Texture);
+    // TODO: Allow reads from compute as well
+    if (destinationQueue.RequiresTransfer(transferCommandBuffer.GetQueue()))
+    {
+        // The destination queue acquires the image on its first access
+        transferCommandBuffer.ReleaseOwnership(m_Texture, EResourceAccess::GraphicsShaderRead, destinationQueue);
+    }
+    else
+    {
+        transferCommandBuffer.RequireAccess(m_Texture, EResourceAccess::GraphicsShaderRead);
+    }
     m_PendingTransferFence = &transferCommandBuffer.End();
 }
 
 Texture2D::Texture2D(Texture2D && other) : 
     m_Device(other.m_Device), m_StagingBuffer(std::move(other.m_StagingBuffer)), 
     m_Texture(std::move(other.m_Texture)),
-    m_PendingAcquireBarrier(std::move(other.m_PendingAcquireBarrier)), 
     m_PendingTransferFence(std::move(other.m_PendingTransferFence)), 
-    m_Sampler(std::exchange(other.m_Sampler, VK_NULL_HANDLE))
+    m_Sampler(std::exchange(other.m_Sampler, VK_NULL_HANDLE)), m_BindlessIndex(other.m_BindlessIndex)
 {  
 }
 
@@ -361,9 +328,9 @@ Texture2D &Texture2D::operator=(Texture2D &&other)
     m_Device = other.m_Device;
     m_StagingBuffer = std::move(other.m_StagingBuffer);
     m_Texture = std::move(other.m_Texture);
-    m_PendingAcquireBarrier = std::move(other.m_PendingAcquireBarrier),
     m_PendingTransferFence = std::move(other.m_PendingTransferFence); 
     m_Sampler = std::exchange(other.m_Sampler, VK_NULL_HANDLE);
+    m_BindlessIndex = other.m_BindlessIndex;
     return *this;
 }
 
@@ -405,12 +372,27 @@ VkDescriptorImageInfo Texture2D::GetDescriptorInfo()
     return descriptorInfo;
 }
 
-std::optional<ImageMemoryBarrier> Texture2D::TakePendingAcquire()
+VkImageView Texture2D::GetView() const
+{
+    return m_Texture.GetView();
+}
+
+std::optional<uint32_t> Texture2D::GetBindlessIndex() const
+{
+    return m_BindlessIndex;
+}
+
+void Texture2D::SetBindlessIndex(uint32_t bindlessIndex)
+{
+    m_BindlessIndex = bindlessIndex;
+}
+
+Texture &Texture2D::GetTexture()
 {
-    // If the transfer hasn't completed, we'll be giving a barrier that may be set
-    // prior to the transfer (and its subsequent release barrier)
+    // Accesses from later recordings are assumed to be ordered after the upload, which is
+    // only true once its fence was waited on
     WaitTransfer();
-    return std::move(m_PendingAcquireBarrier);
+    return m_Texture;
 }
 
 VkSampler Texture2D::CreateTextureSampler(VkDevice device, const PhysicalDevice &physicalDevice)
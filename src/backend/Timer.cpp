@@ -37,8 +37,7 @@ Timer::~Timer()
 {
     if (m_CommandBuffer != VK_NULL_HANDLE)
     {
-        // Should not use anything else than bottom of pipe bit, results within passes
-        // are unreliable.
-        vkCmdWriteTimestamp(m_CommandBuffer, VkPipelineStageFlagBits::VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_TimerPool.get().GetQueryPool(), m_TimestampId.End);
+        // Also closes the scope's debug label and makes its parent the innermost scope again
+        m_TimerPool.get().EndScope(m_CommandBuffer, m_TimestampId);
     }
 }
@@ -1,51 +1,128 @@
 #include <backend/TimerPool.h>
 
+#include <algorithm>
+#include <cassert>
+#include <format>
 #include <stdexcept>
+#include <utility>
 
-#include <backend/TimerPool.h>
 #include <backend/PhysicalDevice.h>
+#include <backend/ExtensionFunctionMapping.h>
 
 constexpr uint16_t QueryCount = 4096;
 
-TimerPool::TimerPool(VkDevice device, const PhysicalDevice &physicalDevice)
-    : m_Device(device), m_TimerResolution(physicalDevice.GetProperties().limits.timestampPeriod)
+void ResolvedTimerPool::PrintTree(std::ostream &output) const
+{
+    for (const auto &scope : Scopes)
+    {
+        std::chrono::duration<double, std::milli> millis = scope.Duration;
+        output << std::format("{:{}}{}: {:.3f} ms\n", "", 2 * (scope.Depth + 1), scope.Name, millis.count());
+    }
+}
+
+TimerPool::TimerPool(VkDevice device, const PhysicalDevice &physicalDevice, uint32_t frameCount,
+                     const ExtensionFunctionMapping *functionMapping)
+    : m_Device(device), m_TimestampPeriod(physicalDevice.GetProperties().limits.timestampPeriod),
+      m_QueriesPerFrame(QueryCount / frameCount)
 {
-    m_ResultBuffer.resize(QueryCount);
+    if (functionMapping != nullptr)
+    {
+        m_BeginLabel = reinterpret_cast<PFN_vkCmdBeginDebugUtilsLabelEXT>(
+            functionMapping->GetFunction(EExtensionFunction::CmdBeginDebugUtilsLabel));
+        m_EndLabel = reinterpret_cast<PFN_vkCmdEndDebugUtilsLabelEXT>(
+            functionMapping->GetFunction(EExtensionFunction::CmdEndDebugUtilsLabel));
+    }
+    assert(frameCount > 0 && frameCount <= QueryCount / 2 && "Each frame needs room for at least one scope");
+    m_Frames.resize(frameCount, FrameQueries{m_QueriesPerFrame, {}});
+    m_ResultBuffer.resize(2 * m_QueriesPerFrame);
     VkQueryPoolCreateInfo query_pool_info{};
     query_pool_info.sType = VkStructureType::VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
     query_pool_info.queryType = VkQueryType::VK_QUERY_TYPE_TIMESTAMP;
-    query_pool_info.queryCount = QueryCount;
+    query_pool_info.queryCount = m_QueriesPerFrame * frameCount;
     if (vkCreateQueryPool(device, &query_pool_info, nullptr, &m_QueryPool) != VkResult::VK_SUCCESS)
     {
         throw std::runtime_error("Could not create query pool");
     }
 }
 
-TimerPool::TimerPool(TimerPool && other)
+TimerPool::TimerPool(TimerPool &&other) : m_QueryPool(VK_NULL_HANDLE)
 {
     *this = std::move(other);
 }
 
-TimerPool &TimerPool::operator=(TimerPool && other)
+TimerPool &TimerPool::operator=(TimerPool &&other)
 {
     if (this != &other)
     {
-        m_QueryPool = std::move(other.m_QueryPool);
+        if (m_QueryPool != VK_NULL_HANDLE)
+        {
+            vkDestroyQueryPool(m_Device, m_QueryPool, nullptr);
+        }
+        m_Device = other.m_Device;
+        m_QueryPool = std::exchange(other.m_QueryPool, VK_NULL_HANDLE);
+        m_TimestampPeriod = other.m_TimestampPeriod;
+        m_QueriesPerFrame = other.m_QueriesPerFrame;
+        m_Frames = std::move(other.m_Frames);
+        m_RecordedFrames = other.m_RecordedFrames;
+        m_ResolvedFrames = other.m_ResolvedFrames;
+        m_DroppedFrames = other.m_DroppedFrames;
+        m_OpenScopes = std::move(other.m_OpenScopes);
+        m_ScopeNames = std::move(other.m_ScopeNames);
+        m_ScopeIds = std::move(other.m_ScopeIds);
+        m_BeginLabel = other.m_BeginLabel;
+        m_EndLabel = other.m_EndLabel;
+        m_ResultBuffer = std::move(other.m_ResultBuffer);
     }
     return *this;
 }
 
 TimerPool::~TimerPool()
 {
-    vkDestroyQueryPool(m_Device, m_QueryPool, nullptr);
+    if (m_QueryPool != VK_NULL_HANDLE)
+    {
+        vkDestroyQueryPool(m_Device, m_QueryPool, nullptr);
+    }
+}
+
+Timer TimerPool::BeginScope(VkCommandBuffer commandBuffer, std::string_view name)
+{
+    assert(m_RecordedFrames > 0 && "The pool needs to be reset before the first scope");
+    auto &frame = m_Frames[(m_RecordedFrames - 1) % m_Frames.size()];
+    if (frame.UsedQueries + 2 > m_QueriesPerFrame)
+    {
+        throw std::runtime_error("Ran out of timestamp queries for the frame");
+    }
+    auto first = GetFirstQuery(m_RecordedFrames - 1) + frame.UsedQueries;
+    auto nameId = InternScopeName(name);
+    auto parent = m_OpenScopes.empty() ? std::nullopt : std::optional(m_OpenScopes.back());
+    m_OpenScopes.push_back(static_cast<uint32_t>(frame.Scopes.size()));
+    frame.Scopes.push_back(ScopeRecord{nameId, parent});
+    frame.UsedQueries += 2;
+    if (m_BeginLabel != nullptr)
+    {
+        auto label = VkDebugUtilsLabelEXT{.sType = VkStructureType::VK_STRUCTURE_TYPE_DEBUG_UTILS_LABEL_EXT,
+                                          .pNext = nullptr,
+                                          .pLabelName = m_ScopeNames[nameId]->c_str(),
+                                          .color = {0.0f, 0.0f, 0.0f, 0.0f}};
+        m_BeginLabel(commandBuffer, &label);
+    }
+    return Timer(commandBuffer, *this, TimestampId{first, first + 1});
 }
 
-Timer TimerPool::BeginScope(VkCommandBuffer commandBuffer, std::string name)
+void TimerPool::EndScope(VkCommandBuffer commandBuffer, TimestampId timestampId)
 {
-    TimestampId id{m_Counter, m_Counter + 1};
-    m_TimestampIdNames.push_back(name);
-    m_Counter += 2;
-    return Timer(commandBuffer, *this, id);
+    assert(!m_OpenScopes.empty() &&
+           GetFirstQuery(m_RecordedFrames - 1) + 2 * m_OpenScopes.back() == timestampId.Begin &&
+           "Scopes need to end in the reverse order they began");
+    // Should not use anything else than bottom of pipe bit, results within passes
+    // are unreliable.
+    vkCmdWriteTimestamp(commandBuffer, VkPipelineStageFlagBits::VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_QueryPool,
+                        timestampId.End);
+    if (m_EndLabel != nullptr)
+    {
+        m_EndLabel(commandBuffer);
+    }
+    m_OpenScopes.pop_back();
 }
 
 VkQueryPool TimerPool::GetQueryPool() const
@@ -55,38 +132,107 @@ VkQueryPool TimerPool::GetQueryPool() const
 
 void TimerPool::Reset(VkCommandBuffer commandBuffer)
 {
-    if (!m_TimestampIdNames.empty())
+    assert(m_OpenScopes.empty() && "All scopes of the previous frame need to end before the next one");
+    if (m_RecordedFrames - m_ResolvedFrames == m_Frames.size())
     {
-        throw std::runtime_error("Resetting TimerPool with unresolved timings");
+        // The oldest frame still wasn't available, its range is overwritten rather than waited on
+        m_ResolvedFrames++;
+        m_DroppedFrames++;
     }
-    vkCmdResetQueryPool(commandBuffer, m_QueryPool, 0, QueryCount);
+    auto &frame = m_Frames[m_RecordedFrames % m_Frames.size()];
+    // Only the queries written last time need to go back to the reset state, the rest of the range still is
+    if (frame.UsedQueries > 0)
+    {
+        vkCmdResetQueryPool(commandBuffer, m_QueryPool, GetFirstQuery(m_RecordedFrames), frame.UsedQueries);
+    }
+    frame.UsedQueries = 0;
+    frame.Scopes.clear();
+    m_RecordedFrames++;
 }
 
 ResolvedTimerPool TimerPool::Resolve()
 {
     ResolvedTimerPool resolvedTimings;
-    if (m_Counter)
+    if (m_ResolvedFrames == m_RecordedFrames)
     {
-        // TODO: Check if all timers were actually "ended", so that we don't try
-        // to resolve "end" timestamps that were actually never written as cmd to
-        // the command buffer.
-        vkGetQueryPoolResults(
-            m_Device, m_QueryPool, 0, m_Counter, sizeof(uint64_t) * m_Counter, m_ResultBuffer.data(), sizeof(uint64_t),
-            VkQueryResultFlagBits::VK_QUERY_RESULT_64_BIT | VkQueryResultFlagBits::VK_QUERY_RESULT_WAIT_BIT);
-
-        auto timestampIdNames = std::move(m_TimestampIdNames);
-        for (int i = 0; i < m_Counter; i += 2)
+        return resolvedTimings;
+    }
+    const auto &frame = m_Frames[m_ResolvedFrames % m_Frames.size()];
+    if (frame.UsedQueries > 0)
+    {
+        // Without the wait bit this returns `VK_NOT_READY` if any timestamp is unavailable. That includes scopes
+        // whose end was never recorded, which are then dropped once the ring wraps around
+        auto result = vkGetQueryPoolResults(
+            m_Device, m_QueryPool, GetFirstQuery(m_ResolvedFrames), frame.UsedQueries,
+            sizeof(uint64_t) * 2 * frame.UsedQueries, m_ResultBuffer.data(), sizeof(uint64_t) * 2,
+            VkQueryResultFlagBits::VK_QUERY_RESULT_64_BIT | VkQueryResultFlagBits::VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+        if (result == VkResult::VK_NOT_READY)
+        {
+            return resolvedTimings;
+        }
+        if (result != VkResult::VK_SUCCESS)
         {
-            // Divide by 2, since counter advances by 2 for every
-            // every timestamp for a begin and end timestamp.
-            std::string name = timestampIdNames[i / 2];
-            uint64_t nanos = (m_ResultBuffer[i + 1] - m_ResultBuffer[i]) * m_TimerResolution;
-            resolvedTimings.Timings[timestampIdNames[i / 2]] += std::chrono::nanoseconds(nanos);
+            throw std::runtime_error("Could not get query pool results");
         }
 
-        m_Counter = 0;
+        auto toNanoseconds = [this](uint64_t timestamp) {
+            return std::chrono::nanoseconds(static_cast<int64_t>(static_cast<double>(timestamp) * m_TimestampPeriod));
+        };
+        resolvedTimings.Scopes.reserve(frame.Scopes.size());
+        for (uint32_t i = 0; i < frame.Scopes.size(); i++)
+        {
+            // Each query is followed by its availability in the result buffer
+            auto begin = toNanoseconds(m_ResultBuffer[4 * i]);
+            auto end = toNanoseconds(m_ResultBuffer[4 * i + 2]);
+            const auto &record = frame.Scopes[i];
+            std::string_view name = *m_ScopeNames[record.NameId];
+            resolvedTimings.Timings[name] += end - begin;
+
+            uint32_t depth = 0;
+            if (record.Parent.has_value())
+            {
+                auto &parent = resolvedTimings.Scopes[*record.Parent];
+                parent.Children.push_back(i);
+                depth = parent.Depth + 1;
+            }
+            else
+            {
+                resolvedTimings.Roots.push_back(i);
+            }
+            resolvedTimings.Scopes.push_back(
+                ResolvedGpuScope{name, GpuTimeSpan{begin, end}, end - begin, record.Parent, depth, {}});
+
+            auto [span, inserted] = resolvedTimings.Spans.try_emplace(name, GpuTimeSpan{begin, end});
+            if (!inserted)
+            {
+                span->second.Begin = std::min(span->second.Begin, begin);
+                span->second.End = std::max(span->second.End, end);
+            }
+        }
     }
-    // TODO: Automatically invoke Reset here?
+    m_ResolvedFrames++;
     return resolvedTimings;
 }
 
+uint64_t TimerPool::GetDroppedFrameCount() const
+{
+    return m_DroppedFrames;
+}
+
+uint32_t TimerPool::GetFirstQuery(uint64_t frame) const
+{
+    return static_cast<uint32_t>(frame % m_Frames.size()) * m_QueriesPerFrame;
+}
+
+uint32_t TimerPool::InternScopeName(std::string_view name)
+{
+    auto id = m_ScopeIds.find(name);
+    if (id != m_ScopeIds.end())
+    {
+        return id->second;
+    }
+    auto newId = static_cast<uint32_t>(m_ScopeNames.size());
+    auto [inserted, _] = m_ScopeIds.emplace(name, newId);
+    m_ScopeNames.push_back(&inserted->first);
+    return newId;
+}
@@ -13,6 +13,11 @@ VkDescriptorBufferInfo UniformBuffer::GetDescriptorInfo() const
     return m_Buffer.GetDescriptorInfo();
 }
 
+const DeviceBuffer &UniformBuffer::GetBuffer() const
+{
+    return m_Buffer;
+}
+
 DeviceBuffer &UniformBuffer::CreateBuffer(VulkanDevice &vulkanDevice, size_t size)
 {
 	CreateBufferInfo bufferInfo;
@@ -1,7 +1,9 @@
 #include <backend/VulkanDevice.h>
 
 #include <cassert>
+#include <chrono>
 #include <condition_variable>
+#include <future>
 #include <iostream>
 #include <stdexcept>
 #include <thread>
@@ -23,6 +25,9 @@
 #include <backend/PhysicalDevice.h>
 #include <backend/IndexBuffer.h>
 
+// Relative to the working directory, like the shaders and assets
+const std::filesystem::path PIPELINE_CACHE_PATH = "pipeline_cache.bin";
+
 VkSurfaceFormatKHR VulkanDevice::SelectSurfaceFormat() const
 {
     auto surfaceProperties = m_PhysicalDevice.GetCachedSurfaceProperties();
@@ -77,22 +82,39 @@ DeviceBuffer& VulkanDevice::CreateBuffer(const CreateBufferInfo& createInfo)
     return *m_Buffers.emplace_back(std::make_unique<DeviceBuffer>(m_Device, m_PhysicalDevice, createInfo));
 }
 
+DynamicUniformBuffer &VulkanDevice::CreateDynamicUniformBuffer(const DynamicUniformBufferCreateInfo &createInfo)
+{
+    return *m_DynamicUniformBuffers.emplace_back(std::make_unique<DynamicUniformBuffer>(
+        *this, createInfo, m_PhysicalDevice.GetProperties().limits.minUniformBufferOffsetAlignment));
+}
+
 Texture2D &VulkanDevice::CreateTexture(const Texture2DCreateInfo &createInfo)
 {
     auto &commandBuffer = GetTransferCommandBuffer();
     // TODO: Embed texture name
     commandBuffer.SetName("Transfer Texture Command Buffer", GetExtensionFunctionMapping());
-    return *m_Textures.emplace_back(std::make_unique<Texture2D>(m_Device, m_PhysicalDevice, createInfo, commandBuffer, 
+    auto &texture = *m_Textures.emplace_back(std::make_unique<Texture2D>(m_Device, m_PhysicalDevice, createInfo, commandBuffer, 
         // TODO: Should also allow transferring to compute
         *m_GraphicsQueue));
+    if (m_BindlessTextures)
+    {
+        texture.SetBindlessIndex(m_BindlessTextures->RegisterTexture(texture.GetView()));
+    }
+    return texture;
+}
+
+Texture &VulkanDevice::CreateTexture(const TextureCreateInfo &createInfo)
+{
+    return *m_DeviceTextures.emplace_back(std::make_unique<Texture>(m_Device, m_PhysicalDevice, createInfo));
 }
 
 DepthAttachment &VulkanDevice::CreateSwapchainDepthAttachment()
 {
     assert(m_GraphicsQueue && "No suitable graphics queue");
 
-    DepthAttachmentCreateInfo createInfo{.Width = static_cast<uint32_t>(m_Swapchain->GetViewportDescription().Viewport.width),
-                                         .Height = static_cast<uint32_t>(m_Swapchain->GetViewportDescription().Viewport.height)};
+    auto viewport = GetSwapchainViewport();
+    DepthAttachmentCreateInfo createInfo{.Width = static_cast<uint32_t>(viewport.Viewport.width),
+                                         .Height = static_cast<uint32_t>(viewport.Viewport.height)};
     return *m_DepthAttachments.emplace_back(
         std::make_unique<DepthAttachment>(m_Device, m_PhysicalDevice, createInfo, 
             // TODO: Don't just assume first is good here
@@ -101,12 +123,23 @@ DepthAttachment &VulkanDevice::CreateSwapchainDepthAttachment()
 
 DescriptorSet VulkanDevice::CreateDescriptorSet(const DescriptorSetLayout& layout)
 {
-    return m_DescriptorPool->CreateDescriptorSet(layout);
+    return m_DescriptorAllocator->Allocate(layout);
+}
+
+std::vector<DescriptorSet> VulkanDevice::CreateDescriptorSets(const DescriptorSetLayout &layout, uint32_t count)
+{
+    return m_DescriptorAllocator->Allocate(layout, count);
 }
 
 const DescriptorSetLayout& VulkanDevice::CreateDescriptorSetLayout(DescriptorSetBuilder builder)
 {
-    return *m_DescriptorSetLayouts.emplace_back(std::make_unique<DescriptorSetLayout>(builder.Build(m_Device)));
+    return m_DescriptorSetLayouts.GetOrCreate(DescriptorSetLayout::GetStateKey(builder.GetBindings(), builder.GetReadOnlyBindings()),
+                                              [&]() { return builder.Build(m_Device); });
+}
+
+DescriptorAllocator &VulkanDevice::CreateDescriptorAllocator(const DescriptorAllocatorCreateInfo &createInfo)
+{
+    return *m_DescriptorAllocators.emplace_back(std::make_unique<DescriptorAllocator>(m_Device, createInfo));
 }
 
 void VulkanDevice::WaitForIdle() const
@@ -137,20 +170,52 @@ Swapchain &VulkanDevice::GetSwapchain()
     return *m_Swapchain;
 }
 
-void VulkanDevice::RecreateSwapchain(VkExtent2D newSize)
+OffscreenSwapchain &VulkanDevice::CreateOffscreenSwapchain(const OffscreenSwapchainCreateInfo &createInfo)
 {
-    // TODO: Remove this through proper syncing with old swapchain
-    WaitForIdle();
+    assert(!m_Swapchain.has_value() && "Device already renders to a window");
+    if (!SupportsDynamicRendering())
+    {
+        throw std::runtime_error("Rendering headless requires dynamic rendering");
+    }
+    return m_OffscreenSwapchain.emplace(m_Device, m_PhysicalDevice, createInfo, *m_GraphicsQueue);
+}
 
+bool VulkanDevice::IsHeadless() const
+{
+    return m_OffscreenSwapchain.has_value();
+}
+
+Viewport VulkanDevice::GetSwapchainViewport() const
+{
+    if (m_OffscreenSwapchain.has_value())
+    {
+        return m_OffscreenSwapchain->GetViewportDescription();
+    }
+    assert(m_Swapchain.has_value() && "No swapchain to render to");
+    return m_Swapchain->GetViewportDescription();
+}
+
+void VulkanDevice::RecreateSwapchain(VkExtent2D newSize)
+{
+    auto start = std::chrono::steady_clock::now();
+    // Frames in flight may still render to the old images and depth attachments, so instead of waiting for the
+    // device to idle, these are destroyed once the graphics work submitted up to now finished
+    auto pendingWork = m_GraphicsCommandBufferPool->GetPendingFences();
+    std::vector<DepthAttachment> retiredDepthAttachments;
+    retiredDepthAttachments.reserve(m_DepthAttachments.size());
     for (auto& depthAttachment : m_DepthAttachments)
     {
         DepthAttachmentCreateInfo createInfo{.Width = newSize.width, .Height = newSize.height};
 
+        retiredDepthAttachments.emplace_back(std::move(*depthAttachment));
         *depthAttachment = DepthAttachment{m_Device, m_PhysicalDevice, createInfo,
                                            // TODO: Don't just assume first is good here
                                            m_GraphicsCommandBufferPool->CreateCommandBuffer(*m_GraphicsQueue)};
     }
-    m_Swapchain->Recreate(m_SwapchainFramebuffers, newSize);
+    m_DeletionQueue.Push(pendingWork, m_Swapchain->Recreate(newSize));
+    m_DeletionQueue.Push(std::move(pendingWork), std::move(retiredDepthAttachments));
+    m_SwapchainGeneration++;
+    m_SwapchainRecreateTime += std::chrono::steady_clock::now() - start;
 }
 
 ShaderModule VulkanDevice::LoadShaderModule(const std::filesystem::path &filename)
@@ -158,27 +223,16 @@ ShaderModule VulkanDevice::LoadShaderModule(const std::filesystem::path &filenam
     return ShaderModule::LoadFromDisk(m_Device, filename);
 }
 
-RasterPipeline VulkanDevice::CreateRasterPipeline(RasterPipelineBuilder &&pipelineBuilder, const RenderPass& renderPass)
+const RasterPipeline &VulkanDevice::CreateRasterPipeline(RasterPipelineBuilder &&pipelineBuilder, const RenderPass& renderPass)
 {
-    auto fragmentShader = LoadShaderModule(pipelineBuilder.GetFragmentShaderPath());
-    auto vertexShader = LoadShaderModule(pipelineBuilder.GetVertexShaderPath());
-
-    VkPipelineShaderStageCreateInfo fragCreateInfo{};
-    fragCreateInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    fragCreateInfo.stage = VkShaderStageFlagBits::VK_SHADER_STAGE_FRAGMENT_BIT;
-    fragCreateInfo.module = fragmentShader.Get();
-    fragCreateInfo.pName = "main";
-    fragCreateInfo.pSpecializationInfo = nullptr;
-
-    VkPipelineShaderStageCreateInfo vertexCreateInfo{};
-    vertexCreateInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    vertexCreateInfo.stage = VkShaderStageFlagBits::VK_SHADER_STAGE_VERTEX_BIT;
-    vertexCreateInfo.module = vertexShader.Get();
-    vertexCreateInfo.pName = "main";
-    vertexCreateInfo.pSpecializationInfo = nullptr;
-
-    VkPipelineShaderStageCreateInfo stages[] = {fragCreateInfo, vertexCreateInfo};
+    return CreateRasterPipeline(std::move(pipelineBuilder), renderPass.GetRenderingLayout());
+}
 
+const RasterPipeline &VulkanDevice::CreateRasterPipeline(RasterPipelineBuilder &&pipelineBuilder,
+                                                         const RenderingLayout &rendering)
+{
+    assert((rendering.CompatibleRenderPass != nullptr || SupportsDynamicRendering()) &&
+           "Pipelines without a render pass need dynamic rendering");
     std::array<VkDynamicState, 2> dynamicStates = {
         VK_DYNAMIC_STATE_SCISSOR,
         VK_DYNAMIC_STATE_VIEWPORT,
@@ -189,27 +243,22 @@ RasterPipeline VulkanDevice::CreateRasterPipeline(RasterPipelineBuilder &&pipeli
     dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
     dynamicState.pDynamicStates = dynamicStates.data();
 
-    auto bindingDescription = pipelineBuilder.GetVertexBindingDescription();
-    VkPipelineVertexInputStateCreateInfo vertexInputCreateInfo = bindingDescription.has_value() ? bindingDescription->GetVkPipelineInputStateCreateInfo() 
-        : VertexBindingDescription::DefaultPipelineInputStateCreateInfo();
+    // Needs to outlive pipeline creation, as the create info points into it
+    auto vertexInputState = pipelineBuilder.GetVertexInputState();
+    VkPipelineVertexInputStateCreateInfo vertexInputCreateInfo = vertexInputState.GetVkPipelineInputStateCreateInfo();
 
     VkPipelineInputAssemblyStateCreateInfo inputAssemblyCreateInfo{};
     inputAssemblyCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
     inputAssemblyCreateInfo.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
     inputAssemblyCreateInfo.primitiveRestartEnable = VK_FALSE;
 
-    // TODO: Get framebuffer from pipeline builder, so that it's not 
-    // fixed to the currently active swapchain on this device.
-    assert(m_Swapchain.has_value());
-
-    Viewport viewport = m_Swapchain->GetViewportDescription();
-    
+    // Viewport and scissor are dynamic state, so pipelines don't depend on the size of the target they render to
     VkPipelineViewportStateCreateInfo viewportState{};
     viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
     viewportState.viewportCount = 1;
-    viewportState.pViewports = &viewport.Viewport;
+    viewportState.pViewports = nullptr;
     viewportState.scissorCount = 1;
-    viewportState.pScissors = &viewport.Scissor;
+    viewportState.pScissors = nullptr;
 
     VkPipelineRasterizationStateCreateInfo rasterizationState{};
     rasterizationState.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
@@ -270,8 +319,6 @@ RasterPipeline VulkanDevice::CreateRasterPipeline(RasterPipelineBuilder &&pipeli
 
     VkGraphicsPipelineCreateInfo pipelineInfo{};
     pipelineInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-    pipelineInfo.stageCount = 2;
-    pipelineInfo.pStages = stages;
     pipelineInfo.pVertexInputState = &vertexInputCreateInfo;
     pipelineInfo.pInputAssemblyState = &inputAssemblyCreateInfo;
     pipelineInfo.pViewportState = &viewportState;
@@ -284,21 +331,235 @@ RasterPipeline VulkanDevice::CreateRasterPipeline(RasterPipelineBuilder &&pipeli
     auto descriptorSetLayout = pipelineBuilder.GetDescriptorSetLayout();
     
     std::vector<VkDescriptorSetLayout> layouts{};
+    std::vector<VkPushConstantRange> pushConstantRanges = pipelineBuilder.GetPushConstantRanges();
     if (descriptorSetLayout.has_value())
     {
         layouts = {descriptorSetLayout->get().Get()};
     }
-    
-    auto createInfo = PipelineCreateInfo{pipelineInfo, layouts, renderPass};
-    // TODO: Manage here so that you cannot destory a pipeline before destroying its
-    // descriptor set (layout)
-    return RasterPipeline(m_Device, createInfo);
+    else
+    {
+        // Derived from the shaders instead
+        std::array shaderPaths = {pipelineBuilder.GetVertexShaderPath(), pipelineBuilder.GetFragmentShaderPath()};
+        auto pipelineInterface = ReflectShaders(shaderPaths);
+        layouts = CreateReflectedSetLayouts(pipelineInterface);
+        if (pushConstantRanges.empty())
+        {
+            pushConstantRanges = pipelineInterface.PushConstantRanges;
+        }
+    }
+    const auto &pipelineLayout = CreatePipelineLayout(layouts, pushConstantRanges);
+
+    // Identical pipelines are shared, which also skips loading the shaders
+    auto key = pipelineBuilder.GetStateKey(pipelineInfo, pipelineLayout, rendering);
+    return m_RasterPipelines.GetOrCreate(key, [&]() {
+        auto fragmentShader = LoadShaderModule(pipelineBuilder.GetFragmentShaderPath());
+        auto vertexShader = LoadShaderModule(pipelineBuilder.GetVertexShaderPath());
+
+        VkPipelineShaderStageCreateInfo fragCreateInfo{};
+        fragCreateInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        fragCreateInfo.stage = VkShaderStageFlagBits::VK_SHADER_STAGE_FRAGMENT_BIT;
+        fragCreateInfo.module = fragmentShader.Get();
+        fragCreateInfo.pName = "main";
+        const auto &fragmentSpecialization =
+            pipelineBuilder.GetSpecializationConstants(VkShaderStageFlagBits::VK_SHADER_STAGE_FRAGMENT_BIT);
+        auto fragmentSpecializationInfo = fragmentSpecialization ? fragmentSpecialization->GetInfo() : VkSpecializationInfo{};
+        fragCreateInfo.pSpecializationInfo = fragmentSpecialization ? &fragmentSpecializationInfo : nullptr;
+
+        VkPipelineShaderStageCreateInfo vertexCreateInfo{};
+        vertexCreateInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        vertexCreateInfo.stage = VkShaderStageFlagBits::VK_SHADER_STAGE_VERTEX_BIT;
+        vertexCreateInfo.module = vertexShader.Get();
+        vertexCreateInfo.pName = "main";
+        const auto &vertexSpecialization =
+            pipelineBuilder.GetSpecializationConstants(VkShaderStageFlagBits::VK_SHADER_STAGE_VERTEX_BIT);
+        auto vertexSpecializationInfo = vertexSpecialization ? vertexSpecialization->GetInfo() : VkSpecializationInfo{};
+        vertexCreateInfo.pSpecializationInfo = vertexSpecialization ? &vertexSpecializationInfo : nullptr;
+
+        VkPipelineShaderStageCreateInfo stages[] = {fragCreateInfo, vertexCreateInfo};
+        auto stagedPipelineInfo = pipelineInfo;
+        stagedPipelineInfo.stageCount = 2;
+        stagedPipelineInfo.pStages = stages;
+
+        auto createInfo = PipelineCreateInfo{stagedPipelineInfo, pipelineLayout, rendering, m_PipelineCache->Get()};
+        auto start = std::chrono::high_resolution_clock::now();
+        auto pipeline = RasterPipeline(m_Device, createInfo);
+        m_PipelineCache->RecordCreation(std::chrono::high_resolution_clock::now() - start);
+        return pipeline;
+    });
+}
+
+const DescriptorSetLayout &VulkanDevice::CreateReflectedDescriptorSetLayout(
+    std::span<const std::filesystem::path> shaderPaths, uint32_t set)
+{
+    return CreateReflectedDescriptorSetLayout(shaderPaths, {}, set);
+}
+
+const DescriptorSetLayout &VulkanDevice::CreateReflectedDescriptorSetLayout(
+    std::span<const std::filesystem::path> shaderPaths, std::span<const uint32_t> dynamicBindings, uint32_t set)
+{
+    auto pipelineInterface = ReflectShaders(shaderPaths);
+    DescriptorSetBuilder builder;
+    if (set < pipelineInterface.Sets.size())
+    {
+        const auto &readOnlyBindings = pipelineInterface.ReadOnlyBindings[set];
+        for (auto binding : pipelineInterface.Sets[set])
+        {
+            if (binding.descriptorCount == 0)
+            {
+                throw std::runtime_error("Unbounded descriptor arrays are only supported in the bindless set");
+            }
+            if (std::find(dynamicBindings.begin(), dynamicBindings.end(), binding.binding) != dynamicBindings.end())
+            {
+                assert(binding.descriptorType == VkDescriptorType::VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER &&
+                       "Only uniform buffers can be made dynamic");
+                binding.descriptorType = VkDescriptorType::VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+            }
+            builder.AddBinding(binding, std::find(readOnlyBindings.begin(), readOnlyBindings.end(), binding.binding) !=
+                                            readOnlyBindings.end());
+        }
+    }
+    return CreateDescriptorSetLayout(builder);
+}
+
+std::vector<VkDescriptorSetLayout> VulkanDevice::CreateReflectedSetLayouts(const PipelineInterface &pipelineInterface)
+{
+    std::vector<VkDescriptorSetLayout> layouts;
+    for (uint32_t set = 0; set < pipelineInterface.Sets.size(); set++)
+    {
+        if (set == BindlessSetIndex && m_BindlessTextures)
+        {
+            // Shaders only declare the arrays they sample, but the layout has to match the set bound at draw time
+            layouts.emplace_back(m_BindlessTextures->GetLayout().Get());
+            continue;
+        }
+        DescriptorSetBuilder builder;
+        const auto &readOnlyBindings = pipelineInterface.ReadOnlyBindings[set];
+        for (const auto &binding : pipelineInterface.Sets[set])
+        {
+            if (binding.descriptorCount == 0)
+            {
+                throw std::runtime_error("Unbounded descriptor arrays are only supported in the bindless set");
+            }
+            builder.AddBinding(binding, std::find(readOnlyBindings.begin(), readOnlyBindings.end(), binding.binding) !=
+                                            readOnlyBindings.end());
+        }
+        layouts.emplace_back(CreateDescriptorSetLayout(builder).Get());
+    }
+    return layouts;
+}
+
+PipelineInterface VulkanDevice::ReflectShaders(std::span<const std::filesystem::path> shaderPaths)
+{
+    std::vector<ShaderReflection> reflections;
+    for (const auto &path : shaderPaths)
+    {
+        StateKey key;
+        key.Add(path.string());
+        reflections.emplace_back(
+            m_ShaderReflections.GetOrCreate(key, [&]() { return LoadShaderModule(path).GetReflection(); }));
+    }
+    return PipelineInterface::Merge(reflections);
+}
+
+const PipelineLayout &VulkanDevice::CreatePipelineLayout(std::span<const VkDescriptorSetLayout> descriptorSetLayouts,
+                                                         std::span<const VkPushConstantRange> pushConstantRanges)
+{
+    StateKey key;
+    key.Add(descriptorSetLayouts.size());
+    for (auto layout : descriptorSetLayouts)
+    {
+        // Descriptor set layouts are shared, so the handle identifies the bindings
+        key.Add(layout);
+    }
+    for (const auto &range : pushConstantRanges)
+    {
+        key.Add(range.stageFlags).Add(range.offset).Add(range.size);
+    }
+    return m_PipelineLayouts.GetOrCreate(
+        key, [&]() { return PipelineLayout(m_Device, descriptorSetLayouts, pushConstantRanges); });
+}
+
+void VulkanDevice::ReportObjectCaches(std::ostream &stream) const
+{
+    ReportCacheStatistics(stream, "Raster pipelines", m_RasterPipelines.GetStatistics());
+    ReportCacheStatistics(stream, "Pipeline layouts", m_PipelineLayouts.GetStatistics());
+    ReportCacheStatistics(stream, "Descriptor set layouts", m_DescriptorSetLayouts.GetStatistics());
+    ReportCacheStatistics(stream, "Shader reflections", m_ShaderReflections.GetStatistics());
+    auto descriptorStatistics = m_DescriptorAllocator->GetStatistics();
+    stream << "Descriptor sets: " << descriptorStatistics.AllocatedSets << " in " << descriptorStatistics.PoolCount
+           << " pools, " << descriptorStatistics.AllocateCalls << " allocation calls\n";
+}
+
+PendingRasterPipeline VulkanDevice::CreateRasterPipelineAsync(RasterPipelineBuilder &&pipelineBuilder,
+                                                              RenderingLayout rendering)
+{
+    // Shared, as `std::function` has to be copyable
+    auto task = std::make_shared<std::packaged_task<const RasterPipeline *()>>(
+        [this, builder = std::move(pipelineBuilder), rendering = std::move(rendering)]() mutable {
+            return &CreateRasterPipeline(std::move(builder), rendering);
+        });
+    PendingRasterPipeline pipeline(task->get_future().share());
+    m_PipelineCompiler->Enqueue([task] { (*task)(); });
+    return pipeline;
+}
+
+ComputePipeline VulkanDevice::CreateComputePipeline(const std::filesystem::path &computeShaderPath)
+{
+    return CreateComputePipeline(ComputePipelineBuilder(std::filesystem::path(computeShaderPath)));
+}
+
+ComputePipeline VulkanDevice::CreateComputePipeline(const std::filesystem::path &computeShaderPath,
+                                                    const DescriptorSetLayout &descriptorSetLayout)
+{
+    auto builder = ComputePipelineBuilder(std::filesystem::path(computeShaderPath));
+    builder.SetDescriptorSetLayout(descriptorSetLayout);
+    return CreateComputePipeline(std::move(builder));
+}
+
+ComputePipeline VulkanDevice::CreateComputePipeline(ComputePipelineBuilder &&pipelineBuilder)
+{
+    auto descriptorSetLayout = pipelineBuilder.GetDescriptorSetLayout();
+    std::vector<VkDescriptorSetLayout> layouts{};
+    std::vector<VkPushConstantRange> pushConstantRanges = pipelineBuilder.GetPushConstantRanges();
+    if (descriptorSetLayout.has_value())
+    {
+        layouts = {descriptorSetLayout->get().Get()};
+    }
+    else
+    {
+        // Derived from the shader instead
+        std::array shaderPaths = {pipelineBuilder.GetComputeShaderPath()};
+        auto pipelineInterface = ReflectShaders(shaderPaths);
+        layouts = CreateReflectedSetLayouts(pipelineInterface);
+        if (pushConstantRanges.empty())
+        {
+            pushConstantRanges = pipelineInterface.PushConstantRanges;
+        }
+    }
+    const auto &pipelineLayout = CreatePipelineLayout(layouts, pushConstantRanges);
+
+    auto computeShader = LoadShaderModule(pipelineBuilder.GetComputeShaderPath());
+
+    VkPipelineShaderStageCreateInfo computeCreateInfo{};
+    computeCreateInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    computeCreateInfo.stage = VkShaderStageFlagBits::VK_SHADER_STAGE_COMPUTE_BIT;
+    computeCreateInfo.module = computeShader.Get();
+    computeCreateInfo.pName = "main";
+    const auto &specialization = pipelineBuilder.GetSpecializationConstants();
+    auto specializationInfo = specialization ? specialization->GetInfo() : VkSpecializationInfo{};
+    computeCreateInfo.pSpecializationInfo = specialization ? &specializationInfo : nullptr;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    auto pipeline =
+        ComputePipeline(m_Device, ComputePipelineCreateInfo{computeCreateInfo, pipelineLayout, m_PipelineCache->Get()});
+    m_PipelineCache->RecordCreation(std::chrono::high_resolution_clock::now() - start);
+    return pipeline;
 }
 
 VulkanDevice::VulkanDevice(PhysicalDevice &physicalDevice, VkPhysicalDevice physicalDeviceHandle,
                         const VulkanInstance& instance,
                         const std::vector<const char*> &validationLayers, std::vector<EDeviceExtension> extensions,
-                        const DeviceExtensionMapping &deviceExtensionMapping, GLFWwindow& window)
+                        const DeviceExtensionMapping &deviceExtensionMapping, GLFWwindow* window)
     : m_Instance(instance), m_PhysicalDevice(physicalDevice), m_Window(window)
 {
     assert(physicalDevice.IsValid() && "Need a valid physical device");
@@ -327,36 +588,136 @@ VulkanDevice::VulkanDevice(PhysicalDevice &physicalDevice, VkPhysicalDevice phys
 
     deviceCreateInfo.ppEnabledExtensionNames = extensionNames.data();
 
-    deviceCreateInfo.pEnabledFeatures = &physicalDevice.GetFeatures();
+    // Only enable the 1.2 features we actually use, the chain is left out entirely
+    // for devices that don't support 1.2
+    VkPhysicalDeviceVulkan12Features enabledVulkan12Features{};
+    enabledVulkan12Features.sType = VkStructureType::VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    enabledVulkan12Features.drawIndirectCount = physicalDevice.GetVulkan12Features().drawIndirectCount;
+    bool enableBindless = physicalDevice.SupportsBindless();
+    if (enableBindless)
+    {
+        enabledVulkan12Features.descriptorIndexing = VK_TRUE;
+        enabledVulkan12Features.runtimeDescriptorArray = VK_TRUE;
+        enabledVulkan12Features.descriptorBindingPartiallyBound = VK_TRUE;
+        enabledVulkan12Features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+        enabledVulkan12Features.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+    }
+
+    // Extension features are chained on their own, as older devices enable them without the 1.2 features
+    void *enabledExtensionFeatures = nullptr;
+    bool enableSynchronization2 =
+        std::find(extensions.begin(), extensions.end(), EDeviceExtension::Synchronization2) != extensions.end() &&
+        physicalDevice.SupportsSynchronization2();
+    VkPhysicalDeviceSynchronization2FeaturesKHR enabledSynchronization2Features{};
+    enabledSynchronization2Features.sType =
+        VkStructureType::VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR;
+    enabledSynchronization2Features.synchronization2 = VK_TRUE;
+    if (enableSynchronization2)
+    {
+        enabledSynchronization2Features.pNext = enabledExtensionFeatures;
+        enabledExtensionFeatures = &enabledSynchronization2Features;
+    }
+
+    bool enableDynamicRendering =
+        std::find(extensions.begin(), extensions.end(), EDeviceExtension::DynamicRendering) != extensions.end() &&
+        physicalDevice.SupportsDynamicRendering();
+    VkPhysicalDeviceDynamicRenderingFeaturesKHR enabledDynamicRenderingFeatures{};
+    enabledDynamicRenderingFeatures.sType =
+        VkStructureType::VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+    enabledDynamicRenderingFeatures.dynamicRendering = VK_TRUE;
+    if (enableDynamicRendering)
+    {
+        enabledDynamicRenderingFeatures.pNext = enabledExtensionFeatures;
+        enabledExtensionFeatures = &enabledDynamicRenderingFeatures;
+    }
+
+    VkPhysicalDeviceFeatures2 enabledFeatures{};
+    enabledFeatures.sType = VkStructureType::VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    enabledFeatures.features = physicalDevice.GetFeatures();
+    if (physicalDevice.GetProperties().apiVersion >= VK_API_VERSION_1_2)
+    {
+        enabledVulkan12Features.pNext = enabledExtensionFeatures;
+        enabledFeatures.pNext = &enabledVulkan12Features;
+        deviceCreateInfo.pNext = &enabledFeatures;
+        deviceCreateInfo.pEnabledFeatures = nullptr;
+    }
+    else
+    {
+        // The extension feature structures are valid directly on the create info
+        deviceCreateInfo.pNext = enabledExtensionFeatures;
+        deviceCreateInfo.pEnabledFeatures = &physicalDevice.GetFeatures();
+    }
 
     if (vkCreateDevice(physicalDeviceHandle, &deviceCreateInfo, nullptr, &m_Device) != VK_SUCCESS)
     {
         throw std::runtime_error("Could not create logical device");
     }
-    // Assertion: physical device has a graphics and present family queue
+    if (enableSynchronization2)
+    {
+        m_PipelineBarrier2 = reinterpret_cast<PFN_vkCmdPipelineBarrier2KHR>(
+            vkGetDeviceProcAddr(m_Device, "vkCmdPipelineBarrier2KHR"));
+    }
+    if (enableDynamicRendering)
+    {
+        m_DynamicRendering.BeginRendering = reinterpret_cast<PFN_vkCmdBeginRenderingKHR>(
+            vkGetDeviceProcAddr(m_Device, "vkCmdBeginRenderingKHR"));
+        m_DynamicRendering.EndRendering =
+            reinterpret_cast<PFN_vkCmdEndRenderingKHR>(vkGetDeviceProcAddr(m_Device, "vkCmdEndRenderingKHR"));
+    }
+    // Assertion: physical device has a graphics queue, and a present family queue unless headless
     m_GraphicsQueue = Queue(m_Device, physicalDevice.GetQueueFamilies().GraphicsFamilyIndex.value());
-    m_PresentQueue = Queue(m_Device, physicalDevice.GetQueueFamilies().PresentFamilyIndex.value());
+    if (physicalDevice.GetQueueFamilies().PresentFamilyIndex.has_value())
+    {
+        m_PresentQueue = Queue(m_Device, physicalDevice.GetQueueFamilies().PresentFamilyIndex.value());
+    }
 
     // Possibly redundant creation if it's shared with the graphics queue
     m_TransferQueue = Queue(m_Device, physicalDevice.GetQueueFamilies().TransferFamilyIndex.value());
+    m_ComputeQueue = Queue(m_Device, physicalDevice.GetQueueFamilies().ComputeFamilyIndex.value());
     
     m_GraphicsCommandBufferPool = std::make_unique<CommandBufferPool>(CreateGraphicsCommandBufferPool());
     m_TransferCommandBufferPool = std::make_unique<CommandBufferPool>(CreateTransferCommandBufferPool());
-    m_DescriptorPool = std::make_unique<DescriptorPool>(
-        // Arbitrary size
-        m_Device, DescriptorPoolCreateInfo{64, {VkDescriptorType::VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VkDescriptorType::VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER}});
+    m_ComputeCommandBufferPool = std::make_unique<CommandBufferPool>(CreateComputeCommandBufferPool());
+    m_PipelineCache = std::make_unique<PipelineCache>(m_Device, physicalDevice, PIPELINE_CACHE_PATH);
+    m_PipelineCompiler = std::make_unique<PipelineCompiler>();
+    m_DescriptorAllocator = std::make_unique<DescriptorAllocator>(m_Device, DescriptorAllocatorCreateInfo{});
+    if (enableBindless)
+    {
+        // The limits count every sampled image a pipeline layout can access, so leave room for the other sets
+        constexpr uint32_t OtherSetsReserve = 16;
+        const auto &limits = physicalDevice.GetVulkan12Properties();
+        BindlessTextureTableCreateInfo createInfo{.MaxAnisotropy = physicalDevice.GetProperties().limits.maxSamplerAnisotropy};
+        createInfo.MaxTextures = std::min({createInfo.MaxTextures, limits.maxDescriptorSetUpdateAfterBindSampledImages,
+                                           limits.maxPerStageDescriptorUpdateAfterBindSampledImages - OtherSetsReserve});
+        createInfo.MaxSamplers = std::min({createInfo.MaxSamplers, limits.maxDescriptorSetUpdateAfterBindSamplers,
+                                           limits.maxPerStageDescriptorUpdateAfterBindSamplers - OtherSetsReserve});
+        m_BindlessTextures = std::make_unique<BindlessTextureTable>(m_Device, createInfo);
+    }
 }
 
 VulkanDevice::VulkanDevice(VulkanDevice &&other)
     : m_Device(std::exchange(other.m_Device, VK_NULL_HANDLE)), m_PhysicalDevice(other.m_PhysicalDevice),
       m_GraphicsQueue(other.m_GraphicsQueue), m_PresentQueue(other.m_PresentQueue),
-      m_TransferQueue(other.m_TransferQueue),
+      m_TransferQueue(other.m_TransferQueue), m_ComputeQueue(other.m_ComputeQueue),
+      m_PipelineBarrier2(other.m_PipelineBarrier2), m_DynamicRendering(other.m_DynamicRendering),
+      m_PipelineCache(std::move(other.m_PipelineCache)),
+      m_PipelineCompiler(std::move(other.m_PipelineCompiler)),
       m_Swapchain(std::move(other.m_Swapchain)), 
+      m_OffscreenSwapchain(std::move(other.m_OffscreenSwapchain)),
       m_GraphicsCommandBufferPool(std::move(other.m_GraphicsCommandBufferPool)),
       m_TransferCommandBufferPool(std::move(other.m_TransferCommandBufferPool)),
+      m_ComputeCommandBufferPool(std::move(other.m_ComputeCommandBufferPool)),
       m_Semaphores(std::move(other.m_Semaphores)),
-      m_SwapchainFramebuffers(std::move(other.m_SwapchainFramebuffers)), m_Window(other.m_Window),
-      m_DescriptorPool(std::move(other.m_DescriptorPool)),
+      m_Window(other.m_Window),
+      m_DescriptorAllocator(std::move(other.m_DescriptorAllocator)),
+      m_DescriptorAllocators(std::move(other.m_DescriptorAllocators)),
+      m_BindlessTextures(std::move(other.m_BindlessTextures)),
+      m_SwapchainGeneration(other.m_SwapchainGeneration), m_SwapchainRecreateTime(other.m_SwapchainRecreateTime),
+      m_DescriptorSetLayouts(std::move(other.m_DescriptorSetLayouts)),
+      m_PipelineLayouts(std::move(other.m_PipelineLayouts)),
+      m_RasterPipelines(std::move(other.m_RasterPipelines)),
+      m_ShaderReflections(std::move(other.m_ShaderReflections)),
+      m_DeletionQueue(std::move(other.m_DeletionQueue)),
       m_Instance(other.m_Instance)
 {
 }
@@ -379,22 +740,41 @@ VulkanDevice::~VulkanDevice()
         m_PresentQueue->Wait();
     }
 
-    m_DescriptorSetLayouts.clear();
+    // Finishes compilations in progress, before anything they use is destroyed
+    m_PipelineCompiler.reset();
+    m_RasterPipelines.Clear();
+    m_PipelineLayouts.Clear();
+    m_DescriptorSetLayouts.Clear();
+
+    try
+    {
+        m_PipelineCache->Save();
+    }
+    catch (const std::exception &exception)
+    {
+        // Not fatal, the next launch just compiles all pipelines again
+        std::cout << "Could not save pipeline cache: " << exception.what() << "\n";
+    }
+    m_PipelineCache.reset();
    
-    m_DescriptorPool.reset();
+    m_BindlessTextures.reset();
+    m_DescriptorAllocator.reset();
+    m_DescriptorAllocators.clear();
     // Explicitly order destruction of vulkan objects
-    // Prior to swapchain destruction, since framebuffers may be 
-    // to swapchain images
-    m_SwapchainFramebuffers.clear();
-
+    // Retired swapchains are destroyed before the current one, while the fences of the command buffers that
+    // used them still exist
+    m_DeletionQueue.Flush();
     m_Swapchain.reset();
+    m_OffscreenSwapchain.reset();
     m_GraphicsCommandBufferPool.reset();
     m_TransferCommandBufferPool.reset();
+    m_ComputeCommandBufferPool.reset();
     m_Semaphores.clear();
     m_VertexBuffers.clear();
     m_IndexBuffers.clear();
     m_Buffers.clear();
     m_Textures.clear();
+    m_DeviceTextures.clear();
 
     std::condition_variable destroyed;
     std::mutex destroyMutex;
@@ -418,20 +798,50 @@ VulkanDevice::~VulkanDevice()
     vkDestroyDevice(m_Device, nullptr);
 }
 
-RenderPass VulkanDevice::CreateRenderPass(DepthAttachment& depthAttachment)
+bool VulkanDevice::SupportsDynamicRendering() const
 {
-    // TODO: Don't always bind this to the swapchain
-    assert(m_Swapchain.has_value());
-    auto attachmentDescription = m_Swapchain->AttachmentDescription();
-    
-    return RenderPass(m_Device,
-                      RenderPassCreateInfo{attachmentDescription, depthAttachment.GetAttachmentDescription()});
+    return m_DynamicRendering.BeginRendering != nullptr;
+}
+
+bool VulkanDevice::SupportsBindless() const
+{
+    return m_BindlessTextures != nullptr;
 }
 
-const SwapchainFramebuffer& VulkanDevice::CreateSwapchainFramebuffers(const RenderPass &renderpass, DepthAttachment *depthAttachment)
+BindlessTextureTable &VulkanDevice::GetBindlessTextures()
 {
-    assert(m_Swapchain.has_value() && "No swapchain to create framebuffers for");
-    return *m_SwapchainFramebuffers.emplace_back(std::make_unique<SwapchainFramebuffer>(m_Swapchain->CreateFramebuffersFor(renderpass, depthAttachment)));
+    assert(m_BindlessTextures && "Bindless textures are not supported");
+    return *m_BindlessTextures;
+}
+
+RenderingLayout VulkanDevice::GetSwapchainRenderingLayout(const DepthAttachment *depthAttachment) const
+{
+    assert((m_Swapchain.has_value() || m_OffscreenSwapchain.has_value()) && "No swapchain to render to");
+    RenderingLayout layout;
+    layout.ColorFormats = {m_OffscreenSwapchain.has_value() ? m_OffscreenSwapchain->GetFormat()
+                                                            : m_Swapchain->AttachmentDescription().format};
+    if (depthAttachment != nullptr)
+    {
+        layout.DepthFormat = depthAttachment->GetAttachmentDescription().format;
+    }
+    return layout;
+}
+
+const Texture &VulkanDevice::GetSwapchainTexture() const
+{
+    assert((m_Swapchain.has_value() || m_OffscreenSwapchain.has_value()) && "No swapchain to render to");
+    return m_OffscreenSwapchain.has_value() ? m_OffscreenSwapchain->GetCurrentTexture()
+                                            : m_Swapchain->GetCurrentTexture();
+}
+
+uint64_t VulkanDevice::GetSwapchainGeneration() const
+{
+    return m_SwapchainGeneration;
+}
+
+std::chrono::nanoseconds VulkanDevice::TakeSwapchainRecreateTime()
+{
+    return std::exchange(m_SwapchainRecreateTime, std::chrono::nanoseconds{0});
 }
 
 CommandBufferPool VulkanDevice::CreateGraphicsCommandBufferPool()
@@ -441,7 +851,8 @@ CommandBufferPool VulkanDevice::CreateGraphicsCommandBufferPool()
            "No graphics family queue to create command buffer pool for");
 
     CommandBufferPoolCreateInfo createInfo{VkCommandPoolCreateFlagBits::VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
-                                           familyIndices.GraphicsFamilyIndex.value()};
+                                           familyIndices.GraphicsFamilyIndex.value(), m_PipelineBarrier2,
+                                           m_DynamicRendering};
     auto commandBufferPool = CommandBufferPool{m_Device, createInfo, m_Instance};
     commandBufferPool.SetName("Graphics CMD Buffer Pool", m_Instance.GetExtensionFunctionMapping());
     return commandBufferPool;
@@ -454,13 +865,29 @@ CommandBufferPool VulkanDevice::CreateTransferCommandBufferPool() const
            "No graphics family queue to create command buffer pool for");
 
     CommandBufferPoolCreateInfo createInfo{VkCommandPoolCreateFlagBits::VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
-                                           familyIndices.TransferFamilyIndex.value()};
+                                           familyIndices.TransferFamilyIndex.value(), m_PipelineBarrier2,
+                                           m_DynamicRendering};
 
     auto commandBufferPool = CommandBufferPool(m_Device, createInfo, m_Instance);
     commandBufferPool.SetName("Transfer CMD Buffer Pool", m_Instance.GetExtensionFunctionMapping());
     return commandBufferPool;
 }
 
+CommandBufferPool VulkanDevice::CreateComputeCommandBufferPool() const
+{
+    auto familyIndices = m_PhysicalDevice.GetQueueFamilies();
+    assert(familyIndices.ComputeFamilyIndex.has_value() &&
+           "No compute family queue to create command buffer pool for");
+
+    CommandBufferPoolCreateInfo createInfo{VkCommandPoolCreateFlagBits::VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+                                           familyIndices.ComputeFamilyIndex.value(), m_PipelineBarrier2,
+                                           m_DynamicRendering};
+
+    auto commandBufferPool = CommandBufferPool(m_Device, createInfo, m_Instance);
+    commandBufferPool.SetName("Compute CMD Buffer Pool", m_Instance.GetExtensionFunctionMapping());
+    return commandBufferPool;
+}
+
 CommandBuffer &VulkanDevice::GetTransferCommandBuffer()
 {
     // TODO: Cache most recent?
@@ -472,6 +899,11 @@ CommandBufferPool &VulkanDevice::GetGraphicsCommandBufferPool()
     return *m_GraphicsCommandBufferPool;
 }
 
+CommandBufferPool &VulkanDevice::GetComputeCommandBufferPool()
+{
+    return *m_ComputeCommandBufferPool;
+}
+
 Semaphore &VulkanDevice::CreateDeviceSemaphore()
 {
     return *m_Semaphores.emplace_back(std::make_unique<Semaphore>(m_Device));
@@ -489,13 +921,46 @@ Queue VulkanDevice::GetTransferQueue() const
     return m_TransferQueue.value();
 }
 
-TimerPool &VulkanDevice::CreateTimerPool()
+Queue VulkanDevice::GetComputeQueue() const
+{
+    assert(m_ComputeQueue.has_value() && "Device has no compute queue");
+    return m_ComputeQueue.value();
+}
+
+const PhysicalDevice &VulkanDevice::GetPhysicalDevice() const
+{
+    return m_PhysicalDevice;
+}
+
+TimerPool &VulkanDevice::CreateTimerPool(uint32_t frameCount)
+{
+    return *m_TimerPools.emplace_back(std::make_unique<TimerPool>(m_Device, m_PhysicalDevice, frameCount,
+                                                                  &m_Instance.GetExtensionFunctionMapping()));
+}
+
+const PipelineCache &VulkanDevice::GetPipelineCache() const
+{
+    return *m_PipelineCache;
+}
+
+void VulkanDevice::SavePipelineCache() const
 {
-    return *m_TimerPools.emplace_back(std::make_unique<TimerPool>(m_Device, m_PhysicalDevice));
+    m_PipelineCache->Save();
+}
+
+RenderGraph VulkanDevice::CreateRenderGraph()
+{
+    return RenderGraph(m_Device, m_PhysicalDevice, *m_GraphicsCommandBufferPool, SupportsDynamicRendering());
 }
 
 void VulkanDevice::AcquireNext(const Semaphore& toSignal)
 {
+    m_DeletionQueue.Collect();
+    if (m_OffscreenSwapchain.has_value())
+    {
+        m_OffscreenSwapchain->AcquireNext(toSignal);
+        return;
+    }
     // TODO: Ensure semaphores in correct state, or more properly,
     // that we cannot have a recording cmd buffer at this time
     if (m_LastUnhandledResize)
@@ -508,17 +973,22 @@ void VulkanDevice::AcquireNext(const Semaphore& toSignal)
     // as well when AcquireNext does
     while (m_Swapchain->AcquireNext(toSignal) == SwapchainState::OutOfDate)
     {
-        RecreateSwapchain(SelectSwapchainExtent(m_Window, m_PhysicalDevice.QuerySurfaceProperties()));
+        RecreateSwapchain(SelectSwapchainExtent(*m_Window, m_PhysicalDevice.QuerySurfaceProperties()));
     }
 }
 
 void VulkanDevice::Present(std::span<Semaphore> waitSemaphores)
 {
+    if (m_OffscreenSwapchain.has_value())
+    {
+        m_OffscreenSwapchain->Present(waitSemaphores);
+        return;
+    }
     assert(m_Swapchain.has_value());
     if (m_Swapchain->Present(waitSemaphores) != SwapchainState::Optimal)
     {
         std::cout << "Present recreate\n";
-        RecreateSwapchain(SelectSwapchainExtent(m_Window, m_PhysicalDevice.QuerySurfaceProperties()));
+        RecreateSwapchain(SelectSwapchainExtent(*m_Window, m_PhysicalDevice.QuerySurfaceProperties()));
     }
 }
 
@@ -565,5 +1035,11 @@ std::vector<VkDeviceQueueCreateInfo> VulkanDevice::GetQueueCreateInfos(const Phy
 
 std::set<uint32_t> QueueFamilyIndices::GetUniqueQueues() const
 {
-    return {GraphicsFamilyIndex.value(), PresentFamilyIndex.value(), ComputeFamilyIndex.value(), TransferFamilyIndex.value()};
+    std::set<uint32_t> queues = {GraphicsFamilyIndex.value(), ComputeFamilyIndex.value(), TransferFamilyIndex.value()};
+    // No present queue when headless
+    if (PresentFamilyIndex.has_value())
+    {
+        queues.insert(PresentFamilyIndex.value());
+    }
+    return queues;
 }
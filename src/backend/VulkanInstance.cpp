@@ -1,12 +1,16 @@
+#ifdef _WIN32
 #define VK_USE_PLATFORM_WIN32_KHR
-#define GLFW_INCLUDE_VULKAN
 #define GLFW_EXPOSE_NATIVE_WIN32
+#endif
+#define GLFW_INCLUDE_VULKAN
 #include <backend/VulkanInstance.h>
 
 #include <GLFW/glfw3.h>
+#ifdef _WIN32
 #include <GLFW/glfw3native.h>
+#endif
+#include <bit>
 #include <condition_variable>
-#include <immintrin.h>
 #include <iostream>
 #include <set>
 #include <stdexcept>
@@ -22,7 +26,7 @@
 std::vector<const char*> ValidationLayer::GetLayerNames() const
 {
     std::vector<const char*> names;
-    names.reserve(_mm_popcnt_u32((uint32_t)Layers));
+    names.reserve(std::popcount((uint32_t)Layers));
     for (EValidationLayer availableLayer : AvailableValidationLayers())
     {
         if (((uint32_t)availableLayer & (uint32_t)Layers) == (uint32_t)availableLayer)
@@ -43,18 +47,24 @@ const uint32_t Version::ToVulkanVersion() const
 }
 
 VulkanInstance::VulkanInstance(const InstanceCreateInfo &createInfo, GLFWwindow &window)
-    : m_VkInstance(CreateInstance(createInfo)), m_ExtensionMapper(ExtensionFunctionMapping(m_VkInstance))
+    : m_VkInstance(CreateInstance(createInfo, true)), m_ExtensionMapper(ExtensionFunctionMapping(m_VkInstance))
 {
     m_VulkanDebugMessenger.ScopeBegin(m_VkInstance, m_ExtensionMapper);
 
     m_Surface.ScopeBegin(m_VkInstance, window);
-    m_ActivePhysicalDevice.ScopeBegin(CreatePhysicalDevice(*m_Surface, std::span{createInfo.RequiredExtensions}));
-
-    m_ActiveDevice.ScopeBegin(
-        m_ActivePhysicalDevice->CreateLogicalDevice(m_ValidationLayers, createInfo.RequiredExtensions, window, *this));
+    CreateDevice(createInfo, &window);
     m_ActiveDevice->CreateSwapchain(window, *m_Surface);
 }
 
+VulkanInstance::VulkanInstance(const InstanceCreateInfo &createInfo, const OffscreenSwapchainCreateInfo &offscreenTarget)
+    : m_VkInstance(CreateInstance(createInfo, false)), m_ExtensionMapper(ExtensionFunctionMapping(m_VkInstance))
+{
+    m_VulkanDebugMessenger.ScopeBegin(m_VkInstance, m_ExtensionMapper);
+
+    CreateDevice(createInfo, nullptr);
+    m_ActiveDevice->CreateOffscreenSwapchain(offscreenTarget);
+}
+
 VulkanInstance::~VulkanInstance()
 {
     if (m_VkInstance != VK_NULL_HANDLE)
@@ -62,7 +72,10 @@ VulkanInstance::~VulkanInstance()
         m_VulkanDebugMessenger.ScopeEnd();
         m_ActiveDevice.ScopeEnd();
         m_ActivePhysicalDevice.ScopeEnd();
-        m_Surface.ScopeEnd();
+        if (m_HasSurface)
+        {
+            m_Surface.ScopeEnd();
+        }
         vkDestroyInstance(m_VkInstance, nullptr);
     }
 }
@@ -73,10 +86,26 @@ VulkanInstance::VulkanInstance(VulkanInstance &&other)
       m_DeviceExtensionMapper(std::move(other.m_DeviceExtensionMapper)),
       m_VulkanDebugMessenger(std::move(other.m_VulkanDebugMessenger)), m_Surface(std::move(other.m_Surface)),
       m_ActivePhysicalDevice(std::move(other.m_ActivePhysicalDevice)), m_ActiveDevice(std::move(other.m_ActiveDevice)),
-      m_ValidationLayers(std::move(other.m_ValidationLayers))
+      m_ValidationLayers(std::move(other.m_ValidationLayers)), m_HasSurface(other.m_HasSurface)
 {
 }
 
+void VulkanInstance::CreateDevice(const InstanceCreateInfo &createInfo, GLFWwindow *window)
+{
+    std::optional<std::reference_wrapper<const VulkanSurface>> surface;
+    if (window != nullptr)
+    {
+        surface = *m_Surface;
+    }
+    m_ActivePhysicalDevice.ScopeBegin(CreatePhysicalDevice(surface, std::span{createInfo.RequiredExtensions}));
+
+    auto extensions = createInfo.RequiredExtensions;
+    auto optionalExtensions = m_ActivePhysicalDevice->FilterAvailableExtensions(createInfo.OptionalExtensions);
+    extensions.insert(extensions.end(), optionalExtensions.begin(), optionalExtensions.end());
+    m_ActiveDevice.ScopeBegin(
+        m_ActivePhysicalDevice->CreateLogicalDevice(m_ValidationLayers, extensions, window, *this));
+}
+
 VulkanDevice &VulkanInstance::GetActiveDevice()
 {
     return *m_ActiveDevice;
@@ -139,8 +168,9 @@ std::vector<const char *> VulkanInstance::CheckValidationLayers(const std::vecto
     return requestedLayers;
 }
 
-VkInstance VulkanInstance::CreateInstance(const InstanceCreateInfo &createInfo)
+VkInstance VulkanInstance::CreateInstance(const InstanceCreateInfo &createInfo, bool withSurface)
 {
+    m_HasSurface = withSurface;
     VkApplicationInfo appInfo{};
     appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
     appInfo.pNext = nullptr;
@@ -148,7 +178,9 @@ VkInstance VulkanInstance::CreateInstance(const InstanceCreateInfo &createInfo)
     appInfo.applicationVersion = createInfo.AppVersion.ToVulkanVersion();
     appInfo.pEngineName = "Artifact";
     appInfo.engineVersion = createInfo.EngineVersion.ToVulkanVersion();
-    appInfo.apiVersion = VK_API_VERSION_1_0;
+    // 1.2 for core draw indirect count. Devices reporting an older version are still
+    // usable, we just don't enable any of the newer features on them
+    appInfo.apiVersion = VK_API_VERSION_1_2;
 
     VkInstanceCreateInfo instanceInfo{};
     instanceInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -160,7 +192,10 @@ VkInstance VulkanInstance::CreateInstance(const InstanceCreateInfo &createInfo)
 
     m_ValidationLayers = CheckValidationLayers(createInfo.ValidationLayers);
 
-    glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+    if (withSurface)
+    {
+        glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+    }
     std::vector<const char *> requestedExtensions(glfwExtensionCount);
     for (size_t i = 0; i < glfwExtensionCount; i++)
     {
@@ -229,7 +264,7 @@ VkInstance VulkanInstance::CreateInstance(const InstanceCreateInfo &createInfo)
     return vkInstance;
 }
 
-PhysicalDevice VulkanInstance::CreatePhysicalDevice(const VulkanSurface &targetSurface,
+PhysicalDevice VulkanInstance::CreatePhysicalDevice(std::optional<std::reference_wrapper<const VulkanSurface>> targetSurface,
                                                   std::span<const EDeviceExtension> requestedExtensions) const
 {
     VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
@@ -260,7 +295,8 @@ PhysicalDevice VulkanInstance::CreatePhysicalDevice(const VulkanSurface &targetS
     {
         if (iter->IsValid())
         {
-            if (numValidDevices == 0)
+            // Prefer any hardware device over a software one
+            if (numValidDevices == 0 || (firstValid->IsCpu() && !iter->IsCpu()))
             {
                 firstValid = iter;
             }
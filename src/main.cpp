@@ -10,7 +10,12 @@
 #include <glm/mat4x4.hpp>
 #include <glm/vec4.hpp>
 
+#include <algorithm>
 #include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
 
 #include "App.h"
 
@@ -19,11 +24,124 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb/stb_image.h>
 
-int main()
+struct BenchmarkArguments
 {
-    // TODO: Move to app init?
-    glfwInit();
-    App app;
+    std::optional<BenchmarkCreateInfo> Benchmark;
+    uint32_t FramesInFlight = DEFAULT_FRAMES_IN_FLIGHT;
+    std::optional<HeadlessCreateInfo> Headless;
+    FrameStatisticsCreateInfo Statistics;
+};
+
+// Usage: ArtifactVK [--benchmark push-constants|uniform-buffer|dynamic-uniform-buffer|instanced|bindless|
+//                                runtime-branching|specialized|descriptor-writes|descriptor-template|descriptor-transient|
+//                                compute-blur]
+//                   [--draws <count>] [--taps <count>] [--sets <count>] [--blur-radius <texels>] [--frames <count>]
+//                   [--frames-in-flight 1-4] [--pacing low-latency|max-throughput] [--headless <frames>]
+//                   [--stats-window <frames>] [--stats-interval <frames>] [--stats-output <path.csv|path.json>]
+BenchmarkArguments ParseBenchmarkArguments(int argc, char *argv[])
+{
+    std::optional<std::string> benchmark;
+    BenchmarkCreateInfo benchmarkOptions{};
+    std::optional<uint32_t> framesInFlight;
+    std::optional<EFramePacingPreset> pacing;
+    std::optional<HeadlessCreateInfo> headless;
+    FrameStatisticsCreateInfo statistics{};
+    // Every option takes a value
+    for (int i = 1; i < argc; i += 2)
+    {
+        std::string_view argument = argv[i];
+        if (i + 1 == argc)
+        {
+            throw std::runtime_error("Missing value for " + std::string(argument));
+        }
+        std::string value = argv[i + 1];
+        if (argument == "--benchmark")
+        {
+            benchmark = value;
+        }
+        else if (argument == "--draws")
+        {
+            benchmarkOptions.DrawCount = static_cast<uint32_t>(std::stoul(value));
+        }
+        else if (argument == "--taps")
+        {
+            benchmarkOptions.TapCount = static_cast<uint32_t>(std::stoul(value));
+        }
+        else if (argument == "--sets")
+        {
+            benchmarkOptions.SetCount = static_cast<uint32_t>(std::stoul(value));
+        }
+        else if (argument == "--blur-radius")
+        {
+            benchmarkOptions.BlurRadius = static_cast<uint32_t>(std::stoul(value));
+        }
+        else if (argument == "--frames")
+        {
+            benchmarkOptions.FrameCount = static_cast<uint32_t>(std::stoul(value));
+        }
+        else if (argument == "--frames-in-flight")
+        {
+            framesInFlight = static_cast<uint32_t>(std::stoul(value));
+            if (*framesInFlight < MIN_FRAMES_IN_FLIGHT || *framesInFlight > MAX_FRAMES_IN_FLIGHT)
+            {
+                throw std::runtime_error("Frames in flight must be between " + std::to_string(MIN_FRAMES_IN_FLIGHT) +
+                                         " and " + std::to_string(MAX_FRAMES_IN_FLIGHT) + ", got " + value);
+            }
+        }
+        else if (argument == "--pacing")
+        {
+            pacing = ParseFramePacingPreset(value);
+            if (!pacing.has_value())
+            {
+                throw std::runtime_error("Unknown frame pacing preset " + value);
+            }
+        }
+        else if (argument == "--headless")
+        {
+            headless = HeadlessCreateInfo{static_cast<uint32_t>(std::stoul(value))};
+        }
+        else if (argument == "--stats-window")
+        {
+            statistics.WindowSize = std::max(static_cast<uint32_t>(std::stoul(value)), 1u);
+        }
+        else if (argument == "--stats-interval")
+        {
+            statistics.ReportInterval = static_cast<uint32_t>(std::stoul(value));
+        }
+        else if (argument == "--stats-output")
+        {
+            statistics.OutputPath = value;
+        }
+        else
+        {
+            throw std::runtime_error("Unknown argument " + std::string(argument));
+        }
+    }
+
+    BenchmarkArguments arguments;
+    // An explicit count overrides the preset, whichever came first
+    arguments.FramesInFlight =
+        framesInFlight.value_or(pacing.has_value() ? GetFramesInFlight(*pacing) : DEFAULT_FRAMES_IN_FLIGHT);
+    arguments.Headless = headless;
+    arguments.Statistics = statistics;
+    if (!benchmark.has_value())
+    {
+        return arguments;
+    }
+    // Checked before creating the device, so that a typo fails right away
+    if (!Benchmark::IsKnown(*benchmark))
+    {
+        throw std::runtime_error("Unknown benchmark " + *benchmark);
+    }
+    benchmarkOptions.Name = *benchmark;
+    arguments.Benchmark = benchmarkOptions;
+    return arguments;
+}
+
+int main(int argc, char *argv[])
+{
+    auto benchmark = ParseBenchmarkArguments(argc, argv);
+    App app(benchmark.Benchmark, benchmark.FramesInFlight, benchmark.Headless, benchmark.Statistics);
     app.RunRenderLoop();
     return 0;
 }